@@ -16,6 +16,7 @@
 #include <drivers/input/ps2_keyboard.h>
 
 #include <arch/x86_64/cpu.h>
+#include <arch/x86_64/cpu_features.h>
 #include <arch/x86_64/gdt.h>
 #include <arch/x86_64/multiboot2.h>
 #include <arch/x86_64/tss.h>
@@ -31,6 +32,9 @@ void multiboot2_parse_mmap(struct multiboot_tag_mmap *mb_mmap);
 
 extern "C" void boot_main(struct multiboot_tag *mb_tag, uint32_t magic)
 {
+    // Pick the routines that suit this CPU before anything uses them.
+    cpu_features_init();
+
     // Initialize terminal.
     kernel_write = vga_text_write;
     vga_text_initialize();
@@ -127,15 +127,62 @@ static inline void cpu_io_wait(void)
 /// Get the current RDTSC time-stamp.
 static inline uint64_t cpu_rdtsc(void)
 {
-    uint64_t ret;
+    uint32_t low;
+    uint32_t high;
     asm volatile
     (
         "rdtsc \n"
-        : "=A" (ret)
+        : "=a" (low), "=d" (high)
         :
         :
     );
-    return (ret);
+    return (((uint64_t)high << 32) | low);
+}
+
+/// Reads a random number from the CPU's generator. Check
+/// cpu_has(CPU_FEATURE_RDRAND) first. Returns false if the generator had
+/// nothing ready, in which case the caller may retry.
+static inline bool cpu_rdrand(uint64_t* val)
+{
+    bool ok;
+    asm volatile
+    (
+        "rdrand %0 \n"
+        "setc %1 \n"
+        : "=r" (*val), "=qm" (ok)
+        :
+        : "cc"
+    );
+    return (ok);
+}
+
+/// Reads a seed straight from the CPU's entropy source. Check
+/// cpu_has(CPU_FEATURE_RDSEED) first. Fails more often than cpu_rdrand().
+static inline bool cpu_rdseed(uint64_t* val)
+{
+    bool ok;
+    asm volatile
+    (
+        "rdseed %0 \n"
+        "setc %1 \n"
+        : "=r" (*val), "=qm" (ok)
+        :
+        : "cc"
+    );
+    return (ok);
+}
+
+/// Executes CPUID for a leaf and subleaf.
+static inline void cpu_cpuid(uint32_t leaf, uint32_t subleaf, uint32_t* a,
+                             uint32_t* b, uint32_t* c, uint32_t* d)
+{
+    asm volatile
+    (
+        "cpuid \n"
+        : "=a" (*a), "=b" (*b), "=c" (*c), "=d" (*d)
+        : "a" (leaf), "c" (subleaf)
+        :
+    );
 }
 
 /// Get the contents of the RFLAGS register.
@@ -166,6 +213,52 @@ static inline void cpu_set_flags(uint64_t flags)
     );
 }
 
+/// Disable interrupts, returning the previous RFLAGS for cpu_irq_restore().
+static inline uint64_t cpu_irq_save(void)
+{
+    uint64_t flags;
+    asm volatile
+    (
+        "pushfq \n"
+        "popq %0 \n"
+        "cli \n"
+        : "=r" (flags)
+        :
+        : "memory"
+    );
+    return (flags);
+}
+
+/// Re-enable interrupts if they were enabled before cpu_irq_save().
+static inline void cpu_irq_restore(uint64_t flags)
+{
+    if (flags & (1 << 9))
+    {
+        asm volatile ("sti \n" : : : "memory");
+    }
+}
+
+/// Hint to the CPU that we are in a spin-wait loop.
+static inline void cpu_relax(void)
+{
+    asm volatile ("pause \n" : : : "memory");
+}
+
+/// Drops the TLB entry of the page holding addr.
+static inline void cpu_invlpg(const void* addr)
+{
+    asm volatile ("invlpg (%0) \n" : : "r" (addr) : "memory");
+}
+
+/// Maximum number of CPUs that per-CPU data is sized for.
+#define CPU_MAX 16
+
+/// Index of the executing CPU. Only the boot CPU is brought up for now.
+static inline size_t cpu_id(void)
+{
+    return (0);
+}
+
 static inline uint64_t cpu_read_cr0()
 {
     uint64_t ret;
@@ -0,0 +1,241 @@
+/**
+ * @file cpu_features.cc
+ * @author Seth McBee
+ * @date 2026-10-19
+ * @brief CPU feature registry and per-CPU routine dispatch.
+ */
+
+#include <globals.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <arch/x86_64/cpu.h>
+#include <arch/x86_64/cpu_features.h>
+
+uint64_t cpu_feature_bits;
+struct Cpu_Info cpu_info;
+
+// Bounds of the CPU_DISPATCH() table. Defined in linker script.
+extern const struct Cpu_Dispatch cpu_dispatch_start[];
+extern const struct Cpu_Dispatch cpu_dispatch_end[];
+
+// Where each feature is reported by CPUID.
+struct Cpu_Feature_Source
+{
+    const char* name;
+    uint32_t leaf;
+    uint8_t reg;        // 0 to 3 for EAX to EDX.
+    uint8_t bit;
+};
+
+enum { EAX, EBX, ECX, EDX };
+
+static const Cpu_Feature_Source cpu_feature_sources[CPU_FEATURE_COUNT] =
+{
+    [CPU_FEATURE_SSE3]          = { "sse3",          1,          ECX, 0 },
+    [CPU_FEATURE_PCLMULQDQ]     = { "pclmulqdq",     1,          ECX, 1 },
+    [CPU_FEATURE_SSSE3]         = { "ssse3",         1,          ECX, 9 },
+    [CPU_FEATURE_FMA]           = { "fma",           1,          ECX, 12 },
+    [CPU_FEATURE_CX16]          = { "cx16",          1,          ECX, 13 },
+    [CPU_FEATURE_SSE4_1]        = { "sse4.1",        1,          ECX, 19 },
+    [CPU_FEATURE_SSE4_2]        = { "sse4.2",        1,          ECX, 20 },
+    [CPU_FEATURE_MOVBE]         = { "movbe",         1,          ECX, 22 },
+    [CPU_FEATURE_POPCNT]        = { "popcnt",        1,          ECX, 23 },
+    [CPU_FEATURE_AES]           = { "aes",           1,          ECX, 25 },
+    [CPU_FEATURE_XSAVE]         = { "xsave",         1,          ECX, 26 },
+    [CPU_FEATURE_AVX]           = { "avx",           1,          ECX, 28 },
+    [CPU_FEATURE_F16C]          = { "f16c",          1,          ECX, 29 },
+    [CPU_FEATURE_RDRAND]        = { "rdrand",        1,          ECX, 30 },
+    [CPU_FEATURE_HYPERVISOR]    = { "hypervisor",    1,          ECX, 31 },
+    [CPU_FEATURE_TSC]           = { "tsc",           1,          EDX, 4 },
+    [CPU_FEATURE_APIC]          = { "apic",          1,          EDX, 9 },
+    [CPU_FEATURE_CLFLUSH]       = { "clflush",       1,          EDX, 19 },
+    [CPU_FEATURE_FXSR]          = { "fxsr",          1,          EDX, 24 },
+    [CPU_FEATURE_SSE]           = { "sse",           1,          EDX, 25 },
+    [CPU_FEATURE_SSE2]          = { "sse2",          1,          EDX, 26 },
+    [CPU_FEATURE_FSGSBASE]      = { "fsgsbase",      7,          EBX, 0 },
+    [CPU_FEATURE_BMI1]          = { "bmi1",          7,          EBX, 3 },
+    [CPU_FEATURE_AVX2]          = { "avx2",          7,          EBX, 5 },
+    [CPU_FEATURE_SMEP]          = { "smep",          7,          EBX, 7 },
+    [CPU_FEATURE_BMI2]          = { "bmi2",          7,          EBX, 8 },
+    [CPU_FEATURE_ERMS]          = { "erms",          7,          EBX, 9 },
+    [CPU_FEATURE_INVPCID]       = { "invpcid",       7,          EBX, 10 },
+    [CPU_FEATURE_AVX512F]       = { "avx512f",       7,          EBX, 16 },
+    [CPU_FEATURE_RDSEED]        = { "rdseed",        7,          EBX, 18 },
+    [CPU_FEATURE_ADX]           = { "adx",           7,          EBX, 19 },
+    [CPU_FEATURE_SMAP]          = { "smap",          7,          EBX, 20 },
+    [CPU_FEATURE_CLFLUSHOPT]    = { "clflushopt",    7,          EBX, 23 },
+    [CPU_FEATURE_SHA]           = { "sha",           7,          EBX, 29 },
+    [CPU_FEATURE_FSRM]          = { "fsrm",          7,          EDX, 4 },
+    [CPU_FEATURE_LZCNT]         = { "lzcnt",         0x80000001, ECX, 5 },
+    [CPU_FEATURE_NX]            = { "nx",            0x80000001, EDX, 20 },
+    [CPU_FEATURE_PDPE1GB]       = { "pdpe1gb",       0x80000001, EDX, 26 },
+    [CPU_FEATURE_RDTSCP]        = { "rdtscp",        0x80000001, EDX, 27 },
+    [CPU_FEATURE_INVARIANT_TSC] = { "invariant_tsc", 0x80000007, EDX, 8 },
+};
+
+// Features that use the AVX register state, which the kernel hasn't
+// enabled in XCR0.
+static const uint64_t cpu_avx_features =
+    CPU_FEATURE_BIT(CPU_FEATURE_AVX) | CPU_FEATURE_BIT(CPU_FEATURE_AVX2) |
+    CPU_FEATURE_BIT(CPU_FEATURE_FMA) | CPU_FEATURE_BIT(CPU_FEATURE_F16C) |
+    CPU_FEATURE_BIT(CPU_FEATURE_AVX512F);
+
+// Reads a leaf, or zeros if the CPU doesn't have it.
+static void cpu_features_leaf(uint32_t leaf, uint32_t regs[4])
+{
+    uint32_t max;
+    uint32_t unused[3];
+
+    cpu_cpuid(leaf & 0x80000000, 0, &max, &unused[0], &unused[1], &unused[2]);
+    if (leaf > max)
+    {
+        regs[EAX] = regs[EBX] = regs[ECX] = regs[EDX] = 0;
+        return;
+    }
+
+    cpu_cpuid(leaf, 0, &regs[EAX], &regs[EBX], &regs[ECX], &regs[EDX]);
+}
+
+static void cpu_features_identify(void)
+{
+    uint32_t regs[4];
+
+    // The vendor string is spread over EBX, EDX and ECX.
+    cpu_cpuid(0, 0, &regs[EAX], &regs[EBX], &regs[ECX], &regs[EDX]);
+    memcpy(&cpu_info.vendor[0], &regs[EBX], 4);
+    memcpy(&cpu_info.vendor[4], &regs[EDX], 4);
+    memcpy(&cpu_info.vendor[8], &regs[ECX], 4);
+    cpu_info.vendor[12] = '\0';
+
+    cpu_features_leaf(1, regs);
+    uint32_t family = (regs[EAX] >> 8) & 0xf;
+    uint32_t model = (regs[EAX] >> 4) & 0xf;
+    if (family == 0xf)
+    {
+        family += (regs[EAX] >> 20) & 0xff;
+    }
+    if (family == 0x6 || family >= 0xf)
+    {
+        model += ((regs[EAX] >> 16) & 0xf) << 4;
+    }
+    cpu_info.family = family;
+    cpu_info.model = model;
+    cpu_info.stepping = regs[EAX] & 0xf;
+
+    // The brand string takes three leaves of 16 bytes each.
+    cpu_info.brand[0] = '\0';
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        cpu_features_leaf(0x80000002 + i, regs);
+        memcpy(&cpu_info.brand[16 * i], regs, 16);
+    }
+    cpu_info.brand[48] = '\0';
+}
+
+static void cpu_features_detect(void)
+{
+    uint64_t bits = 0;
+    uint32_t leaf = 0;
+    uint32_t regs[4] = { 0, 0, 0, 0 };
+
+    // The table is grouped by leaf, so each leaf is read once.
+    for (size_t f = 0; f < CPU_FEATURE_COUNT; f++)
+    {
+        const Cpu_Feature_Source* src = &cpu_feature_sources[f];
+        if (src->leaf != leaf)
+        {
+            leaf = src->leaf;
+            cpu_features_leaf(leaf, regs);
+        }
+
+        if ((regs[src->reg] >> src->bit) & 1)
+        {
+            bits |= CPU_FEATURE_BIT(f);
+        }
+    }
+
+    // AVX state is only usable once the kernel sets CR4.OSXSAVE and
+    // enables it in XCR0, which it doesn't do yet.
+    bits &= ~cpu_avx_features;
+
+    cpu_feature_bits = bits;
+}
+
+// Points every dispatched routine at its best usable variant.
+static void cpu_features_dispatch(void)
+{
+    for (const Cpu_Dispatch* d = cpu_dispatch_start; d < cpu_dispatch_end; d++)
+    {
+        if ((d->needs & cpu_feature_bits) != d->needs)
+        {
+            continue;
+        }
+
+        // Skip this variant if a better usable one exists for the slot.
+        bool best = true;
+        for (const Cpu_Dispatch* o = cpu_dispatch_start; o < cpu_dispatch_end; o++)
+        {
+            if (o != d && o->slot == d->slot && o->rank > d->rank &&
+                (o->needs & cpu_feature_bits) == o->needs)
+            {
+                best = false;
+                break;
+            }
+        }
+
+        if (best)
+        {
+            *d->slot = d->impl;
+        }
+    }
+}
+
+const char* cpu_feature_name(enum Cpu_Feature f)
+{
+    return (cpu_feature_sources[f].name);
+}
+
+void cpu_features_init(void)
+{
+    cpu_features_identify();
+    cpu_features_detect();
+    cpu_features_dispatch();
+}
+
+void cpu_features_print(void)
+{
+    const char* brand = cpu_info.brand;
+    while (*brand == ' ')
+    {
+        brand++;
+    }
+
+    printf("%s, family %d model %d stepping %d\n", cpu_info.vendor,
+           cpu_info.family, cpu_info.model, cpu_info.stepping);
+    if (*brand != '\0')
+    {
+        printf("%s\n", brand);
+    }
+
+    printf("Features:");
+    for (size_t f = 0; f < CPU_FEATURE_COUNT; f++)
+    {
+        if (cpu_has((Cpu_Feature)f))
+        {
+            printf(" %s", cpu_feature_name((Cpu_Feature)f));
+        }
+    }
+    printf("\n");
+
+    printf("Dispatched:");
+    for (const Cpu_Dispatch* d = cpu_dispatch_start; d < cpu_dispatch_end; d++)
+    {
+        if (*d->slot == d->impl)
+        {
+            printf(" %s", d->name);
+        }
+    }
+    printf("\n");
+}
@@ -0,0 +1,133 @@
+/**
+ * @file cpu_features.h
+ * @author Seth McBee
+ * @date 2026-10-19
+ * @brief CPU feature registry and per-CPU routine dispatch.
+ *
+ * The features of the boot CPU are read with CPUID once at boot. Code
+ * that has faster variants for newer CPUs calls through a function
+ * pointer that starts out at the baseline variant, and registers the
+ * others with CPU_DISPATCH(). cpu_features_init() then points every
+ * such pointer at the best variant the CPU can run.
+ */
+
+#pragma once
+
+#include <globals.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Features the kernel knows about. Only features the kernel can
+/// actually use are reported, so AVX is missing until the kernel
+/// enables the extended register state.
+enum Cpu_Feature
+{
+    CPU_FEATURE_SSE3,
+    CPU_FEATURE_PCLMULQDQ,
+    CPU_FEATURE_SSSE3,
+    CPU_FEATURE_FMA,
+    CPU_FEATURE_CX16,
+    CPU_FEATURE_SSE4_1,
+    CPU_FEATURE_SSE4_2,
+    CPU_FEATURE_MOVBE,
+    CPU_FEATURE_POPCNT,
+    CPU_FEATURE_AES,
+    CPU_FEATURE_XSAVE,
+    CPU_FEATURE_AVX,
+    CPU_FEATURE_F16C,
+    CPU_FEATURE_RDRAND,
+    CPU_FEATURE_HYPERVISOR,
+    CPU_FEATURE_TSC,
+    CPU_FEATURE_APIC,
+    CPU_FEATURE_CLFLUSH,
+    CPU_FEATURE_FXSR,
+    CPU_FEATURE_SSE,
+    CPU_FEATURE_SSE2,
+    CPU_FEATURE_FSGSBASE,
+    CPU_FEATURE_BMI1,
+    CPU_FEATURE_AVX2,
+    CPU_FEATURE_SMEP,
+    CPU_FEATURE_BMI2,
+    CPU_FEATURE_ERMS,
+    CPU_FEATURE_INVPCID,
+    CPU_FEATURE_AVX512F,
+    CPU_FEATURE_RDSEED,
+    CPU_FEATURE_ADX,
+    CPU_FEATURE_SMAP,
+    CPU_FEATURE_CLFLUSHOPT,
+    CPU_FEATURE_SHA,
+    CPU_FEATURE_FSRM,
+    CPU_FEATURE_LZCNT,
+    CPU_FEATURE_NX,
+    CPU_FEATURE_PDPE1GB,
+    CPU_FEATURE_RDTSCP,
+    CPU_FEATURE_INVARIANT_TSC,
+    CPU_FEATURE_COUNT
+};
+
+/// Mask with a single feature set, for combining in CPU_DISPATCH().
+#define CPU_FEATURE_BIT(f) (1ULL << (f))
+
+/// Identification of the boot CPU.
+struct Cpu_Info
+{
+    char vendor[13];
+    char brand[49];
+    uint32_t family;
+    uint32_t model;
+    uint32_t stepping;
+};
+
+/// Bit f is set when feature f is usable. Zero until cpu_features_init().
+extern uint64_t cpu_feature_bits;
+
+extern struct Cpu_Info cpu_info;
+
+/// Whether the CPU supports a feature.
+static inline bool cpu_has(enum Cpu_Feature f)
+{
+    return ((cpu_feature_bits >> f) & 1);
+}
+
+/// Name of a feature as CPUID documentation spells it, in lower case.
+const char* cpu_feature_name(enum Cpu_Feature f);
+
+/// Reads the CPU's features and applies every CPU_DISPATCH() entry. Run
+/// once at boot, before other CPUs or threads exist.
+void cpu_features_init(void);
+
+/// Prints the CPU identification, its features and the routines chosen.
+void cpu_features_print(void);
+
+/// One variant of a dispatched routine.
+struct Cpu_Dispatch
+{
+    void** slot;        ///< Function pointer to set.
+    void* impl;         ///< Variant to install.
+    uint64_t needs;     ///< CPU_FEATURE_BIT()s the variant requires.
+    int rank;           ///< Preference among usable variants; highest wins.
+    const char* name;   ///< Name shown by cpu_features_print().
+};
+
+#define CPU_DISPATCH_CAT(a, b) a##b
+#define CPU_DISPATCH_ID(line) CPU_DISPATCH_CAT(cpu_dispatch_, line)
+
+/**
+ * @brief Registers a variant of a dispatched routine. The pointer keeps
+ * its initial value, the baseline, unless a usable variant is registered.
+ *
+ * @param slot Function pointer variable.
+ * @param impl Variant, with the pointer's type.
+ * @param needs CPU_FEATURE_BIT()s the variant requires.
+ * @param rank Preference among usable variants; highest wins.
+ */
+#define CPU_DISPATCH(slot, impl, needs, rank) \
+    static const struct Cpu_Dispatch CPU_DISPATCH_ID(__LINE__) \
+        __attribute__((section(".cpu_dispatch"), used, aligned(8))) = \
+        { (void**)&(slot), (void*)(impl), (needs), (rank), #impl }
+
+#ifdef __cplusplus
+}
+#endif
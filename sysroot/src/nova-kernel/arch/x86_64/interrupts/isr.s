@@ -2,7 +2,9 @@
 # Created: 2017-10-17
 # Description: x86-64 Interrupt Service Routines.
 
-# Pushes registers.
+# Pushes registers. The kernel itself uses SSE (memcpy, memset, floats),
+# so the vector registers are saved too, on a 16-byte aligned stack as
+# C code expects.
 .macro isr_push
 	push %rax
 	push %rbx
@@ -14,11 +16,49 @@
 	push %r9
 	push %r10
 	push %r11
+	push %rbp
+	movq %rsp, %rbp
+	andq $-16, %rsp
+	subq $256, %rsp
+	movdqa %xmm0, 0(%rsp)
+	movdqa %xmm1, 16(%rsp)
+	movdqa %xmm2, 32(%rsp)
+	movdqa %xmm3, 48(%rsp)
+	movdqa %xmm4, 64(%rsp)
+	movdqa %xmm5, 80(%rsp)
+	movdqa %xmm6, 96(%rsp)
+	movdqa %xmm7, 112(%rsp)
+	movdqa %xmm8, 128(%rsp)
+	movdqa %xmm9, 144(%rsp)
+	movdqa %xmm10, 160(%rsp)
+	movdqa %xmm11, 176(%rsp)
+	movdqa %xmm12, 192(%rsp)
+	movdqa %xmm13, 208(%rsp)
+	movdqa %xmm14, 224(%rsp)
+	movdqa %xmm15, 240(%rsp)
 	cld
 .endm
 
 # Pops registers.
 .macro isr_pop
+	movdqa 0(%rsp), %xmm0
+	movdqa 16(%rsp), %xmm1
+	movdqa 32(%rsp), %xmm2
+	movdqa 48(%rsp), %xmm3
+	movdqa 64(%rsp), %xmm4
+	movdqa 80(%rsp), %xmm5
+	movdqa 96(%rsp), %xmm6
+	movdqa 112(%rsp), %xmm7
+	movdqa 128(%rsp), %xmm8
+	movdqa 144(%rsp), %xmm9
+	movdqa 160(%rsp), %xmm10
+	movdqa 176(%rsp), %xmm11
+	movdqa 192(%rsp), %xmm12
+	movdqa 208(%rsp), %xmm13
+	movdqa 224(%rsp), %xmm14
+	movdqa 240(%rsp), %xmm15
+	movq %rbp, %rsp
+	pop %rbp
 	pop %r11
 	pop %r10
 	pop %r9
@@ -10,6 +10,7 @@
 #include <string.h>
 
 #include <kernel.h>
+#include <arch/x86_64/cpu_features.h>
 #include <arch/x86_64/multiboot2.h>
 #include <arch/x86_64/memory/paging.h>
 #include <arch/x86_64/memory/pmm.h>
@@ -24,6 +25,66 @@ size_t pmm_frames_unavailable;
 // Defined in linker script.
 extern void *phys_end;
 
+// Byte of the bitmap where the search for a free frame starts. Every
+// byte below it is full, so allocation stays lowest-first.
+static size_t pmm_search_start;
+
+// Returns the first clear bit in a bitmap byte that isn't full.
+static inline size_t pmm_byte_first_clear(uint8_t block)
+{
+    return (__builtin_ctz(~block & 0xFF));
+}
+
+// Finds the first free frame at or after a bitmap byte, a word at a
+// time. Returns SIZE_MAX if every frame is used. Inlined into each
+// variant below so it is compiled for that variant's instruction set.
+static inline __attribute__((always_inline)) size_t pmm_scan_body(size_t byte)
+{
+    // Bytes up to the first aligned word.
+    for (; byte < pmm_bitmap_len && ((uintptr_t)&pmm_bitmap[byte] & 7) != 0; byte++)
+    {
+        if (pmm_bitmap[byte] != 0xFF)
+        {
+            return (8 * byte + pmm_byte_first_clear(pmm_bitmap[byte]));
+        }
+    }
+
+    for (; byte + 8 <= pmm_bitmap_len; byte += 8)
+    {
+        uint64_t word = *(const uint64_t*)&pmm_bitmap[byte];
+        if (word != ~0ULL)
+        {
+            return (8 * byte + __builtin_ctzll(~word));
+        }
+    }
+
+    for (; byte < pmm_bitmap_len; byte++)
+    {
+        if (pmm_bitmap[byte] != 0xFF)
+        {
+            return (8 * byte + pmm_byte_first_clear(pmm_bitmap[byte]));
+        }
+    }
+
+    return (SIZE_MAX);
+}
+
+static size_t pmm_scan_generic(size_t byte)
+{
+    return (pmm_scan_body(byte));
+}
+
+// Same search using tzcnt, which is cheaper than bsf on some CPUs.
+__attribute__((target("bmi")))
+static size_t pmm_scan_bmi(size_t byte)
+{
+    return (pmm_scan_body(byte));
+}
+
+static size_t (*pmm_scan)(size_t byte) = pmm_scan_generic;
+CPU_DISPATCH(pmm_scan, pmm_scan_generic, 0, 0);
+CPU_DISPATCH(pmm_scan, pmm_scan_bmi, CPU_FEATURE_BIT(CPU_FEATURE_BMI1), 1);
+
 void pmm_init(struct multiboot_tag_mmap *mb_mmap)
 {
     // Number of memory map entries.
@@ -205,6 +266,10 @@ void pmm_frame_free(void* addr)
     uint8_t bit = frame_num % 8;
 
     pmm_bitmap[byte] = BIT_CLEAR(pmm_bitmap[byte], bit);
+    if (byte < pmm_search_start)
+    {
+        pmm_search_start = byte;
+    }
 
     pmm_frames_free++;
     pmm_frames_used--;
@@ -218,28 +283,15 @@ void* pmm_frame_alloc(void)
         return (NULL);
     }
 
-    // Find first empty page.
-    // TODO: Optimize this search.
-    for (size_t byte = 0; byte < pmm_bitmap_len; byte++)
+    size_t frame = pmm_scan(pmm_search_start);
+    if (frame != SIZE_MAX)
     {
-        // Check if byte contains an empty page.
-        if (pmm_bitmap[byte] < 255)
-        {
-            uint8_t block = pmm_bitmap[byte];
-
-            // Check each bit for a page.
-            for (uint8_t bit = 0; bit < 8; bit++)
-            {
-                if (BIT_CHECK(block, bit) == 0)
-                {
-                    pmm_bitmap[byte] = BIT_SET(pmm_bitmap[byte], bit);
-                    pmm_frames_free--;
-                    pmm_frames_used++;
-                    void *addr = (void*) (PAGE_SIZE * (8 * byte + bit));
-                    return (addr);
-                }
-            }
-        }
+        size_t byte = frame / 8;
+        pmm_bitmap[byte] = BIT_SET(pmm_bitmap[byte], frame % 8);
+        pmm_search_start = byte;
+        pmm_frames_free--;
+        pmm_frames_used++;
+        return ((void*)(PAGE_SIZE * frame));
     }
 
     // Since we don't currently support swapping or adequate signaling,
@@ -10,7 +10,11 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <static_vector>
+
 #include <globals.h>
+#include <mm/slab.h>
+#include <arch/x86_64/cpu.h>
 #include <arch/x86_64/memory/paging.h>
 #include <arch/x86_64/memory/pmm.h>
 #include <arch/x86_64/memory/vmm.h>
@@ -35,64 +39,12 @@ static const size_t MEM_MAX = (size_t)-1;
 extern void* pml4_start;
 extern void* kernel_end;
 
-// Used to iterate over nodes without recursion.
-typedef struct Vmm_Node_Stack Vmm_Node_Stack;
-struct Vmm_Node_Stack
-{
-    Vmm_Node** base;
-    size_t count;
-    size_t max;
-};
-
-Vmm_Node_Stack* vmm_node_stack_ctor(void)
-{
-    static const size_t DEFAULT_MAX = 5;
-
-    auto stk = (Vmm_Node_Stack*)malloc(sizeof(Vmm_Node_Stack));
-    stk->base = (Vmm_Node**)malloc(sizeof(Vmm_Node*) * DEFAULT_MAX);
-    stk->count = 0;
-    stk->max = DEFAULT_MAX;
-
-    return (stk);
-}
-
-void vmm_node_stack_push(Vmm_Node_Stack* stk, Vmm_Node* node)
-{
-    // Resize if needed. Increases in increments of 5.
-    if (stk->count == stk->max)
-    {
-        stk->max += 5;
-        size_t new_size = sizeof(Vmm_Node*) * (stk->max);
-        stk->base = (Vmm_Node**) realloc((void*)stk->base, new_size);
-    }
-
-    // Add to the stack and increment count.
-    stk->base[stk->count] = node;
-    stk->count++;
-}
-
-Vmm_Node* vmm_node_stack_pop(Vmm_Node_Stack* stk)
-{
-    // Check if the list is empty.
-    if (stk->count == 0)
-    {
-        return (NULL);
-    }
-
-    // Retrieve the next node and remove it from the stack.
-    stk->count--;
+// Deepest a node tree can get. An AVL tree is at most about 1.44 log2(n)
+// tall, so this covers far more nodes than there is memory for.
+static const size_t VMM_TREE_MAX_DEPTH = 96;
 
-    return (stk->base[stk->count]);
-}
-
-void vmm_node_stack_dtor(Vmm_Node_Stack* stk)
-{
-    // Free the actual stack.
-    free((void*)stk->base);
-
-    // Free this object.
-    free((void*)stk);
-}
+// Object cache for tree nodes.
+static Slab_Cache vmm_node_cache = SLAB_CACHE("vmm_node", Vmm_Node, NULL);
 
 static Pml4e* vmm_pml4(void)
 {
@@ -286,7 +238,7 @@ void vmm_init(void)
 
     // Set up the state of the virtual memory tree.
     // First, we define a region that is free for kernel allocations
-    // so that we can use malloc immediately afterwards to define
+    // so that we can use the node cache immediately afterwards to define
     // additional regions.
     Vmm_Region init_mem;
     init_mem.base = (void*)&kernel_end;
@@ -296,8 +248,8 @@ void vmm_init(void)
     vmm_tree_kernel_free->height = 1;
     vmm_tree_kernel_free->l = NULL;
     vmm_tree_kernel_free->r = NULL;
-    // Now we can allocate the new node on the heap.
-    vmm_tree_kernel_free = (Vmm_Node*)malloc(sizeof(Vmm_Node*));
+    // Now we can allocate the new node from the node cache.
+    vmm_tree_kernel_free = (Vmm_Node*)slab_alloc(&vmm_node_cache);
     *vmm_tree_kernel_free = _vmm_tree_kernel_free;
 
     void* a = vmm_page_alloc_kernel();
@@ -489,7 +441,9 @@ void vmm_page_map(void* phys, void* virt, uint16_t flags)
     tmp_pte.page_addr_high = (phys_addr >> 32) & 0xFFFFF;
     tmp_pte.page_addr_low = (phys_addr >> 12) & 0xFFFFF;
     pt[pt_i] = tmp_pte;
-    vmm_flush();
+
+    // Only this page's translation changed.
+    cpu_invlpg((void*)virt_addr);
 }
 
 void vmm_page_unmap(void* virt)
@@ -509,9 +463,7 @@ void vmm_page_unmap(void* virt)
     // Mark the page as not present.
     pt = vmm_pt(pml4_i, pdpt_i, pd_i);
     pt[pt_i].present = 0;
-
-    // Probably unneccessary.
-    vmm_flush();
+    cpu_invlpg((void*)virt_addr);
 }
 
 void vmm_table_flags(void* entry, uint16_t flags)
@@ -528,7 +480,7 @@ void* vmm_page_alloc_kernel(void)
     return (vmm_pages_alloc_kernel(1));
 }
 
-void* vmm_pages_alloc_kernel(size_t n)
+void* vmm_pages_reserve_kernel(size_t n)
 {
     // Check for invalid input.
     if (n == 0)
@@ -539,42 +491,72 @@ void* vmm_pages_alloc_kernel(size_t n)
     Vmm_Region mem = vmm_tree_find_pages(vmm_tree_kernel_free, n);
 
     // Check if a region was actually found.
-    if (mem.pages > 0)
+    if (mem.pages == 0)
     {
-        void* virt_base;
+        return (NULL);
+    }
 
-        // Return any memory to the pool that we aren't using.
-        if (mem.pages > n)
-        {
-            mem.pages -= n;
-            virt_base = (void*)((size_t)mem.base + PAGE_SIZE * mem.pages);
-            vmm_tree_resize(vmm_tree_kernel_free, mem);
-        }
-        else
-        {
-            // Delete the memory region from the tree.
-            virt_base = mem.base;
-            vmm_tree_kernel_free = vmm_tree_delete(vmm_tree_kernel_free, mem);
-        }
+    void* virt_base;
 
-        // Map the region.
-        void* phys;
-        size_t virt = (size_t) virt_base;
-        for (size_t i = 0; i < n; i++)
-        {
-            phys = pmm_frame_alloc();
-            //vmm_page_map(phys, (void*)virt, PG_PR | PG_RW);
+    // Return any memory to the pool that we aren't using.
+    if (mem.pages > n)
+    {
+        mem.pages -= n;
+        virt_base = (void*)((size_t)mem.base + PAGE_SIZE * mem.pages);
+        vmm_tree_resize(vmm_tree_kernel_free, mem);
+    }
+    else
+    {
+        // Delete the memory region from the tree.
+        virt_base = mem.base;
+        vmm_tree_kernel_free = vmm_tree_delete(vmm_tree_kernel_free, mem);
+    }
 
-            // TEST:
-            // USER FLAG SAFETY RISK.
-            vmm_page_map(phys, (void*)virt, PG_PR | PG_RW | PG_U);
-            virt += PAGE_SIZE;
-        }
-        return (virt_base);
+    return (virt_base);
+}
+
+void* vmm_pages_alloc_kernel(size_t n)
+{
+    void* virt_base = vmm_pages_reserve_kernel(n);
+
+    // Check if a region was actually found.
+    if (virt_base == NULL)
+    {
+        return (NULL);
     }
 
-    // Else.
-    return (NULL);
+    vmm_pages_map_kernel(virt_base, n);
+    return (virt_base);
+}
+
+void vmm_pages_map_kernel(void* virt, size_t n)
+{
+    void* phys;
+    size_t addr = (size_t)virt;
+    for (size_t i = 0; i < n; i++)
+    {
+        phys = pmm_frame_alloc();
+        //vmm_page_map(phys, (void*)addr, PG_PR | PG_RW);
+
+        // TEST:
+        // USER FLAG SAFETY RISK.
+        vmm_page_map(phys, (void*)addr, PG_PR | PG_RW | PG_U);
+        addr += PAGE_SIZE;
+    }
+}
+
+void vmm_pages_move_kernel(void* dst, void* src, size_t n)
+{
+    size_t from = (size_t)src;
+    size_t to = (size_t)dst;
+    for (size_t i = 0; i < n; i++)
+    {
+        void* phys = vmm_phys_addr((void*)from);
+        vmm_page_unmap((void*)from);
+        vmm_page_map(phys, (void*)to, PG_PR | PG_RW | PG_U);
+        from += PAGE_SIZE;
+        to += PAGE_SIZE;
+    }
 }
 
 void vmm_page_free_kernel(void* virt)
@@ -584,22 +566,36 @@ void vmm_page_free_kernel(void* virt)
 
 void vmm_pages_free_kernel(void* virt, size_t n)
 {
-    // STUB. Doesn't actually do anything.
-    return;
-
-    // Modify trees.
-    Vmm_Region region;
-    region.base = virt;
-    region.pages = n;
-    vmm_tree_kernel_free = vmm_tree_insert(vmm_tree_kernel_free, region);
+    if (virt == NULL || n == 0)
+    {
+        return;
+    }
 
     // Modify paging tables.
+    size_t addr = (size_t)virt;
     for (size_t i = 0; i < n; i++)
     {
-        vmm_page_unmap(virt);
-        pmm_frame_free(vmm_phys_addr(virt));
-        virt = (void*)((size_t)virt + PAGE_SIZE);
+        void* phys = vmm_phys_addr((void*)addr);
+        vmm_page_unmap((void*)addr);
+        pmm_frame_free(phys);
+        addr += PAGE_SIZE;
+    }
+
+    vmm_pages_release_kernel(virt, n);
+}
+
+void vmm_pages_release_kernel(void* virt, size_t n)
+{
+    if (virt == NULL || n == 0)
+    {
+        return;
     }
+
+    // Modify trees.
+    Vmm_Region region;
+    region.base = virt;
+    region.pages = n;
+    vmm_tree_kernel_free = vmm_tree_free_region(vmm_tree_kernel_free, region);
 }
 
 int vmm_tree_height(Vmm_Node* node)
@@ -654,27 +650,25 @@ Vmm_Node* vmm_tree_balance(Vmm_Node* node)
 
     if (balance > 1)
     {
-        // Left-left.
-        if (node->mem.base < node->l->mem.base)
+        // Left-right.
+        if (vmm_tree_height(node->l->l) < vmm_tree_height(node->l->r))
         {
-            return (vmm_tree_rotate_right(node));
+            node->l = vmm_tree_rotate_left(node->l);
         }
 
-        // Else, left-right.
-        node->l = vmm_tree_rotate_left(node->l);
+        // Left-left.
         return (vmm_tree_rotate_right(node));
     }
 
     if (balance < -1)
     {
-        // Right-right.
-        if (node->mem.base > node->r->mem.base)
+        // Right-left.
+        if (vmm_tree_height(node->r->r) < vmm_tree_height(node->r->l))
         {
-            return (vmm_tree_rotate_left(node));
+            node->r = vmm_tree_rotate_right(node->r);
         }
 
-        // Else, right-left.
-        node->r = vmm_tree_rotate_right(node->r);
+        // Right-right.
         return (vmm_tree_rotate_left(node));
     }
 
@@ -686,7 +680,7 @@ Vmm_Node* vmm_tree_insert(Vmm_Node* root, Vmm_Region mem)
 {
     if (root == NULL)
     {
-        Vmm_Node* new_node = (Vmm_Node*) malloc(sizeof(Vmm_Node));
+        Vmm_Node* new_node = (Vmm_Node*) slab_alloc(&vmm_node_cache);
 
         new_node->mem = mem;
         new_node->height = 1;
@@ -709,21 +703,6 @@ Vmm_Node* vmm_tree_insert(Vmm_Node* root, Vmm_Region mem)
         kernel_panic("VMM tree insert failed.");
     }
 
-    // TODO: Figure out how to merge with left node correctly.
-
-    // Check if we should merge with the right node.
-    if (root->r)
-    {
-        void* end = (void*)((size_t)mem.base + mem.pages * PAGE_SIZE);
-        if (end == root->r->mem.base)
-        {
-            mem.base = root->r->mem.base;
-            mem.pages += root->r->mem.pages;
-            root->r = vmm_tree_delete(root->r, root->r->mem);
-            vmm_tree_resize(root, mem);
-        }
-    }
-
     vmm_tree_update_height(root);
     root = vmm_tree_balance(root);
 
@@ -739,11 +718,11 @@ Vmm_Node* vmm_tree_delete(Vmm_Node* root, Vmm_Region mem)
 
     if (mem.base < root->mem.base)
     {
-        root->r = vmm_tree_delete(root->r, mem);
+        root->l = vmm_tree_delete(root->l, mem);
     }
     else if (mem.base > root->mem.base)
     {
-        root->l = vmm_tree_delete(root->l, mem);
+        root->r = vmm_tree_delete(root->r, mem);
     }
     else
     {
@@ -766,23 +745,16 @@ Vmm_Node* vmm_tree_delete(Vmm_Node* root, Vmm_Region mem)
         // If node has no children.
         else if (!root->l && !root->r)
         {
-            free(root);
+            slab_free(&vmm_node_cache, root);
             return (NULL);
         }
         // Node has one child.
         else
         {
-            // Move the child.
-            if (root->l)
-            {
-                root = root->l;
-                free(root->l);
-            }
-            else
-            {
-                root = root->r;
-                free(root->r);
-            }
+            // Move the child up and free this node.
+            Vmm_Node* child = root->l ? root->l : root->r;
+            slab_free(&vmm_node_cache, root);
+            root = child;
         }
     }
 
@@ -795,44 +767,114 @@ Vmm_Node* vmm_tree_delete(Vmm_Node* root, Vmm_Region mem)
     vmm_tree_update_height(root);
 
     // Balance node.
-    vmm_tree_balance(root);
+    root = vmm_tree_balance(root);
 
     return (root);
 }
 
-Vmm_Region vmm_tree_find_pages(Vmm_Node* root, size_t pages)
+// Returns the node with the greatest base below addr, or NULL.
+static Vmm_Node* vmm_tree_below(Vmm_Node* root, void* addr)
 {
-    Vmm_Region ret;
-    ret.base = NULL;
+    Vmm_Node* ret = NULL;
 
-    if (root == NULL)
+    while (root != NULL)
     {
-        // Not in this branch.
-        ret.pages = 0;
-        return (ret);
+        if (root->mem.base < addr)
+        {
+            ret = root;
+            root = root->r;
+        }
+        else
+        {
+            root = root->l;
+        }
+    }
+
+    return (ret);
+}
+
+// Returns the node with the least base above addr, or NULL.
+static Vmm_Node* vmm_tree_above(Vmm_Node* root, void* addr)
+{
+    Vmm_Node* ret = NULL;
+
+    while (root != NULL)
+    {
+        if (root->mem.base > addr)
+        {
+            ret = root;
+            root = root->l;
+        }
+        else
+        {
+            root = root->r;
+        }
     }
 
-    // Found a sufficient region.
-    if (root->mem.pages >= pages)
+    return (ret);
+}
+
+Vmm_Node* vmm_tree_free_region(Vmm_Node* root, Vmm_Region mem)
+{
+    size_t end = (size_t)mem.base + mem.pages * PAGE_SIZE;
+
+    // Absorb the region directly after this one.
+    Vmm_Node* next = vmm_tree_above(root, mem.base);
+    if (next != NULL && (size_t)next->mem.base == end)
     {
-        return (root->mem);
+        mem.pages += next->mem.pages;
+        root = vmm_tree_delete(root, next->mem);
     }
 
-    // Else, check left branch.
-    ret = vmm_tree_find_pages(root->l, pages);
-    if (ret.pages > 0)
+    // Grow the region directly before this one. Its base doesn't change,
+    // so the tree keeps its shape.
+    Vmm_Node* prev = vmm_tree_below(root, mem.base);
+    if (prev != NULL &&
+        (size_t)prev->mem.base + prev->mem.pages * PAGE_SIZE == (size_t)mem.base)
     {
-        return (ret);
+        prev->mem.pages += mem.pages;
+        return (root);
     }
 
-    // Else, check right branch.
-    ret = vmm_tree_find_pages(root->r, pages);
-    if (ret.pages > 0)
+    return (vmm_tree_insert(root, mem));
+}
+
+Vmm_Region vmm_tree_find_pages(Vmm_Node* root, size_t pages)
+{
+    // Preorder walk, node then left then right, on a stack that lives on
+    // this frame so finding pages never allocates.
+    std::static_vector<Vmm_Node*, VMM_TREE_MAX_DEPTH> stk;
+    if (root != NULL)
     {
-        return (ret);
+        stk.push_back(root);
     }
 
-    // Else, not in this branch.
+    while (!stk.empty())
+    {
+        Vmm_Node* node = stk.back();
+        stk.pop_back();
+
+        // Found a sufficient region.
+        if (node->mem.pages >= pages)
+        {
+            return (node->mem);
+        }
+
+        // Right goes first so that left is checked first.
+        if (node->r != NULL)
+        {
+            stk.push_back(node->r);
+        }
+        if (node->l != NULL)
+        {
+            stk.push_back(node->l);
+        }
+    }
+
+    // Not in this tree.
+    Vmm_Region ret;
+    ret.base = NULL;
+    ret.pages = 0;
     return (ret);
 }
 
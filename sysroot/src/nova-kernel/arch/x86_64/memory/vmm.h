@@ -74,10 +74,21 @@ void vmm_table_flags(void* virt, uint16_t flags);
 // or NULL.
 void* vmm_page_alloc_kernel(void);
 
+// Reserve consecutive kernel virtual pages without mapping them. Return
+// virtual address of first page, or NULL.
+void* vmm_pages_reserve_kernel(size_t n);
+
 // Allocate and map consecutive pages for kernel use. Return virtual
 // address of first page, or NULL.
 void* vmm_pages_alloc_kernel(size_t n);
 
+// Map fresh frames to consecutive reserved kernel pages.
+void vmm_pages_map_kernel(void* virt, size_t n);
+
+// Move the frames behind consecutive kernel pages to other reserved
+// pages, leaving the source pages unmapped. No data is copied.
+void vmm_pages_move_kernel(void* dst, void* src, size_t n);
+
 // Frees a page that was used by the kernel. This unmaps the page, as
 // well as marking it as free in the PMM.
 void vmm_page_free_kernel(void* virt);
@@ -85,12 +96,19 @@ void vmm_page_free_kernel(void* virt);
 // Frees consecutive kernel pages.
 void vmm_pages_free_kernel(void* virt, size_t n);
 
+// Returns consecutive unmapped kernel pages to the free tree.
+void vmm_pages_release_kernel(void* virt, size_t n);
+
 // Inserts a node and returns a pointer to the new root node.
 Vmm_Node* vmm_tree_insert(Vmm_Node* root, Vmm_Region mem);
 
 // Deletes a node and returns a pointer to the new root node.
 Vmm_Node* vmm_tree_delete(Vmm_Node* root, Vmm_Region mem);
 
+// Adds a free region to a tree, merging it with adjacent regions, and
+// returns a pointer to the new root node.
+Vmm_Node* vmm_tree_free_region(Vmm_Node* root, Vmm_Region mem);
+
 // Searches a tree for a sufficient amount of pages.
 // return.pages == 0 when no sufficient region was found.
 Vmm_Region vmm_tree_find_pages(Vmm_Node* root, size_t pages);
@@ -16,7 +16,7 @@
 
 Thread* thread_spawn(void* entry)
 {
-    Thread* thread = new Thread;
+    Thread* thread = thread_alloc();
     Thread_State* state = &thread->state;
     state->rsp = (size_t)vmm_pages_alloc_kernel(STACK_PAGES) + PAGE_SIZE*STACK_PAGES;
 
@@ -28,7 +28,10 @@ Thread* thread_spawn(void* entry)
         // Load new stack pointer.
         "movq %1, %%rsp \n"
 
-        // Push entry address and dummy values.
+        // Push a null return address for the entry function, so that it
+        // starts with the stack aligned as the ABI expects, then the
+        // entry address and dummy values.
+        "pushq $0 \n"
         "pushq %2 \n"
         "subq $48, %%rsp \n"
 
@@ -0,0 +1,207 @@
+/**
+ * @file alloc_bench.cc
+ * @author Seth McBee
+ * @date 2026-10-19
+ * @brief Allocator benchmarks.
+ */
+
+#include <globals.h>
+
+#include <list>
+#include <memory_resource>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <bench/bench.h>
+#include <liballoc/liballoc.h>
+#include <mm/slab.h>
+#include <proc/thread.h>
+
+// Live objects per round. Enough to cycle several batches through the
+// slabs rather than just the CPU free list.
+static const size_t BENCH_SLAB_LIVE = 256;
+static const size_t BENCH_SLAB_ROUNDS = 64;
+
+static void* bench_slab_objs[BENCH_SLAB_LIVE];
+
+static void bench_slab_size(size_t size)
+{
+    Slab_Cache* cache = slab_size_cache(size);
+    const uint64_t ops = BENCH_SLAB_LIVE * BENCH_SLAB_ROUNDS;
+
+    uint64_t start = bench_now();
+    for (size_t r = 0; r < BENCH_SLAB_ROUNDS; r++)
+    {
+        for (size_t i = 0; i < BENCH_SLAB_LIVE; i++)
+        {
+            bench_slab_objs[i] = slab_alloc(cache);
+        }
+        for (size_t i = 0; i < BENCH_SLAB_LIVE; i++)
+        {
+            slab_free(cache, bench_slab_objs[i]);
+        }
+    }
+    uint64_t slab = bench_now() - start;
+
+    start = bench_now();
+    for (size_t r = 0; r < BENCH_SLAB_ROUNDS; r++)
+    {
+        for (size_t i = 0; i < BENCH_SLAB_LIVE; i++)
+        {
+            bench_slab_objs[i] = l_malloc(size);
+        }
+        for (size_t i = 0; i < BENCH_SLAB_LIVE; i++)
+        {
+            l_free(bench_slab_objs[i]);
+        }
+    }
+    uint64_t heap = bench_now() - start;
+
+    printf(" %ld bytes:\n", size);
+    bench_report("slab alloc+free", slab, ops);
+    bench_report("liballoc alloc+free", heap, ops);
+}
+
+void bench_slab()
+{
+    static const size_t sizes[] = { 8, 24, 48, 96, 160, 256 };
+
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+    {
+        bench_slab_size(sizes[i]);
+    }
+}
+
+// Threads taking part in the multi-threaded benchmark. Each one frees the
+// blocks allocated by the thread before it, so every block changes hands.
+static const size_t BENCH_MT_THREADS = 4;
+static const size_t BENCH_MT_LIVE = 128;
+static const size_t BENCH_MT_ROUNDS = 256;
+
+static Thread* bench_mt_threads[BENCH_MT_THREADS];
+static Thread* bench_mt_caller;
+static size_t bench_mt_started;
+static void* bench_mt_objs[BENCH_MT_THREADS][BENCH_MT_LIVE];
+static void* (*bench_mt_alloc)(size_t);
+static void (*bench_mt_free)(void*);
+
+static size_t bench_mt_size(size_t i)
+{
+    return (16 + (i * 37) % 241);
+}
+
+static void bench_mt_worker()
+{
+    size_t self = bench_mt_started++;
+    size_t prev = (self + BENCH_MT_THREADS - 1) % BENCH_MT_THREADS;
+
+    while (true)
+    {
+        for (size_t i = 0; i < BENCH_MT_LIVE; i++)
+        {
+            bench_mt_free(bench_mt_objs[prev][i]);
+            bench_mt_objs[prev][i] = nullptr;
+        }
+        for (size_t i = 0; i < BENCH_MT_LIVE; i++)
+        {
+            bench_mt_objs[self][i] = bench_mt_alloc(bench_mt_size(i));
+        }
+
+        if (self + 1 < BENCH_MT_THREADS)
+        {
+            thread_switch(bench_mt_threads[self + 1]);
+        }
+        else
+        {
+            thread_switch(bench_mt_caller);
+        }
+    }
+}
+
+static uint64_t bench_mt_run(void* (*alloc)(size_t), void (*dealloc)(void*))
+{
+    bench_mt_alloc = alloc;
+    bench_mt_free = dealloc;
+    bench_mt_caller = current_thread;
+
+    uint64_t start = bench_now();
+    for (size_t r = 0; r < BENCH_MT_ROUNDS; r++)
+    {
+        thread_switch(bench_mt_threads[0]);
+    }
+    uint64_t cycles = bench_now() - start;
+
+    for (size_t t = 0; t < BENCH_MT_THREADS; t++)
+    {
+        for (size_t i = 0; i < BENCH_MT_LIVE; i++)
+        {
+            dealloc(bench_mt_objs[t][i]);
+            bench_mt_objs[t][i] = nullptr;
+        }
+    }
+
+    return (cycles);
+}
+
+void bench_heap_mt()
+{
+    // The workers are kept between runs; their stacks are not reclaimed.
+    if (bench_mt_threads[0] == nullptr)
+    {
+        for (size_t t = 0; t < BENCH_MT_THREADS; t++)
+        {
+            bench_mt_threads[t] = thread_spawn((void*)bench_mt_worker);
+        }
+    }
+
+    const uint64_t ops = BENCH_MT_ROUNDS * BENCH_MT_THREADS * BENCH_MT_LIVE * 2;
+
+    printf(" %ld threads, %ld-%ld bytes, blocks freed by another thread:\n",
+           BENCH_MT_THREADS, bench_mt_size(0), (size_t)256);
+    bench_report("malloc/free", bench_mt_run(malloc, free), ops);
+    bench_report("liballoc (global lock)", bench_mt_run(l_malloc, l_free), ops);
+}
+
+// Request-scoped work: a short-lived list and vector built and thrown
+// away, as a shell command or an interrupt handler would.
+static const size_t BENCH_ARENA_NODES = 64;
+static const size_t BENCH_ARENA_ROUNDS = 256;
+
+static void bench_arena_round(std::pmr::memory_resource* res)
+{
+    std::pmr::list<int> l(res);
+    std::pmr::vector<int> v(res);
+    for (size_t i = 0; i < BENCH_ARENA_NODES; i++)
+    {
+        l.push_back(i);
+        v.push_back(i);
+    }
+}
+
+void bench_arena()
+{
+    static char buffer[8192];
+    const uint64_t ops = BENCH_ARENA_ROUNDS;
+
+    uint64_t start = bench_now();
+    for (size_t r = 0; r < BENCH_ARENA_ROUNDS; r++)
+    {
+        bench_arena_round(std::pmr::new_delete_resource());
+    }
+    uint64_t heap = bench_now() - start;
+
+    std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer));
+    start = bench_now();
+    for (size_t r = 0; r < BENCH_ARENA_ROUNDS; r++)
+    {
+        bench_arena_round(&arena);
+        arena.release();
+    }
+    uint64_t mono = bench_now() - start;
+
+    printf(" %ld list nodes and vector pushes per round:\n", BENCH_ARENA_NODES);
+    bench_report("heap", heap, ops);
+    bench_report("monotonic arena", mono, ops);
+}
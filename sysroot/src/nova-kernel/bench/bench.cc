@@ -0,0 +1,121 @@
+/**
+ * @file bench.cc
+ * @author Seth McBee
+ * @date 2026-10-19
+ * @brief Benchmark registry and timing helpers.
+ */
+
+#include <globals.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <bench/bench.h>
+
+#ifdef ARCH_X86_64
+#include <arch/x86_64/cpu.h>
+#include <arch/x86_64/devices/pit.h>
+#endif // ARCH_X86_64
+
+#ifdef ARCH_X86
+#include <arch/x86/cpu.h>
+#endif // ARCH_X86
+
+struct Bench
+{
+    const char* name;
+    const char* desc;
+    void (*fn)();
+};
+
+static const Bench benches[] =
+{
+    { "slab", "slab caches vs. liballoc for small objects", bench_slab },
+    { "heapmt", "malloc/free throughput across threads", bench_heap_mt },
+    { "arena", "request-scoped containers on the heap vs. an arena", bench_arena },
+    { "memcpy", "memcpy, memmove and memset from 8 B to 8 MiB", bench_memcpy },
+    { "strfuzz", "string search routines against byte-loop references", bench_strfuzz },
+    { "printf", "formatted and literal output to a null stream", bench_printf },
+    { "stdout", "1 MiB of lines through stdout's buffer", bench_stdout },
+    { "sort", "qsort and std::sort on 1M integers and records", bench_sort },
+    { "format", "integer and floating point formatting and parsing", bench_format },
+    { "rand", "per-CPU generator against the old shared LCG", bench_rand },
+    { "hash", "CRC32C and hash_bytes checks and throughput", bench_hash },
+    { "vector", "std::vector growth, relocation and resize", bench_vector },
+    { "hashmap", "unordered_map against map: insert, find and erase, 1k to 1M keys", bench_hashmap },
+    { "deque", "std::deque as a queue, at both ends and indexed", bench_deque },
+    { "intrusive", "intrusive list, tree and hash against list, map and unordered_map", bench_intrusive },
+    { "smallvec", "small_vector and static_vector against vector for short-lived collections", bench_small_vector },
+    { "string", "string building inline and allocated, and path splitting with string_view", bench_string },
+};
+
+static uint64_t tsc_hz;
+
+uint64_t bench_now()
+{
+    return (cpu_rdtsc());
+}
+
+uint64_t bench_tsc_hz()
+{
+    if (tsc_hz == 0)
+    {
+        // Count cycles across ten PIT ticks, starting on a tick edge.
+        const uint64_t ticks = 10;
+        volatile uint64_t* count = &irq_pit_count;
+
+        uint64_t edge = *count;
+        while (*count == edge)
+        {
+            cpu_relax();
+        }
+
+        uint64_t start_tick = *count;
+        uint64_t start = cpu_rdtsc();
+        while (*count - start_tick < ticks)
+        {
+            cpu_relax();
+        }
+        uint64_t end = cpu_rdtsc();
+
+        tsc_hz = (uint64_t)((double)(end - start) * PIT_REAL_FREQ / ticks);
+    }
+
+    return (tsc_hz);
+}
+
+void bench_report(const char* what, uint64_t cycles, uint64_t ops)
+{
+    if (ops == 0)
+    {
+        ops = 1;
+    }
+
+    uint64_t ns = (uint64_t)((double)cycles * 1000000000.0 / bench_tsc_hz());
+    printf("  %s: %ld cycles/op, %ld ns total\n", what, cycles / ops, ns);
+}
+
+void bench_run(std::string_view name)
+{
+    const size_t count = sizeof(benches) / sizeof(benches[0]);
+    bool found = false;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (name == "all" || name == benches[i].name)
+        {
+            printf("%s: %s\n", benches[i].name, benches[i].desc);
+            benches[i].fn();
+            found = true;
+        }
+    }
+
+    if (!found)
+    {
+        printf("Benchmarks:\n");
+        for (size_t i = 0; i < count; i++)
+        {
+            printf("  %s - %s\n", benches[i].name, benches[i].desc);
+        }
+    }
+}
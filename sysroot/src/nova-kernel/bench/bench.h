@@ -0,0 +1,59 @@
+/**
+ * @file bench.h
+ * @author Seth McBee
+ * @date 2026-10-19
+ * @brief In-kernel micro-benchmarks, run from the shell with "bench".
+ */
+
+#pragma once
+
+#include <globals.h>
+
+#include <string_view>
+
+/**
+ * @brief Runs a benchmark by name. "all" runs every benchmark and any
+ * unknown name lists the available ones.
+ *
+ * @param name Name of the benchmark.
+ */
+void bench_run(std::string_view name);
+
+/**
+ * @brief Reads the time-stamp counter.
+ */
+uint64_t bench_now();
+
+/**
+ * @brief Time-stamp counter frequency, calibrated against the PIT on
+ * first use.
+ */
+uint64_t bench_tsc_hz();
+
+/**
+ * @brief Prints the cost of a timed loop.
+ *
+ * @param what Label of the measurement.
+ * @param cycles Elapsed time-stamp counter cycles.
+ * @param ops Number of operations performed.
+ */
+void bench_report(const char* what, uint64_t cycles, uint64_t ops);
+
+// Benchmarks.
+void bench_slab();
+void bench_heap_mt();
+void bench_arena();
+void bench_memcpy();
+void bench_strfuzz();
+void bench_printf();
+void bench_stdout();
+void bench_sort();
+void bench_format();
+void bench_rand();
+void bench_hash();
+void bench_vector();
+void bench_hashmap();
+void bench_deque();
+void bench_intrusive();
+void bench_small_vector();
+void bench_string();
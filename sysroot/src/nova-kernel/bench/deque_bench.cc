@@ -0,0 +1,90 @@
+/**
+ * @file deque_bench.cc
+ * @author Seth McBee
+ * @date 2026-10-19
+ * @brief std::deque benchmark.
+ */
+
+#include <globals.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <deque>
+#include <list>
+#include <stack>
+
+#include <bench/bench.h>
+
+static const size_t BENCH_DEQUE_OPS = 1000000;
+
+// Depth of the queue kept while elements stream through it.
+static const size_t BENCH_DEQUE_DEPTH = 1000;
+
+// Streams elements through a queue held at a fixed depth.
+template <class Queue>
+static size_t bench_deque_stream(const char* what)
+{
+    Queue q;
+    size_t bad = 0;
+    uint64_t start = bench_now();
+    for (size_t i = 0; i < BENCH_DEQUE_OPS; i++)
+    {
+        q.push_back(i);
+        if (q.size() > BENCH_DEQUE_DEPTH)
+        {
+            bad += q.front() != i - BENCH_DEQUE_DEPTH;
+            q.pop_front();
+        }
+    }
+    bench_report(what, bench_now() - start, BENCH_DEQUE_OPS);
+    return bad;
+}
+
+void bench_deque()
+{
+    size_t bad = bench_deque_stream<std::deque<uint64_t>>("deque push_back/pop_front");
+    bad += bench_deque_stream<std::list<uint64_t>>("list push_back/pop_front");
+
+    std::deque<uint64_t> d;
+    uint64_t start = bench_now();
+    for (size_t i = 0; i < BENCH_DEQUE_OPS; i++)
+    {
+        d.push_front(i);
+    }
+    bench_report("deque push_front", bench_now() - start, BENCH_DEQUE_OPS);
+
+    srand(47);
+    start = bench_now();
+    for (size_t i = 0; i < BENCH_DEQUE_OPS; i++)
+    {
+        size_t n = rand_range(BENCH_DEQUE_OPS);
+        bad += d[n] != BENCH_DEQUE_OPS - 1 - n;
+    }
+    bench_report("deque random index", bench_now() - start, BENCH_DEQUE_OPS);
+
+    start = bench_now();
+    while (!d.empty())
+    {
+        d.pop_back();
+    }
+    bench_report("deque pop_back", bench_now() - start, BENCH_DEQUE_OPS);
+
+    std::stack<uint64_t> s;
+    start = bench_now();
+    for (size_t i = 0; i < BENCH_DEQUE_OPS; i++)
+    {
+        s.push(i);
+    }
+    for (size_t i = BENCH_DEQUE_OPS; i > 0; i--)
+    {
+        bad += s.top() != i - 1;
+        s.pop();
+    }
+    bench_report("stack push and pop", bench_now() - start, 2 * BENCH_DEQUE_OPS);
+
+    if (bad != 0)
+    {
+        printf("  %ld wrong results\n", bad);
+    }
+}
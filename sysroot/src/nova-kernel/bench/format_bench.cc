@@ -0,0 +1,145 @@
+/**
+ * @file format_bench.cc
+ * @author Seth McBee
+ * @date 2026-10-19
+ * @brief Number formatting and parsing benchmarks.
+ */
+
+#include <globals.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <bench/bench.h>
+
+static const size_t BENCH_FORMAT_INTS = 10000000;
+static const size_t BENCH_FORMAT_DOUBLES = 1000000;
+
+// Digit-at-a-time conversion, as the library used to do it.
+static char* ref_utoa(unsigned long val, char* end)
+{
+    char* p = end;
+    do
+    {
+        *--p = "0123456789"[val % 10];
+        val /= 10;
+    } while (val != 0);
+    return (p);
+}
+
+// Spreads values over all digit counts, as log output has them.
+static unsigned long bench_format_value(size_t i)
+{
+    unsigned long x = i * 0x9e3779b97f4a7c15UL;
+    return (x >> (x & 63));
+}
+
+static double bench_format_double(size_t i)
+{
+    unsigned long x = bench_format_value(i);
+    return ((double)(x >> 11) / (double)((i % 1000) + 1));
+}
+
+// strtod() inputs on or just past a point halfway between two doubles,
+// with the bits of the correctly rounded result. Digits past the 19th
+// decide the last two.
+struct Bench_Strtod_Case
+{
+    const char* str;
+    uint64_t bits;
+};
+
+static const Bench_Strtod_Case bench_strtod_cases[] =
+{
+    { "9007199254740993", 0x4340000000000000 },
+    { "9007199254740993.0000000000000001", 0x4340000000000001 },
+    { "4.0093444502001212027284e34", 0x471ee309a8ba1ad0 },
+};
+
+void bench_format()
+{
+    char buf[64];
+    char* end = buf + sizeof(buf);
+    volatile size_t sink = 0;
+
+    // Integers.
+    uint64_t start = bench_now();
+    for (size_t i = 0; i < BENCH_FORMAT_INTS; i++)
+    {
+        sink += end - ref_utoa(bench_format_value(i), end);
+    }
+    uint64_t ref = bench_now() - start;
+
+    size_t bad = 0;
+    start = bench_now();
+    for (size_t i = 0; i < BENCH_FORMAT_INTS; i++)
+    {
+        sink += end - utoa_digits(bench_format_value(i), end, 10, false);
+    }
+    uint64_t pairs = bench_now() - start;
+
+    start = bench_now();
+    for (size_t i = 0; i < BENCH_FORMAT_INTS / 10; i++)
+    {
+        sink += snprintf(buf, sizeof(buf), "%lu", bench_format_value(i));
+    }
+    uint64_t print = bench_now() - start;
+
+    // Parse back what was formatted, checking it as it goes.
+    start = bench_now();
+    for (size_t i = 0; i < BENCH_FORMAT_INTS / 10; i++)
+    {
+        unsigned long val = bench_format_value(i);
+        end[-1] = '\0';
+        char* s = utoa_digits(val, end - 1, 10, false);
+        bad += strtoul(s, NULL, 10) != val;
+    }
+    uint64_t parse = bench_now() - start;
+
+    // Doubles: shortest form, then fixed, then back again.
+    start = bench_now();
+    for (size_t i = 0; i < BENCH_FORMAT_DOUBLES; i++)
+    {
+        sink += strlen(dtoa(bench_format_double(i), buf));
+    }
+    uint64_t shortest = bench_now() - start;
+
+    start = bench_now();
+    for (size_t i = 0; i < BENCH_FORMAT_DOUBLES; i++)
+    {
+        sink += strlen(_dtoa(bench_format_double(i), buf, 6));
+    }
+    uint64_t fixed = bench_now() - start;
+
+    start = bench_now();
+    for (size_t i = 0; i < BENCH_FORMAT_DOUBLES; i++)
+    {
+        double val = bench_format_double(i);
+        dtoa(val, buf);
+        bad += strtod(buf, NULL) != val;
+    }
+    uint64_t roundtrip = bench_now() - start;
+
+    size_t misread = 0;
+    for (const Bench_Strtod_Case& c : bench_strtod_cases)
+    {
+        double val = strtod(c.str, NULL);
+        uint64_t bits;
+        memcpy(&bits, &val, sizeof(bits));
+        misread += bits != c.bits;
+    }
+
+    printf(" %ld integers:\n", BENCH_FORMAT_INTS);
+    bench_report("digit at a time", ref, BENCH_FORMAT_INTS);
+    bench_report("utoa_digits", pairs, BENCH_FORMAT_INTS);
+    bench_report("snprintf %lu", print, BENCH_FORMAT_INTS / 10);
+    bench_report("utoa_digits + strtoul", parse, BENCH_FORMAT_INTS / 10);
+    printf(" %ld doubles:\n", BENCH_FORMAT_DOUBLES);
+    bench_report("dtoa", shortest, BENCH_FORMAT_DOUBLES);
+    bench_report("_dtoa, 6 places", fixed, BENCH_FORMAT_DOUBLES);
+    bench_report("dtoa + strtod", roundtrip, BENCH_FORMAT_DOUBLES);
+    printf("  %ld values did not read back\n", bad);
+    printf("  %ld of %ld halfway cases misread\n", misread,
+           sizeof(bench_strtod_cases) / sizeof(bench_strtod_cases[0]));
+}
@@ -0,0 +1,135 @@
+/**
+ * @file hash_bench.cc
+ * @author Seth McBee
+ * @date 2026-10-19
+ * @brief Checksum and hash self-check and benchmark.
+ */
+
+#include <globals.h>
+
+#include <hash.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <functional>
+
+#include <bench/bench.h>
+
+static const size_t BENCH_HASH_ROUNDS = 10000;
+static const size_t BENCH_HASH_BUF = 1024 * 1024;
+
+// Bit-at-a-time CRC32C, straight from the definition.
+static uint32_t ref_crc32c(uint32_t crc, const uint8_t* p, size_t n)
+{
+    crc = ~crc;
+    for (size_t i = 0; i < n; i++)
+    {
+        crc ^= p[i];
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc >> 1) ^ ((crc & 1) ? 0x82f63b78 : 0);
+        }
+    }
+    return (~crc);
+}
+
+static double bench_hash_rate(uint64_t cycles, size_t bytes)
+{
+    if (cycles == 0)
+    {
+        cycles = 1;
+    }
+
+    return ((double)bytes * bench_tsc_hz() / cycles / 1e9);
+}
+
+void bench_hash()
+{
+    uint8_t* buf = (uint8_t*)malloc(BENCH_HASH_BUF);
+    if (buf == NULL)
+    {
+        printf("  out of memory\n");
+        return;
+    }
+    rand_fill(buf, BENCH_HASH_BUF);
+
+    // The standard check value, then random spans split at random points.
+    size_t failures = 0;
+    const char* check = "123456789";
+    if (crc32c(0, check, 9) != 0xe3069283 || crc32c_soft(0, check, 9) != 0xe3069283)
+    {
+        printf("  wrong check value\n");
+        failures++;
+    }
+    for (size_t r = 0; r < BENCH_HASH_ROUNDS; r++)
+    {
+        size_t n = rand_range(r % 16 == 0 ? 4096 : 100);
+        const uint8_t* p = buf + rand_range(BENCH_HASH_BUF - n);
+        size_t split = rand_range(n + 1);
+        uint32_t ref = ref_crc32c(0, p, n);
+        uint32_t hw = crc32c(crc32c(0, p, split), p + split, n - split);
+        uint32_t sw = crc32c_soft(crc32c_soft(0, p, split), p + split, n - split);
+        if (hw != ref || sw != ref)
+        {
+            if (failures < 8)
+            {
+                printf("  mismatch: length %ld, split %ld\n", n, split);
+            }
+            failures++;
+        }
+    }
+
+    // Flipping any one input bit should flip about half the hash bits.
+    size_t flips = 0;
+    for (size_t r = 0; r < BENCH_HASH_ROUNDS; r++)
+    {
+        uint8_t key[64];
+        size_t n = 1 + rand_range(sizeof(key));
+        memcpy(key, buf + r, n);
+        uint64_t before = hash_bytes(key, n, 0);
+        key[rand_range(n)] ^= 1 << rand_range(8);
+        flips += __builtin_popcountll(before ^ hash_bytes(key, n, 0));
+    }
+    printf("  %ld rounds, %ld mismatches, %ld of 64 hash bits flip per input bit\n",
+           BENCH_HASH_ROUNDS, failures, flips / BENCH_HASH_ROUNDS);
+
+    volatile uint64_t sink = 0;
+    uint64_t start = bench_now();
+    sink += crc32c_soft(0, buf, BENCH_HASH_BUF);
+    uint64_t soft = bench_now() - start;
+
+    start = bench_now();
+    sink += crc32c(0, buf, BENCH_HASH_BUF);
+    uint64_t hw = bench_now() - start;
+
+    start = bench_now();
+    sink += hash_bytes(buf, BENCH_HASH_BUF, 0);
+    uint64_t whole = bench_now() - start;
+
+    // Short keys, as hash tables see them.
+    const size_t keys = BENCH_HASH_BUF / 16;
+    start = bench_now();
+    for (size_t i = 0; i < keys; i++)
+    {
+        sink += hash_bytes(buf + 16 * i, 16, 0);
+    }
+    uint64_t short_keys = bench_now() - start;
+
+    std::hash<uint64_t> hasher;
+    start = bench_now();
+    for (size_t i = 0; i < keys; i++)
+    {
+        sink += hasher(i);
+    }
+    uint64_t ints = bench_now() - start;
+
+    printf(" 1 MiB buffer:\n");
+    printf("  crc32c, slicing-by-8: %.2f GB/s\n", bench_hash_rate(soft, BENCH_HASH_BUF));
+    printf("  crc32c: %.2f GB/s\n", bench_hash_rate(hw, BENCH_HASH_BUF));
+    printf("  hash_bytes: %.2f GB/s\n", bench_hash_rate(whole, BENCH_HASH_BUF));
+    bench_report("hash_bytes, 16-byte keys", short_keys, keys);
+    bench_report("std::hash<uint64_t>", ints, keys);
+
+    free(buf);
+}
@@ -0,0 +1,92 @@
+/**
+ * @file hashmap_bench.cc
+ * @author Seth McBee
+ * @date 2026-10-19
+ * @brief Hash map against ordered map benchmark.
+ */
+
+#include <globals.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include <bench/bench.h>
+
+static const size_t bench_hashmap_sizes[] = { 1000, 10000, 100000, 1000000 };
+
+// Times insert, find and erase of every key on one kind of map.
+template <class Map>
+static size_t bench_hashmap_run(const char* name, const std::vector<uint64_t>& keys)
+{
+    size_t n = keys.size();
+    char what[64];
+    Map m;
+
+    uint64_t start = bench_now();
+    for (size_t i = 0; i < n; i++)
+    {
+        m.insert({keys[i], i});
+    }
+    uint64_t insert = bench_now() - start;
+
+    size_t bad = 0;
+    start = bench_now();
+    for (size_t i = 0; i < n; i++)
+    {
+        auto it = m.find(keys[i]);
+        bad += it == m.end() || it->second != i;
+    }
+    uint64_t hit = bench_now() - start;
+
+    // Random keys are all but certainly absent.
+    start = bench_now();
+    for (size_t i = 0; i < n; i++)
+    {
+        bad += m.find(keys[i] ^ 1) != m.end();
+    }
+    uint64_t miss = bench_now() - start;
+
+    start = bench_now();
+    for (size_t i = 0; i < n; i++)
+    {
+        bad += m.erase(keys[i]) != 1;
+    }
+    uint64_t erase = bench_now() - start;
+    bad += m.size() != 0;
+
+    snprintf(what, sizeof(what), "%s insert", name);
+    bench_report(what, insert, n);
+    snprintf(what, sizeof(what), "%s find, present", name);
+    bench_report(what, hit, n);
+    snprintf(what, sizeof(what), "%s find, absent", name);
+    bench_report(what, miss, n);
+    snprintf(what, sizeof(what), "%s erase", name);
+    bench_report(what, erase, n);
+    return bad;
+}
+
+void bench_hashmap()
+{
+    srand(45);
+    for (size_t n : bench_hashmap_sizes)
+    {
+        std::vector<uint64_t> keys;
+        keys.reserve(n);
+        for (size_t i = 0; i < n; i++)
+        {
+            keys.push_back(rand64());
+        }
+
+        printf(" %ld keys:\n", n);
+        size_t bad = bench_hashmap_run<std::unordered_map<uint64_t, uint64_t>>("unordered_map", keys);
+        bad += bench_hashmap_run<std::map<uint64_t, uint64_t>>("map", keys);
+        if (bad != 0)
+        {
+            printf("  %ld wrong results\n", bad);
+        }
+    }
+}
@@ -0,0 +1,192 @@
+/**
+ * @file intrusive_bench.cc
+ * @author Seth McBee
+ * @date 2026-10-19
+ * @brief Intrusive containers against their allocating counterparts.
+ */
+
+#include <globals.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <intrusive_hash>
+#include <intrusive_list>
+#include <intrusive_tree>
+#include <list>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include <bench/bench.h>
+
+static const size_t BENCH_INTRUSIVE_OBJECTS = 100000;
+
+// Buckets for the intrusive hash, a power of two above the object count.
+static const size_t BENCH_INTRUSIVE_BUCKETS = 131072;
+
+struct Bench_Object
+{
+    uint64_t key;
+    std::list_hook list;
+    std::tree_hook tree;
+    std::hash_hook hash;
+};
+
+static std::hash_bucket bench_buckets[BENCH_INTRUSIVE_BUCKETS];
+
+void bench_intrusive()
+{
+    size_t n = BENCH_INTRUSIVE_OBJECTS;
+    std::vector<Bench_Object> objects(n);
+    std::vector<size_t> order(n);
+    srand(48);
+    for (size_t i = 0; i < n; i++)
+    {
+        objects[i].key = rand64();
+        order[i] = i;
+    }
+    for (size_t i = n - 1; i > 0; i--)
+    {
+        size_t j = rand_range(i + 1);
+        size_t t = order[i];
+        order[i] = order[j];
+        order[j] = t;
+    }
+
+    size_t bad = 0;
+
+    // Lists: link everything, then unlink in random order. std::list has
+    // no way to reach an element from itself, so it only gets the links.
+    std::intrusive_list<Bench_Object, &Bench_Object::list> il;
+    uint64_t start = bench_now();
+    for (size_t i = 0; i < n; i++)
+    {
+        il.push_back(objects[i]);
+    }
+    uint64_t link = bench_now() - start;
+    start = bench_now();
+    for (size_t i = 0; i < n; i++)
+    {
+        il.erase(objects[order[i]]);
+    }
+    uint64_t unlink = bench_now() - start;
+    bad += !il.empty();
+    bench_report("intrusive_list push_back", link, n);
+    bench_report("intrusive_list erase, random", unlink, n);
+
+    {
+        std::list<uint64_t> l;
+        start = bench_now();
+        for (size_t i = 0; i < n; i++)
+        {
+            l.push_back(objects[i].key);
+        }
+        bench_report("list push_back", bench_now() - start, n);
+    }
+
+    // Trees: insert, find and erase by key.
+    std::intrusive_tree<Bench_Object, &Bench_Object::tree, &Bench_Object::key> it;
+    start = bench_now();
+    for (size_t i = 0; i < n; i++)
+    {
+        it.insert(objects[i]);
+    }
+    link = bench_now() - start;
+    start = bench_now();
+    for (size_t i = 0; i < n; i++)
+    {
+        bad += it.find(objects[order[i]].key) == it.end();
+    }
+    uint64_t find = bench_now() - start;
+    start = bench_now();
+    for (size_t i = 0; i < n; i++)
+    {
+        it.erase(objects[order[i]]);
+    }
+    unlink = bench_now() - start;
+    bad += !it.empty();
+    bench_report("intrusive_tree insert", link, n);
+    bench_report("intrusive_tree find", find, n);
+    bench_report("intrusive_tree erase", unlink, n);
+
+    {
+        std::map<uint64_t, Bench_Object*> m;
+        start = bench_now();
+        for (size_t i = 0; i < n; i++)
+        {
+            m.insert({objects[i].key, &objects[i]});
+        }
+        link = bench_now() - start;
+        start = bench_now();
+        for (size_t i = 0; i < n; i++)
+        {
+            bad += m.find(objects[order[i]].key) == m.end();
+        }
+        find = bench_now() - start;
+        start = bench_now();
+        for (size_t i = 0; i < n; i++)
+        {
+            m.erase(objects[order[i]].key);
+        }
+        unlink = bench_now() - start;
+        bench_report("map insert", link, n);
+        bench_report("map find", find, n);
+        bench_report("map erase", unlink, n);
+    }
+
+    // Hash tables.
+    std::intrusive_hash<Bench_Object, &Bench_Object::hash, &Bench_Object::key> ih(bench_buckets, BENCH_INTRUSIVE_BUCKETS);
+    start = bench_now();
+    for (size_t i = 0; i < n; i++)
+    {
+        bad += !ih.insert(objects[i]).second;
+    }
+    link = bench_now() - start;
+    start = bench_now();
+    for (size_t i = 0; i < n; i++)
+    {
+        bad += ih.find(objects[order[i]].key) == ih.end();
+    }
+    find = bench_now() - start;
+    start = bench_now();
+    for (size_t i = 0; i < n; i++)
+    {
+        ih.erase(objects[order[i]]);
+    }
+    unlink = bench_now() - start;
+    bad += !ih.empty();
+    bench_report("intrusive_hash insert", link, n);
+    bench_report("intrusive_hash find", find, n);
+    bench_report("intrusive_hash erase", unlink, n);
+
+    {
+        std::unordered_map<uint64_t, Bench_Object*> h;
+        start = bench_now();
+        for (size_t i = 0; i < n; i++)
+        {
+            h.insert({objects[i].key, &objects[i]});
+        }
+        link = bench_now() - start;
+        start = bench_now();
+        for (size_t i = 0; i < n; i++)
+        {
+            bad += h.find(objects[order[i]].key) == h.end();
+        }
+        find = bench_now() - start;
+        start = bench_now();
+        for (size_t i = 0; i < n; i++)
+        {
+            h.erase(objects[order[i]].key);
+        }
+        unlink = bench_now() - start;
+        bench_report("unordered_map insert", link, n);
+        bench_report("unordered_map find", find, n);
+        bench_report("unordered_map erase", unlink, n);
+    }
+
+    if (bad != 0)
+    {
+        printf("  %ld wrong results\n", bad);
+    }
+}
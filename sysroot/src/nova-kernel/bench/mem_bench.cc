@@ -0,0 +1,102 @@
+/**
+ * @file mem_bench.cc
+ * @author Seth McBee
+ * @date 2026-10-19
+ * @brief Memory copy and fill benchmarks.
+ */
+
+#include <globals.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <bench/bench.h>
+
+// Sizes run from BENCH_MEM_MIN to BENCH_MEM_MAX in steps of four, each
+// repeated until about BENCH_MEM_TOTAL bytes have been moved.
+static const size_t BENCH_MEM_MIN = 8;
+static const size_t BENCH_MEM_MAX = 8 * 1024 * 1024;
+static const size_t BENCH_MEM_TOTAL = 16 * 1024 * 1024;
+
+// Overlap of the memmove measurement, which shifts a buffer up by this
+// much and so has to copy back to front.
+static const size_t BENCH_MEM_SHIFT = 8;
+
+static void bench_mem_bytes(void* s, const void* ct, size_t n)
+{
+    volatile uint8_t* d = (volatile uint8_t*)s;
+    const uint8_t* src = (const uint8_t*)ct;
+    for (size_t i = 0; i < n; i++)
+    {
+        d[i] = src[i];
+    }
+}
+
+static uint64_t bench_mem_rate(uint64_t cycles, size_t bytes)
+{
+    if (cycles == 0)
+    {
+        cycles = 1;
+    }
+
+    return ((uint64_t)((double)bytes * bench_tsc_hz() / cycles / (1024 * 1024)));
+}
+
+void bench_memcpy()
+{
+    uint8_t* src = (uint8_t*)malloc(BENCH_MEM_MAX + BENCH_MEM_SHIFT);
+    uint8_t* dst = (uint8_t*)malloc(BENCH_MEM_MAX + BENCH_MEM_SHIFT);
+    if (src == NULL || dst == NULL)
+    {
+        printf("  out of memory\n");
+        free(src);
+        free(dst);
+        return;
+    }
+
+    memset(src, 0x5a, BENCH_MEM_MAX + BENCH_MEM_SHIFT);
+    memset(dst, 0, BENCH_MEM_MAX + BENCH_MEM_SHIFT);
+
+    printf(" MiB/s by size, against a byte loop:\n");
+    for (size_t n = BENCH_MEM_MIN; n <= BENCH_MEM_MAX; n *= 4)
+    {
+        size_t reps = BENCH_MEM_TOTAL / n;
+        size_t bytes = reps * n;
+
+        uint64_t start = bench_now();
+        for (size_t r = 0; r < reps; r++)
+        {
+            bench_mem_bytes(dst, src, n);
+        }
+        uint64_t loop = bench_now() - start;
+
+        start = bench_now();
+        for (size_t r = 0; r < reps; r++)
+        {
+            memcpy(dst, src, n);
+        }
+        uint64_t copy = bench_now() - start;
+
+        start = bench_now();
+        for (size_t r = 0; r < reps; r++)
+        {
+            memmove(src + BENCH_MEM_SHIFT, src, n);
+        }
+        uint64_t move = bench_now() - start;
+
+        start = bench_now();
+        for (size_t r = 0; r < reps; r++)
+        {
+            memset(dst, (int)r, n);
+        }
+        uint64_t fill = bench_now() - start;
+
+        printf("  %ld B: bytes %ld, memcpy %ld, memmove %ld, memset %ld\n", n,
+               bench_mem_rate(loop, bytes), bench_mem_rate(copy, bytes),
+               bench_mem_rate(move, bytes), bench_mem_rate(fill, bytes));
+    }
+
+    free(src);
+    free(dst);
+}
@@ -0,0 +1,96 @@
+/**
+ * @file rand_bench.cc
+ * @author Seth McBee
+ * @date 2026-10-19
+ * @brief Random number generator benchmark.
+ */
+
+#include <globals.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <bench/bench.h>
+
+static const size_t BENCH_RAND_OPS = 1000000;
+static const size_t BENCH_RAND_FILL = 1024 * 1024;
+
+// The generator rand() used to be: a shared 32-bit LCG giving 15 bits.
+static unsigned long ref_seed = 1;
+
+static int ref_rand(void)
+{
+    ref_seed = ref_seed * 1103515245 + 12345;
+    return ((unsigned int)(ref_seed / 65536) % 32768);
+}
+
+void bench_rand()
+{
+    volatile uint64_t sink = 0;
+
+    uint64_t start = bench_now();
+    for (size_t i = 0; i < BENCH_RAND_OPS; i++)
+    {
+        sink += ref_rand();
+    }
+    uint64_t ref = bench_now() - start;
+
+    start = bench_now();
+    for (size_t i = 0; i < BENCH_RAND_OPS; i++)
+    {
+        sink += rand64();
+    }
+    uint64_t r64 = bench_now() - start;
+
+    start = bench_now();
+    for (size_t i = 0; i < BENCH_RAND_OPS; i++)
+    {
+        sink += rand_range(1000);
+    }
+    uint64_t range = bench_now() - start;
+
+    uint8_t* buf = (uint8_t*)malloc(BENCH_RAND_FILL);
+    if (buf == NULL)
+    {
+        printf("  out of memory\n");
+        return;
+    }
+    start = bench_now();
+    rand_fill(buf, BENCH_RAND_FILL);
+    uint64_t fill = bench_now() - start;
+
+    // Every byte value should turn up about as often.
+    size_t counts[256] = {};
+    for (size_t i = 0; i < BENCH_RAND_FILL; i++)
+    {
+        counts[buf[i]]++;
+    }
+    size_t lo = BENCH_RAND_FILL;
+    size_t hi = 0;
+    for (size_t i = 0; i < 256; i++)
+    {
+        lo = (counts[i] < lo) ? counts[i] : lo;
+        hi = (counts[i] > hi) ? counts[i] : hi;
+    }
+    free(buf);
+
+    // Two thirds of 2^64 is where reducing modulo the bound is worst: the
+    // lower half of the range comes up twice as often as the upper half.
+    const uint64_t bound = 0xaaaaaaaaaaaaaaaaUL;
+    size_t mod_low = 0;
+    size_t range_low = 0;
+    for (size_t i = 0; i < BENCH_RAND_OPS; i++)
+    {
+        mod_low += rand64() % bound < bound / 2;
+        range_low += rand_range(bound) < bound / 2;
+    }
+
+    bench_report("shared LCG, 15 bits", ref, BENCH_RAND_OPS);
+    bench_report("rand64", r64, BENCH_RAND_OPS);
+    bench_report("rand_range(1000)", range, BENCH_RAND_OPS);
+    bench_report("rand_fill, per 8 bytes", fill, BENCH_RAND_FILL / 8);
+    printf("  byte counts over 1 MiB: %ld to %ld, expected %ld\n", lo, hi,
+           BENCH_RAND_FILL / 256);
+    printf("  lower half of 2/3 * 2^64: %ld per mille with %%, %ld with rand_range\n",
+           mod_low * 1000 / BENCH_RAND_OPS, range_low * 1000 / BENCH_RAND_OPS);
+}
@@ -0,0 +1,69 @@
+/**
+ * @file smallvec_bench.cc
+ * @author Seth McBee
+ * @date 2026-10-19
+ * @brief small_vector and static_vector benchmark.
+ */
+
+#include <globals.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <small_vector>
+#include <static_vector>
+#include <vector>
+
+#include <bench/bench.h>
+
+static const size_t BENCH_SMALLVEC_OPS = 100000;
+
+// Elements in each short-lived collection, which fits inline.
+static const size_t BENCH_SMALLVEC_LEN = 8;
+
+// Builds and drops many small collections, as a walker or parser would.
+template <class Vec>
+static uint64_t bench_smallvec_run(const char* what, size_t len)
+{
+    uint64_t sum = 0;
+    uint64_t start = bench_now();
+    for (size_t i = 0; i < BENCH_SMALLVEC_OPS; i++)
+    {
+        Vec v;
+        for (size_t j = 0; j < len; j++)
+        {
+            v.push_back(i + j);
+        }
+        for (uint64_t x : v)
+        {
+            sum += x;
+        }
+    }
+    bench_report(what, bench_now() - start, BENCH_SMALLVEC_OPS);
+    return sum;
+}
+
+void bench_small_vector()
+{
+    const size_t len = BENCH_SMALLVEC_LEN;
+    uint64_t expect = bench_smallvec_run<std::vector<uint64_t>>("vector, 8 elements", len);
+    size_t bad = 0;
+    bad += bench_smallvec_run<std::small_vector<uint64_t, 16>>("small_vector<16>, 8 elements", len) != expect;
+    bad += bench_smallvec_run<std::static_vector<uint64_t, 16>>("static_vector<16>, 8 elements", len) != expect;
+
+    // Past the inline capacity small_vector behaves like vector.
+    expect = bench_smallvec_run<std::vector<uint64_t>>("vector, 32 elements", 4 * len);
+    bad += bench_smallvec_run<std::small_vector<uint64_t, 16>>("small_vector<16>, 32 elements", 4 * len) != expect;
+
+    // Spilling to the heap and shrinking back must keep the elements.
+    std::small_vector<uint64_t, 4> v;
+    for (size_t i = 0; i < 100; i++)
+    {
+        v.push_back(i);
+    }
+    v.resize(3);
+    v.shrink_to_fit();
+    bad += !v.is_inline() || v[0] != 0 || v[2] != 2;
+
+    printf("  %ld mismatches\n", bad);
+}
@@ -0,0 +1,181 @@
+/**
+ * @file sort_bench.cc
+ * @author Seth McBee
+ * @date 2026-10-19
+ * @brief Sorting benchmarks and self-check.
+ */
+
+#include <globals.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include <bench/bench.h>
+
+static const size_t BENCH_SORT_COUNT = 1024 * 1024;
+
+// A record sorted by key, with the original position kept to check that
+// stable_sort() doesn't reorder equal keys.
+struct Bench_Record
+{
+    uint32_t key;
+    uint32_t pos;
+    uint64_t payload;
+};
+
+static int bench_sort_int_cmp(const void* a, const void* b)
+{
+    uint32_t x = *(const uint32_t*)a;
+    uint32_t y = *(const uint32_t*)b;
+    return ((x > y) - (x < y));
+}
+
+static int bench_sort_record_cmp(const void* a, const void* b)
+{
+    uint32_t x = ((const Bench_Record*)a)->key;
+    uint32_t y = ((const Bench_Record*)b)->key;
+    return ((x > y) - (x < y));
+}
+
+static bool bench_sort_record_less(const Bench_Record& a, const Bench_Record& b)
+{
+    return (a.key < b.key);
+}
+
+// The same pseudo-random keys every time, so each sort gets the same input.
+static void bench_sort_fill_ints(uint32_t* a, size_t n)
+{
+    srand(1);
+    for (size_t i = 0; i < n; i++)
+    {
+        a[i] = ((uint32_t)rand() << 15) ^ rand();
+    }
+}
+
+// Keys are drawn from a small range so there are many ties.
+static void bench_sort_fill_records(Bench_Record* a, size_t n)
+{
+    srand(2);
+    for (size_t i = 0; i < n; i++)
+    {
+        a[i].key = rand() % 4096;
+        a[i].pos = i;
+        a[i].payload = i * 0x9e3779b97f4a7c15UL;
+    }
+}
+
+static bool bench_sort_ints_ok(const uint32_t* a, size_t n)
+{
+    for (size_t i = 1; i < n; i++)
+    {
+        if (a[i - 1] > a[i])
+        {
+            return (false);
+        }
+    }
+    return (true);
+}
+
+static bool bench_sort_records_ok(const Bench_Record* a, size_t n, bool stable)
+{
+    for (size_t i = 1; i < n; i++)
+    {
+        if (a[i - 1].key > a[i].key ||
+            (stable && a[i - 1].key == a[i].key && a[i - 1].pos > a[i].pos))
+        {
+            return (false);
+        }
+    }
+    return (true);
+}
+
+static void bench_sort_check(const char* what, bool ok)
+{
+    if (!ok)
+    {
+        printf("  %s: NOT SORTED\n", what);
+    }
+}
+
+void bench_sort()
+{
+    const size_t n = BENCH_SORT_COUNT;
+    uint32_t* ints = (uint32_t*)malloc(n * sizeof(uint32_t));
+    Bench_Record* records = (Bench_Record*)malloc(n * sizeof(Bench_Record));
+    if (ints == NULL || records == NULL)
+    {
+        printf("  out of memory\n");
+        free(ints);
+        free(records);
+        return;
+    }
+
+    // Integers.
+    bench_sort_fill_ints(ints, n);
+    uint64_t start = bench_now();
+    qsort(ints, n, sizeof(uint32_t), bench_sort_int_cmp);
+    uint64_t int_qsort = bench_now() - start;
+    bench_sort_check("qsort", bench_sort_ints_ok(ints, n));
+
+    bench_sort_fill_ints(ints, n);
+    start = bench_now();
+    std::sort(ints, ints + n);
+    uint64_t int_sort = bench_now() - start;
+    bench_sort_check("std::sort", bench_sort_ints_ok(ints, n));
+
+    // Already sorted input is the worst case for a naive pivot.
+    start = bench_now();
+    std::sort(ints, ints + n);
+    uint64_t int_sorted = bench_now() - start;
+
+    // Lookups in the sorted array.
+    volatile size_t sink = 0;
+    start = bench_now();
+    for (size_t i = 0; i < n; i++)
+    {
+        sink += std::lower_bound(ints, ints + n, ints[(i * 7919) % n]) - ints;
+    }
+    uint64_t lookups = bench_now() - start;
+
+    // Records.
+    bench_sort_fill_records(records, n);
+    start = bench_now();
+    qsort(records, n, sizeof(Bench_Record), bench_sort_record_cmp);
+    uint64_t rec_qsort = bench_now() - start;
+    bench_sort_check("qsort", bench_sort_records_ok(records, n, false));
+
+    bench_sort_fill_records(records, n);
+    start = bench_now();
+    std::sort(records, records + n, bench_sort_record_less);
+    uint64_t rec_sort = bench_now() - start;
+    bench_sort_check("std::sort", bench_sort_records_ok(records, n, false));
+
+    bench_sort_fill_records(records, n);
+    start = bench_now();
+    std::stable_sort(records, records + n, bench_sort_record_less);
+    uint64_t rec_stable = bench_now() - start;
+    bench_sort_check("std::stable_sort", bench_sort_records_ok(records, n, true));
+
+    bench_sort_fill_records(records, n);
+    start = bench_now();
+    std::partition(records, records + n,
+                   [](const Bench_Record& r) { return (r.key < 2048); });
+    uint64_t rec_part = bench_now() - start;
+
+    printf(" %ld 32-bit integers:\n", n);
+    bench_report("qsort", int_qsort, 1);
+    bench_report("std::sort", int_sort, 1);
+    bench_report("std::sort, already sorted", int_sorted, 1);
+    bench_report("std::lower_bound", lookups, n);
+    printf(" %ld %ld-byte records, 4096 distinct keys:\n", n, sizeof(Bench_Record));
+    bench_report("qsort", rec_qsort, 1);
+    bench_report("std::sort", rec_sort, 1);
+    bench_report("std::stable_sort", rec_stable, 1);
+    bench_report("std::partition in halves", rec_part, 1);
+
+    free(ints);
+    free(records);
+}
@@ -0,0 +1,101 @@
+/**
+ * @file stdio_bench.cc
+ * @author Seth McBee
+ * @date 2026-10-19
+ * @brief Formatted output and stream benchmarks.
+ */
+
+#include <globals.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <bench/bench.h>
+
+static const size_t BENCH_PRINTF_LINES = 20000;
+
+// Bytes pushed through stdout, and the size of each write.
+static const size_t BENCH_STDOUT_BYTES = 1024 * 1024;
+static const size_t BENCH_STDOUT_CHUNK = 64;
+
+void bench_printf()
+{
+    // A fully buffered stream that discards what it flushes.
+    static char buf[4096];
+    FILE null_file = {};
+    null_file.buf = buf;
+    null_file.pos = 0;
+    null_file.len = 0;
+    null_file.max_len = sizeof(buf);
+    null_file.buf_mode = _IOFBF;
+    null_file.io_mode = _IOO;
+    null_file.write = write_null;
+
+    const uint64_t ops = BENCH_PRINTF_LINES;
+    size_t bytes = 0;
+
+    uint64_t start = bench_now();
+    for (size_t i = 0; i < BENCH_PRINTF_LINES; i++)
+    {
+        bytes += fprintf(&null_file, "[%ld] %s: mapped %d pages at %p\n",
+                         i, "vmm", 16, (void*)(0xffffffff80000000UL + i * 4096));
+    }
+    uint64_t stream = bench_now() - start;
+
+    char line[128];
+    start = bench_now();
+    for (size_t i = 0; i < BENCH_PRINTF_LINES; i++)
+    {
+        snprintf(line, sizeof(line), "[%ld] %s: mapped %d pages at %p\n",
+                 i, "vmm", 16, (void*)(0xffffffff80000000UL + i * 4096));
+    }
+    uint64_t str = bench_now() - start;
+
+    start = bench_now();
+    for (size_t i = 0; i < BENCH_PRINTF_LINES; i++)
+    {
+        fputs("a log line with no conversions in it at all\n", &null_file);
+    }
+    uint64_t literal = bench_now() - start;
+
+    printf(" %ld bytes per formatted line:\n", bytes / BENCH_PRINTF_LINES);
+    bench_report("fprintf to a null stream", stream, ops);
+    bench_report("snprintf", str, ops);
+    bench_report("fputs of a 44-byte line", literal, ops);
+}
+
+void bench_stdout()
+{
+    static char chunk[BENCH_STDOUT_CHUNK];
+    memset(chunk, 'x', sizeof(chunk) - 1);
+    chunk[sizeof(chunk) - 1] = '\n';
+
+    // Keep stdout's buffering, but discard what it flushes.
+    fflush(stdout);
+    ssize_t (*write)(const void*, size_t) = stdout->write;
+    stdout->write = write_null;
+
+    uint64_t start = bench_now();
+    for (size_t i = 0; i < BENCH_STDOUT_BYTES; i += sizeof(chunk))
+    {
+        fputn(chunk, sizeof(chunk), stdout);
+    }
+    fflush(stdout);
+    uint64_t spans = bench_now() - start;
+
+    start = bench_now();
+    for (size_t i = 0; i < BENCH_STDOUT_BYTES; i++)
+    {
+        fputc(chunk[i % sizeof(chunk)], stdout);
+    }
+    fflush(stdout);
+    uint64_t bytes = bench_now() - start;
+
+    stdout->write = write;
+
+    const uint64_t ops = BENCH_STDOUT_BYTES / sizeof(chunk);
+    printf(" %ld KiB through stdout in %ld-byte lines:\n",
+           BENCH_STDOUT_BYTES / 1024, sizeof(chunk));
+    bench_report("fputn per line", spans, ops);
+    bench_report("fputc per byte, per line", bytes, ops);
+}
@@ -0,0 +1,206 @@
+/**
+ * @file str_bench.cc
+ * @author Seth McBee
+ * @date 2026-10-19
+ * @brief String search self-check and benchmark.
+ */
+
+#include <globals.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <bench/bench.h>
+
+#ifdef ARCH_X86_64
+#include <arch/x86_64/memory/paging.h>
+#include <arch/x86_64/memory/vmm.h>
+#endif // ARCH_X86_64
+
+#ifdef ARCH_X86
+#include <arch/x86/memory/paging.h>
+#include <arch/x86/memory/vmm.h>
+#endif // ARCH_X86
+
+static const size_t BENCH_STR_ROUNDS = 100000;
+
+// Length of the string timed against the byte loops.
+static const size_t BENCH_STR_LONG = 2000;
+
+// Byte-at-a-time references.
+
+static size_t ref_strlen(const char* s)
+{
+    size_t i = 0;
+    while (s[i] != '\0')
+    {
+        i++;
+    }
+    return (i);
+}
+
+static const char* ref_strchr(const char* s, int c)
+{
+    for (;; s++)
+    {
+        if (*s == (char)c)
+        {
+            return (s);
+        }
+        if (*s == '\0')
+        {
+            return (NULL);
+        }
+    }
+}
+
+static int ref_strcmp(const char* a, const char* b)
+{
+    for (;; a++, b++)
+    {
+        if (*a != *b || *a == '\0')
+        {
+            return ((uint8_t)*a - (uint8_t)*b);
+        }
+    }
+}
+
+static const void* ref_memchr(const void* p, int c, size_t n)
+{
+    const uint8_t* s = (const uint8_t*)p;
+    for (size_t i = 0; i < n; i++)
+    {
+        if (s[i] == (uint8_t)c)
+        {
+            return (s + i);
+        }
+    }
+    return (NULL);
+}
+
+static int sign(int x)
+{
+    return ((x > 0) - (x < 0));
+}
+
+// Fills a random string of len bytes. Small alphabets make long common
+// prefixes for strcmp.
+static void bench_str_fill(char* s, size_t len)
+{
+    int range = (rand() % 2) ? 3 : 255;
+    for (size_t i = 0; i < len; i++)
+    {
+        s[i] = (char)(1 + rand() % range);
+    }
+    s[len] = '\0';
+}
+
+// Places a string of len bytes either at the start of a page or flush
+// against the unmapped page after it, where any over-read faults.
+static char* bench_str_place(char* page, size_t len)
+{
+    if (rand() % 2)
+    {
+        return (page + PAGE_SIZE - len - 1);
+    }
+    return (page + rand() % 64);
+}
+
+void bench_strfuzz()
+{
+    // One mapped page followed by an unmapped guard page, for each string.
+    char* a_page = (char*)vmm_pages_reserve_kernel(2);
+    char* b_page = (char*)vmm_pages_reserve_kernel(2);
+    if (a_page == NULL || b_page == NULL)
+    {
+        printf("  out of memory\n");
+        vmm_pages_release_kernel(a_page, 2);
+        vmm_pages_release_kernel(b_page, 2);
+        return;
+    }
+    vmm_pages_map_kernel(a_page, 1);
+    vmm_pages_map_kernel(b_page, 1);
+
+    size_t failures = 0;
+    for (size_t r = 0; r < BENCH_STR_ROUNDS; r++)
+    {
+        size_t len = rand() % ((r % 16 == 0) ? PAGE_SIZE - 64 : 80);
+        char* a = bench_str_place(a_page, len);
+        bench_str_fill(a, len);
+
+        // b shares a prefix with a, possibly with a byte changed or the
+        // string cut short.
+        char* b = bench_str_place(b_page, len);
+        memcpy(b, a, len + 1);
+        if (len > 0 && rand() % 2)
+        {
+            b[rand() % len] = (char)(rand() % 256);
+        }
+
+        int c = (rand() % 4 == 0) ? 0 : a[len > 0 ? rand() % len : 0] + rand() % 2;
+        size_t n = rand() % (len + 2);
+        const char* m = a + rand() % (len + 2 - n);
+
+        bool ok = strlen(a) == ref_strlen(a) &&
+                  strchr(a, c) == ref_strchr(a, c) &&
+                  sign(strcmp(a, b)) == sign(ref_strcmp(a, b)) &&
+                  sign(strcmp(b, a)) == sign(ref_strcmp(b, a)) &&
+                  memchr(m, c, n) == ref_memchr(m, c, n);
+        if (!ok)
+        {
+            if (failures < 8)
+            {
+                printf("  mismatch: length %ld, c %d, n %ld\n", len, c, n);
+            }
+            failures++;
+        }
+    }
+    printf("  %ld rounds, %ld mismatches\n", BENCH_STR_ROUNDS, failures);
+
+    // Time a long string against the references.
+    char* s = a_page;
+    memset(s, 'x', BENCH_STR_LONG);
+    s[BENCH_STR_LONG] = '\0';
+    const uint64_t ops = 1000;
+    volatile size_t sink = 0;
+
+    uint64_t start = bench_now();
+    for (size_t i = 0; i < ops; i++)
+    {
+        sink += ref_strlen(s);
+    }
+    uint64_t ref_len = bench_now() - start;
+
+    start = bench_now();
+    for (size_t i = 0; i < ops; i++)
+    {
+        sink += strlen(s);
+    }
+    uint64_t len = bench_now() - start;
+
+    start = bench_now();
+    for (size_t i = 0; i < ops; i++)
+    {
+        sink += ref_strcmp(s, s) == 0;
+    }
+    uint64_t ref_cmp = bench_now() - start;
+
+    start = bench_now();
+    for (size_t i = 0; i < ops; i++)
+    {
+        sink += strcmp(s, s) == 0;
+    }
+    uint64_t cmp = bench_now() - start;
+
+    printf(" %ld-byte string:\n", BENCH_STR_LONG);
+    bench_report("byte loop strlen", ref_len, ops);
+    bench_report("strlen", len, ops);
+    bench_report("byte loop strcmp", ref_cmp, ops);
+    bench_report("strcmp", cmp, ops);
+
+    vmm_pages_free_kernel(a_page, 1);
+    vmm_pages_free_kernel(b_page, 1);
+    vmm_pages_release_kernel(a_page + PAGE_SIZE, 1);
+    vmm_pages_release_kernel(b_page + PAGE_SIZE, 1);
+}
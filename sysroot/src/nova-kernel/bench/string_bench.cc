@@ -0,0 +1,93 @@
+/**
+ * @file string_bench.cc
+ * @author Seth McBee
+ * @date 2026-10-19
+ * @brief std::string and std::string_view benchmark.
+ */
+
+#include <globals.h>
+
+#include <stdio.h>
+
+#include <string>
+#include <string_view>
+
+#include <bench/bench.h>
+
+static const size_t BENCH_STRING_OPS = 100000;
+
+// Builds and drops a string of src.size() + 1 characters (a copy of src
+// with one more appended), many times over.
+static size_t bench_string_build(const char* what, std::string_view src)
+{
+    size_t sum = 0;
+    uint64_t start = bench_now();
+    for (size_t i = 0; i < BENCH_STRING_OPS; i++)
+    {
+        std::string s(src);
+        s += (char)('a' + i % 26);
+        sum += s.size() + s.is_local();
+    }
+    bench_report(what, bench_now() - start, BENCH_STRING_OPS);
+    return sum;
+}
+
+void bench_string()
+{
+    const std::string_view path = "/usr/share/nova/modules/drivers/input/ps2_keyboard.mod";
+    size_t bad = 0;
+
+    // Short strings stay inline; long ones allocate.
+    bad += bench_string_build("build 8 chars, inline", path.substr(0, 8)) != BENCH_STRING_OPS * 10;
+    bad += bench_string_build("build 54 chars, allocated", path) != BENCH_STRING_OPS * 55;
+
+    // Splitting a path into components with views copies nothing.
+    size_t parts = 0;
+    uint64_t start = bench_now();
+    for (size_t i = 0; i < BENCH_STRING_OPS; i++)
+    {
+        std::string_view rest = path;
+        while (!rest.empty())
+        {
+            size_t end = rest.find('/');
+            std::string_view part = rest.substr(0, end);
+            parts += !part.empty();
+            rest = rest.substr(end == std::string_view::npos ? rest.size() : end + 1);
+        }
+    }
+    bench_report("split path into views", bench_now() - start, BENCH_STRING_OPS);
+    bad += parts != BENCH_STRING_OPS * 7;
+
+    // The same split, copying each component into a string.
+    parts = 0;
+    start = bench_now();
+    for (size_t i = 0; i < BENCH_STRING_OPS; i++)
+    {
+        size_t pos = 0;
+        while (pos < path.size())
+        {
+            size_t end = path.find('/', pos);
+            if (end == std::string_view::npos)
+            {
+                end = path.size();
+            }
+            std::string part(path.substr(pos, end - pos));
+            parts += !part.empty();
+            pos = end + 1;
+        }
+    }
+    bench_report("split path into strings", bench_now() - start, BENCH_STRING_OPS);
+    bad += parts != BENCH_STRING_OPS * 7;
+
+    // Appending a character at a time doubles the capacity as it goes.
+    std::string s;
+    start = bench_now();
+    for (size_t i = 0; i < BENCH_STRING_OPS; i++)
+    {
+        s.push_back((char)('a' + i % 26));
+    }
+    bench_report("push_back", bench_now() - start, BENCH_STRING_OPS);
+    bad += s.size() != BENCH_STRING_OPS || s.find("xyzab") != 23;
+
+    printf("  %ld mismatches\n", bad);
+}
@@ -0,0 +1,115 @@
+/**
+ * @file vector_bench.cc
+ * @author Seth McBee
+ * @date 2026-10-19
+ * @brief std::vector growth benchmark.
+ */
+
+#include <globals.h>
+
+#include <stdio.h>
+
+#include <vector>
+
+#include <bench/bench.h>
+
+static const size_t BENCH_VECTOR_OPS = 1000000;
+
+// Counts the work done on its behalf.
+static size_t record_builds;
+static size_t record_copies;
+static size_t record_moves;
+
+struct Bench_Record
+{
+    uint64_t key;
+    uint64_t payload[7];
+
+    Bench_Record()
+    {
+        key = 0;
+        record_builds++;
+    }
+
+    explicit Bench_Record(uint64_t k)
+    {
+        key = k;
+        record_builds++;
+    }
+
+    Bench_Record(const Bench_Record& other)
+    {
+        key = other.key;
+        record_copies++;
+    }
+
+    Bench_Record(Bench_Record&& other) noexcept
+    {
+        key = other.key;
+        record_moves++;
+    }
+};
+
+void bench_vector()
+{
+    volatile size_t sink = 0;
+
+    uint64_t start = bench_now();
+    {
+        std::vector<uint64_t> v;
+        for (size_t i = 0; i < BENCH_VECTOR_OPS; i++)
+        {
+            v.push_back(i);
+        }
+        sink += v.size();
+    }
+    uint64_t grow = bench_now() - start;
+
+    start = bench_now();
+    {
+        std::vector<uint64_t> v;
+        v.reserve(BENCH_VECTOR_OPS);
+        for (size_t i = 0; i < BENCH_VECTOR_OPS; i++)
+        {
+            v.push_back(i);
+        }
+        sink += v.size();
+    }
+    uint64_t reserved = bench_now() - start;
+
+    start = bench_now();
+    {
+        std::vector<Bench_Record> v;
+        for (size_t i = 0; i < BENCH_VECTOR_OPS; i++)
+        {
+            v.emplace_back(i);
+        }
+        sink += v.size();
+    }
+    uint64_t records = bench_now() - start;
+
+    // Shrinking and regrowing within capacity should build only the
+    // regrown elements.
+    size_t builds = record_builds;
+    start = bench_now();
+    {
+        std::vector<Bench_Record> v(1000);
+        for (size_t i = 0; i < 1000; i++)
+        {
+            v.resize(i);
+            v.resize(1000);
+        }
+        sink += v.capacity();
+    }
+    uint64_t resize = bench_now() - start;
+    builds = record_builds - builds;
+
+    bench_report("push_back uint64_t", grow, BENCH_VECTOR_OPS);
+    bench_report("push_back uint64_t, reserved", reserved, BENCH_VECTOR_OPS);
+    bench_report("emplace_back 64-byte record", records, BENCH_VECTOR_OPS);
+    bench_report("resize within capacity", resize, 2000);
+    printf("  records: %ld built, %ld copied, %ld moved\n", record_builds,
+           record_copies, record_moves);
+    printf("  resize: %ld constructions, expected %ld\n", builds,
+           1000 + 1000 * 1001 / 2);
+}
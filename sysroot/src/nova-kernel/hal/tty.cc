@@ -40,6 +40,18 @@ static ssize_t tty_write(const void *s, size_t n)
     return ( ext_write(s, n) );
 }
 
+// Hands out buffered input up to and including the next newline.
+static ssize_t tty_read_line(char* str, size_t n)
+{
+    size_t line = ring_find(tty_ins, '\n');
+    if (line < tty_ins->len)
+    {
+        line++;
+    }
+
+    return (ring_read(tty_ins, str, line < n ? line : n));
+}
+
 // Reads data.
 static ssize_t tty_read(void *s, size_t n)
 {
@@ -47,7 +59,6 @@ static ssize_t tty_read(void *s, size_t n)
 
     char c;
     char* str = (char*)s;
-    size_t len = 0;
 
     // Flush stdout if the input stream is stdin.
     if (tty_ins == stdin)
@@ -58,30 +69,14 @@ static ssize_t tty_read(void *s, size_t n)
     // Check if the stream still holds data.
     if (tty_ins->len > 0)
     {
-        c = rgetc(tty_ins);
-        for (len = 0; len < n && c != EOF; len++)
-        {
-            str[len] = c;
-
-            if (c == '\n')
-            {
-                break;
-            }
-
-            c = rgetc(tty_ins);
-        }
-
-        if (len == n && c != EOF)
-            rungetc(c, tty_ins);
-
-        return (len);
+        return (tty_read_line(str, n));
     }
 
     // Handle any awaiting keyboard data.
     while (ps2_keyboard_stream->len == 0)
         ; // Wait.
     c = rgetc(ps2_keyboard_stream);
-    while (tty_in_len < tty_in_file.max_len)
+    while (tty_in_len < sizeof(tty_in_str) - 1)
     {
         // Handle EOF.
         if (c == EOF)
@@ -135,31 +130,11 @@ static ssize_t tty_read(void *s, size_t n)
     }
 
     // Copy data to stream.
-    for (size_t i = 0; i < tty_in_len; i++)
-    {
-        c = tty_in_str[i];
-        rputc(c, tty_ins);
-    }
+    ring_write(tty_ins, tty_in_str, tty_in_len);
     tty_in_len = 0;
 
     // Pass data.
-    c = rgetc(tty_ins);
-    for (len = 0; len < n && c != EOF; len++)
-    {
-        str[len] = c;
-
-        if (c == '\n')
-        {
-            break;
-        }
-
-        c = rgetc(tty_ins);
-    }
-
-    if (len == n)
-        rungetc(c, tty_ins);
-
-    return (len);
+    return (tty_read_line(str, n));
 }
 
 void tty_init(void)
@@ -168,7 +143,7 @@ void tty_init(void)
     tty_out_file.buf = tty_out_buf;
     tty_out_file.pos = 0;
     tty_out_file.len = 0;
-    tty_out_file.max_len = 10000;
+    tty_out_file.max_len = sizeof(tty_out_buf);
     tty_out_file.buf_mode = _IOLBF;
     tty_out_file.io_mode = _IOO;
     tty_out_file.write = tty_write;
@@ -177,9 +152,9 @@ void tty_init(void)
     tty_in_file.buf = tty_in_buf;
     tty_in_file.pos = 0;
     tty_in_file.len = 0;
-    tty_in_file.max_len = 10000;
+    tty_in_file.max_len = sizeof(tty_in_buf);
     tty_in_file.buf_mode = _IOLBF;
-    tty_in_file.io_mode = _IOO;
+    tty_in_file.io_mode = _IOI;
     tty_in_file.read = tty_read;
     tty_ins = &tty_in_file;
 
@@ -13,8 +13,11 @@
 #include <list>
 #include <map>
 #include <memory>
+#include <memory_resource>
 #include <mutex>
 #include <stack>
+#include <string>
+#include <string_view>
 #include <thread>
 #include <tuple>
 #include <type_traits>
@@ -24,15 +27,20 @@
 #include <stdlib.h>
 
 #include <kernel.h>
+#include <bench/bench.h>
 #include <drivers/graphics/vga_text.h>
 #include <drivers/input/ps2_keyboard.h>
 #include <hal/tty.h>
 #include <liballoc/liballoc.h>
+#include <mm/heap.h>
+#include <mm/heap_prof.h>
+#include <mm/slab.h>
 #include <proc/process.h>
 #include <proc/thread.h>
 
 #ifdef ARCH_X86_64
 #include <arch/x86_64/cpu.h>
+#include <arch/x86_64/cpu_features.h>
 #include <arch/x86_64/gdt.h>
 #include <arch/x86_64/thread_state.h>
 #include <arch/x86_64/memory/pmm.h>
@@ -128,7 +136,7 @@ void kernel_start()
     stderr = tty_outs;
 
     // Set up scheduler and run main kernel process.
-    null_thread = new Thread;
+    null_thread = thread_alloc();
     current_thread = null_thread;
     kernel_thread = thread_spawn((void*)kernel_main);
     thread_switch(kernel_thread);
@@ -139,23 +147,47 @@ void kernel_start()
     kernel_halt();
 }
 
+// Reads a line of shell input into buf and returns it without the
+// whitespace around it. The view points into buf.
+static std::string_view shell_read_line(char* buf, size_t n)
+{
+    fgets(buf, n, stdin);
+
+    std::string_view line(buf);
+    size_t first = line.find_first_not_of(" \t\r\n");
+    if (first == std::string_view::npos)
+    {
+        return (std::string_view());
+    }
+    size_t last = line.find_last_not_of(" \t\r\n");
+    return (line.substr(first, last - first + 1));
+}
+
 void kernel_main()
 {
     kernel_test();
 
-    char s[1000];
-    const char user[] = "kernel@nova:";
-    const char dir[] = "/";
+    char line[1000];
+    const std::string_view user = "kernel@nova:";
+    std::string dir = "/";
+
+    // Scratch memory for a single command, dropped once it finishes.
+    char scratch[512];
+    std::pmr::monotonic_buffer_resource cmd_arena(scratch, sizeof(scratch));
 
     // Kernel loop.
     while (1)
     {
-        printf("%s%s$ ", user, dir);
+        cmd_arena.release();
+
+        fputs(user, stdout);
+        fputs(dir, stdout);
+        fputs("$ ", stdout);
         fflush(stdout);
 
         // Get user input.
-        scanf("%s", s);
-        if (strcmp(s, "module") == 0)
+        std::string_view cmd = shell_read_line(line, sizeof(line));
+        if (cmd == "module")
         {
             static char* module_page = nullptr;
 
@@ -171,7 +203,7 @@ void kernel_main()
             kernel_write(module_page, mod_len);
             puts("");
         }
-        else if (strcmp(s, "mem") == 0)
+        else if (cmd == "mem")
         {
             float conversion = 4096.0 / 1024.0 / 1024.0;
             float free_memory = ((float)pmm_frames_free) * conversion;
@@ -183,18 +215,18 @@ void kernel_main()
             printf("Free memory:     %fMiB\n", free_memory);
             printf("Used memory:     %fMiB\n", used_memory);
         }
-        else if (strcmp(s, "vector") == 0)
+        else if (cmd == "vector")
         {
             float n;
             printf("size: ");
             scanf("%f", &n);
-            std::vector<uint8_t> v;
+            std::pmr::vector<uint8_t> v(&cmd_arena);
             v.resize((size_t)n);
             for (auto& a : v)
                 a = 4;
             printf("done\n");
         }
-        else if (strcmp(s, "malloc") == 0)
+        else if (cmd == "malloc")
         {
             float mb;
             printf("mb: ");
@@ -203,29 +235,29 @@ void kernel_main()
             void* discard = malloc(bytes);
             printf("address: %ld\n", (size_t)discard);
         }
-        else if (strcmp(s, "free") == 0)
+        else if (cmd == "free")
         {
             size_t addr;
             printf("addr: ");
             scanf("%ld", &addr);
             free((void*)addr);
         }
-        else if (strcmp(s, "timer") == 0)
+        else if (cmd == "timer")
         {
             auto start = *&irq_pit_count;
-            scanf("%s", s);
+            shell_read_line(line, sizeof(line));
             auto end = *&irq_pit_count;
 
             auto ms = ticks_to_ms(end - start);
             printf("time: %d ms\n", ms);
         }
-        else if (strcmp(s, "ticks") == 0)
+        else if (cmd == "ticks")
         {
             auto ticks = irq_pit_count;
             printf("ticks: %d\n", ticks);
             printf("uptime: %f sec\n", (double)ticks_to_ms(ticks) / 1000);
         }
-        else if (strcmp(s, "sleep") == 0)
+        else if (cmd == "sleep")
         {
             float sec;
             printf("sec: ");
@@ -243,11 +275,50 @@ void kernel_main()
             wait_ms(whole * 1000);
             printf("%fs.\n", sec);
         }
-        else if (strcmp(s, "date") == 0)
+        else if (cmd == "date")
         {
             print_date();
             puts("");
         }
+        else if (cmd == "heap")
+        {
+            heap_info();
+        }
+        else if (cmd == "heapprof")
+        {
+            printf("on, off or report: ");
+            fflush(stdout);
+            std::string_view mode = shell_read_line(line, sizeof(line));
+            if (mode == "on")
+            {
+                if (!heap_prof_start())
+                {
+                    printf("Not enough memory for the profiler.\n");
+                }
+            }
+            else if (mode == "off")
+            {
+                heap_prof_stop();
+            }
+            else
+            {
+                heap_prof_report(10);
+            }
+        }
+        else if (cmd == "slabinfo")
+        {
+            slab_info();
+        }
+        else if (cmd == "cpuinfo")
+        {
+            cpu_features_print();
+        }
+        else if (cmd == "bench")
+        {
+            printf("name: ");
+            fflush(stdout);
+            bench_run(shell_read_line(line, sizeof(line)));
+        }
         else
         {
             printf("Command not recognized.\n");
@@ -290,6 +361,12 @@ int kernel_print(const char *s)
     return (ret);
 }
 
+int kernel_print(std::string_view s)
+{
+    int ret = kernel_write(s.data(), s.size());
+    return (ret);
+}
+
 int kernel_log(const char *s)
 {
     int ret = 0;
@@ -74,6 +74,19 @@ void kernel_halt(void);
 
 #ifdef __cplusplus
 }
+
+#include <string_view>
+
+/**
+ * @brief Writes a string using kernel_write(). The string needn't be
+ * null-terminated, so part of a larger one can be written as it is.
+ *
+ * @param s Data to be written.
+ *
+ * @return Number of bytes written, or an error code.
+ */
+int kernel_print(std::string_view s);
+
 #endif
 
 /**
@@ -2,14 +2,19 @@
 
 #include <globals.h>
 
+#include <string.h>
+
 /**  Durand's Ridiculously Amazing Super Duper Memory functions.  */
 
 //#define DEBUG
 
 #define LIBALLOC_MAGIC	0xc001c0de
-#define MAXCOMPLETE		5
+#define HIGHWATER		(4 * 1024 * 1024)	//< Default cached bytes that trigger a release.
+#define LOWWATER		(512 * 1024)		//< Default cached bytes kept after a release.
+#define DECAYTIME		1000				//< Default decay period in milliseconds.
 #define MAXEXP	32
 #define MINEXP	8
+#define ALIGNMENT	16		//< Alignment of every block; sizeof(struct boundary_tag) is a multiple.
 
 #define MODE_BEST			0
 #define MODE_INSTANT		1
@@ -21,7 +26,16 @@
 #endif
 
 struct boundary_tag* l_freePages[MAXEXP];		//< Allowing for 2^MAXEXP blocks
-int 				 l_completePages[MAXEXP];	//< Allowing for 2^MAXEXP blocks
+
+static size_t l_allocatedBytes = 0;		//< Memory currently taken from the system.
+static size_t l_cachedBytes = 0;		//< Memory in whole free blocks.
+static size_t l_returnedBytes = 0;		//< Memory given back to the system so far.
+static size_t l_idleBytes = 0;			//< Least cached memory since the last decay.
+static unsigned long l_decayStart = 0;	//< Time of the last decay.
+
+static size_t l_highWater = HIGHWATER;
+static size_t l_lowWater = LOWWATER;
+static unsigned long l_decayTime = DECAYTIME;
 
 
 #ifdef DEBUG
@@ -51,55 +65,8 @@ static inline int getexp( unsigned int size )
         return -1;	// Smaller than the quantum.
     }
 
-
-    int shift = MINEXP;
-
-    while ( shift < MAXEXP )
-    {
-        if ( (1<<shift) > size ) break;
-        shift += 1;
-    }
-
-#ifdef DEBUG
-    //printf("getexp returns %i (%i bytes) for %i size\n", shift - 1, (1<<(shift -1)), size );
-#endif
-
-    return shift - 1;
-}
-
-
-static void* 	liballoc_memset(void* s, int c, size_t n)
-{
-    int i;
-    for ( i = 0; i < n ; i++)
-        ((char*)s)[i] = c;
-
-    return s;
-}
-
-static void* 	liballoc_memcpy(void* s1, const void* s2, size_t n)
-{
-    char *cdest;
-    char *csrc;
-    unsigned int *ldest = (unsigned int*)s1;
-    unsigned int *lsrc  = (unsigned int*)s2;
-
-    while ( n >= sizeof(unsigned int) )
-    {
-        *ldest++ = *lsrc++;
-        n -= sizeof(unsigned int);
-    }
-
-    cdest = (char*)ldest;
-    csrc  = (char*)lsrc;
-
-    while ( n > 0 )
-    {
-        *cdest++ = *csrc++;
-        n -= 1;
-    }
-
-    return s1;
+    // Index of the highest set bit (bsr).
+    return 31 - __builtin_clz( size );
 }
 
 
@@ -116,7 +83,7 @@ static void dump_array()
 
     for ( i = 0; i < MAXEXP; i++ )
     {
-        printf("%.2i(%i): ",i, l_completePages[i] );
+        printf("%.2i: ",i );
 
         tag = l_freePages[ i ];
         while ( tag != NULL )
@@ -229,6 +196,88 @@ static inline struct boundary_tag* split_tag( struct boundary_tag* tag )
 }
 
 
+/** Gives the slack after a block's requested size back as a free block,
+ *  melted into a free right neighbour. Must hold the lock.
+ */
+static inline void trim_tag( struct boundary_tag *tag )
+{
+    struct boundary_tag *new_tag;
+    unsigned int remainder = tag->real_size - tag->size - sizeof( struct boundary_tag ) * 2;
+
+    if ( ((int)(remainder) <= 0) || (getexp( remainder ) < 0) ) return;
+
+    new_tag = split_tag( tag );
+
+    if ( (new_tag->split_right != NULL) && (new_tag->split_right->index >= 0) )
+    {
+        remove_tag( new_tag );
+        absorb_right( new_tag );
+        insert_tag( new_tag, -1 );
+    }
+}
+
+
+/** Takes a whole block out of the cached memory count. */
+static inline void uncache( unsigned int real_size )
+{
+    l_cachedBytes -= real_size;
+    if ( l_cachedBytes < l_idleBytes ) l_idleBytes = l_cachedBytes;
+}
+
+/** Returns whole free blocks to the system, largest first, until no more
+ *  than 'keep' bytes of them remain. Must hold the lock.
+ */
+static void release_complete( size_t keep )
+{
+    int index;
+    struct boundary_tag *tag;
+    struct boundary_tag *next;
+
+    for ( index = MAXEXP - 1; (index >= MINEXP) && (l_cachedBytes > keep); index-- )
+    {
+        tag = l_freePages[ index ];
+        while ( (tag != NULL) && (l_cachedBytes > keep) )
+        {
+            next = tag->next;
+
+            if ( (tag->split_left == NULL) && (tag->split_right == NULL) )
+            {
+                unsigned int pages = tag->real_size / l_pageSize;
+
+                if ( (tag->real_size % l_pageSize) != 0 ) pages += 1;
+                if ( pages < l_pageCount ) pages = l_pageCount;
+
+                remove_tag( tag );
+                uncache( tag->real_size );
+                l_allocatedBytes -= pages * l_pageSize;
+                l_returnedBytes += pages * l_pageSize;
+
+                liballoc_free( tag, pages );
+            }
+
+            tag = next;
+        }
+    }
+}
+
+/** Memory that stayed cached for a whole decay period is idle. Half of the
+ *  idle memory above the low watermark is returned each period, so that
+ *  brief churn keeps its blocks while a past spike drains away. Must hold
+ *  the lock.
+ */
+static void decay_complete( void )
+{
+    unsigned long now = liballoc_time();
+
+    if ( (now - l_decayStart) < l_decayTime ) return;
+
+    if ( l_idleBytes > l_lowWater )
+        release_complete( l_cachedBytes - (l_idleBytes - l_lowWater) / 2 );
+
+    l_decayStart = now;
+    l_idleBytes = l_cachedBytes;
+}
+
 // ***************************************************************
 
 
@@ -254,6 +303,8 @@ static struct boundary_tag* allocate_new_tag( unsigned int size )
 
     if ( tag == NULL ) return NULL;	// uh oh, we ran out of memory.
 
+    l_allocatedBytes += pages * l_pageSize;
+
     tag->magic 		= LIBALLOC_MAGIC;
     tag->size 		= size;
     tag->real_size 	= pages * l_pageSize;
@@ -278,12 +329,15 @@ static struct boundary_tag* allocate_new_tag( unsigned int size )
 
 
 
-void *malloc(size_t size)
+void *PREFIX(malloc)(size_t size)
 {
     int index;
     void *ptr;
     struct boundary_tag *tag = NULL;
 
+    // Rounding sizes keeps every split tag, and so every block, aligned.
+    size = (size + ALIGNMENT - 1) & ~(size_t)(ALIGNMENT - 1);
+
     liballoc_lock();
 
     if ( l_initialized == 0 )
@@ -294,30 +348,37 @@ void *malloc(size_t size)
         for ( index = 0; index < MAXEXP; index++ )
         {
             l_freePages[index] = NULL;
-            l_completePages[index] = 0;
         }
         l_initialized = 1;
     }
 
+    decay_complete();
+
     index = getexp( size ) + MODE;
     if ( index < MINEXP ) index = MINEXP;
 
 
-    // Find one big enough.
-    tag = l_freePages[ index ];				// Start at the front of the list.
-    while ( tag != NULL )
+    // Find one big enough, moving on to the lists of larger blocks so that
+    // cached whole blocks get reused.
+    for ( ; index < MAXEXP; index++ )
     {
-        // If there's enough space in this tag.
-        if ( (tag->real_size - sizeof(struct boundary_tag))
-                >= (size + sizeof(struct boundary_tag) ) )
+        tag = l_freePages[ index ];			// Start at the front of the list.
+        while ( tag != NULL )
         {
+            // If there's enough space in this tag.
+            if ( (tag->real_size - sizeof(struct boundary_tag))
+                    >= (size + sizeof(struct boundary_tag) ) )
+            {
 #ifdef DEBUG
-            //printf("Tag search found %i >= %i\n",(tag->real_size - sizeof(struct boundary_tag)), (size + sizeof(struct boundary_tag) ) );
+                //printf("Tag search found %i >= %i\n",(tag->real_size - sizeof(struct boundary_tag)), (size + sizeof(struct boundary_tag) ) );
 #endif
-            break;
+                break;
+            }
+
+            tag = tag->next;
         }
 
-        tag = tag->next;
+        if ( tag != NULL ) break;
     }
 
 
@@ -337,7 +398,7 @@ void *malloc(size_t size)
         remove_tag( tag );
 
         if ( (tag->split_left == NULL) && (tag->split_right == NULL) )
-            l_completePages[ index ] -= 1;
+            uncache( tag->real_size );
     }
 
     // We have a free page.  Remove it from the free pages list.
@@ -393,7 +454,7 @@ void *malloc(size_t size)
 
 
 
-void free(void *ptr)
+void PREFIX(free)(void *ptr)
 {
     int index;
     struct boundary_tag *tag;
@@ -443,39 +504,19 @@ void free(void *ptr)
     index = getexp( tag->real_size - sizeof(struct boundary_tag) );
     if ( index < MINEXP ) index = MINEXP;
 
-    // A whole, empty block?
+    insert_tag( tag, index );
+
+    // A whole, empty block? Keep it around for reuse, unless too much
+    // memory is standing by already.
     if ( (tag->split_left == NULL) && (tag->split_right == NULL) )
     {
+        l_cachedBytes += tag->real_size;
 
-        if ( l_completePages[ index ] == MAXCOMPLETE )
-        {
-            // Too many standing by to keep. Free this one.
-            unsigned int pages = tag->real_size / l_pageSize;
-
-            if ( (tag->real_size % l_pageSize) != 0 ) pages += 1;
-            if ( pages < l_pageCount ) pages = l_pageCount;
-
-            liballoc_free( tag, pages );
-
-#ifdef DEBUG
-            //l_allocated -= pages * l_pageSize;
-            //printf("Resource freeing %x of %i pages\n", tag, pages );
-            //dump_array();
-#endif
-
-            liballoc_unlock();
-            return;
-        }
-
-
-        l_completePages[ index ] += 1;	// Increase the count of complete pages.
+        if ( l_cachedBytes > l_highWater )
+            release_complete( l_lowWater );
     }
 
-
-    // ..........
-
-
-    insert_tag( tag, index );
+    decay_complete();
 
 #ifdef DEBUG
     //printf("Returning tag with %i bytes (requested %i bytes), which has exponent: %i\n", tag->real_size, tag->size, index );
@@ -488,46 +529,187 @@ void free(void *ptr)
 
 
 
-void* calloc(size_t nobj, size_t size)
+void* PREFIX(calloc)(size_t nobj, size_t size)
 {
     int real_size;
     void *p;
 
     real_size = nobj * size;
 
-    p = malloc( real_size );
+    p = PREFIX(malloc)( real_size );
+    if ( p == NULL ) return NULL;
 
-    liballoc_memset( p, 0, real_size );
+    memset( p, 0, real_size );
 
     return p;
 }
 
 
 
-void*   realloc(void *p, size_t size)
+void*   PREFIX(realloc)(void *p, size_t size)
 {
     void *ptr;
     struct boundary_tag *tag;
-    int real_size;
+    unsigned int real_size;
+    unsigned int pages;
+    unsigned int new_pages;
 
     if ( size == 0 )
     {
-        free( p );
+        PREFIX(free)( p );
         return NULL;
     }
-    if ( p == NULL ) return malloc( size );
+    if ( p == NULL ) return PREFIX(malloc)( size );
+
+    size = (size + ALIGNMENT - 1) & ~(size_t)(ALIGNMENT - 1);
+
+    liballoc_lock();
 
-    if ( liballoc_lock != NULL ) liballoc_lock();		// lockit
     tag = (struct boundary_tag*)((size_t)p - sizeof( struct boundary_tag ));
+
+    if ( tag->magic != LIBALLOC_MAGIC )
+    {
+        liballoc_unlock();
+        return NULL;
+    }
+
     real_size = tag->size;
-    if ( liballoc_unlock != NULL ) liballoc_unlock();
 
-    if ( real_size > size ) real_size = size;
+    // A free right neighbour joins the block, so that it can grow without
+    // moving and any slack goes back in one piece.
+    if ( (tag->split_right != NULL) && (tag->split_right->index >= 0) )
+        absorb_right( tag );
+
+    if ( (tag->real_size - sizeof(struct boundary_tag)) >= size )
+    {
+        tag->size = size;
+        trim_tag( tag );
+
+        liballoc_unlock();
+        return p;
+    }
+
+    // A whole block spans its own pages, which can be moved to a larger
+    // region instead of copying their contents.
+    if ( (tag->split_left == NULL) && (tag->split_right == NULL) )
+    {
+        pages = tag->real_size / l_pageSize;
+        new_pages = (size + sizeof(struct boundary_tag) + l_pageSize - 1) / l_pageSize;
+
+        ptr = liballoc_remap( tag, pages, new_pages );
+        if ( ptr != NULL )
+        {
+            l_allocatedBytes += (new_pages - pages) * l_pageSize;
+
+            tag = (struct boundary_tag*)ptr;
+            tag->real_size = new_pages * l_pageSize;
+            tag->size = size;
+            trim_tag( tag );
+
+            liballoc_unlock();
+            return (void*)((size_t)tag + sizeof( struct boundary_tag ));
+        }
+    }
+
+    // Give back what was taken from the neighbour and move the block.
+    trim_tag( tag );
+
+    liballoc_unlock();
+
+    ptr = PREFIX(malloc)( size );
+    if ( ptr == NULL ) return NULL;
 
-    ptr = malloc( size );
-    liballoc_memcpy( ptr, p, real_size );
-    free( p );
+    memcpy( ptr, p, real_size );
+    PREFIX(free)( p );
 
     return ptr;
 }
 
+
+
+
+
+void* PREFIX(memalign)(size_t align, size_t size)
+{
+    void *ptr;
+    struct boundary_tag *tag;
+    struct boundary_tag *new_tag;
+    size_t aligned;
+
+    if ( align <= ALIGNMENT ) return PREFIX(malloc)( size );
+
+    size = (size + ALIGNMENT - 1) & ~(size_t)(ALIGNMENT - 1);
+
+    // Room for the block, the alignment slack and a tag for the gap.
+    ptr = PREFIX(malloc)( size + align + sizeof(struct boundary_tag) );
+    if ( ptr == NULL ) return NULL;
+
+    aligned = ((size_t)ptr + align - 1) & ~(align - 1);
+    if ( aligned == (size_t)ptr ) return ptr;
+
+    // The gap in front must be able to hold a tag of its own.
+    if ( (aligned - (size_t)ptr) < sizeof(struct boundary_tag) ) aligned += align;
+
+    liballoc_lock();
+
+    tag = (struct boundary_tag*)((size_t)ptr - sizeof( struct boundary_tag ));
+    new_tag = (struct boundary_tag*)(aligned - sizeof( struct boundary_tag ));
+
+    new_tag->magic = LIBALLOC_MAGIC;
+    new_tag->size = size;
+    new_tag->real_size = tag->real_size - ((size_t)new_tag - (size_t)tag);
+    new_tag->index = -1;
+    new_tag->next = NULL;
+    new_tag->prev = NULL;
+
+    new_tag->split_left = tag;
+    new_tag->split_right = tag->split_right;
+    if ( new_tag->split_right != NULL ) new_tag->split_right->split_left = new_tag;
+    tag->split_right = new_tag;
+
+    tag->real_size -= new_tag->real_size;
+    tag->size = 0;
+
+    // Give back the slack after the block, as malloc does.
+    unsigned int remainder = new_tag->real_size - size - sizeof( struct boundary_tag ) * 2;
+    if ( ((int)(remainder) > 0) && (getexp( remainder ) >= 0) )
+        split_tag( new_tag );
+
+    liballoc_unlock();
+
+    // The gap in front becomes a free block of its own.
+    PREFIX(free)( ptr );
+
+    return (void*)aligned;
+}
+
+
+
+void PREFIX(tune)(size_t high, size_t low, unsigned long decay)
+{
+    liballoc_lock();
+
+    l_highWater = high;
+    l_lowWater = (low < high) ? low : high;
+    l_decayTime = decay;
+
+    if ( l_cachedBytes > l_highWater )
+        release_complete( l_lowWater );
+
+    liballoc_unlock();
+}
+
+
+
+void PREFIX(stats)(struct liballoc_stats *stats)
+{
+    liballoc_lock();
+
+    stats->allocated = l_allocatedBytes;
+    stats->cached = l_cachedBytes;
+    stats->returned = l_returnedBytes;
+    stats->high = l_highWater;
+    stats->low = l_lowWater;
+
+    liballoc_unlock();
+}
@@ -30,6 +30,19 @@ struct	boundary_tag
 
 
 
+/** Memory accounting reported by PREFIX(stats). */
+struct liballoc_stats
+{
+    size_t allocated;			//< Memory currently taken from the system.
+    size_t cached;				//< Memory in whole free blocks kept for reuse.
+    size_t returned;			//< Memory given back to the system so far.
+    size_t high;				//< Cached memory that triggers a release.
+    size_t low;					//< Cached memory kept after a release.
+};
+
+
+
+
 /** This function is supposed to lock the memory data structures. It
  * could be as simple as disabling interrupts or acquiring a spinlock.
  * It's up to you to decide.
@@ -66,12 +79,45 @@ extern void* liballoc_alloc(int);
  */
 extern int liballoc_free(void*,int);
 
+/** This moves the pages of a block returned by liballoc_alloc to a new
+ * region of 'new_pages' pages without copying them. The block keeps its
+ * contents at the start of the new region, and its old pages are gone.
+ *
+ * \return NULL if the block could not be moved; it is left untouched.
+ * \return A pointer to the new region.
+ */
+extern void* liballoc_remap(void*,int,int);
+
+/** This returns a monotonic time in milliseconds, used to decay the
+ * cache of whole free blocks.
+ */
+extern unsigned long liballoc_time();
+
+
+
+/** The standard functions are provided by the heap front-end in
+ * mm/heap.cc, which only falls back to these for larger blocks.
+ */
+#define PREFIX(func)		l_ ## func
 
+void     *PREFIX(malloc)(size_t);				//< The standard function.
+void     *PREFIX(realloc)(void *, size_t);		//< The standard function.
+void     *PREFIX(calloc)(size_t, size_t);		//< The standard function.
+void      PREFIX(free)(void *);					//< The standard function.
+
+/** Allocates a block aligned to 'align', which must be a power of two.
+ * The gap in front of the block is split off and freed.
+ */
+void     *PREFIX(memalign)(size_t align, size_t size);
+
+/** Sets how much memory in whole free blocks is kept for reuse: above
+ * 'high' bytes, blocks are released until 'low' bytes remain, and idle
+ * memory above 'low' decays every 'decay' milliseconds.
+ */
+void      PREFIX(tune)(size_t high, size_t low, unsigned long decay);
 
-void     *malloc(size_t);				//< The standard function.
-void     *realloc(void *, size_t);		//< The standard function.
-void     *calloc(size_t, size_t);		//< The standard function.
-void      free(void *);					//< The standard function.
+/** Reports memory accounting. */
+void      PREFIX(stats)(struct liballoc_stats *stats);
 
 
 #ifdef __cplusplus
@@ -10,6 +10,7 @@
 #include <liballoc/liballoc.h>
 
 #ifdef ARCH_X86_64
+#include <arch/x86_64/devices/pit.h>
 #include <arch/x86_64/memory/paging.h>
 #include <arch/x86_64/memory/vmm.h>
 #endif // ARCH_X86_64
@@ -44,17 +45,30 @@ extern "C" void* liballoc_alloc(int pages)
     return (ret);
 }
 
-// NOTE: Is not currently freeing pages.
 extern "C" int liballoc_free(void* page,int pages)
 {
-    uint8_t* p = (uint8_t*)page;
+    vmm_pages_free_kernel(page, pages);
+    return (0);
+}
 
-    while (pages > 0)
-    {
-        vmm_page_free_kernel(p);
-        p += PAGE_SIZE;
-        pages--;
-    }
+extern "C" void* liballoc_remap(void* page, int pages, int new_pages)
+{
+    if (new_pages < pages)
+        return (NULL);
 
-    return (0);
+    void* ret = vmm_pages_reserve_kernel(new_pages);
+    if (ret == NULL)
+        return (NULL);
+
+    // Move the old frames to the front and back the rest with new ones.
+    vmm_pages_move_kernel(ret, page, pages);
+    vmm_pages_map_kernel((char*)ret + pages * PAGE_SIZE, new_pages - pages);
+    vmm_pages_release_kernel(page, pages);
+
+    return (ret);
+}
+
+extern "C" unsigned long liballoc_time()
+{
+    return ((unsigned long)((float)irq_pit_count * 1000.0f / PIT_REAL_FREQ));
 }
@@ -0,0 +1,45 @@
+/**
+ * @file errno.h
+ * @author Seth McBee
+ * @date 2026-10-19
+ * @brief C standard library error numbers.
+ */
+
+#ifndef ERRNO_H
+#define ERRNO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Argument outside the domain of a function.
+ */
+#define EDOM 33
+
+/**
+ * @brief Result not representable.
+ */
+#define ERANGE 34
+
+/**
+ * @brief Invalid argument.
+ */
+#define EINVAL 22
+
+/**
+ * @brief Not enough memory.
+ */
+#define ENOMEM 12
+
+/**
+ * @brief Last error reported by a library function. Shared by all
+ * threads for now.
+ */
+extern int errno;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ERRNO_H */
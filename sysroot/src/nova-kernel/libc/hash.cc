@@ -0,0 +1,224 @@
+/**
+ * @file hash.cc
+ * @author Seth McBee
+ * @date 2026-10-19
+ * @brief Checksums and non-cryptographic hashing.
+ */
+
+#include <globals.h>
+
+#include <hash.h>
+#include <string.h>
+
+#ifdef ARCH_X86_64
+#include <arch/x86_64/cpu_features.h>
+#endif // ARCH_X86_64
+
+// CRC32C, with the reflected Castagnoli polynomial. Slicing-by-8 folds
+// eight bytes per step through eight tables, table k holding the effect
+// of a byte followed by k zero bytes.
+
+#define CRC32C_POLY 0x82f63b78
+
+struct Crc32c_Tables
+{
+    uint32_t t[8][256];
+};
+
+static constexpr Crc32c_Tables crc32c_make_tables()
+{
+    Crc32c_Tables tables = {};
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc >> 1) ^ ((crc & 1) ? CRC32C_POLY : 0);
+        }
+        tables.t[0][i] = crc;
+    }
+    for (int k = 1; k < 8; k++)
+    {
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t prev = tables.t[k - 1][i];
+            tables.t[k][i] = (prev >> 8) ^ tables.t[0][prev & 0xff];
+        }
+    }
+    return (tables);
+}
+
+static constexpr Crc32c_Tables crc32c_tables = crc32c_make_tables();
+
+// Loads that may be unaligned. The CPU is little-endian.
+static inline uint32_t hash_read32(const uint8_t* p)
+{
+    uint32_t val;
+    memcpy(&val, p, sizeof(val));
+    return (val);
+}
+
+static inline uint64_t hash_read64(const uint8_t* p)
+{
+    uint64_t val;
+    memcpy(&val, p, sizeof(val));
+    return (val);
+}
+
+// Both variants work on the inverted checksum; crc32c() inverts it.
+static uint32_t crc32c_update_soft(uint32_t crc, const uint8_t* p, size_t n)
+{
+    const uint32_t (*t)[256] = crc32c_tables.t;
+
+    for (; n > 0 && (size_t)p % 8 != 0; n--, p++)
+    {
+        crc = (crc >> 8) ^ t[0][(crc ^ *p) & 0xff];
+    }
+
+    for (; n >= 8; n -= 8, p += 8)
+    {
+        uint32_t lo = crc ^ hash_read32(p);
+        uint32_t hi = hash_read32(p + 4);
+        crc = t[7][lo & 0xff] ^ t[6][(lo >> 8) & 0xff] ^
+              t[5][(lo >> 16) & 0xff] ^ t[4][lo >> 24] ^
+              t[3][hi & 0xff] ^ t[2][(hi >> 8) & 0xff] ^
+              t[1][(hi >> 16) & 0xff] ^ t[0][hi >> 24];
+    }
+
+    for (; n > 0; n--, p++)
+    {
+        crc = (crc >> 8) ^ t[0][(crc ^ *p) & 0xff];
+    }
+
+    return (crc);
+}
+
+#ifdef ARCH_X86_64
+
+// The crc32 instruction computes the same CRC eight bytes at a time.
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_update_sse42(uint32_t crc, const uint8_t* p, size_t n)
+{
+    for (; n > 0 && (size_t)p % 8 != 0; n--, p++)
+    {
+        crc = __builtin_ia32_crc32qi(crc, *p);
+    }
+
+    uint64_t crc64 = crc;
+    for (; n >= 8; n -= 8, p += 8)
+    {
+        crc64 = __builtin_ia32_crc32di(crc64, hash_read64(p));
+    }
+    crc = (uint32_t)crc64;
+
+    for (; n > 0; n--, p++)
+    {
+        crc = __builtin_ia32_crc32qi(crc, *p);
+    }
+
+    return (crc);
+}
+
+#endif // ARCH_X86_64
+
+static uint32_t (*crc32c_update)(uint32_t crc, const uint8_t* p, size_t n) =
+    crc32c_update_soft;
+
+#ifdef ARCH_X86_64
+CPU_DISPATCH(crc32c_update, crc32c_update_soft, 0, 0);
+CPU_DISPATCH(crc32c_update, crc32c_update_sse42, CPU_FEATURE_BIT(CPU_FEATURE_SSE4_2), 1);
+#endif // ARCH_X86_64
+
+uint32_t crc32c(uint32_t crc, const void* data, size_t n)
+{
+    return (~crc32c_update(~crc, (const uint8_t*)data, n));
+}
+
+uint32_t crc32c_soft(uint32_t crc, const void* data, size_t n)
+{
+    return (~crc32c_update_soft(~crc, (const uint8_t*)data, n));
+}
+
+// wyhash: each step multiplies two 64-bit words, each a block of input
+// xored with a secret or the running state, and folds the product. Inputs
+// of 48 bytes or more run three independent lanes.
+
+static const uint64_t hash_secret[4] =
+{
+    0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL,
+    0x4b33a62ed433d4a3ULL, 0x4d5a2da51de1aa47ULL
+};
+
+// One to three bytes, spread over the low 24 bits.
+static inline uint64_t hash_read_small(const uint8_t* p, size_t n)
+{
+    return (((uint64_t)p[0] << 16) | ((uint64_t)p[n >> 1] << 8) | p[n - 1]);
+}
+
+uint64_t hash_bytes(const void* data, size_t n, uint64_t seed)
+{
+    const uint8_t* p = (const uint8_t*)data;
+    uint64_t a;
+    uint64_t b;
+
+    seed ^= hash_mix(seed ^ hash_secret[0], hash_secret[1]);
+    if (n <= 16)
+    {
+        if (n >= 4)
+        {
+            // Two overlapping pairs of 4-byte loads cover 4 to 16 bytes.
+            size_t mid = (n >> 3) << 2;
+            a = ((uint64_t)hash_read32(p) << 32) | hash_read32(p + mid);
+            b = ((uint64_t)hash_read32(p + n - 4) << 32) |
+                hash_read32(p + n - 4 - mid);
+        }
+        else if (n > 0)
+        {
+            a = hash_read_small(p, n);
+            b = 0;
+        }
+        else
+        {
+            a = 0;
+            b = 0;
+        }
+    }
+    else
+    {
+        size_t i = n;
+        if (i >= 48)
+        {
+            uint64_t see1 = seed;
+            uint64_t see2 = seed;
+            do
+            {
+                seed = hash_mix(hash_read64(p) ^ hash_secret[1],
+                                hash_read64(p + 8) ^ seed);
+                see1 = hash_mix(hash_read64(p + 16) ^ hash_secret[2],
+                                hash_read64(p + 24) ^ see1);
+                see2 = hash_mix(hash_read64(p + 32) ^ hash_secret[3],
+                                hash_read64(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i >= 48);
+            seed ^= see1 ^ see2;
+        }
+
+        for (; i > 16; i -= 16, p += 16)
+        {
+            seed = hash_mix(hash_read64(p) ^ hash_secret[1],
+                            hash_read64(p + 8) ^ seed);
+        }
+
+        // The last 16 bytes, overlapping what came before.
+        a = hash_read64(p + i - 16);
+        b = hash_read64(p + i - 8);
+    }
+
+    a ^= hash_secret[1];
+    b ^= seed;
+    unsigned __int128 m = (unsigned __int128)a * b;
+    a = (uint64_t)m;
+    b = (uint64_t)(m >> 64);
+    return (hash_mix(a ^ hash_secret[0] ^ n, b ^ hash_secret[1]));
+}
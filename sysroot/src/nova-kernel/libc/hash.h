@@ -0,0 +1,66 @@
+/**
+ * @file hash.h
+ * @author Seth McBee
+ * @date 2026-10-19
+ * @brief Checksums and non-cryptographic hashing.
+ */
+
+#ifndef HASH_H
+#define HASH_H
+
+#include <globals.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Updates a CRC32C (Castagnoli) checksum with more data. Uses the
+ * SSE4.2 crc32 instruction when the CPU has it.
+ *
+ * Start with a crc of 0; passing the result of one call into the next
+ * gives the checksum of the data of both.
+ *
+ * @param crc Checksum of the data so far.
+ * @param data Data to add.
+ * @param n Number of bytes.
+ *
+ * @return Checksum including data.
+ */
+uint32_t crc32c(uint32_t crc, const void* data, size_t n);
+
+/// crc32c() computed with tables alone, on any CPU.
+uint32_t crc32c_soft(uint32_t crc, const void* data, size_t n);
+
+/**
+ * @brief Hashes a block of bytes to 64 bits, in the manner of wyhash. Fast
+ * and well mixed, but not resistant to deliberate collisions by anyone
+ * who can see the results.
+ *
+ * @param data Bytes to hash.
+ * @param n Number of bytes.
+ * @param seed Selects an unrelated hash function; 0 will do.
+ *
+ * @return Hash of the bytes.
+ */
+uint64_t hash_bytes(const void* data, size_t n, uint64_t seed);
+
+/// Multiplies a and b and folds the 128-bit product into 64 bits.
+static inline uint64_t hash_mix(uint64_t a, uint64_t b)
+{
+    unsigned __int128 m = (unsigned __int128)a * b;
+    return ((uint64_t)m ^ (uint64_t)(m >> 64));
+}
+
+/// Hashes a single 64-bit value, so that every input bit affects every
+/// output bit.
+static inline uint64_t hash_u64(uint64_t x)
+{
+    return (hash_mix(x ^ 0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL));
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HASH_H
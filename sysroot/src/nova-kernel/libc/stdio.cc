@@ -15,6 +15,7 @@
 #include <string.h>
 
 #include <kernel.h>
+#include <proc/thread.h>
 
 // printf() specifiers.
 #define WIDTH_ARG           -2
@@ -25,6 +26,10 @@
 #define LENGTH_WIDE         1
 #define LENGTH_DOUBLE       2
 
+// Longest %f precision, and room for the widest such conversion.
+#define PRINTF_PRECISION_MAX    64
+#define PRINTF_FLOAT_MAX        (312 + PRINTF_PRECISION_MAX)
+
 FILE* stdin;
 FILE* stdout;
 FILE* stderr;
@@ -48,7 +53,7 @@ int rgetc(FILE *stream)
     }
 
     // Get character.
-    ret = stream->buf[stream->pos];
+    ret = (unsigned char) stream->buf[stream->pos];
     stream->len--;
     stream->pos++;
     if (stream->pos == stream->max_len)
@@ -59,11 +64,8 @@ int rgetc(FILE *stream)
 
 int rputc(int c, FILE *stream)
 {
-    // Not thread-safe (needs a per-stream lock, maybe).
+    // The caller holds the stream lock.
     char* buf = (char*) stream->buf;
-    size_t pos = stream->pos;
-    size_t len = stream->len;
-    size_t max_len = stream->max_len;
 
     // Check if the stream is at maximum length.
     if (stream->len == stream->max_len)
@@ -71,36 +73,187 @@ int rputc(int c, FILE *stream)
         return (EOF);
     }
 
-    // Check if the buffer should wrap around.
-    if (pos + len >= max_len)
+    // The first free byte follows the data, wrapping around the end.
+    size_t tail = stream->pos + stream->len;
+    if (tail >= stream->max_len)
     {
-        size_t tmp_len = len + pos - max_len;
-        buf[pos + tmp_len] = c;
-    }
-    else
-    {
-        buf[pos + len] = c;
+        tail -= stream->max_len;
     }
+    buf[tail] = c;
 
     stream->len++;
 
     return (c);
 }
 
+size_t ring_write(FILE *stream, const void *src, size_t n)
+{
+    char* buf = (char*) stream->buf;
+    size_t max_len = stream->max_len;
+    size_t len = stream->len;
+
+    if (n > max_len - len)
+    {
+        n = max_len - len;
+    }
+
+    // Free space runs from the end of the data to the end of the buffer,
+    // then from the start of the buffer.
+    size_t tail = stream->pos + len;
+    if (tail >= max_len)
+    {
+        tail -= max_len;
+    }
+    size_t first = max_len - tail;
+    if (first > n)
+    {
+        first = n;
+    }
+
+    memcpy(&buf[tail], src, first);
+    memcpy(buf, (const char*) src + first, n - first);
+    stream->len = len + n;
+
+    return (n);
+}
+
 int rungetc(int c, FILE *stream)
 {
-    // Not thread-safe (needs a per-stream lock, maybe).
+    // The caller holds the stream lock.
+    char* buf = (char*) stream->buf;
 
-    rputc(c, stream);
+    if (stream->len == stream->max_len)
+    {
+        return (EOF);
+    }
 
-    // Move back position.
-    stream->pos--;
-    if (stream->pos == -1)
+    // The byte goes in front of the data, wrapping around the start.
+    if (stream->pos == 0)
+    {
         stream->pos = stream->max_len;
+    }
+    stream->pos--;
+    buf[stream->pos] = c;
+    stream->len++;
+
+    return (c);
+}
+
+size_t ring_read(FILE *stream, void *dst, size_t n)
+{
+    const char* buf = (const char*) stream->buf;
+    size_t max_len = stream->max_len;
+    size_t pos = stream->pos;
+
+    if (n > stream->len)
+    {
+        n = stream->len;
+    }
+
+    // Data runs from pos to the end of the buffer, then from the start.
+    size_t first = max_len - pos;
+    if (first > n)
+    {
+        first = n;
+    }
+
+    memcpy(dst, &buf[pos], first);
+    memcpy((char*) dst + first, buf, n - first);
+
+    pos += n;
+    if (pos >= max_len)
+    {
+        pos -= max_len;
+    }
+    stream->pos = pos;
+    stream->len -= n;
+
+    return (n);
+}
+
+size_t ring_find(FILE *stream, int c)
+{
+    const char* buf = (const char*) stream->buf;
+    size_t pos = stream->pos;
+    size_t len = stream->len;
+
+    size_t first = stream->max_len - pos;
+    if (first > len)
+    {
+        first = len;
+    }
+
+    const char* hit = (const char*) memchr(&buf[pos], c, first);
+    if (hit != NULL)
+    {
+        return (hit - &buf[pos]);
+    }
+
+    hit = (const char*) memchr(buf, c, len - first);
+    if (hit != NULL)
+    {
+        return (first + (hit - buf));
+    }
+
+    return (len);
+}
+
+void flockfile(FILE *stream)
+{
+    Thread* self = current_thread;
+
+    // Only the holder can find itself as the owner.
+    if (stream->lock && stream->lock_owner == self)
+    {
+        stream->lock_depth++;
+        return;
+    }
+
+    while (!__sync_bool_compare_and_swap(&stream->lock, 0, 1))
+    {
+        // The holder is another thread. With one CPU it only runs again
+        // once the timer preempts this one, so wait for that interrupt.
+        asm volatile ("hlt \n");
+    }
+    stream->lock_owner = self;
+    stream->lock_depth = 1;
+}
+
+int ftrylockfile(FILE *stream)
+{
+    Thread* self = current_thread;
+
+    if (stream->lock && stream->lock_owner == self)
+    {
+        stream->lock_depth++;
+        return (0);
+    }
+
+    if (!__sync_bool_compare_and_swap(&stream->lock, 0, 1))
+    {
+        return (EOF);
+    }
+    stream->lock_owner = self;
+    stream->lock_depth = 1;
 
     return (0);
 }
 
+void funlockfile(FILE *stream)
+{
+    if (!stream->lock || stream->lock_owner != current_thread)
+    {
+        return;
+    }
+
+    stream->lock_depth--;
+    if (stream->lock_depth == 0)
+    {
+        stream->lock_owner = NULL;
+        __sync_lock_release(&stream->lock);
+    }
+}
+
 void stdio_init(void)
 {
     // STUB: This currently sets up fake FILEs for use if no TTY
@@ -142,6 +295,15 @@ void stdio_init(void)
 }
 
 int fflush(FILE *stream)
+{
+    flockfile(stream);
+    int ret = fflush_unlocked(stream);
+    funlockfile(stream);
+
+    return (ret);
+}
+
+int fflush_unlocked(FILE *stream)
 {
     char* p = (char*) stream->buf;
     size_t pos = stream->pos;
@@ -166,18 +328,126 @@ int fflush(FILE *stream)
         return (EOF);
     }
 
-    // Check if the buffer wraps around.
-    if (pos + len >= max_len)
+    // The data may wrap around the end of the buffer.
+    if (pos + len > max_len)
     {
         size_t tmp_len = max_len - pos;
 
         stream->write(&p[pos], tmp_len);
-        len -= tmp_len;
+        stream->write(p, len - tmp_len);
+    }
+    else
+    {
+        stream->write(&p[pos], len);
     }
 
-    stream->write(&p[pos], len);
-    len = 0;
-    stream->len = len;
+    // Start over at the front, which leaves the most contiguous room.
+    stream->pos = 0;
+    stream->len = 0;
+
+    return (0);
+}
+
+// Appends a span to a stream's buffer, flushing whenever it fills.
+// Returns the number of bytes taken.
+static size_t stream_put(FILE *stream, const char *s, size_t n)
+{
+    size_t written = 0;
+
+    while (written < n)
+    {
+        written += ring_write(stream, s + written, n - written);
+
+        // Give up if a full buffer can't be drained.
+        if (stream->len == stream->max_len &&
+            (fflush_unlocked(stream) != 0 || stream->len == stream->max_len))
+        {
+            break;
+        }
+    }
+
+    return (written);
+}
+
+// Flushes a stream if its buffering mode asks for it after a write.
+static void stream_settle(FILE *stream, bool newline)
+{
+    if (stream->buf_mode == _IONBF || (stream->buf_mode == _IOLBF && newline))
+    {
+        fflush_unlocked(stream);
+    }
+}
+
+// Writes a span to a stream. Spans at least as large as the buffer gain
+// nothing from being copied through it, so they go straight to the device
+// once the data queued ahead of them is out. Returns the number of bytes
+// taken.
+static size_t stream_write(FILE *stream, const char *s, size_t n)
+{
+    size_t written;
+
+    if (stream->io_mode == _IOO && n >= stream->max_len)
+    {
+        if (fflush_unlocked(stream) != 0)
+        {
+            return (0);
+        }
+
+        ssize_t ret = stream->write(s, n);
+        written = (ret > 0) ? ret : 0;
+    }
+    else
+    {
+        written = stream_put(stream, s, n);
+        stream_settle(stream, memchr(s, '\n', written) != NULL);
+    }
+
+    return (written);
+}
+
+int setvbuf(FILE *stream, char *buf, int mode, size_t size)
+{
+    if (mode != _IONBF && mode != _IOLBF && mode != _IOFBF)
+    {
+        return (EOF);
+    }
+
+    flockfile(stream);
+
+    // A string stream's data is its buffer, and input can't be flushed,
+    // so only an empty buffer may be replaced.
+    if (stream->io_mode == _IOS || fflush_unlocked(stream) != 0 ||
+        stream->len != 0)
+    {
+        funlockfile(stream);
+        return (EOF);
+    }
+
+    if (size > 0)
+    {
+        bool owned = (buf == NULL);
+        if (owned)
+        {
+            buf = (char*) malloc(size);
+            if (buf == NULL)
+            {
+                funlockfile(stream);
+                return (EOF);
+            }
+        }
+
+        if (stream->buf_owned)
+        {
+            free((char*) stream->buf);
+        }
+        stream->buf = buf;
+        stream->max_len = size;
+        stream->pos = 0;
+        stream->buf_owned = owned;
+    }
+    stream->buf_mode = mode;
+
+    funlockfile(stream);
 
     return (0);
 }
@@ -189,45 +459,103 @@ void clearerr(FILE *stream)
 
 int fputn(const char *s, size_t n, FILE *stream)
 {
-    int bytes = 0;
+    flockfile(stream);
+    int ret = fputn_unlocked(s, n, stream);
+    funlockfile(stream);
 
-    for (size_t i = 0; i < n; i++)
+    return (ret);
+}
+
+int fputn_unlocked(const char *s, size_t n, FILE *stream)
+{
+    size_t written = stream_write(stream, s, n);
+
+    if (written < n)
     {
-        int cur_byte = fputc(s[i], stream);
+        return (EOF);
+    }
+    return ((int) written);
+}
 
-        if (cur_byte == EOF)
-            return (EOF);
+size_t fwrite(const void *ptr, size_t size, size_t nmemb, FILE *stream)
+{
+    flockfile(stream);
+    size_t ret = fwrite_unlocked(ptr, size, nmemb, stream);
+    funlockfile(stream);
+
+    return (ret);
+}
 
-        bytes++;
+size_t fwrite_unlocked(const void *ptr, size_t size, size_t nmemb, FILE *stream)
+{
+    size_t n;
+    if (size == 0 || nmemb == 0 || __builtin_mul_overflow(size, nmemb, &n))
+    {
+        return (0);
     }
 
-    return (bytes);
+    return (stream_write(stream, (const char*) ptr, n) / size);
 }
 
-int fputc(int c, FILE *stream)
+size_t fread(void *ptr, size_t size, size_t nmemb, FILE *stream)
 {
-    // Write character to buffer.
-    rputc(c, stream);
+    flockfile(stream);
+    size_t ret = fread_unlocked(ptr, size, nmemb, stream);
+    funlockfile(stream);
 
-    // Check if the buffer should be flushed.
-    if (stream->buf_mode == _IONBF)
+    return (ret);
+}
+
+size_t fread_unlocked(void *ptr, size_t size, size_t nmemb, FILE *stream)
+{
+    char* dst = (char*) ptr;
+    size_t n;
+
+    if (__builtin_mul_overflow(size, nmemb, &n) || n == 0 || stream->io_mode == _IOO)
     {
-        fflush(stream);
+        return (0);
     }
-    else if (stream->len == stream->max_len)
+
+    // Take what the stream already holds, then read the rest straight
+    // into place rather than through the buffer.
+    size_t got = ring_read(stream, dst, n);
+    while (got < n && stream->io_mode == _IOI)
     {
-        // Always flush if we run out of room in the buffer.
-        fflush(stream);
+        ssize_t ret = stream->read(dst + got, n - got);
+        if (ret <= 0)
+        {
+            break;
+        }
+        got += ret;
     }
-    else if (stream->buf_mode == _IOLBF && (c == '\n' || stream->len == stream->max_len))
+
+    return (got / size);
+}
+
+int fputc(int c, FILE *stream)
+{
+    flockfile(stream);
+    int ret = fputc_unlocked(c, stream);
+    funlockfile(stream);
+
+    return (ret);
+}
+
+int fputc_unlocked(int c, FILE *stream)
+{
+    // Most bytes just go in the buffer.
+    if (stream->len < stream->max_len && stream->buf_mode != _IONBF &&
+        (c != '\n' || stream->buf_mode == _IOFBF))
     {
-        fflush(stream);
+        return (rputc(c, stream));
     }
-    else if (stream->buf_mode == _IOFBF && stream->len == stream->max_len)
+
+    char ch = (char) c;
+
+    if (fputn_unlocked(&ch, 1, stream) == EOF)
     {
-        fflush(stream);
+        return (EOF);
     }
-
     return (c);
 }
 
@@ -236,11 +564,21 @@ int putc(int c, FILE *stream)
     return ( fputc(c, stream) );
 }
 
+int putc_unlocked(int c, FILE *stream)
+{
+    return ( fputc_unlocked(c, stream) );
+}
+
 int putchar(int c)
 {
     return ( fputc(c, stdout) );
 }
 
+int putchar_unlocked(int c)
+{
+    return ( fputc_unlocked(c, stdout) );
+}
+
 int fputs(const char *s, FILE *stream)
 {
     size_t len = strlen(s);
@@ -248,20 +586,68 @@ int fputs(const char *s, FILE *stream)
     return (fputn(s, len, stream));
 };
 
+int fputs_unlocked(const char *s, FILE *stream)
+{
+    size_t len = strlen(s);
+
+    return (fputn_unlocked(s, len, stream));
+};
+
 int puts(const char *s)
 {
-    fputs(s, stdout);
-    return ( fputc('\n', stdout) );
+    flockfile(stdout);
+    fputs_unlocked(s, stdout);
+    int ret = fputc_unlocked('\n', stdout);
+    funlockfile(stdout);
+
+    return (ret);
+}
+
+int fputs(std::string_view s, FILE *stream)
+{
+    return (fputn(s.data(), s.size(), stream));
+}
+
+int fputs_unlocked(std::string_view s, FILE *stream)
+{
+    return (fputn_unlocked(s.data(), s.size(), stream));
+}
+
+int puts(std::string_view s)
+{
+    flockfile(stdout);
+    fputn_unlocked(s.data(), s.size(), stdout);
+    int ret = fputc_unlocked('\n', stdout);
+    funlockfile(stdout);
+
+    return (ret);
 }
 
 int fgetc(FILE *stream)
 {
-    int ret;
+    flockfile(stream);
+    int ret = fgetc_unlocked(stream);
+    funlockfile(stream);
+
+    return (ret);
+}
+
+int fgetc_unlocked(FILE *stream)
+{
+    // String streams hold all their data in the buffer.
+    if (stream->io_mode == _IOS)
+    {
+        return (rgetc(stream));
+    }
 
     // Get character.
-    stream->read(&ret, 1);
+    char c;
+    if (stream->read(&c, 1) != 1)
+    {
+        return (EOF);
+    }
 
-    return (ret);
+    return ((unsigned char) c);
 }
 
 int getc(FILE *stream)
@@ -269,10 +655,17 @@ int getc(FILE *stream)
     return ( fgetc(stream) );
 }
 
+int getc_unlocked(FILE *stream)
+{
+    return ( fgetc_unlocked(stream) );
+}
+
 int ungetc(int c, FILE *stream)
 {
     int ret;
+    flockfile(stream);
     ret = rungetc(c, stream);
+    funlockfile(stream);
     return (ret);
 }
 
@@ -281,13 +674,43 @@ int getchar(void)
     return ( fgetc(stdin) );
 }
 
+int getchar_unlocked(void)
+{
+    return ( fgetc_unlocked(stdin) );
+}
+
 char* fgets(char *s, int n, FILE *stream)
 {
-    int len;
-    len = stream->read(s, n);
+    size_t len;
+
+    if (n <= 0)
+    {
+        return (NULL);
+    }
+
+    flockfile(stream);
+
+    if (stream->io_mode == _IOS)
+    {
+        // String streams hold all their data in the buffer, so take the
+        // line from there.
+        size_t line = ring_find(stream, '\n');
+        if (line < stream->len)
+        {
+            line++;
+        }
+        len = ring_read(stream, s, line < (size_t) n - 1 ? line : (size_t) n - 1);
+    }
+    else
+    {
+        ssize_t got = stream->read(s, n - 1);
+        len = (got > 0) ? got : 0;
+    }
+
+    funlockfile(stream);
 
     // Null terminate stream.
-    s[len + 1] = '\0';
+    s[len] = '\0';
 
     return (s);
 }
@@ -309,238 +732,359 @@ char* gets(char *s)
     return (s);
 }
 
-int vfprintf(FILE *stream, const char *format, va_list arg)
+// Destination of formatted output: a stream, or a string of a given size.
+struct Printf_Sink
 {
-    ssize_t len = 0;
-    int written = 0;
+    FILE* stream;
+    char* str;
+    size_t size;
 
-    // Tags.
-    char spec;
-    bool left_justify = false;
-    bool force_sign = false;
-    bool force_space = false;
-    bool force_spec = false;
-    bool zero_pad = false;
-    int width = -1;
-    int precision = -1;
-    int length = LENGTH_DEFAULT;
+    // Bytes produced so far, including any that didn't fit in str.
+    size_t len;
 
-    while (format[len] != '\0')
+    // Whether a newline was written, for line-buffered streams.
+    bool newline;
+};
+
+// Appends a span to the output.
+static void sink_put(Printf_Sink* sink, const char* s, size_t n)
+{
+    if (sink->stream != NULL)
     {
-        if (format[len] == '%')
+        stream_put(sink->stream, s, n);
+        if (!sink->newline && memchr(s, '\n', n) != NULL)
         {
-            // Print string so far.
-            fputn(format, len, stream);
-            written += len;
-            format += len + 1;
-            len = -1;
-
-            // Get tags.
-            bool done = false;
-            bool dot = false;
-            while (!done)
-            {
-                switch (*format)
-                {
-                case '-':
-                    left_justify = true;
-                    break;
+            sink->newline = true;
+        }
+    }
+    else if (sink->len + 1 < sink->size)
+    {
+        // Keep room for the terminator; the rest is only counted.
+        size_t room = sink->size - 1 - sink->len;
+        memcpy(sink->str + sink->len, s, n < room ? n : room);
+    }
 
-                case '+':
-                    force_sign = true;
-                    break;
+    sink->len += n;
+}
 
-                case ' ':
-                    force_space = true;
-                    break;
+// Appends a character repeated n times.
+static void sink_pad(Printf_Sink* sink, char c, size_t n)
+{
+    char pad[32];
+    memset(pad, c, n < sizeof(pad) ? n : sizeof(pad));
 
-                case '#':
-                    force_spec = true;
-                    break;
+    while (n > 0)
+    {
+        size_t chunk = n < sizeof(pad) ? n : sizeof(pad);
+        sink_put(sink, pad, chunk);
+        n -= chunk;
+    }
+}
 
-                case '0':
-                    zero_pad = true;
-                    break;
+// Appends a field of len bytes with its prefix (sign or 0x) and padding.
+// zeros more zeros go between the prefix and s, for an integer precision.
+static void sink_field(Printf_Sink* sink, const char* prefix, size_t prefix_len,
+                       size_t zeros, const char* s, size_t len, int width,
+                       bool left_justify, bool zero_pad)
+{
+    size_t total = prefix_len + zeros + len;
+    size_t pad = (width > 0 && (size_t)width > total) ? width - total : 0;
 
-                case '.':
-                    dot = true;
-                    break;
+    if (!left_justify && !zero_pad)
+    {
+        sink_pad(sink, ' ', pad);
+    }
+    sink_put(sink, prefix, prefix_len);
+    if (!left_justify && zero_pad)
+    {
+        sink_pad(sink, '0', pad);
+    }
+    sink_pad(sink, '0', zeros);
+    sink_put(sink, s, len);
+    if (left_justify)
+    {
+        sink_pad(sink, ' ', pad);
+    }
+}
 
-                case '*':
-                    if (dot == true)
-                    {
-                        dot = false;
-                        precision = PRECISION_ARG;
-                    }
-                    else
-                        width = WIDTH_ARG;
-                    break;
+static void sink_format(Printf_Sink* sink, const char *format, va_list arg)
+{
+    while (*format != '\0')
+    {
+        // Literal text up to the next specifier goes out in one span.
+        const char* pct = strchr(format, '%');
+        if (pct == NULL)
+        {
+            sink_put(sink, format, strlen(format));
+            return;
+        }
+        if (pct != format)
+        {
+            sink_put(sink, format, pct - format);
+        }
+        format = pct + 1;
+
+        // Tags.
+        bool left_justify = false;
+        bool force_sign = false;
+        bool force_space = false;
+        bool force_spec = false;
+        bool zero_pad = false;
+        int width = -1;
+        int precision = -1;
+        int length = LENGTH_DEFAULT;
+
+        for (bool done = false; !done; )
+        {
+            switch (*format)
+            {
+            case '-':
+                left_justify = true;
+                break;
 
-                case 'h':
-                    length = LENGTH_SHORT;
-                    break;
+            case '+':
+                force_sign = true;
+                break;
 
-                case 'l':
-                    length = LENGTH_LONG;
-                    break;
+            case ' ':
+                force_space = true;
+                break;
 
-                case 'L':
-                    length = LENGTH_DOUBLE;
-                    break;
+            case '#':
+                force_spec = true;
+                break;
 
-                case '1':
-                case '2':
-                case '3':
-                case '4':
-                case '5':
-                case '6':
-                case '7':
-                case '8':
-                case '9':
-                    if (dot == true)
-                    {
-                        dot = false;
-                        precision = atoi(format);
-                    }
-                    else
-                    {
-                        width = atoi(format);
-                    }
-                    while (isdigit(*format))
-                        format++;
-                    format--;
-                    break;
+            case '0':
+                zero_pad = true;
+                break;
 
-                default:
-                    done = true;
-                    format--;
-                    break;
-                }
-                format++;
+            default:
+                done = true;
+                continue;
             }
+            format++;
+        }
 
-            // Get specifier.
-            spec = *format;
+        if (*format == '*')
+        {
+            width = va_arg(arg, int);
+            if (width < 0)
+            {
+                left_justify = true;
+                width = -width;
+            }
             format++;
+        }
+        else
+        {
+            while (isdigit(*format))
+            {
+                width = (width < 0 ? 0 : width * 10) + (*format++ - '0');
+            }
+        }
 
-            // Character.
-            if (spec == 'c' || spec == '%')
+        if (*format == '.')
+        {
+            format++;
+            precision = 0;
+            if (*format == '*')
             {
-                if (length != LENGTH_WIDE)
+                precision = va_arg(arg, int);
+                format++;
+            }
+            else
+            {
+                while (isdigit(*format))
                 {
-                    char c = va_arg(arg, int);
-                    if (c != NULL)
-                    {
-                        fputc(c, stream);
-                    }
-                    written++;
+                    precision = precision * 10 + (*format++ - '0');
                 }
-                continue;
             }
+        }
 
-            // String.
-            if (spec == 's')
+        for (bool done = false; !done; )
+        {
+            switch (*format)
             {
-                // Get precision from va_arg if specified.
-                if (precision == PRECISION_ARG)
-                    precision = va_arg(arg, int);
+            case 'h':
+                length = LENGTH_SHORT;
+                break;
 
-                // Get pointer to string.
-                const char *s = va_arg(arg, const char *);
+            case 'l':
+            case 'z':
+                length = LENGTH_LONG;
+                break;
 
-                if (precision > 0)
-                {
-                    fputn(s, precision, stream);
-                    written += precision;
-                }
-                else
-                {
-                    fputs(s, stream);
-                    written += strlen(s);
-                }
+            case 'L':
+                length = LENGTH_DOUBLE;
+                break;
+
+            default:
+                done = true;
                 continue;
             }
+            format++;
+        }
 
-            // Signed decimal integer.
-            if (spec == 'd' || spec == 'i')
-            {
-                // Get width from va_arg if specified.
-                if (width == WIDTH_ARG)
-                    width = (int) va_arg(arg, int);
+        // Get specifier.
+        char spec = *format;
+        if (spec == '\0')
+        {
+            return;
+        }
+        format++;
 
-                char tmp[100 + width];
-                long n;
-                int pad;
+        // Large enough for a 64-bit value in octal.
+        char tmp[24];
+        char* end = tmp + sizeof(tmp);
 
-                // Get integer.
-                if (length == LENGTH_SHORT)
-                    n = (short) va_arg(arg, int);
-                else if (length == LENGTH_LONG)
-                    n = (long) va_arg(arg, long);
-                else
-                    n = (int) va_arg(arg, int);
+        // An integer precision is a minimum digit count, made up with
+        // zeros, and turns off the 0 flag. A zero value with precision 0
+        // has no digits.
+        size_t zeros = 0;
 
-                // Format string.
-                if (force_sign == true)
-                {
-                    if (n < 0)
-                        tmp[0] = '-';
-                    else
-                        tmp[0] = '+';
-                    litoa(labs(n), tmp+1);
-                }
-                else if (force_space == true)
-                {
-                    if (n < 0)
-                        tmp[0] = '-';
-                    else
-                        tmp[0] = ' ';
-                    litoa(labs(n), tmp+1);
-                }
-                else
-                {
-                    litoa(n, tmp);
-                }
+        switch (spec)
+        {
+        case '%':
+            sink_put(sink, "%", 1);
+            break;
 
-                fputs(tmp, stream);
-                written += strlen(tmp);
-                continue;
+        case 'c':
+        {
+            char c = (char)va_arg(arg, int);
+            sink_field(sink, NULL, 0, 0, &c, 1, width, left_justify, false);
+            break;
+        }
+
+        case 's':
+        {
+            const char* s = va_arg(arg, const char*);
+            if (s == NULL)
+            {
+                s = "(null)";
             }
-            
-            if (spec == 'f')
+
+            // A precision bounds the string, which needn't be terminated.
+            size_t len;
+            if (precision >= 0)
             {
-                char tmp[100];
-                float f;
-                
-                // Get float.
-                f = (float) va_arg(arg, double);
-                
-                // Format string.
-                ftoa(f, tmp);
-                
-                // Output string.
-                fputs(tmp, stream);
-                written += strlen(tmp);
+                const char* z = (const char*)memchr(s, '\0', precision);
+                len = (z != NULL) ? (size_t)(z - s) : (size_t)precision;
+            }
+            else
+            {
+                len = strlen(s);
             }
+            sink_field(sink, NULL, 0, 0, s, len, width, left_justify, false);
+            break;
+        }
 
-            // Reset tags.
-            left_justify = false;
-            force_sign = false;
-            force_space = false;
-            force_spec = false;
-            zero_pad = false;
-            width = -1;
-            precision = -1;
-            length = LENGTH_DEFAULT;
+        case 'd':
+        case 'i':
+        {
+            long n;
+            if (length == LENGTH_LONG)
+                n = va_arg(arg, long);
+            else if (length == LENGTH_SHORT)
+                n = (short)va_arg(arg, int);
+            else
+                n = va_arg(arg, int);
+
+            const char* sign = NULL;
+            if (n < 0)
+                sign = "-";
+            else if (force_sign)
+                sign = "+";
+            else if (force_space)
+                sign = " ";
+
+            // Negate as unsigned so LONG_MIN survives.
+            unsigned long mag = (n < 0) ? -(unsigned long)n : (unsigned long)n;
+            char* p = (precision == 0 && mag == 0) ? end : utoa_digits(mag, end, 10, false);
+            if (precision > end - p)
+                zeros = precision - (end - p);
+            sink_field(sink, sign, sign ? 1 : 0, zeros, p, end - p, width, left_justify,
+                       zero_pad && precision < 0);
+            break;
         }
 
-        len++;
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o':
+        case 'p':
+        {
+            unsigned long n;
+            if (spec == 'p')
+                n = (uintptr_t)va_arg(arg, void*);
+            else if (length == LENGTH_LONG)
+                n = va_arg(arg, unsigned long);
+            else if (length == LENGTH_SHORT)
+                n = (unsigned short)va_arg(arg, unsigned int);
+            else
+                n = va_arg(arg, unsigned int);
+
+            unsigned base = (spec == 'u') ? 10 : (spec == 'o') ? 8 : 16;
+            char* p = (precision == 0 && n == 0) ? end : utoa_digits(n, end, base, spec == 'X');
+            if (precision > end - p)
+                zeros = precision - (end - p);
+
+            // # makes octal start with a zero, unless it already does.
+            const char* prefix = NULL;
+            if (spec == 'p' || (force_spec && n != 0 && base == 16))
+                prefix = (spec == 'X') ? "0X" : "0x";
+            else if (force_spec && base == 8 && zeros == 0 && (p == end || *p != '0'))
+                *--p = '0';
+
+            sink_field(sink, prefix, prefix ? 2 : 0, zeros, p, end - p, width, left_justify,
+                       zero_pad && precision < 0);
+            break;
+        }
+
+        case 'f':
+        {
+            // Digits beyond what a double holds would only be zeros.
+            char buf[PRINTF_FLOAT_MAX];
+            if (precision < 0)
+                precision = 6;
+            else if (precision > PRINTF_PRECISION_MAX)
+                precision = PRINTF_PRECISION_MAX;
+            _dtoa(va_arg(arg, double), buf, precision);
+
+            const char* p = buf;
+            const char* sign = NULL;
+            if (*p == '-')
+            {
+                sign = "-";
+                p++;
+            }
+            else if (force_sign)
+                sign = "+";
+            else if (force_space)
+                sign = " ";
+
+            sink_field(sink, sign, sign ? 1 : 0, 0, p, strlen(p), width, left_justify, zero_pad);
+            break;
+        }
+
+        default:
+            // Unknown specifiers are printed as they were written.
+            sink_put(sink, pct, format - pct);
+            break;
+        }
     }
+}
 
-    // Print anything left.
-    fputs(format, stream);
+int vfprintf(FILE *stream, const char *format, va_list arg)
+{
+    Printf_Sink sink = { stream, NULL, 0, 0, false };
 
-    return (written);
+    // Hold the stream for the whole line so it isn't interleaved.
+    flockfile(stream);
+    sink_format(&sink, format, arg);
+    stream_settle(stream, sink.newline);
+    funlockfile(stream);
+
+    return ((int)sink.len);
 }
 
 int fprintf(FILE *stream, const char *format, ...)
@@ -568,23 +1112,34 @@ int vprintf(const char *format, va_list arg)
     return ( vfprintf(stdout, format, arg) );
 }
 
-int vsprintf(char *s, const char *format, va_list arg)
+int vsnprintf(char *s, size_t n, const char *format, va_list arg)
 {
-    int ret;
-    FILE tmp;
-    FILE *stream = &tmp;
-    tmp.buf = s;
-    tmp.pos = 0;
-    tmp.len = 0;
-    tmp.max_len = SIZE_MAX;
-    tmp.buf_mode = _IOFBF;
-    tmp.io_mode = _IOS;
-    tmp.write = &write_null;
+    Printf_Sink sink = { NULL, s, n, 0, false };
 
-    ret = vfprintf(stream, format, arg);
+    sink_format(&sink, format, arg);
+    if (n > 0)
+    {
+        s[sink.len < n ? sink.len : n - 1] = '\0';
+    }
+
+    return ((int)sink.len);
+}
+
+int snprintf(char *s, size_t n, const char *format, ...)
+{
+    int ret;
+    va_list arg;
+    va_start(arg, format);
+    ret = vsnprintf(s, n, format, arg);
+    va_end(arg);
     return (ret);
 }
 
+int vsprintf(char *s, const char *format, va_list arg)
+{
+    return ( vsnprintf(s, SIZE_MAX, format, arg) );
+}
+
 int sprintf(char *s, const char *format, ...)
 {
     int ret;
@@ -595,7 +1150,8 @@ int sprintf(char *s, const char *format, ...)
     return (ret);
 }
 
-int vfscanf(FILE *stream, const char *format, va_list arg)
+// vfscanf() for a stream the caller holds.
+static int stream_scan(FILE *stream, const char *format, va_list arg)
 {
     ssize_t len = 0;
     int args_read = 0;
@@ -713,7 +1269,7 @@ int vfscanf(FILE *stream, const char *format, va_list arg)
                 if (length != LENGTH_WIDE)
                 {
                     char *c = (char*) va_arg(arg, int*);
-                    *c = fgetc(stream);
+                    *c = fgetc_unlocked(stream);
                     args_read++;
                 }
                 continue;
@@ -759,12 +1315,12 @@ int vfscanf(FILE *stream, const char *format, va_list arg)
                 int tmp_len = 0;
                 char tmp[tmp_max];
                 int pad;
-                char c = fgetc(stream);
+                char c = fgetc_unlocked(stream);
                 while (isdigit(c) || c == '-')
                 {
                     tmp[tmp_len] = c;
                     tmp_len++;
-                    c = fgetc(stream);
+                    c = fgetc_unlocked(stream);
                 }
                 tmp[tmp_len] = '\0';
 
@@ -793,12 +1349,12 @@ int vfscanf(FILE *stream, const char *format, va_list arg)
                 // Get string.
                 char tmp[100];
                 size_t len = 0;
-                char c = fgetc(stream);
+                char c = fgetc_unlocked(stream);
                 while (isdigit(c) || c == '-' || c == '.')
                 {
                     tmp[len] = c;
                     ++len;
-                    c = fgetc(stream);
+                    c = fgetc_unlocked(stream);
                 }
                 tmp[len] = '\0';
                 
@@ -828,6 +1384,15 @@ int vfscanf(FILE *stream, const char *format, va_list arg)
     return (args_read);
 }
 
+int vfscanf(FILE *stream, const char *format, va_list arg)
+{
+    flockfile(stream);
+    int ret = stream_scan(stream, format, arg);
+    funlockfile(stream);
+
+    return (ret);
+}
+
 int fscanf(FILE *stream, const char *format, ...)
 {
     int ret;
@@ -865,6 +1430,9 @@ int vsscanf(const char *s, const char *format, va_list arg)
     tmp.buf_mode = _IOFBF;
     tmp.io_mode = _IOS;
     tmp.write = &write_null;
+    tmp.lock = 0;
+    tmp.lock_depth = 0;
+    tmp.buf_owned = false;
 
     ret = vfscanf(stream, format, arg);
     return (ret);
@@ -41,6 +41,8 @@ extern "C" {
 /// String-stream.
 #define _IOS 2
 
+struct Thread;
+
 /// Stream/file abstraction.
 typedef struct FILE
 {
@@ -68,6 +70,18 @@ typedef struct FILE
         ssize_t (*write)(const void* s, size_t n);
         ssize_t (*read)(void* s, size_t n);
     };
+
+    /// Nonzero while a thread holds the stream. See flockfile().
+    volatile uint32_t lock;
+
+    /// Thread holding the stream.
+    struct Thread* volatile lock_owner;
+
+    /// Number of times the holder has locked the stream.
+    size_t lock_depth;
+
+    /// Whether setvbuf() allocated the buffer, and so frees it.
+    bool buf_owned;
 } FILE;
 
 /// Standard input stream.
@@ -98,16 +112,82 @@ int rgetc(FILE* stream);
  */
 int rputc(int c, FILE* stream);
 
+/**
+ * @brief Append bytes to stream buffer, wrapping around its end. For
+ * internal use.
+ *
+ * @param stream Destination stream.
+ * @param src Bytes to append.
+ * @param n Number of bytes.
+ *
+ * @return Number of bytes appended, fewer than n if the buffer filled.
+ */
+size_t ring_write(FILE* stream, const void* src, size_t n);
+
+/**
+ * @brief Take bytes from the front of stream buffer, wrapping around its
+ * end. For internal use.
+ *
+ * @param stream Source stream.
+ * @param dst Destination for the bytes.
+ * @param n Maximum number of bytes.
+ *
+ * @return Number of bytes taken, fewer than n if the buffer emptied.
+ */
+size_t ring_read(FILE* stream, void* dst, size_t n);
+
+/**
+ * @brief Find a byte in stream buffer without taking anything. For
+ * internal use.
+ *
+ * @param stream Stream to search.
+ * @param c Byte to find.
+ *
+ * @return Offset of the first c from the front of the buffered data, or
+ * the length of the data if there is none.
+ */
+size_t ring_find(FILE* stream, int c);
+
 /**
  * @brief Un-get byte from stream buffer. For internal use.
  *
- * @param c Byte to replace in buffer.
+ * @param c Byte to place in front of the buffered data.
  * @param stream Destination stream.
  *
  * @return Byte that was placed back into the buffer, or error code.
  */
 int rungetc(int c, FILE* stream);
 
+/**
+ * @brief Lock a stream for the calling thread, waiting for any other
+ * holder. A thread may lock a stream it already holds, and must unlock it
+ * as many times.
+ *
+ * Every stdio function locks the stream it works on, so a single call is
+ * never interleaved with another thread's output. Lock the stream around
+ * several calls to keep them together, and use the _unlocked variants
+ * inside to skip the per-call locking.
+ *
+ * @param stream Stream to lock.
+ */
+void flockfile(FILE* stream);
+
+/**
+ * @brief Lock a stream if no other thread holds it.
+ *
+ * @param stream Stream to lock.
+ *
+ * @return 0 if the stream was locked, or nonzero if another thread holds it.
+ */
+int ftrylockfile(FILE* stream);
+
+/**
+ * @brief Release a stream locked with flockfile() or ftrylockfile().
+ *
+ * @param stream Stream to unlock.
+ */
+void funlockfile(FILE* stream);
+
 /**
  * @brief Initialize STDIO interface. Must be called before any
  * related features may be used.
@@ -123,6 +203,20 @@ void stdio_init(void);
  */
 int fflush(FILE *stream);
 
+/**
+ * @brief Set the buffering mode of a stream, and optionally its buffer.
+ * Anything buffered for output is flushed first.
+ *
+ * @param stream Stream to change.
+ * @param buf New buffer of size bytes, or NULL to have one allocated.
+ * @param mode _IONBF, _IOLBF or _IOFBF.
+ * @param size Size of the new buffer, or 0 to keep the current one.
+ *
+ * @return 0 if successful, or EOF if the mode is unknown, the stream
+ * still holds data or no buffer could be allocated.
+ */
+int setvbuf(FILE *stream, char *buf, int mode, size_t size);
+
 /**
  * @brief Clear error status on stream.
  *
@@ -141,6 +235,32 @@ void clearerr(FILE *stream);
  */
 int fputn(const char *s, size_t n, FILE *stream);
 
+/**
+ * @brief Write an array of objects to a stream. Writes at least as large
+ * as the stream's buffer go straight to the device.
+ *
+ * @param ptr Objects to write.
+ * @param size Size of each object.
+ * @param nmemb Number of objects.
+ * @param stream Destination stream.
+ *
+ * @return Number of whole objects written.
+ */
+size_t fwrite(const void *ptr, size_t size, size_t nmemb, FILE *stream);
+
+/**
+ * @brief Read an array of objects from a stream. Data the stream doesn't
+ * already hold is read straight into ptr.
+ *
+ * @param ptr Destination for the objects.
+ * @param size Size of each object.
+ * @param nmemb Number of objects.
+ * @param stream Source stream.
+ *
+ * @return Number of whole objects read.
+ */
+size_t fread(void *ptr, size_t size, size_t nmemb, FILE *stream);
+
 /**
  * @brief Write a single character to a stream.
  *
@@ -248,6 +368,14 @@ int printf(const char *format, ...);
 /// Write a formatted string to another string with an argument list.
 int vsprintf(char *s, const char *format, va_list arg);
 
+/// Write at most n-1 formatted characters and a terminator to another
+/// string with an argument list. Returns the length of the whole output.
+int vsnprintf(char *s, size_t n, const char *format, va_list arg);
+
+/// Write at most n-1 formatted characters and a terminator to another
+/// string with variable arguments.
+int snprintf(char *s, size_t n, const char *format, ...);
+
 /// Write a formatted string to another string with variable argument.
 int sprintf(char *s, const char *format, ...);
 
@@ -269,6 +397,41 @@ int vsscanf(const char *s, const char *format, va_list arg);
 /// Read a formatted string from another string with variable arguments.
 int sscanf(const char *s, const char *format, ...);
 
+/* Variants for callers that hold the stream lock. See flockfile(). */
+
+/// fflush() without locking the stream.
+int fflush_unlocked(FILE *stream);
+
+/// fputn() without locking the stream.
+int fputn_unlocked(const char *s, size_t n, FILE *stream);
+
+/// fwrite() without locking the stream.
+size_t fwrite_unlocked(const void *ptr, size_t size, size_t nmemb, FILE *stream);
+
+/// fread() without locking the stream.
+size_t fread_unlocked(void *ptr, size_t size, size_t nmemb, FILE *stream);
+
+/// fputc() without locking the stream.
+int fputc_unlocked(int c, FILE *stream);
+
+/// putc() without locking the stream.
+int putc_unlocked(int c, FILE *stream);
+
+/// putchar() without locking stdout.
+int putchar_unlocked(int c);
+
+/// fputs() without locking the stream.
+int fputs_unlocked(const char *s, FILE *stream);
+
+/// fgetc() without locking the stream.
+int fgetc_unlocked(FILE *stream);
+
+/// getc() without locking the stream.
+int getc_unlocked(FILE *stream);
+
+/// getchar() without locking stdin.
+int getchar_unlocked(void);
+
 /// Null write interface.
 ssize_t write_null(const void *s, size_t n);
 
@@ -277,6 +440,21 @@ ssize_t read_null(void *s, size_t n);
 
 #ifdef __cplusplus
 }
+
+#include <string_view>
+
+/* Overloads for string views, which needn't end in a NUL, so that a slice
+   of a larger string is written without copying or terminating it. */
+
+/// Write a string to a stream. See fputs().
+int fputs(std::string_view s, FILE *stream);
+
+/// fputs() of a string_view without locking the stream.
+int fputs_unlocked(std::string_view s, FILE *stream);
+
+/// Write a string and a newline to stdout. See puts().
+int puts(std::string_view s);
+
 #endif
 
 #endif // STDIO_H
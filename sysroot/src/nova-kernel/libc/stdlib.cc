@@ -9,15 +9,21 @@
 #include <globals.h>
 
 #include <float.h>
+#include <limits.h>
 
 #include <ctype.h>
+#include <errno.h>
 #include <stdlib.h>
+#include <string.h>
 
 #ifdef ARCH_X86_64
 #include <arch/x86_64/cpu.h>
+#include <arch/x86_64/cpu_features.h>
 #include <arch/x86_64/memory/pmm.h>
 #endif
 
+int errno;
+
 int abs(int n)
 {
     if (n < 0)
@@ -30,145 +36,1303 @@ int abs(int n)
     }
 }
 
-double atof(const char* s)
+// Number conversion. Integers are formatted two decimal digits per
+// division, floating point is formatted with Grisu2 and parsed with
+// Clinger's fast path or a 64-bit scaled multiply, and decimal strings
+// are parsed eight digits at a time.
+
+// Digits of 0 to 99, two characters each.
+static const char dec_pairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+// Powers of ten that fit in 64 bits.
+static const uint64_t pow10_u64[20] =
 {
-    double val = 0;
-    size_t i = 0;
+    1UL, 10UL, 100UL, 1000UL, 10000UL, 100000UL, 1000000UL, 10000000UL,
+    100000000UL, 1000000000UL, 10000000000UL, 100000000000UL,
+    1000000000000UL, 10000000000000UL, 100000000000000UL,
+    1000000000000000UL, 10000000000000000UL, 100000000000000000UL,
+    1000000000000000000UL, 10000000000000000000UL,
+};
+
+char* utoa_digits(unsigned long val, char* end, int base, bool upper)
+{
+    const char* digits = upper ? "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+                               : "0123456789abcdefghijklmnopqrstuvwxyz";
+    char* p = end;
 
-    /* Ignores any whitespace at beginning of string. */
-    while (isspace(s[i]) != 0)
+    if (base == 10)
     {
-        ++i;
+        while (val >= 100)
+        {
+            size_t i = (val % 100) * 2;
+            val /= 100;
+            p -= 2;
+            p[0] = dec_pairs[i];
+            p[1] = dec_pairs[i + 1];
+        }
+        if (val >= 10)
+        {
+            p -= 2;
+            p[0] = dec_pairs[val * 2];
+            p[1] = dec_pairs[val * 2 + 1];
+        }
+        else
+        {
+            *--p = '0' + val;
+        }
+        return (p);
     }
 
-    /* If sign is 1, integer is positive. If sign is -1, integer is
-     * negative. Default is positive. */
-    double val_sign = 1.0;
+    // Power of two bases only need shifts.
+    if ((base & (base - 1)) == 0)
+    {
+        unsigned shift = __builtin_ctz(base);
+        unsigned long mask = base - 1;
+        do
+        {
+            *--p = digits[val & mask];
+            val >>= shift;
+        } while (val != 0);
+        return (p);
+    }
 
-    /* Checks for negative sign. */
-    if (s[i] == '-')
+    do
     {
-        val_sign = -1;
-        ++i;
+        *--p = digits[val % base];
+        val /= base;
+    } while (val != 0);
+    return (p);
+}
+
+// Formats a magnitude with the sign and base prefix _itoa() and friends
+// have always written.
+static char* itoa_prefixed(unsigned long mag, bool negative, char* str, int base)
+{
+    char* s = str;
+
+    if (negative)
+    {
+        *s++ = '-';
+    }
+
+    switch (base)
+    {
+    case (2):
+        *s++ = '0';
+        *s++ = 'b';
+        break;
+
+    case (8):
+        *s++ = '0';
+        break;
+
+    case (10):
+        break;
+
+    case (16):
+        *s++ = '0';
+        *s++ = 'x';
+        break;
+
+    default:
+        return ((char*) "ERROR: BASE NOT SUPPORTED");
+    }
+
+    char tmp[64];
+    char* end = tmp + sizeof(tmp);
+    char* p = utoa_digits(mag, end, base, true);
+    memcpy(s, p, end - p);
+    s[end - p] = '\0';
+
+    return (str);
+}
+
+// Value of a digit in bases up to 36, or 36 if c isn't one.
+static inline unsigned strto_digit(char c)
+{
+    if (c >= '0' && c <= '9')
+    {
+        return (c - '0');
+    }
+
+    c |= 0x20;
+    if (c >= 'a' && c <= 'z')
+    {
+        return (c - 'a' + 10);
+    }
+
+    return (36);
+}
+
+// Eight digits are read as one word when the load stays in the page.
+static const uintptr_t STRTO_PAGE_SIZE = 4096;
+
+// Largest value that can take eight more decimal digits without overflow.
+static const unsigned long STRTO_EIGHT_MAX = (ULONG_MAX - 99999999UL) / 100000000UL;
+
+// Whether all 8 bytes of a word are ASCII digits.
+static inline bool strto_is_eight_digits(uint64_t chunk)
+{
+    return (((chunk & 0xF0F0F0F0F0F0F0F0UL) |
+             (((chunk + 0x0606060606060606UL) & 0xF0F0F0F0F0F0F0F0UL) >> 4)) ==
+            0x3333333333333333UL);
+}
+
+// Value of the 8 digits in a word, the first digit in the lowest byte.
+// Each step combines neighbouring groups: digits into pairs, pairs into
+// fours, fours into the whole.
+static inline uint32_t strto_eight_digits(uint64_t chunk)
+{
+    chunk = ((chunk & 0x0F0F0F0F0F0F0F0FUL) * 2561) >> 8;
+    chunk = ((chunk & 0x00FF00FF00FF00FFUL) * 6553601) >> 16;
+    return ((uint32_t)(((chunk & 0x0000FFFF0000FFFFUL) * 42949672960001UL) >> 32));
+}
+
+// Parses the sign, prefix and digits shared by strtol() and strtoul().
+// Returns the magnitude, with *overflow set if it didn't fit.
+static unsigned long strto_parse(const char* s, char** endp, int base,
+                                 bool* negative, bool* overflow)
+{
+    const char* p = s;
+    unsigned long val = 0;
+
+    *negative = false;
+    *overflow = false;
+
+    while (isspace(*p) != 0)
+    {
+        ++p;
+    }
+
+    if (*p == '-' || *p == '+')
+    {
+        *negative = (*p == '-');
+        ++p;
+    }
+
+    // A 0x prefix only counts when a hex digit follows it. Otherwise the
+    // 0 is the number.
+    if ((base == 0 || base == 16) && p[0] == '0' && (p[1] | 0x20) == 'x' &&
+        strto_digit(p[2]) < 16)
+    {
+        p += 2;
+        base = 16;
+    }
+    else if (base == 0)
+    {
+        base = (p[0] == '0') ? 8 : 10;
+    }
+
+    if (base < 2 || base > 36)
+    {
+        errno = EINVAL;
+        if (endp != NULL)
+        {
+            *endp = (char*) s;
+        }
+        return (0);
+    }
+
+    const char* digits = p;
+
+    if (base == 10)
+    {
+        while (val <= STRTO_EIGHT_MAX &&
+               ((uintptr_t)p & (STRTO_PAGE_SIZE - 1)) <= STRTO_PAGE_SIZE - 8)
+        {
+            uint64_t chunk;
+            memcpy(&chunk, p, sizeof(chunk));
+            if (!strto_is_eight_digits(chunk))
+            {
+                break;
+            }
+            val = val * 100000000UL + strto_eight_digits(chunk);
+            p += 8;
+        }
+    }
+
+    // The rest one digit at a time. Digits past an overflow are still
+    // consumed, so endp lands after the number.
+    for (;;)
+    {
+        unsigned d = strto_digit(*p);
+        if (d >= (unsigned) base)
+        {
+            break;
+        }
+
+        if (__builtin_mul_overflow(val, (unsigned long) base, &val) ||
+            __builtin_add_overflow(val, (unsigned long) d, &val))
+        {
+            *overflow = true;
+        }
+        ++p;
+    }
+
+    // No digits: nothing was converted.
+    if (p == digits)
+    {
+        p = s;
+        *negative = false;
+    }
+
+    if (endp != NULL)
+    {
+        *endp = (char*) p;
+    }
+
+    return (*overflow ? ULONG_MAX : val);
+}
+
+unsigned long strtoul(const char* s, char** endp, int base)
+{
+    bool negative;
+    bool overflow;
+    unsigned long val = strto_parse(s, endp, base, &negative, &overflow);
+
+    if (overflow)
+    {
+        errno = ERANGE;
+        return (ULONG_MAX);
+    }
+
+    // A minus sign negates in unsigned arithmetic.
+    return (negative ? 0 - val : val);
+}
+
+long strtol(const char* s, char** endp, int base)
+{
+    bool negative;
+    bool overflow;
+    unsigned long val = strto_parse(s, endp, base, &negative, &overflow);
+
+    if (negative)
+    {
+        if (overflow || val > (unsigned long) LONG_MAX + 1)
+        {
+            errno = ERANGE;
+            return (LONG_MIN);
+        }
+        return ((long) (0 - val));
+    }
+
+    if (overflow || val > (unsigned long) LONG_MAX)
+    {
+        errno = ERANGE;
+        return (LONG_MAX);
+    }
+    return ((long) val);
+}
+
+// A 64-bit significand and binary exponent: f * 2^e.
+struct Diy_Fp
+{
+    uint64_t f;
+    int e;
+};
+
+// Product of two numbers, rounded to 64 bits.
+static inline Diy_Fp diy_fp_mul(Diy_Fp a, Diy_Fp b)
+{
+    unsigned __int128 p = (unsigned __int128) a.f * b.f;
+    uint64_t hi = (uint64_t)(p >> 64);
+    uint64_t lo = (uint64_t) p;
+
+    Diy_Fp r = { hi + (lo >> 63), a.e + b.e + 64 };
+    return (r);
+}
+
+static inline Diy_Fp diy_fp_normalize(Diy_Fp a)
+{
+    int shift = __builtin_clzl(a.f);
+    Diy_Fp r = { a.f << shift, a.e - shift };
+    return (r);
+}
+
+// Normalized powers of ten from 1e-348 to 1e340, every 8th power.
+static const Diy_Fp cached_pow10[87] =
+{
+    { 0xfa8fd5a0081c0288UL, -1220 },  // 1e-348
+    { 0xbaaee17fa23ebf76UL, -1193 },  // 1e-340
+    { 0x8b16fb203055ac76UL, -1166 },  // 1e-332
+    { 0xcf42894a5dce35eaUL, -1140 },  // 1e-324
+    { 0x9a6bb0aa55653b2dUL, -1113 },  // 1e-316
+    { 0xe61acf033d1a45dfUL, -1087 },  // 1e-308
+    { 0xab70fe17c79ac6caUL, -1060 },  // 1e-300
+    { 0xff77b1fcbebcdc4fUL, -1034 },  // 1e-292
+    { 0xbe5691ef416bd60cUL, -1007 },  // 1e-284
+    { 0x8dd01fad907ffc3cUL,  -980 },  // 1e-276
+    { 0xd3515c2831559a83UL,  -954 },  // 1e-268
+    { 0x9d71ac8fada6c9b5UL,  -927 },  // 1e-260
+    { 0xea9c227723ee8bcbUL,  -901 },  // 1e-252
+    { 0xaecc49914078536dUL,  -874 },  // 1e-244
+    { 0x823c12795db6ce57UL,  -847 },  // 1e-236
+    { 0xc21094364dfb5637UL,  -821 },  // 1e-228
+    { 0x9096ea6f3848984fUL,  -794 },  // 1e-220
+    { 0xd77485cb25823ac7UL,  -768 },  // 1e-212
+    { 0xa086cfcd97bf97f4UL,  -741 },  // 1e-204
+    { 0xef340a98172aace5UL,  -715 },  // 1e-196
+    { 0xb23867fb2a35b28eUL,  -688 },  // 1e-188
+    { 0x84c8d4dfd2c63f3bUL,  -661 },  // 1e-180
+    { 0xc5dd44271ad3cdbaUL,  -635 },  // 1e-172
+    { 0x936b9fcebb25c996UL,  -608 },  // 1e-164
+    { 0xdbac6c247d62a584UL,  -582 },  // 1e-156
+    { 0xa3ab66580d5fdaf6UL,  -555 },  // 1e-148
+    { 0xf3e2f893dec3f126UL,  -529 },  // 1e-140
+    { 0xb5b5ada8aaff80b8UL,  -502 },  // 1e-132
+    { 0x87625f056c7c4a8bUL,  -475 },  // 1e-124
+    { 0xc9bcff6034c13053UL,  -449 },  // 1e-116
+    { 0x964e858c91ba2655UL,  -422 },  // 1e-108
+    { 0xdff9772470297ebdUL,  -396 },  // 1e-100
+    { 0xa6dfbd9fb8e5b88fUL,  -369 },  // 1e-92
+    { 0xf8a95fcf88747d94UL,  -343 },  // 1e-84
+    { 0xb94470938fa89bcfUL,  -316 },  // 1e-76
+    { 0x8a08f0f8bf0f156bUL,  -289 },  // 1e-68
+    { 0xcdb02555653131b6UL,  -263 },  // 1e-60
+    { 0x993fe2c6d07b7facUL,  -236 },  // 1e-52
+    { 0xe45c10c42a2b3b06UL,  -210 },  // 1e-44
+    { 0xaa242499697392d3UL,  -183 },  // 1e-36
+    { 0xfd87b5f28300ca0eUL,  -157 },  // 1e-28
+    { 0xbce5086492111aebUL,  -130 },  // 1e-20
+    { 0x8cbccc096f5088ccUL,  -103 },  // 1e-12
+    { 0xd1b71758e219652cUL,   -77 },  // 1e-4
+    { 0x9c40000000000000UL,   -50 },  // 1e4
+    { 0xe8d4a51000000000UL,   -24 },  // 1e12
+    { 0xad78ebc5ac620000UL,     3 },  // 1e20
+    { 0x813f3978f8940984UL,    30 },  // 1e28
+    { 0xc097ce7bc90715b3UL,    56 },  // 1e36
+    { 0x8f7e32ce7bea5c70UL,    83 },  // 1e44
+    { 0xd5d238a4abe98068UL,   109 },  // 1e52
+    { 0x9f4f2726179a2245UL,   136 },  // 1e60
+    { 0xed63a231d4c4fb27UL,   162 },  // 1e68
+    { 0xb0de65388cc8ada8UL,   189 },  // 1e76
+    { 0x83c7088e1aab65dbUL,   216 },  // 1e84
+    { 0xc45d1df942711d9aUL,   242 },  // 1e92
+    { 0x924d692ca61be758UL,   269 },  // 1e100
+    { 0xda01ee641a708deaUL,   295 },  // 1e108
+    { 0xa26da3999aef774aUL,   322 },  // 1e116
+    { 0xf209787bb47d6b85UL,   348 },  // 1e124
+    { 0xb454e4a179dd1877UL,   375 },  // 1e132
+    { 0x865b86925b9bc5c2UL,   402 },  // 1e140
+    { 0xc83553c5c8965d3dUL,   428 },  // 1e148
+    { 0x952ab45cfa97a0b3UL,   455 },  // 1e156
+    { 0xde469fbd99a05fe3UL,   481 },  // 1e164
+    { 0xa59bc234db398c25UL,   508 },  // 1e172
+    { 0xf6c69a72a3989f5cUL,   534 },  // 1e180
+    { 0xb7dcbf5354e9beceUL,   561 },  // 1e188
+    { 0x88fcf317f22241e2UL,   588 },  // 1e196
+    { 0xcc20ce9bd35c78a5UL,   614 },  // 1e204
+    { 0x98165af37b2153dfUL,   641 },  // 1e212
+    { 0xe2a0b5dc971f303aUL,   667 },  // 1e220
+    { 0xa8d9d1535ce3b396UL,   694 },  // 1e228
+    { 0xfb9b7cd9a4a7443cUL,   720 },  // 1e236
+    { 0xbb764c4ca7a44410UL,   747 },  // 1e244
+    { 0x8bab8eefb6409c1aUL,   774 },  // 1e252
+    { 0xd01fef10a657842cUL,   800 },  // 1e260
+    { 0x9b10a4e5e9913129UL,   827 },  // 1e268
+    { 0xe7109bfba19c0c9dUL,   853 },  // 1e276
+    { 0xac2820d9623bf429UL,   880 },  // 1e284
+    { 0x80444b5e7aa7cf85UL,   907 },  // 1e292
+    { 0xbf21e44003acdd2dUL,   933 },  // 1e300
+    { 0x8e679c2f5e44ff8fUL,   960 },  // 1e308
+    { 0xd433179d9c8cb841UL,   986 },  // 1e316
+    { 0x9e19db92b4e31ba9UL,  1013 },  // 1e324
+    { 0xeb96bf6ebadf77d9UL,  1039 },  // 1e332
+    { 0xaf87023b9bf0ee6bUL,  1066 },  // 1e340
+};
+
+static const int CACHED_POW10_FIRST = -348;
+static const int CACHED_POW10_STEP = 8;
+
+// Fields of an IEEE 754 double.
+static const int DBL_SIG_BITS = 52;
+static const int DBL_EXP_BIAS = 1023 + DBL_SIG_BITS;
+static const uint64_t DBL_HIDDEN_BIT = 1UL << DBL_SIG_BITS;
+static const uint64_t DBL_SIG_MASK = DBL_HIDDEN_BIT - 1;
+static const uint64_t DBL_EXP_MASK = 0x7FF0000000000000UL;
+
+static inline uint64_t dbl_bits(double d)
+{
+    uint64_t bits;
+    memcpy(&bits, &d, sizeof(bits));
+    return (bits);
+}
+
+static inline double dbl_from_bits(uint64_t bits)
+{
+    double d;
+    memcpy(&d, &bits, sizeof(d));
+    return (d);
+}
+
+// Cached power c with c * 2^e landing in [2^-60, 2^-32) for the digit
+// loop. Sets *k so that c is about 10^-k.
+static Diy_Fp grisu_cached_power(int e, int* k)
+{
+    double dk = (-61 - e) * 0.30102999566398114 + 347;
+    int ik = (int) dk;
+    if (dk - ik > 0.0)
+    {
+        ik++;
+    }
+
+    unsigned index = (ik >> 3) + 1;
+    *k = -(CACHED_POW10_FIRST + (int) index * CACHED_POW10_STEP);
+    return (cached_pow10[index]);
+}
+
+// Moves the last digit towards w while it stays inside the interval.
+static void grisu_round(char* buf, int len, uint64_t delta, uint64_t rest,
+                        uint64_t ten_kappa, uint64_t wp_w)
+{
+    while (rest < wp_w && delta - rest >= ten_kappa &&
+           (rest + ten_kappa < wp_w || wp_w - rest > rest + ten_kappa - wp_w))
+    {
+        buf[len - 1]--;
+        rest += ten_kappa;
+    }
+}
+
+static int grisu_count_digits(uint32_t n)
+{
+    int count = 1;
+    while (count < 10 && n >= pow10_u64[count])
+    {
+        count++;
+    }
+    return (count);
+}
+
+// Generates the shortest digits of the interval (mp - delta, mp].
+static void grisu_digits(Diy_Fp w, Diy_Fp mp, uint64_t delta, char* buf,
+                         int* len, int* k)
+{
+    const Diy_Fp one = { 1UL << -mp.e, mp.e };
+    const uint64_t wp_w = mp.f - w.f;
+    uint32_t p1 = (uint32_t)(mp.f >> -one.e);
+    uint64_t p2 = mp.f & (one.f - 1);
+    int kappa = grisu_count_digits(p1);
+
+    *len = 0;
+
+    // Integer part.
+    while (kappa > 0)
+    {
+        uint32_t div = (uint32_t) pow10_u64[kappa - 1];
+        uint32_t d = p1 / div;
+        p1 %= div;
+        if (d != 0 || *len != 0)
+        {
+            buf[(*len)++] = '0' + d;
+        }
+        kappa--;
+
+        uint64_t rest = ((uint64_t) p1 << -one.e) + p2;
+        if (rest <= delta)
+        {
+            *k += kappa;
+            grisu_round(buf, *len, delta, rest, pow10_u64[kappa] << -one.e, wp_w);
+            return;
+        }
+    }
+
+    // Fractional part.
+    for (;;)
+    {
+        p2 *= 10;
+        delta *= 10;
+        char d = (char)(p2 >> -one.e);
+        if (d != 0 || *len != 0)
+        {
+            buf[(*len)++] = '0' + d;
+        }
+        p2 &= one.f - 1;
+        kappa--;
+
+        if (p2 < delta)
+        {
+            *k += kappa;
+            grisu_round(buf, *len, delta, p2, one.f, wp_w * pow10_u64[-kappa]);
+            return;
+        }
+    }
+}
+
+// Shortest digits that read back as the finite, positive value v: the
+// value is buf[0..len) * 10^k. Grisu2 is shortest for nearly all values
+// and always round-trips.
+static void grisu2(double v, char* buf, int* len, int* k)
+{
+    uint64_t bits = dbl_bits(v);
+    uint64_t sig = bits & DBL_SIG_MASK;
+    int biased = (int)((bits & DBL_EXP_MASK) >> DBL_SIG_BITS);
+
+    Diy_Fp val;
+    if (biased != 0)
+    {
+        val.f = sig + DBL_HIDDEN_BIT;
+        val.e = biased - DBL_EXP_BIAS;
     }
-    /* Checks for positive sign. */
     else
     {
-        if (s[i] == '+')
+        val.f = sig;
+        val.e = 1 - DBL_EXP_BIAS;
+    }
+
+    // Halfway points to the neighbouring doubles. The gap below is half
+    // as wide at powers of two.
+    Diy_Fp plus = { (val.f << 1) + 1, val.e - 1 };
+    while ((plus.f & (DBL_HIDDEN_BIT << 1)) == 0)
+    {
+        plus.f <<= 1;
+        plus.e--;
+    }
+    plus.f <<= 64 - DBL_SIG_BITS - 2;
+    plus.e -= 64 - DBL_SIG_BITS - 2;
+
+    Diy_Fp minus;
+    if (val.f == DBL_HIDDEN_BIT)
+    {
+        minus.f = (val.f << 2) - 1;
+        minus.e = val.e - 2;
+    }
+    else
+    {
+        minus.f = (val.f << 1) - 1;
+        minus.e = val.e - 1;
+    }
+    minus.f <<= minus.e - plus.e;
+    minus.e = plus.e;
+
+    Diy_Fp c = grisu_cached_power(plus.e, k);
+    Diy_Fp w = diy_fp_mul(diy_fp_normalize(val), c);
+    Diy_Fp wp = diy_fp_mul(plus, c);
+    Diy_Fp wm = diy_fp_mul(minus, c);
+
+    // Stay inside the interval despite the rounding of the products.
+    wm.f++;
+    wp.f--;
+    grisu_digits(w, wp, wp.f - wm.f, buf, len, k);
+}
+
+// Writes "nan" or "inf" for a non-finite value, returning the end.
+static char* dtoa_special(uint64_t bits, char* s)
+{
+    memcpy(s, (bits & DBL_SIG_MASK) ? "nan" : "inf", 3);
+    return (s + 3);
+}
+
+char* dtoa(double val, char* str)
+{
+    uint64_t bits = dbl_bits(val);
+    char* s = str;
+
+    if (bits >> 63)
+    {
+        *s++ = '-';
+        bits &= ~(1UL << 63);
+    }
+
+    if ((bits & DBL_EXP_MASK) == DBL_EXP_MASK)
+    {
+        *dtoa_special(bits, s) = '\0';
+        return (str);
+    }
+    if (bits == 0)
+    {
+        s[0] = '0';
+        s[1] = '\0';
+        return (str);
+    }
+
+    char digits[20];
+    int len;
+    int k;
+    grisu2(dbl_from_bits(bits), digits, &len, &k);
+
+    // Place the point as JavaScript does: plain notation from 1e-6 up to
+    // 1e21, exponents outside that.
+    int point = len + k;
+    if (len <= point && point <= 21)
+    {
+        memcpy(s, digits, len);
+        memset(s + len, '0', point - len);
+        s += point;
+    }
+    else if (0 < point && point <= 21)
+    {
+        memcpy(s, digits, point);
+        s[point] = '.';
+        memcpy(s + point + 1, digits + point, len - point);
+        s += len + 1;
+    }
+    else if (-6 < point && point <= 0)
+    {
+        s[0] = '0';
+        s[1] = '.';
+        memset(s + 2, '0', -point);
+        memcpy(s + 2 - point, digits, len);
+        s += 2 - point + len;
+    }
+    else
+    {
+        *s++ = digits[0];
+        if (len > 1)
         {
-            ++i;
+            *s++ = '.';
+            memcpy(s, digits + 1, len - 1);
+            s += len - 1;
         }
+        *s++ = 'e';
+        int exp = point - 1;
+        *s++ = (exp < 0) ? '-' : '+';
+        char tmp[8];
+        char* end = tmp + sizeof(tmp);
+        char* p = utoa_digits(exp < 0 ? -exp : exp, end, 10, false);
+        memcpy(s, p, end - p);
+        s += end - p;
+    }
+    *s = '\0';
+
+    return (str);
+}
+
+// Digits after the point that _dtoa() gets by splitting the value. The
+// scaled fraction then stays below 2^50, where doubles step by at most
+// a quarter.
+static const int DTOA_SPLIT_PRECISION = 15;
+
+static int dtoa_cmp_halfway(double frac, uint64_t fp, int precision);
+
+char* _dtoa(double val, char* str, int precision)
+{
+    uint64_t bits = dbl_bits(val);
+    char* s = str;
+
+    if (precision < 0)
+    {
+        precision = 0;
+    }
+
+    if (bits >> 63)
+    {
+        *s++ = '-';
+        bits &= ~(1UL << 63);
+    }
+
+    if ((bits & DBL_EXP_MASK) == DBL_EXP_MASK)
+    {
+        *dtoa_special(bits, s) = '\0';
+        return (str);
+    }
+
+    double a = dbl_from_bits(bits);
+    char tmp[24];
+    char* end = tmp + sizeof(tmp);
+
+    if (a < 1e18 && precision <= DTOA_SPLIT_PRECISION)
+    {
+        // Split at the point. Both halves are exact, and scaling the
+        // fraction rounds once, by less than a quarter.
+        uint64_t ip = (uint64_t) a;
+        uint64_t scale = pow10_u64[precision];
+        double frac = a - (double) ip;
+        double scaled = frac * (double) scale;
+        uint64_t fp = (uint64_t) scaled;
+        double rem = scaled - (double) fp;
+
+        // Near a tie the rounding of the product matters: decide exactly.
+        int order;
+        double slop = scaled * 0x1p-52 + 0x1p-60;
+        if (rem - 0.5 <= slop && 0.5 - rem <= slop)
+        {
+            order = dtoa_cmp_halfway(frac, fp, precision);
+        }
+        else
+        {
+            order = (rem > 0.5) ? 1 : -1;
+        }
+
+        // Ties go to the even last digit, which is in ip without a fraction.
+        uint64_t last = (precision > 0) ? fp : ip;
+        if (order > 0 || (order == 0 && (last & 1)))
+        {
+            fp++;
+        }
+        if (fp >= scale)
+        {
+            ip++;
+            fp -= scale;
+        }
+
+        char* p = utoa_digits(ip, end, 10, false);
+        memcpy(s, p, end - p);
+        s += end - p;
+
+        if (precision > 0)
+        {
+            *s++ = '.';
+            p = utoa_digits(fp, end, 10, false);
+            memset(s, '0', precision - (end - p));
+            s += precision - (end - p);
+            memcpy(s, p, end - p);
+            s += end - p;
+        }
+        *s = '\0';
+        return (str);
+    }
+
+    // Too large to split, or more digits asked for than a double holds:
+    // lay out the shortest digits and fill the rest with zeros.
+    char digits[20];
+    int len = 0;
+    int k = 0;
+    if (bits != 0)
+    {
+        grisu2(a, digits, &len, &k);
+    }
+
+    int point = len + k;
+    if (point <= 0)
+    {
+        *s++ = '0';
+    }
+    else
+    {
+        int n = (point < len) ? point : len;
+        memcpy(s, digits, n);
+        memset(s + n, '0', point - n);
+        s += point;
+    }
+
+    if (precision > 0)
+    {
+        *s++ = '.';
+        for (int i = 0; i < precision; i++)
+        {
+            int d = point + i;
+            *s++ = (d >= 0 && d < len) ? digits[d] : '0';
+        }
+    }
+    *s = '\0';
+
+    return (str);
+}
+
+// Powers of ten that doubles hold exactly.
+static const double pow10_exact[23] =
+{
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+// Significant digits strtod() reads exactly when it has to. A point halfway
+// between two doubles has at most 767, so digits past these only matter
+// as a sign that the value is a little larger.
+static const int STRTOD_MAX_DIGITS = 800;
+
+// Big integers for the rare strtod() inputs that land too close to a
+// rounding boundary for the 64-bit estimate. 128 words hold the largest
+// operand: STRTOD_MAX_DIGITS digits scaled up to the smallest subnormal.
+static const int STRTOD_BIG_WORDS = 128;
+
+struct Strtod_Big
+{
+    uint32_t w[STRTOD_BIG_WORDS];
+    int n;
+};
+
+static void strtod_big_set(Strtod_Big* b, uint64_t val)
+{
+    b->w[0] = (uint32_t) val;
+    b->w[1] = (uint32_t)(val >> 32);
+    b->n = (val >> 32) ? 2 : 1;
+}
+
+static void strtod_big_mul(Strtod_Big* b, uint32_t m)
+{
+    uint64_t carry = 0;
+    for (int i = 0; i < b->n; i++)
+    {
+        uint64_t p = (uint64_t) b->w[i] * m + carry;
+        b->w[i] = (uint32_t) p;
+        carry = p >> 32;
+    }
+    if (carry != 0)
+    {
+        b->w[b->n++] = (uint32_t) carry;
+    }
+}
+
+static void strtod_big_add(Strtod_Big* b, uint32_t a)
+{
+    uint64_t carry = a;
+    for (int i = 0; i < b->n && carry != 0; i++)
+    {
+        uint64_t sum = (uint64_t) b->w[i] + carry;
+        b->w[i] = (uint32_t) sum;
+        carry = sum >> 32;
+    }
+    if (carry != 0)
+    {
+        b->w[b->n++] = (uint32_t) carry;
+    }
+}
+
+static void strtod_big_mul_pow10(Strtod_Big* b, int e)
+{
+    for (; e >= 9; e -= 9)
+    {
+        strtod_big_mul(b, 1000000000);
+    }
+    if (e > 0)
+    {
+        strtod_big_mul(b, (uint32_t) pow10_u64[e]);
+    }
+}
+
+static void strtod_big_shl(Strtod_Big* b, int bits)
+{
+    int words = bits / 32;
+    bits %= 32;
+
+    b->w[b->n] = 0;
+    for (int i = b->n; i >= 0; i--)
+    {
+        uint32_t hi = (bits != 0 && i > 0) ? b->w[i - 1] >> (32 - bits) : 0;
+        b->w[i + words] = (b->w[i] << bits) | hi;
+    }
+    for (int i = 0; i < words; i++)
+    {
+        b->w[i] = 0;
+    }
+    b->n += words + 1;
+    while (b->n > 1 && b->w[b->n - 1] == 0)
+    {
+        b->n--;
+    }
+}
+
+static int strtod_big_cmp(const Strtod_Big* a, const Strtod_Big* b)
+{
+    if (a->n != b->n)
+    {
+        return ((a->n > b->n) ? 1 : -1);
+    }
+    for (int i = a->n - 1; i >= 0; i--)
+    {
+        if (a->w[i] != b->w[i])
+        {
+            return ((a->w[i] > b->w[i]) ? 1 : -1);
+        }
+    }
+    return (0);
+}
+
+// Error bound of the 64-bit estimate, in its last bit.
+static const uint64_t STRTOD_SLOP = 8;
+
+// How far digits dropped past the 19th can raise the value, in the last
+// bit of the estimate: under 10^-18 of it, or 2^64 / 10^18 at most.
+static const uint64_t STRTOD_DROPPED_SLOP = 20;
+
+// Significant digits of a strtod() input, kept for the exact compare.
+struct Strtod_Digits
+{
+    /// First nonzero digit. Digits run on from here, past a '.'.
+    const char* first;
+
+    /// Number of digits from first on, not counting the '.'.
+    int count;
+};
+
+// Compares digits * 10^exp10 with the point halfway between m * 2^e and
+// the next multiple of 2^e, where exp10 places the last of the digits.
+// Returns its sign like strcmp().
+static int strtod_cmp_halfway(const Strtod_Digits* digits, int exp10, uint64_t m, int e)
+{
+    Strtod_Big val;
+    Strtod_Big half;
+
+    // Read the digits nine at a time. Nonzero ones past STRTOD_MAX_DIGITS
+    // make the value larger than what was read, by less than can reach
+    // the next representable halfway point.
+    strtod_big_set(&val, 0);
+    bool sticky = false;
+    uint32_t chunk = 0;
+    int chunk_len = 0;
+    const char* p = digits->first;
+    for (int i = 0; i < digits->count; i++, p++)
+    {
+        if (*p == '.')
+        {
+            p++;
+        }
+
+        if (i >= STRTOD_MAX_DIGITS)
+        {
+            sticky |= (*p != '0');
+            exp10++;
+            continue;
+        }
+
+        chunk = chunk * 10 + (*p - '0');
+        if (++chunk_len == 9)
+        {
+            strtod_big_mul(&val, 1000000000);
+            strtod_big_add(&val, chunk);
+            chunk = 0;
+            chunk_len = 0;
+        }
+    }
+    if (chunk_len > 0)
+    {
+        strtod_big_mul(&val, (uint32_t) pow10_u64[chunk_len]);
+        strtod_big_add(&val, chunk);
+    }
+
+    // Halfway is (2m + 1) * 2^(e - 1). Scale both sides to integers.
+    strtod_big_set(&half, 2 * m + 1);
+
+    if (exp10 >= 0)
+    {
+        strtod_big_mul_pow10(&val, exp10);
+    }
+    else
+    {
+        strtod_big_mul_pow10(&half, -exp10);
+    }
+
+    if (e - 1 >= 0)
+    {
+        strtod_big_shl(&half, e - 1);
+    }
+    else
+    {
+        strtod_big_shl(&val, 1 - e);
+    }
+
+    int order = strtod_big_cmp(&val, &half);
+    return ((order == 0 && sticky) ? 1 : order);
+}
+
+// Compares frac * 10^precision with fp + 1/2 exactly, for rounding
+// _dtoa() output. Returns its sign like strcmp().
+static int dtoa_cmp_halfway(double frac, uint64_t fp, int precision)
+{
+    uint64_t bits = dbl_bits(frac);
+    int biased = (int)((bits & DBL_EXP_MASK) >> DBL_SIG_BITS);
+    uint64_t sig = bits & DBL_SIG_MASK;
+
+    // frac is sig * 2^-shift.
+    int shift = 1 - DBL_EXP_BIAS;
+    if (biased != 0)
+    {
+        sig += DBL_HIDDEN_BIT;
+        shift = biased - DBL_EXP_BIAS;
+    }
+    shift = -shift;
+
+    // Compare 2 * sig * 10^precision with (2fp + 1) * 2^shift.
+    Strtod_Big val;
+    Strtod_Big half;
+    strtod_big_set(&val, sig);
+    strtod_big_mul_pow10(&val, precision);
+    strtod_big_shl(&val, 1);
+    strtod_big_set(&half, 2 * fp + 1);
+    strtod_big_shl(&half, shift);
+
+    return (strtod_big_cmp(&val, &half));
+}
+
+// Nearest double to mant * 10^exp10, where mant is the first 19 or fewer
+// of the digits. When later digits were dropped, the value is a little
+// more than that and the digits decide close cases.
+static double strtod_scale(uint64_t mant, int exp10, const Strtod_Digits* digits)
+{
+    if (mant == 0)
+    {
+        return (0.0);
+    }
+
+    // Clinger's fast path: both factors are exact, so the one rounding
+    // of the product or quotient gives the right answer.
+    if (mant <= (1UL << 53) && exp10 >= -22 && exp10 <= 22)
+    {
+        double d = (double) mant;
+        return ((exp10 < 0) ? d / pow10_exact[-exp10] : d * pow10_exact[exp10]);
+    }
+
+    if (exp10 < -343)
+    {
+        errno = ERANGE;
+        return (0.0);
+    }
+    if (exp10 > 308)
+    {
+        errno = ERANGE;
+        return (__builtin_huge_val());
     }
 
-    /* Converts ASCII digits to double. */
-    while (isdigit(s[i]) != 0)
+    // Scale by a cached power and an exact one below it. The two
+    // products are each off by at most half a 64-bit ulp, so only results
+    // within STRTOD_SLOP of a halfway point need checking.
+    Diy_Fp v = { mant, 0 };
+    v = diy_fp_normalize(v);
+
+    int index = (exp10 - CACHED_POW10_FIRST) / CACHED_POW10_STEP;
+    int rest = exp10 - (CACHED_POW10_FIRST + index * CACHED_POW10_STEP);
+    if (rest > 0)
     {
-        val *= 10.0;
-        val += (float)(s[i] - '0');
-        ++i;
+        Diy_Fp adjust = { pow10_u64[rest], 0 };
+        v = diy_fp_normalize(diy_fp_mul(v, diy_fp_normalize(adjust)));
     }
+    v = diy_fp_normalize(diy_fp_mul(v, cached_pow10[index]));
 
-    /* Checks for decimal point. */
-    if (s[i] == '.')
+    // Round the 64-bit significand to the 53 bits of a normal double, or
+    // fewer for a subnormal one.
+    int top = v.e + 63;
+    if (top > 1023)
     {
-        ++i;
+        errno = ERANGE;
+        return (__builtin_huge_val());
     }
 
-    double decimal = 10; /* Value to multiply fractional part by. */
-    size_t decimal_place = 1;
+    // Dropped digits can only add to the value, so they widen the window
+    // below halfway in which the estimate can't be trusted.
+    bool dropped = digits->count > 19;
+    uint64_t below = STRTOD_SLOP + (dropped ? STRTOD_DROPPED_SLOP : 0);
+    int last_exp10 = dropped ? exp10 - (digits->count - 19) : exp10;
 
-    /* Converts ASCII digits to fractional part of double. */
-    while ((isdigit(s[i]) != 0) && (decimal_place <= DBL_DIG))
+    int keep = DBL_SIG_BITS + 1;
+    if (top < -1022)
     {
-        val += (s[i] - '0') / decimal;
-        decimal *= 10;
-        ++decimal_place;
-        ++i;
+        // Subnormal. With no bits kept, the value can still round up to
+        // the smallest subnormal.
+        errno = ERANGE;
+        keep -= -1022 - top;
+        if (keep < 0)
+        {
+            // Under half the smallest subnormal, unless the estimate fell
+            // just short of it.
+            if (keep == -1 && ~v.f <= below &&
+                strtod_cmp_halfway(digits, last_exp10, 0, 1 - DBL_EXP_BIAS) > 0)
+            {
+                return (dbl_from_bits(1));
+            }
+            return (0.0);
+        }
     }
 
-    return (val_sign * val);
-}
-
-int atoi(const char* s)
-{
-    int val = 0;
-    size_t i = 0;
+    int shift = 64 - keep;
+    uint64_t m = (shift < 64) ? v.f >> shift : 0;
+    uint64_t lost = (shift < 64) ? v.f & ((1UL << shift) - 1) : v.f;
+    uint64_t half = 1UL << (shift - 1);
 
-    /* If sign is 1, integer is positive. If sign is -1, integer is
-     * negative. Default is positive. */
-    int sign = 1;
+    // Too close to halfway to trust the estimate: decide exactly.
+    int order;
+    if (lost - half + below <= below + STRTOD_SLOP)
+    {
+        order = strtod_cmp_halfway(digits, last_exp10, m, v.e + shift);
+    }
+    else
+    {
+        order = (lost > half) ? 1 : -1;
+    }
 
-    /* Ignores any whitespace at beginning of string. */
-    while (isspace(s[i]) != 0)
+    if (order > 0 || (order == 0 && (m & 1)))
     {
-        ++i;
+        m++;
     }
 
-    /* Checks for negative sign. */
-    if (s[i] == '-')
+    if (top < -1022)
     {
-        sign = -1;
-        ++i;
+        // Rounding up to 2^52 carries into the smallest normal exponent.
+        return (dbl_from_bits(m));
     }
-    /* Checks for positive sign. */
-    else
+
+    if (m == (DBL_HIDDEN_BIT << 1))
     {
-        if (s[i] == '+')
+        m >>= 1;
+        top++;
+        if (top > 1023)
         {
-            ++i;
+            errno = ERANGE;
+            return (__builtin_huge_val());
         }
     }
 
-    /* Converts ASCII digits to int. */
-    while (isdigit(s[i]) != 0)
+    return (dbl_from_bits(((uint64_t)(top + 1023) << DBL_SIG_BITS) | (m & DBL_SIG_MASK)));
+}
+
+// Whether s starts with word, ignoring case.
+static bool strtod_match(const char* s, const char* word)
+{
+    for (; *word != '\0'; s++, word++)
     {
-        val = val * 10;
-        val += s[i] - '0';
-        ++i;
+        if ((*s | 0x20) != *word)
+        {
+            return (false);
+        }
     }
-
-    return (sign * val);
+    return (true);
 }
 
-long atol(const char* s)
+double strtod(const char* s, char** endp)
 {
-    long val = 0;
-    size_t i = 0;
+    const char* p = s;
+    bool negative = false;
+    double val;
 
-    /* If sign is 1, integer is positive. If sign is -1, integer is
-     * negative. Default is positive. */
-    long sign = 1;
+    while (isspace(*p) != 0)
+    {
+        ++p;
+    }
 
-    /* Ignores any whitespace at beginning of string. */
-    while (isspace(s[i]) != 0)
+    if (*p == '-' || *p == '+')
     {
-        ++i;
+        negative = (*p == '-');
+        ++p;
     }
 
-    /* Checks for negative sign. */
-    if (s[i] == '-')
+    if (strtod_match(p, "inf"))
     {
-        sign = -1;
-        ++i;
+        p += strtod_match(p + 3, "inity") ? 8 : 3;
+        val = __builtin_inf();
+    }
+    else if (strtod_match(p, "nan"))
+    {
+        p += 3;
+        val = __builtin_nan("");
     }
-    /* Checks for positive sign. */
     else
     {
-        if (s[i] == '+')
+        // The first 19 significant digits fit in 64 bits. Later ones are
+        // dropped, moving the exponent instead, but are still counted for
+        // strtod_scale() to go back to.
+        uint64_t mant = 0;
+        int exp10 = 0;
+        bool any = false;
+        Strtod_Digits digits = { NULL, 0 };
+
+        for (; isdigit(*p) != 0; ++p)
+        {
+            any = true;
+            if (digits.first == NULL && *p != '0')
+            {
+                digits.first = p;
+            }
+            if (digits.first == NULL)
+            {
+                continue;
+            }
+
+            if (digits.count < 19)
+            {
+                mant = mant * 10 + (*p - '0');
+            }
+            else
+            {
+                exp10++;
+            }
+            digits.count++;
+        }
+
+        if (*p == '.')
+        {
+            for (++p; isdigit(*p) != 0; ++p)
+            {
+                any = true;
+                if (digits.first == NULL && *p != '0')
+                {
+                    digits.first = p;
+                }
+
+                if (digits.first == NULL)
+                {
+                    exp10--;
+                }
+                else if (digits.count < 19)
+                {
+                    mant = mant * 10 + (*p - '0');
+                    exp10--;
+                }
+                if (digits.first != NULL)
+                {
+                    digits.count++;
+                }
+            }
+        }
+
+        if (!any)
+        {
+            if (endp != NULL)
+            {
+                *endp = (char*) s;
+            }
+            return (0.0);
+        }
+
+        // The exponent only counts if it has digits.
+        if ((*p | 0x20) == 'e')
         {
-            ++i;
+            const char* q = p + 1;
+            bool exp_negative = false;
+            if (*q == '-' || *q == '+')
+            {
+                exp_negative = (*q == '-');
+                ++q;
+            }
+
+            if (isdigit(*q) != 0)
+            {
+                int exp = 0;
+                for (; isdigit(*q) != 0; ++q)
+                {
+                    if (exp < 100000)
+                    {
+                        exp = exp * 10 + (*q - '0');
+                    }
+                }
+                exp10 += exp_negative ? -exp : exp;
+                p = q;
+            }
         }
+
+        val = strtod_scale(mant, exp10, &digits);
     }
 
-    /* Converts ASCII digits to long. */
-    while (isdigit(s[i]) != 0)
+    if (endp != NULL)
     {
-        val *= 10;
-        val += s[i] - '0';
-        ++i;
+        *endp = (char*) p;
     }
 
-    return (sign * val);
+    return (negative ? -val : val);
+}
+
+double atof(const char* s)
+{
+    return (strtod(s, NULL));
+}
+
+int atoi(const char* s)
+{
+    return ((int) strtol(s, NULL, 10));
+}
+
+long atol(const char* s)
+{
+    return (strtol(s, NULL, 10));
 }
 
 char* btoa(uint8_t val, char* str, size_t bits)
@@ -209,73 +1373,9 @@ char* itoa(int val, char* str)
 
 char* _itoa(int val, char* str, int base)
 {
-    const char digit[] = "0123456789ABCDEF";
-    size_t str_i = 0;
-
-    if (val < 0)
-    {
-        str[str_i] = '-';
-        ++str_i;
-        val *= -1;
-    }
-
-    switch (base)
-    {
-    case (2):
-        str[str_i] = '0';
-        ++str_i;
-        str[str_i] = 'b';
-        ++str_i;
-        break;
-
-    case (8):
-        str[str_i] = '0';
-        ++str_i;
-        break;
-
-    case (10):
-        break;
-
-    case (16):
-        str[str_i] = '0';
-        ++str_i;
-        str[str_i] = 'x';
-        ++str_i;
-        break;
-
-    default:
-        str = "ERROR: BASE NOT SUPPORTED";
-        return (str);
-    }
-
-    if (val == 0)
-    {
-        str[str_i] = digit[0];
-        str[str_i + 1] = '\0';
-        return (str);
-    }
-
-    size_t place = 0;
-    int place_val = val;
-
-    while (place_val > 0)
-    {
-        ++place;
-        place_val /= base;
-    }
-
-    str_i += place;
-
-    str[str_i] = '\0';
-
-    while (val > 0)
-    {
-        --str_i;
-        str[str_i] = digit[val%base];
-        val /= base;
-    }
-
-    return (str);
+    // Negate as unsigned so INT_MIN survives.
+    unsigned long mag = (val < 0) ? 0 - (unsigned long)(long) val : (unsigned long) val;
+    return (itoa_prefixed(mag, val < 0, str, base));
 }
 
 long labs(long n)
@@ -297,195 +1397,381 @@ char* litoa(long val, char* str)
 
 char* _litoa(long val, char* str, int base)
 {
-    const char digit[] = "0123456789ABCDEF";
-    size_t str_i = 0;
+    unsigned long mag = (val < 0) ? 0 - (unsigned long) val : (unsigned long) val;
+    return (itoa_prefixed(mag, val < 0, str, base));
+}
 
-    if (val < 0)
-    {
-        str[str_i] = '-';
-        ++str_i;
-        val *= -1;
-    }
+char* sitoa(size_t val, char* str)
+{
+    return ( _sitoa(val, str, 10) );
+}
 
-    switch (base)
-    {
-    case (2):
-        str[0] = '0';
-        str[1] = 'b';
-        str_i += 2;
-        break;
+char* _sitoa(size_t val, char* str, int base)
+{
+    return (itoa_prefixed(val, false, str, base));
+}
 
-    case (8):
-        str[0] = '0';
-        ++str_i;
-        break;
+char* ftoa(float val, char* str)
+{
+    return (_dtoa(val, str, 6));
+}
 
-    case (10):
-        break;
+// Partitions this small are finished with insertion sort.
+static const size_t QSORT_SMALL = 16;
 
-    case (16):
-        str[0] = '0';
-        str[1] = 'x';
-        str_i += 2;
-        break;
+// Swaps two elements, a word at a time when their layout allows it.
+static inline void qsort_swap(char* a, char* b, size_t size)
+{
+    if ((((uintptr_t)a | (uintptr_t)b | size) & (sizeof(uint64_t) - 1)) == 0)
+    {
+        uint64_t* wa = (uint64_t*)a;
+        uint64_t* wb = (uint64_t*)b;
+        for (size_t i = 0; i < size / sizeof(uint64_t); i++)
+        {
+            uint64_t tmp = wa[i];
+            wa[i] = wb[i];
+            wb[i] = tmp;
+        }
+        return;
+    }
 
-    default:
-        str = "ERROR: BASE NOT SUPPORTED";
-        return (str);
+    for (size_t i = 0; i < size; i++)
+    {
+        char tmp = a[i];
+        a[i] = b[i];
+        b[i] = tmp;
     }
+}
 
-    if (val == 0)
+static void qsort_insertion(char* base, size_t n, size_t size,
+                            int (*cmp)(const void*, const void*))
+{
+    for (size_t i = 1; i < n; i++)
     {
-        str[str_i] = digit[0];
-        str[str_i + 1] = '\0';
-        return (str);
+        for (char* p = base + i * size; p > base && cmp(p - size, p) > 0; p -= size)
+        {
+            qsort_swap(p - size, p, size);
+        }
     }
+}
 
-    size_t place = 0;
-    long place_val = val;
+// Moves element i down the max-heap of n elements until it is no smaller
+// than its children.
+static void qsort_sift(char* base, size_t i, size_t n, size_t size,
+                       int (*cmp)(const void*, const void*))
+{
+    for (;;)
+    {
+        size_t child = 2 * i + 1;
+        if (child >= n)
+        {
+            return;
+        }
+        if (child + 1 < n && cmp(base + child * size, base + (child + 1) * size) < 0)
+        {
+            child++;
+        }
+        if (cmp(base + i * size, base + child * size) >= 0)
+        {
+            return;
+        }
+        qsort_swap(base + i * size, base + child * size, size);
+        i = child;
+    }
+}
 
-    while (place_val > 0)
+static void qsort_heap(char* base, size_t n, size_t size,
+                       int (*cmp)(const void*, const void*))
+{
+    for (size_t i = n / 2; i > 0; i--)
     {
-        ++place;
-        place_val /= base;
+        qsort_sift(base, i - 1, n, size, cmp);
     }
+    for (size_t end = n - 1; end > 0; end--)
+    {
+        qsort_swap(base, base + end * size, size);
+        qsort_sift(base, 0, end, size, cmp);
+    }
+}
 
-    str_i += place;
+// Quicksort that falls back to heapsort once depth runs out, so
+// adversarial input still sorts in O(n log n).
+static void qsort_intro(char* base, size_t n, size_t size,
+                        int (*cmp)(const void*, const void*), size_t depth)
+{
+    while (n > QSORT_SMALL)
+    {
+        if (depth == 0)
+        {
+            qsort_heap(base, n, size, cmp);
+            return;
+        }
+        depth--;
+
+        // Order the first, middle and last elements, then use the median
+        // as the pivot at the front. The last element then stops the
+        // upward scan and the pivot stops the downward one.
+        char* mid = base + (n / 2) * size;
+        char* last = base + (n - 1) * size;
+        if (cmp(mid, base) < 0)
+        {
+            qsort_swap(mid, base, size);
+        }
+        if (cmp(last, mid) < 0)
+        {
+            qsort_swap(last, mid, size);
+            if (cmp(mid, base) < 0)
+            {
+                qsort_swap(mid, base, size);
+            }
+        }
+        qsort_swap(base, mid, size);
 
-    str[str_i] = '\0';
+        // Hoare partition. Both scans stop on elements equal to the
+        // pivot, which keeps runs of duplicates balanced.
+        char* lo = base;
+        char* hi = base + n * size;
+        for (;;)
+        {
+            do
+            {
+                lo += size;
+            } while (cmp(lo, base) < 0);
+            do
+            {
+                hi -= size;
+            } while (cmp(hi, base) > 0);
+
+            if (lo >= hi)
+            {
+                break;
+            }
+            qsort_swap(lo, hi, size);
+        }
+        qsort_swap(base, hi, size);
 
-    while (val > 0)
-    {
-        --str_i;
-        str[str_i] = digit[val%base];
-        val /= base;
+        // Recurse into the smaller side and loop on the larger, which
+        // bounds the stack at O(log n).
+        size_t left = (hi - base) / size;
+        size_t right = n - left - 1;
+        if (left < right)
+        {
+            qsort_intro(base, left, size, cmp, depth);
+            base = hi + size;
+            n = right;
+        }
+        else
+        {
+            qsort_intro(hi + size, right, size, cmp, depth);
+            n = left;
+        }
     }
 
-    return (str);
+    qsort_insertion(base, n, size, cmp);
 }
 
-char* sitoa(size_t val, char* str)
+void qsort(void* base, size_t n, size_t size,
+           int (*cmp)(const void*, const void*))
 {
-    return ( _sitoa(val, str, 10) );
+    if (n < 2 || size == 0)
+    {
+        return;
+    }
+
+    // Allow twice the depth of a balanced split before giving up.
+    size_t depth = 2 * (63 - __builtin_clzl(n));
+    qsort_intro((char*)base, n, size, cmp, depth);
 }
 
-char* _sitoa(size_t val, char* str, int base)
+void* bsearch(const void* key, const void* base, size_t n, size_t size,
+              int (*cmp)(const void* keyval, const void* datum))
 {
-    const char digit[] = "0123456789ABCDEF";
-    size_t str_i = 0;
+    const char* lo = (const char*)base;
 
-    switch (base)
+    while (n > 0)
     {
-    case (2):
-        str[0] = '0';
-        str[1] = 'b';
-        str_i += 2;
-        break;
+        const char* mid = lo + (n / 2) * size;
+        int order = cmp(key, mid);
+        if (order == 0)
+        {
+            return ((void*)mid);
+        }
+        if (order > 0)
+        {
+            lo = mid + size;
+            n -= n / 2 + 1;
+        }
+        else
+        {
+            n /= 2;
+        }
+    }
 
-    case (8):
-        str[0] = '0';
-        ++str_i;
-        break;
+    return (NULL);
+}
 
-    case (10):
-        break;
+// Random numbers. Each CPU runs its own xoshiro256** generator, so callers
+// never share state or a lock. Generators seed themselves on first use
+// from RDSEED or RDRAND, or from the TSC on CPUs without either.
 
-    case (16):
-        str[0] = '0';
-        str[1] = 'x';
-        str_i += 2;
-        break;
+// Number of times a hardware read is retried before giving up on it.
+#define RAND_HW_TRIES 10
 
-    default:
-        str = "ERROR: BASE NOT SUPPORTED";
-        return (str);
-    }
+// Bytes rand_fill() produces with interrupts off at a time.
+#define RAND_FILL_CHUNK 256
 
-    if (val == 0)
-    {
-        str[str_i] = digit[0];
-        str[str_i + 1] = '\0';
-        return (str);
-    }
+struct Rand_Cpu
+{
+    uint64_t s[4];
+    bool seeded;
+} __attribute__((aligned(64)));
+
+static Rand_Cpu rand_cpu[CPU_MAX];
 
-    size_t place = 0;
-    size_t place_val = val;
+static inline uint64_t rand_rotl(uint64_t x, int k)
+{
+    return ((x << k) | (x >> (64 - k)));
+}
+
+// Spreads a 64-bit seed over the state; splitmix64 never leaves it all
+// zero, which xoshiro can't leave.
+static uint64_t rand_splitmix(uint64_t* x)
+{
+    uint64_t z = (*x += 0x9e3779b97f4a7c15UL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9UL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebUL;
+    return (z ^ (z >> 31));
+}
 
-    while (place_val > 0)
+static void rand_seed_state(Rand_Cpu* r, uint64_t seed)
+{
+    for (size_t i = 0; i < 4; i++)
     {
-        ++place;
-        place_val /= base;
+        r->s[i] = rand_splitmix(&seed);
     }
+    r->seeded = true;
+}
 
-    str_i += place;
+// Gets a 64-bit seed from the best source the CPU has.
+static uint64_t rand_hw_seed(void)
+{
+    uint64_t val;
+    for (size_t i = 0; i < RAND_HW_TRIES; i++)
+    {
+        if (cpu_has(CPU_FEATURE_RDSEED) && cpu_rdseed(&val))
+        {
+            return (val);
+        }
+        if (cpu_has(CPU_FEATURE_RDRAND) && cpu_rdrand(&val))
+        {
+            return (val);
+        }
+        if (!cpu_has(CPU_FEATURE_RDSEED) && !cpu_has(CPU_FEATURE_RDRAND))
+        {
+            break;
+        }
+    }
 
-    str[str_i] = '\0';
+    // The low bits of the TSC jitter with the time spent in port IO.
+    uint64_t seed = cpu_rdtsc();
+    for (size_t i = 0; i < 8; i++)
+    {
+        cpu_io_wait();
+        seed = rand_rotl(seed, 8) ^ cpu_rdtsc();
+    }
+    return (seed ^ ((uint64_t)cpu_id() << 56));
+}
 
-    while (val > 0)
+// Advances the calling CPU's generator. Interrupts must be off.
+static inline uint64_t rand_next(Rand_Cpu* r)
+{
+    if (!r->seeded)
     {
-        --str_i;
-        str[str_i] = digit[val%base];
-        val /= base;
+        rand_seed_state(r, rand_hw_seed());
     }
 
-    return (str);
+    uint64_t* s = r->s;
+    uint64_t result = rand_rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rand_rotl(s[3], 45);
+    return (result);
 }
 
-char* ftoa(float val, char* str)
+uint64_t rand64(void)
 {
-    const char digit[] = "0123456789";
-    size_t pos = 0;
-    
-    // Get integer component.
-    litoa((long)val, str);
-    
-    // Get fractional component.
-    pos = strlen(str);
-    str[pos] = '.';
-    ++pos;
-    
-    val -= (long)val;
-    for (size_t i = 0; i < 6; ++i)
-    {
-        val *= 10.0F;
-        str[pos] = digit[(long)val % 10];
-        val -= (long)val;
-        ++pos;
-    }
-    
-    str[pos] = '\0';
+    uint64_t flags = cpu_irq_save();
+    uint64_t val = rand_next(&rand_cpu[cpu_id()]);
+    cpu_irq_restore(flags);
+    return (val);
+}
 
-    return (str);
+// Lemire's multiply-and-reject: the high half of val * bound is uniform
+// in [0, bound) once the few low halves that would bias it are redrawn.
+uint64_t rand_range(uint64_t bound)
+{
+    unsigned __int128 m = (unsigned __int128)rand64() * bound;
+    uint64_t low = (uint64_t)m;
+    if (low < bound)
+    {
+        uint64_t threshold = (0 - bound) % bound;
+        while (low < threshold)
+        {
+            m = (unsigned __int128)rand64() * bound;
+            low = (uint64_t)m;
+        }
+    }
+    return ((uint64_t)(m >> 64));
 }
 
-static unsigned long int rand_seed;
-int rand_max(unsigned int max) // RAND_MAX assumed to be 32767
+void rand_fill(void* buf, size_t n)
 {
-    static bool seeded = false;
-    if (!seeded)
+    uint8_t* dst = (uint8_t*)buf;
+    while (n > 0)
     {
-        volatile unsigned long int start = cpu_rdtsc();
-        volatile unsigned long int skip = start;
-        while (skip /= 10)
+        size_t chunk = (n < RAND_FILL_CHUNK) ? n : RAND_FILL_CHUNK;
+        n -= chunk;
+
+        uint64_t flags = cpu_irq_save();
+        Rand_Cpu* r = &rand_cpu[cpu_id()];
+        for (; chunk >= sizeof(uint64_t); chunk -= sizeof(uint64_t))
+        {
+            uint64_t val = rand_next(r);
+            memcpy(dst, &val, sizeof(val));
+            dst += sizeof(val);
+        }
+        if (chunk > 0)
         {
-            cpu_io_wait();
-            skip += (cpu_rdtsc() - start) % 10;
+            uint64_t val = rand_next(r);
+            memcpy(dst, &val, chunk);
+            dst += chunk;
         }
-        skip = cpu_rdtsc() - start;
-        rand_seed = cpu_rdtsc() - start;
-        seeded = true;
+        cpu_irq_restore(flags);
     }
+}
 
-    rand_seed = rand_seed * 1103515245 + 12345;
-    return (unsigned int)(rand_seed / 65536) % (max + 1);
+int rand_max(unsigned int max)
+{
+    // Larger bounds would give results an int can't hold.
+    if (max > RAND_MAX)
+    {
+        max = RAND_MAX;
+    }
+    return ((int)rand_range((uint64_t)max + 1));
 }
 
 int rand()
 {
-    return rand_max(32767);
+    return ((int)(rand64() >> 33));
 }
 
 void srand( unsigned int seed )
 {
-    rand_seed = seed;
+    uint64_t flags = cpu_irq_save();
+    rand_seed_state(&rand_cpu[cpu_id()], seed);
+    cpu_irq_restore(flags);
 }
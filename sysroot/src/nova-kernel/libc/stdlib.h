@@ -16,6 +16,9 @@
 extern "C" {
 #endif
 
+/// Largest value returned by rand().
+#define RAND_MAX 0x7fffffff
+
 /**
  * @brief Converts string to double.
  *
@@ -55,7 +58,7 @@ long atol(const char* s);
  * HUGE_VAL is returned with the proper sign; if the answer would underflow,
  * zero is returned. In either error case, errno is set to ERANGE.
  */
-//double strtod(const char* s, char** endp);
+double strtod(const char* s, char** endp);
 
 /**
  * @brief Converts the prefix a string to long, ignoring leading white space;
@@ -99,21 +102,128 @@ long strtol(const char* s, char** endp, int base);
 unsigned long strtoul(const char* s, char** endp, int base);
 
 /**
- * @brief Returns a pseudo-random integer in the range 0 to RAND_MAX, which
- * is at least 32767.
+ * @brief Returns a pseudo-random integer in the range 0 to RAND_MAX.
+ *
+ * Each CPU has its own generator, seeded on first use from the hardware
+ * random number generator, or the TSC if the CPU has none. The numbers
+ * are fast and well spread, but not fit for cryptography.
  *
  * @return Pseudo-random integer generated.
  */
 int rand(void);
 
 /**
- * @brief Uses seed as the seed for a new sequence of pseudo-random numbers.
- * The initial seed is 1.
+ * @brief Uses seed as the seed for a new sequence of pseudo-random numbers
+ * on the calling CPU, for repeatable runs. Other CPUs are unaffected.
  */
 void srand(unsigned int seed);
 
+/// Returns a pseudo-random integer in the range 0 to max, inclusive. A max
+/// above RAND_MAX is taken as RAND_MAX.
 int rand_max(unsigned int max);
 
+/// Returns 64 pseudo-random bits. See rand().
+uint64_t rand64(void);
+
+/**
+ * @brief Returns a pseudo-random integer in the range 0 to bound - 1,
+ * without the bias of reducing rand64() modulo bound.
+ *
+ * @param bound Number of possible results. Must not be 0.
+ *
+ * @return Pseudo-random integer generated.
+ */
+uint64_t rand_range(uint64_t bound);
+
+/**
+ * @brief Fills a buffer with pseudo-random bytes. See rand().
+ *
+ * @param buf Buffer to fill.
+ * @param n Number of bytes.
+ */
+void rand_fill(void* buf, size_t n);
+
+/**
+ * @brief Allocates memory. Small blocks come from per-CPU slab caches and
+ * never take the global heap lock.
+ *
+ * @param size Number of bytes to allocate.
+ *
+ * @return Pointer to the allocated memory, or NULL on failure.
+ */
+void* malloc(size_t size);
+
+/**
+ * @brief Allocates zeroed memory for an array.
+ *
+ * @param nobj Number of elements.
+ * @param size Size of each element.
+ *
+ * @return Pointer to the allocated memory, or NULL on failure or if
+ * nobj * size overflows.
+ */
+void* calloc(size_t nobj, size_t size);
+
+/**
+ * @brief Resizes a block of memory, moving it if needed.
+ *
+ * @param p Block to resize, or NULL to allocate a new one.
+ * @param size New size of the block.
+ *
+ * @return Pointer to the resized block, or NULL on failure, in which case
+ * p is left untouched.
+ */
+void* realloc(void* p, size_t size);
+
+/**
+ * @brief Frees memory returned by malloc(), calloc() or realloc().
+ *
+ * @param p Block to free. May be NULL.
+ */
+void free(void* p);
+
+/**
+ * @brief Allocates memory with a given alignment.
+ *
+ * @param align Alignment of the block. Must be a power of two.
+ * @param size Number of bytes to allocate.
+ *
+ * @return Pointer to the allocated memory, or NULL on failure or if align
+ * is not a power of two.
+ */
+void* aligned_alloc(size_t align, size_t size);
+
+/**
+ * @brief Allocates memory with a given alignment.
+ *
+ * @param p Where to store the pointer to the allocated memory.
+ * @param align Alignment of the block. Must be a power of two and a
+ * multiple of sizeof(void*).
+ * @param size Number of bytes to allocate.
+ *
+ * @return 0 on success, EINVAL if align is invalid or ENOMEM if out of
+ * memory.
+ */
+int posix_memalign(void** p, size_t align, size_t size);
+
+/**
+ * @brief Frees memory whose size is known, which lets small blocks skip
+ * looking up their size class.
+ *
+ * @param p Block to free. May be NULL.
+ * @param size Size the block was allocated with.
+ */
+void free_sized(void* p, size_t size);
+
+/**
+ * @brief Frees memory from aligned_alloc() whose size is known.
+ *
+ * @param p Block to free. May be NULL.
+ * @param align Alignment the block was allocated with.
+ * @param size Size the block was allocated with.
+ */
+void free_aligned_sized(void* p, size_t align, size_t size);
+
 /**
  * @brief Searches array for an item that matches the key specified using a
  * specified function.
@@ -337,8 +447,62 @@ char* _sitoa(size_t val, char* str, int base);
  */
 char* btoa(uint8_t val, char* str, size_t bits);
 
+/**
+ * @brief Converts value to a string with six digits after the point.
+ *
+ * @param val Value to convert.
+ * @param str String to store converted value in. At least 48 bytes.
+ *
+ * @return str.
+ *
+ * @see _dtoa()
+ */
 char* ftoa(float val, char* str);
 
+/**
+ * @brief Converts value to the shortest string that reads back as the
+ * same double, in plain notation from 1e-6 to 1e21 and as "1.5e+300" or
+ * "2e-7" outside that.
+ *
+ * @param val Value to convert.
+ * @param str String to store converted value in. At least 32 bytes.
+ *
+ * @return str.
+ */
+char* dtoa(double val, char* str);
+
+/**
+ * @brief Converts value to a string with a fixed number of digits after
+ * the point, as printf("%.*f") does.
+ *
+ * @param val Value to convert.
+ * @param str String to store converted value in. At least 312 bytes plus
+ * the precision.
+ * @param precision Number of digits after the point. None, and no point,
+ * if 0.
+ *
+ * @return str.
+ *
+ * @note Digits past the 17 significant ones a double holds are written
+ * as zeros rather than the exact decimal expansion of the binary value.
+ */
+char* _dtoa(double val, char* str, int precision);
+
+/**
+ * @brief Writes the digits of a value right to left, ending just before
+ * end, without a sign, prefix or terminator. For formatting code that
+ * builds numbers in place.
+ *
+ * @param val Value to convert.
+ * @param end One past where the last digit goes. There must be room for
+ * 64 digits before it in base 2, or 20 in base 10.
+ * @param base Base between 2 and 36.
+ * @param upper Whether digits above 9 are upper case.
+ *
+ * @return Pointer to the first digit.
+ */
+char* utoa_digits(unsigned long val, char* end, int base, bool upper);
+
 #ifdef __cplusplus
 }
 #endif
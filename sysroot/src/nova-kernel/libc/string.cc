@@ -25,18 +25,301 @@
 
 #include <string.h>
 
+#ifdef ARCH_X86_64
+#include <arch/x86_64/cpu_features.h>
+#endif // ARCH_X86_64
+
+#ifdef ARCH_X86_64
+
+/*
+ * The searches compare 16 bytes at a time with pcmpeqb and turn the result
+ * into a bit mask with pmovmskb. strlen, strchr and memchr only load whole
+ * aligned blocks, which never cross a page, and mask off the bytes before
+ * the start. strcmp can't align both strings at once, so it steps bytewise
+ * while either is within 16 bytes of a page boundary.
+ */
+
+/* Every page is at least this large, so a load that doesn't cross a
+ * multiple of it can't fault even if it reads past the end of a string. */
+#define STR_PAGE_SIZE 4096
+
+typedef char str_v16 __attribute__((vector_size(16)));
+typedef char str_v16u __attribute__((vector_size(16), aligned(1), may_alias));
+
+/* Bit i is set where byte i of a and b are equal. */
+static inline uint32_t str_eq(str_v16 a, str_v16 b)
+{
+    return ((uint32_t)__builtin_ia32_pmovmskb128((str_v16)(a == b)));
+}
+
 void* memchr(const void* cs, int c, size_t n)
 {
-    for (size_t i = 0; i < n; ++i)
+    if (n == 0)
+    {
+        return (NULL);
+    }
+
+    const uint8_t* s = (const uint8_t*)cs;
+    const str_v16* p = (const str_v16*)((uintptr_t)s & ~(uintptr_t)15);
+    size_t skip = (uintptr_t)s & 15;
+    str_v16 vc = (str_v16){} + (char)c;
+
+    /* Bits are counted from cs, which may be inside the first block. */
+    uint32_t mask = str_eq(*p, vc) >> skip;
+    size_t done = 0;
+    size_t scanned = 16 - skip;
+
+    while (mask == 0 && scanned < n)
+    {
+        ++p;
+        done = scanned;
+        mask = str_eq(*p, vc);
+        scanned += 16;
+    }
+
+    if (mask != 0)
+    {
+        size_t i = done + __builtin_ctz(mask);
+        if (i < n)
+        {
+            return ((void*)(s + i));
+        }
+    }
+
+    return (NULL);
+}
+
+const char* strchr(const char* cs, int c)
+{
+    const str_v16* p = (const str_v16*)((uintptr_t)cs & ~(uintptr_t)15);
+    size_t skip = (uintptr_t)cs & 15;
+    str_v16 vc = (str_v16){} + (char)c;
+    str_v16 zero = {};
+
+    /* Stop at the first byte that is either c or the terminator. */
+    str_v16 v = *p;
+    uint32_t mask = ((str_eq(v, vc) | str_eq(v, zero)) >> skip) << skip;
+    while (mask == 0)
+    {
+        v = *++p;
+        mask = str_eq(v, vc) | str_eq(v, zero);
+    }
+
+    const char* hit = (const char*)p + __builtin_ctz(mask);
+    if (*hit == (char)c)
+    {
+        return (hit);
+    }
+    return (NULL);
+}
+
+int strcmp(const char* cs, const char* ct)
+{
+    const uint8_t* a = (const uint8_t*)cs;
+    const uint8_t* b = (const uint8_t*)ct;
+    str_v16 zero = {};
+
+    for (;;)
+    {
+        if (((uintptr_t)a & (STR_PAGE_SIZE - 1)) > STR_PAGE_SIZE - 16 ||
+            ((uintptr_t)b & (STR_PAGE_SIZE - 1)) > STR_PAGE_SIZE - 16)
+        {
+            /* A 16-byte load here could touch the next page. */
+            if (*a != *b || *a == '\0')
+            {
+                return (*a - *b);
+            }
+            ++a;
+            ++b;
+            continue;
+        }
+
+        str_v16 va = *(const str_v16u*)a;
+        str_v16 vb = *(const str_v16u*)b;
+
+        /* Bits for bytes that differ or end the strings. */
+        uint32_t mask = (~str_eq(va, vb) | str_eq(va, zero)) & 0xffff;
+        if (mask != 0)
+        {
+            size_t i = __builtin_ctz(mask);
+            return (a[i] - b[i]);
+        }
+
+        a += 16;
+        b += 16;
+    }
+}
+
+size_t strlen(const char* cs)
+{
+    const str_v16* p = (const str_v16*)((uintptr_t)cs & ~(uintptr_t)15);
+    size_t skip = (uintptr_t)cs & 15;
+    str_v16 zero = {};
+
+    uint32_t mask = (str_eq(*p, zero) >> skip) << skip;
+    while (mask == 0)
+    {
+        ++p;
+        mask = str_eq(*p, zero);
+    }
+
+    return ((const char*)p + __builtin_ctz(mask) - cs);
+}
+
+#else
+
+/*
+ * The searches read a word at a time and find zero bytes with the usual
+ * trick: (w - 0x01..01) & ~w & 0x80..80 is nonzero exactly when some byte
+ * of w is zero. Loads are aligned, so they never cross a page, and bytes
+ * before the start of the string are handled one at a time.
+ */
+
+#define STR_ONES  ((unsigned long)-1 / 0xff)
+#define STR_HIGHS (STR_ONES * 0x80)
+
+static inline bool str_has_zero(unsigned long w)
+{
+    return (((w - STR_ONES) & ~w & STR_HIGHS) != 0);
+}
+
+void* memchr(const void* cs, int c, size_t n)
+{
+    const uint8_t* s = (const uint8_t*)cs;
+    uint8_t c1 = (uint8_t)c;
+
+    for (; n > 0 && ((uintptr_t)s & (sizeof(unsigned long) - 1)) != 0; --n, ++s)
     {
-        if ((((uint8_t*) cs)[i]) == ((uint8_t) c))
+        if (*s == c1)
         {
-            return ((void*) &(((uint8_t*) cs)[i]));
+            return ((void*)s);
+        }
+    }
+
+    /* Bytes equal to c become zero bytes after the xor. */
+    unsigned long pattern = c1 * STR_ONES;
+    for (; n >= sizeof(unsigned long); n -= sizeof(unsigned long))
+    {
+        if (str_has_zero(*(const unsigned long*)s ^ pattern))
+        {
+            break;
+        }
+        s += sizeof(unsigned long);
+    }
+
+    for (; n > 0; --n, ++s)
+    {
+        if (*s == c1)
+        {
+            return ((void*)s);
         }
     }
     return (NULL);
 }
 
+const char* strchr(const char* cs, int c)
+{
+    char c1 = (char)c;
+
+    for (; ((uintptr_t)cs & (sizeof(unsigned long) - 1)) != 0; ++cs)
+    {
+        if (*cs == c1)
+        {
+            return (cs);
+        }
+        if (*cs == '\0')
+        {
+            return (NULL);
+        }
+    }
+
+    unsigned long pattern = (uint8_t)c1 * STR_ONES;
+    for (;;)
+    {
+        unsigned long w = *(const unsigned long*)cs;
+        if (str_has_zero(w) || str_has_zero(w ^ pattern))
+        {
+            break;
+        }
+        cs += sizeof(unsigned long);
+    }
+
+    for (;; ++cs)
+    {
+        if (*cs == c1)
+        {
+            return (cs);
+        }
+        if (*cs == '\0')
+        {
+            return (NULL);
+        }
+    }
+}
+
+int strcmp(const char* cs, const char* ct)
+{
+    const uint8_t* a = (const uint8_t*)cs;
+    const uint8_t* b = (const uint8_t*)ct;
+
+    /* Words can only be compared when both strings align together. */
+    if ((((uintptr_t)a ^ (uintptr_t)b) & (sizeof(unsigned long) - 1)) == 0)
+    {
+        for (; ((uintptr_t)a & (sizeof(unsigned long) - 1)) != 0; ++a, ++b)
+        {
+            if (*a != *b || *a == '\0')
+            {
+                return (*a - *b);
+            }
+        }
+
+        for (;;)
+        {
+            unsigned long w = *(const unsigned long*)a;
+            if (w != *(const unsigned long*)b || str_has_zero(w))
+            {
+                break;
+            }
+            a += sizeof(unsigned long);
+            b += sizeof(unsigned long);
+        }
+    }
+
+    for (;; ++a, ++b)
+    {
+        if (*a != *b || *a == '\0')
+        {
+            return (*a - *b);
+        }
+    }
+}
+
+size_t strlen(const char* cs)
+{
+    const char* s = cs;
+
+    for (; ((uintptr_t)s & (sizeof(unsigned long) - 1)) != 0; ++s)
+    {
+        if (*s == '\0')
+        {
+            return (s - cs);
+        }
+    }
+
+    while (!str_has_zero(*(const unsigned long*)s))
+    {
+        s += sizeof(unsigned long);
+    }
+
+    while (*s != '\0')
+    {
+        ++s;
+    }
+    return (s - cs);
+}
+
+#endif // ARCH_X86_64
+
 int memcmp(const void* cs, const void* ct, size_t n)
 {
     for (size_t i = 0; i < n; ++i)
@@ -56,6 +339,339 @@ int memcmp(const void* cs, const void* ct, size_t n)
     return (0);
 }
 
+#ifdef ARCH_X86_64
+
+/*
+ * Copies and fills are dispatched by size:
+ *  - up to 32 bytes, a pair of overlapping loads and stores;
+ *  - up to MEM_NT_MIN, a 16-byte SSE2 loop storing to an aligned
+ *    destination, or rep movsb/stosb on CPUs with fast string
+ *    operations (ERMS, or FSRM for shorter strings);
+ *  - beyond that, non-temporal stores that keep a multi-page copy from
+ *    flushing the caches.
+ * The first and last 16 bytes of a block are loaded before anything is
+ * stored and written last with unaligned stores, which covers the ragged
+ * ends and makes the forward and backward loops safe for memmove.
+ */
+
+/* Size above which stores bypass the caches (64 pages). */
+#define MEM_NT_MIN (256 * 1024)
+
+typedef uint64_t mem_u64 __attribute__((may_alias, aligned(1)));
+typedef uint32_t mem_u32 __attribute__((may_alias, aligned(1)));
+typedef uint16_t mem_u16 __attribute__((may_alias, aligned(1)));
+
+/* Size from which rep movsb/stosb beat the SSE2 loops, or SIZE_MAX if
+ * they never do on this CPU. */
+static inline size_t mem_rep_threshold(void)
+{
+    if (cpu_has(CPU_FEATURE_FSRM))
+    {
+        /* Fast short rep movsb. */
+        return (256);
+    }
+
+    if (cpu_has(CPU_FEATURE_ERMS))
+    {
+        /* Enhanced rep movsb wins once its startup is paid off. */
+        return (2048);
+    }
+
+    return (SIZE_MAX);
+}
+
+/* Copies up to 32 bytes. Everything is loaded before anything is stored,
+ * so the blocks may overlap. */
+static inline void mem_copy_small(uint8_t* d, const uint8_t* s, size_t n)
+{
+    if (n >= 16)
+    {
+        asm volatile
+        (
+            "movdqu (%[s]), %%xmm0 \n"
+            "movdqu -16(%[s],%[n]), %%xmm1 \n"
+            "movdqu %%xmm0, (%[d]) \n"
+            "movdqu %%xmm1, -16(%[d],%[n]) \n"
+            :
+            : [d] "r" (d), [s] "r" (s), [n] "r" (n)
+            : "xmm0", "xmm1", "memory"
+        );
+    }
+    else if (n >= 8)
+    {
+        uint64_t head = *(const mem_u64*)s;
+        uint64_t tail = *(const mem_u64*)(s + n - 8);
+        *(mem_u64*)d = head;
+        *(mem_u64*)(d + n - 8) = tail;
+    }
+    else if (n >= 4)
+    {
+        uint32_t head = *(const mem_u32*)s;
+        uint32_t tail = *(const mem_u32*)(s + n - 4);
+        *(mem_u32*)d = head;
+        *(mem_u32*)(d + n - 4) = tail;
+    }
+    else if (n >= 2)
+    {
+        uint16_t head = *(const mem_u16*)s;
+        uint16_t tail = *(const mem_u16*)(s + n - 2);
+        *(mem_u16*)d = head;
+        *(mem_u16*)(d + n - 2) = tail;
+    }
+    else if (n == 1)
+    {
+        *d = *s;
+    }
+}
+
+/* Copies more than 32 bytes front to back. Safe for memmove when the
+ * destination lies below the source. */
+static void mem_copy_forward(uint8_t* d, const uint8_t* s, size_t n)
+{
+    size_t skew = 16 - ((uintptr_t)d & 15);
+    uint8_t* p = d + skew;
+    const uint8_t* q = s + skew;
+    size_t left = n - skew;
+
+    if (n >= MEM_NT_MIN)
+    {
+        asm volatile
+        (
+            "movdqu (%[s]), %%xmm0 \n"
+            "movdqu -16(%[s],%[n]), %%xmm1 \n"
+            "1: \n"
+            "movdqu (%[q]), %%xmm2 \n"
+            "movntdq %%xmm2, (%[p]) \n"
+            "add $16, %[q] \n"
+            "add $16, %[p] \n"
+            "sub $16, %[left] \n"
+            "cmp $16, %[left] \n"
+            "ja 1b \n"
+            "sfence \n"
+            "movdqu %%xmm1, -16(%[d],%[n]) \n"
+            "movdqu %%xmm0, (%[d]) \n"
+            : [p] "+r" (p), [q] "+r" (q), [left] "+r" (left)
+            : [d] "r" (d), [s] "r" (s), [n] "r" (n)
+            : "xmm0", "xmm1", "xmm2", "memory", "cc"
+        );
+        return;
+    }
+
+    asm volatile
+    (
+        "movdqu (%[s]), %%xmm0 \n"
+        "movdqu -16(%[s],%[n]), %%xmm1 \n"
+        "cmp $64, %[left] \n"
+        "jbe 2f \n"
+        "1: \n"
+        "movdqu (%[q]), %%xmm2 \n"
+        "movdqu 16(%[q]), %%xmm3 \n"
+        "movdqu 32(%[q]), %%xmm4 \n"
+        "movdqu 48(%[q]), %%xmm5 \n"
+        "movdqa %%xmm2, (%[p]) \n"
+        "movdqa %%xmm3, 16(%[p]) \n"
+        "movdqa %%xmm4, 32(%[p]) \n"
+        "movdqa %%xmm5, 48(%[p]) \n"
+        "add $64, %[q] \n"
+        "add $64, %[p] \n"
+        "sub $64, %[left] \n"
+        "cmp $64, %[left] \n"
+        "ja 1b \n"
+        "2: \n"
+        "cmp $16, %[left] \n"
+        "jbe 3f \n"
+        "movdqu (%[q]), %%xmm2 \n"
+        "movdqa %%xmm2, (%[p]) \n"
+        "add $16, %[q] \n"
+        "add $16, %[p] \n"
+        "sub $16, %[left] \n"
+        "jmp 2b \n"
+        "3: \n"
+        "movdqu %%xmm1, -16(%[d],%[n]) \n"
+        "movdqu %%xmm0, (%[d]) \n"
+        : [p] "+r" (p), [q] "+r" (q), [left] "+r" (left)
+        : [d] "r" (d), [s] "r" (s), [n] "r" (n)
+        : "xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5", "memory", "cc"
+    );
+}
+
+/* Copies more than 32 bytes back to front, for memmove when the
+ * destination lies above an overlapping source. */
+static void mem_copy_backward(uint8_t* d, const uint8_t* s, size_t n)
+{
+    uint8_t* p = (uint8_t*)((uintptr_t)(d + n) & ~(uintptr_t)15);
+    const uint8_t* q = s + (p - d);
+    size_t left = p - d;
+
+    asm volatile
+    (
+        "movdqu (%[s]), %%xmm0 \n"
+        "movdqu -16(%[s],%[n]), %%xmm1 \n"
+        "1: \n"
+        "sub $16, %[q] \n"
+        "sub $16, %[p] \n"
+        "movdqu (%[q]), %%xmm2 \n"
+        "movdqa %%xmm2, (%[p]) \n"
+        "sub $16, %[left] \n"
+        "cmp $16, %[left] \n"
+        "ja 1b \n"
+        "movdqu %%xmm1, -16(%[d],%[n]) \n"
+        "movdqu %%xmm0, (%[d]) \n"
+        : [p] "+r" (p), [q] "+r" (q), [left] "+r" (left)
+        : [d] "r" (d), [s] "r" (s), [n] "r" (n)
+        : "xmm0", "xmm1", "xmm2", "memory", "cc"
+    );
+}
+
+void* memcpy(void* s, const void* ct, size_t n)
+{
+    uint8_t* d = (uint8_t*)s;
+    const uint8_t* src = (const uint8_t*)ct;
+
+    if (n <= 32)
+    {
+        mem_copy_small(d, src, n);
+    }
+    else if (n >= mem_rep_threshold() && n < MEM_NT_MIN)
+    {
+        asm volatile
+        (
+            "rep movsb \n"
+            : "+D" (d), "+S" (src), "+c" (n)
+            :
+            : "memory"
+        );
+    }
+    else
+    {
+        mem_copy_forward(d, src, n);
+    }
+
+    return (s);
+}
+
+void* memmove(void* s, const void* ct, size_t n)
+{
+    uint8_t* d = (uint8_t*)s;
+    const uint8_t* src = (const uint8_t*)ct;
+
+    if (n <= 32)
+    {
+        mem_copy_small(d, src, n);
+    }
+    else if ((uintptr_t)d - (uintptr_t)src >= n)
+    {
+        /* Forward is safe unless the destination starts inside the
+         * source. */
+        mem_copy_forward(d, src, n);
+    }
+    else
+    {
+        mem_copy_backward(d, src, n);
+    }
+
+    return (s);
+}
+
+void* memset(void* s, int c, size_t n)
+{
+    uint8_t* d = (uint8_t*)s;
+    uint64_t pattern = (uint8_t)c * 0x0101010101010101UL;
+
+    if (n < 16)
+    {
+        if (n >= 8)
+        {
+            *(mem_u64*)d = pattern;
+            *(mem_u64*)(d + n - 8) = pattern;
+        }
+        else if (n >= 4)
+        {
+            *(mem_u32*)d = (uint32_t)pattern;
+            *(mem_u32*)(d + n - 4) = (uint32_t)pattern;
+        }
+        else
+        {
+            for (size_t i = 0; i < n; ++i)
+            {
+                d[i] = (uint8_t)c;
+            }
+        }
+        return (s);
+    }
+
+    if (n >= mem_rep_threshold() && n < MEM_NT_MIN)
+    {
+        asm volatile
+        (
+            "rep stosb \n"
+            : "+D" (d), "+c" (n)
+            : "a" (c)
+            : "memory"
+        );
+        return (s);
+    }
+
+    uint8_t* p = (uint8_t*)(((uintptr_t)d + 16) & ~(uintptr_t)15);
+    size_t left = d + n - p;
+
+    if (n >= MEM_NT_MIN)
+    {
+        asm volatile
+        (
+            "movq %[pat], %%xmm0 \n"
+            "punpcklqdq %%xmm0, %%xmm0 \n"
+            "movdqu %%xmm0, (%[d]) \n"
+            "1: \n"
+            "movntdq %%xmm0, (%[p]) \n"
+            "add $16, %[p] \n"
+            "sub $16, %[left] \n"
+            "cmp $16, %[left] \n"
+            "ja 1b \n"
+            "sfence \n"
+            "movdqu %%xmm0, -16(%[d],%[n]) \n"
+            : [p] "+r" (p), [left] "+r" (left)
+            : [d] "r" (d), [n] "r" (n), [pat] "r" (pattern)
+            : "xmm0", "memory", "cc"
+        );
+        return (s);
+    }
+
+    asm volatile
+    (
+        "movq %[pat], %%xmm0 \n"
+        "punpcklqdq %%xmm0, %%xmm0 \n"
+        "movdqu %%xmm0, (%[d]) \n"
+        "cmp $64, %[left] \n"
+        "jbe 2f \n"
+        "1: \n"
+        "movdqa %%xmm0, (%[p]) \n"
+        "movdqa %%xmm0, 16(%[p]) \n"
+        "movdqa %%xmm0, 32(%[p]) \n"
+        "movdqa %%xmm0, 48(%[p]) \n"
+        "add $64, %[p] \n"
+        "sub $64, %[left] \n"
+        "cmp $64, %[left] \n"
+        "ja 1b \n"
+        "2: \n"
+        "cmp $16, %[left] \n"
+        "jbe 3f \n"
+        "movdqa %%xmm0, (%[p]) \n"
+        "add $16, %[p] \n"
+        "sub $16, %[left] \n"
+        "jmp 2b \n"
+        "3: \n"
+        "movdqu %%xmm0, -16(%[d],%[n]) \n"
+        : [p] "+r" (p), [left] "+r" (left)
+        : [d] "r" (d), [n] "r" (n), [pat] "r" (pattern)
+        : "xmm0", "memory", "cc"
+    );
+
+    return (s);
+}
+
+#else
+
 void* memcpy(void* s, const void* ct, size_t n)
 {
     /* If locations are the same, there is no reason to copy. */
@@ -109,6 +725,8 @@ void* memset(void* s, int c, size_t n)
     return (s);
 }
 
+#endif // ARCH_X86_64
+
 char* strcat(char* s, const char* ct)
 {
     size_t s_length = strlen(s);
@@ -123,46 +741,6 @@ char* strcat(char* s, const char* ct)
     return (s);
 }
 
-const char* strchr(const char* cs, int c)
-{
-    for (size_t i = 0; cs[i] != '\0'; ++i)
-    {
-        if (cs[i] == ((char) c))
-        {
-            return (&cs[i]);
-        }
-    }
-    return (NULL);
-}
-
-int strcmp(const char* cs, const char* ct)
-{
-    for (size_t i = 0; (cs[i] != '\0') && (ct[i] != '\0'); ++i)
-    {
-        if (((unsigned char) cs[i]) > ((unsigned char) ct[i]))
-        {
-            return (1);
-        }
-
-        if (((unsigned char) cs[i]) < ((unsigned char) ct[i]))
-        {
-            return (-1);
-        }
-    }
-
-    if (strlen(cs) > strlen(ct))
-    {
-        return (1);
-    }
-
-    if (strlen(cs) < strlen(ct))
-    {
-        return (-1);
-    }
-
-    return (0);
-}
-
 int strncmp(const char* cs, const char* ct, size_t n)
 {
     for (size_t i = 0; (cs[i] != '\0') && (ct[i] != '\0'); ++i)
@@ -228,17 +806,6 @@ size_t strcspn(const char* cs, const char* ct)
     return (length);
 }
 
-size_t strlen(const char* cs)
-{
-    for (size_t i = 0; /* */ ; ++i)
-    {
-        if (cs[i] == '\0')
-        {
-            return (i);
-        }
-    }
-}
-
 char* strncat(char* s, const char* ct, size_t n)
 {
     size_t s_length = strlen(s);
@@ -345,6 +912,13 @@ const char* strstr(const char* cs, const char* ct)
 {
     const char* ret;
 
+    // The empty string is found at the start, not at the terminator
+    // strchr would find.
+    if (ct[0] == '\0')
+    {
+        return (cs);
+    }
+
     ret = strchr(cs, ct[0]);
     while (ret != NULL)
     {
@@ -356,7 +930,7 @@ const char* strstr(const char* cs, const char* ct)
             }
         }
 
-        ret = strchr(ret, ct[0]);
+        ret = strchr(ret + 1, ct[0]);
     }
 
     return (ret);
@@ -390,10 +964,9 @@ char * strtok (char *s, const char *delim)
     /* Find the end of the token.  */
     token = s;
     s = (char*)strpbrk(token, delim);
-    size_t len = strlen(s);
     if (s == NULL)
         /* This token finishes the string.  */
-        olds = (char*)memchr(token, '\0', len);
+        olds = token + strlen(token);
     else
     {
         /* Terminate the token and make OLDS point past it.  */
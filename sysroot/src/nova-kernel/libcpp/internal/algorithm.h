@@ -6,6 +6,13 @@
 
 #pragma once
 
+#include <globals.h>
+
+#include <internal/functional.h>
+#include <internal/iterator.h>
+#include <internal/new.h>
+#include <internal/utility.h>
+
 namespace std
 {
 
@@ -57,4 +64,411 @@ constexpr It2 swap_ranges(It1 src, It1 end, It2 dest)
     return dest;
 }
 
+
+template <class It>
+void reverse(It first, It last)
+{
+    while (first != last && first != --last)
+    {
+        iter_swap(first, last);
+        ++first;
+    }
+}
+
+
+// Rotates [first, last) so middle becomes the first element. Returns where
+// first ended up.
+template <class It>
+It rotate(It first, It middle, It last)
+{
+    if (first == middle)
+    {
+        return last;
+    }
+    if (middle == last)
+    {
+        return first;
+    }
+
+    It ret = next(first, distance(middle, last));
+    reverse(first, middle);
+    reverse(middle, last);
+    reverse(first, last);
+    return ret;
+}
+
+
+// Moves the elements for which pred is true in front of the others.
+// Returns the first element of the second group.
+template <class It, class Pred>
+It partition(It first, It last, Pred pred)
+{
+    while (first != last && pred(*first))
+    {
+        ++first;
+    }
+    if (first == last)
+    {
+        return first;
+    }
+
+    for (It it = next(first); it != last; ++it)
+    {
+        if (pred(*it))
+        {
+            iter_swap(it, first);
+            ++first;
+        }
+    }
+    return first;
+}
+
+
+// First element not ordered before value.
+template <class It, class T, class Compare>
+It lower_bound(It first, It last, const T& value, Compare comp)
+{
+    auto n = distance(first, last);
+    while (n > 0)
+    {
+        auto half = n / 2;
+        It mid = next(first, half);
+        if (comp(*mid, value))
+        {
+            first = ++mid;
+            n -= half + 1;
+        }
+        else
+        {
+            n = half;
+        }
+    }
+    return first;
+}
+
+template <class It, class T>
+It lower_bound(It first, It last, const T& value)
+{
+    return lower_bound(first, last, value, less<T>());
+}
+
+
+// First element ordered after value.
+template <class It, class T, class Compare>
+It upper_bound(It first, It last, const T& value, Compare comp)
+{
+    auto n = distance(first, last);
+    while (n > 0)
+    {
+        auto half = n / 2;
+        It mid = next(first, half);
+        if (!comp(value, *mid))
+        {
+            first = ++mid;
+            n -= half + 1;
+        }
+        else
+        {
+            n = half;
+        }
+    }
+    return first;
+}
+
+template <class It, class T>
+It upper_bound(It first, It last, const T& value)
+{
+    return upper_bound(first, last, value, less<T>());
+}
+
+
+// Sorting. The comparator is a template parameter, so it is inlined into
+// the loops instead of being called through a pointer as qsort() must.
+
+// Ranges this small are finished with insertion sort.
+constexpr ptrdiff_t sort_small = 16;
+
+template <class It, class Compare>
+void sort_insertion(It first, It last, Compare comp)
+{
+    if (first == last)
+    {
+        return;
+    }
+
+    for (It i = first + 1; i != last; ++i)
+    {
+        auto value = move(*i);
+        It j = i;
+        for (; j != first && comp(value, *(j - 1)); --j)
+        {
+            *j = move(*(j - 1));
+        }
+        *j = move(value);
+    }
+}
+
+template <class It, class Compare>
+void sort_sift(It first, ptrdiff_t i, ptrdiff_t n, Compare comp)
+{
+    auto value = move(first[i]);
+    for (;;)
+    {
+        ptrdiff_t child = 2 * i + 1;
+        if (child >= n)
+        {
+            break;
+        }
+        if (child + 1 < n && comp(first[child], first[child + 1]))
+        {
+            child++;
+        }
+        if (!comp(value, first[child]))
+        {
+            break;
+        }
+        first[i] = move(first[child]);
+        i = child;
+    }
+    first[i] = move(value);
+}
+
+template <class It, class Compare>
+void sort_heap_fallback(It first, It last, Compare comp)
+{
+    ptrdiff_t n = last - first;
+    for (ptrdiff_t i = n / 2; i > 0; i--)
+    {
+        sort_sift(first, i - 1, n, comp);
+    }
+    for (ptrdiff_t end = n - 1; end > 0; end--)
+    {
+        iter_swap(first, first + end);
+        sort_sift(first, 0, end, comp);
+    }
+}
+
+// Quicksort that switches to heapsort once depth runs out. Small ranges
+// are left for one insertion sort pass over the whole array.
+template <class It, class Compare>
+void sort_intro(It first, It last, Compare comp, int depth)
+{
+    while (last - first > sort_small)
+    {
+        if (depth == 0)
+        {
+            sort_heap_fallback(first, last, comp);
+            return;
+        }
+        depth--;
+
+        // Median of three at the front. The last element then stops the
+        // upward scan and the pivot stops the downward one.
+        It mid = first + (last - first) / 2;
+        It back = last - 1;
+        if (comp(*mid, *first))
+        {
+            iter_swap(mid, first);
+        }
+        if (comp(*back, *mid))
+        {
+            iter_swap(back, mid);
+            if (comp(*mid, *first))
+            {
+                iter_swap(mid, first);
+            }
+        }
+        iter_swap(first, mid);
+
+        // Hoare partition around *first.
+        It lo = first;
+        It hi = last;
+        for (;;)
+        {
+            while (comp(*++lo, *first))
+            {
+            }
+            while (comp(*first, *--hi))
+            {
+            }
+            if (!(lo < hi))
+            {
+                break;
+            }
+            iter_swap(lo, hi);
+        }
+        iter_swap(first, hi);
+
+        // Recurse into the smaller side, loop on the larger.
+        if (hi - first < last - hi)
+        {
+            sort_intro(first, hi, comp, depth);
+            first = hi + 1;
+        }
+        else
+        {
+            sort_intro(hi + 1, last, comp, depth);
+            last = hi;
+        }
+    }
+}
+
+template <class It, class Compare>
+void sort(It first, It last, Compare comp)
+{
+    ptrdiff_t n = last - first;
+    if (n < 2)
+    {
+        return;
+    }
+
+    sort_intro(first, last, comp, 2 * (63 - __builtin_clzl(n)));
+    sort_insertion(first, last, comp);
+}
+
+template <class It>
+void sort(It first, It last)
+{
+    sort(first, last, less<typename iterator_traits<It>::value_type>());
+}
+
+
+// Merges the sorted runs [first, middle) and [middle, last) without extra
+// memory, by rotating one run's tail past the other's head.
+template <class It, class Compare>
+void merge_in_place(It first, It middle, It last, Compare comp)
+{
+    ptrdiff_t n1 = middle - first;
+    ptrdiff_t n2 = last - middle;
+    if (n1 == 0 || n2 == 0)
+    {
+        return;
+    }
+    if (n1 + n2 == 2)
+    {
+        if (comp(*middle, *first))
+        {
+            iter_swap(first, middle);
+        }
+        return;
+    }
+
+    It cut1;
+    It cut2;
+    if (n1 > n2)
+    {
+        cut1 = first + n1 / 2;
+        cut2 = lower_bound(middle, last, *cut1, comp);
+    }
+    else
+    {
+        cut2 = middle + n2 / 2;
+        cut1 = upper_bound(first, middle, *cut2, comp);
+    }
+
+    It split = rotate(cut1, middle, cut2);
+    merge_in_place(first, cut1, split, comp);
+    merge_in_place(split, cut2, last, comp);
+}
+
+// Merge sort using buf, which has room for half the range, to hold the
+// left run while merging.
+template <class It, class T, class Compare>
+void stable_sort_merge(It first, It last, T* buf, Compare comp)
+{
+    ptrdiff_t n = last - first;
+    if (n <= sort_small)
+    {
+        sort_insertion(first, last, comp);
+        return;
+    }
+
+    It middle = first + n / 2;
+    stable_sort_merge(first, middle, buf, comp);
+    stable_sort_merge(middle, last, buf, comp);
+
+    // Already in order.
+    if (!comp(*middle, *(middle - 1)))
+    {
+        return;
+    }
+
+    if (buf == nullptr)
+    {
+        merge_in_place(first, middle, last, comp);
+        return;
+    }
+
+    ptrdiff_t n1 = middle - first;
+    for (ptrdiff_t i = 0; i < n1; i++)
+    {
+        new (&buf[i]) T(move(first[i]));
+    }
+
+    // Ties take the left run's element first, which keeps the sort stable.
+    T* left = buf;
+    T* left_end = buf + n1;
+    It right = middle;
+    It out = first;
+    while (left != left_end && right != last)
+    {
+        if (comp(*right, *left))
+        {
+            *out = move(*right);
+            ++right;
+        }
+        else
+        {
+            *out = move(*left);
+            ++left;
+        }
+        ++out;
+    }
+    while (left != left_end)
+    {
+        *out = move(*left);
+        ++left;
+        ++out;
+    }
+
+    for (ptrdiff_t i = 0; i < n1; i++)
+    {
+        buf[i].~T();
+    }
+}
+
+template <class It, class Compare>
+void stable_sort(It first, It last, Compare comp)
+{
+    using T = typename iterator_traits<It>::value_type;
+
+    ptrdiff_t n = last - first;
+    if (n < 2)
+    {
+        return;
+    }
+
+    // Without room for the merge buffer, merge in place instead: slower,
+    // but still stable.
+    size_t bytes = ((n + 1) / 2) * sizeof(T);
+    T* buf = nullptr;
+    if (n > sort_small)
+    {
+        buf = static_cast<T*>(::operator new(bytes));
+    }
+
+    stable_sort_merge(first, last, buf, comp);
+
+    if (buf != nullptr)
+    {
+        ::operator delete(buf, bytes);
+    }
+}
+
+template <class It>
+void stable_sort(It first, It last)
+{
+    stable_sort(first, last, less<typename iterator_traits<It>::value_type>());
+}
+
 }
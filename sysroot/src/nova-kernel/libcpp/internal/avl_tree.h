@@ -0,0 +1,310 @@
+/**
+ * @file avl_tree.h
+ * @author Seth McBee
+ * @date 2026-10-19
+ * @brief AVL tree linkage shared by std::map and intrusive_tree.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <utility>
+#include <stddef.h>
+
+namespace std
+{
+
+/// Links of a tree node. A tree's header is a bare AvlNode whose left
+/// child is the root and whose parent is itself, so that end() is the
+/// header and stepping either way off the ends lands on it.
+struct AvlNode
+{
+    AvlNode* parent = nullptr;
+    AvlNode* left = nullptr;
+    AvlNode* right = nullptr;
+    int height = 1;
+
+    static AvlNode* leftmost(AvlNode* n)
+    {
+        while (n->left != nullptr)
+        {
+            n = n->left;
+        }
+        return n;
+    }
+
+    static AvlNode* rightmost(AvlNode* n)
+    {
+        while (n->right != nullptr)
+        {
+            n = n->right;
+        }
+        return n;
+    }
+
+    /// In-order successor. The last node's successor is the header.
+    static AvlNode* next(AvlNode* n)
+    {
+        if (n->right != nullptr)
+        {
+            return leftmost(n->right);
+        }
+        while (n->parent->right == n)
+        {
+            n = n->parent;
+        }
+        return n->parent;
+    }
+
+    /// In-order predecessor. The header's predecessor is the last node and
+    /// the first node's is the header.
+    static AvlNode* prev(AvlNode* n)
+    {
+        if (n->left != nullptr)
+        {
+            return rightmost(n->left);
+        }
+        while (n->parent->left == n)
+        {
+            n = n->parent;
+        }
+        return n->parent;
+    }
+};
+
+/// Shape of an AVL tree with parent links. It links and unlinks nodes it
+/// is handed and keeps the tree balanced; ordering, and where nodes come
+/// from, are up to the container built on it.
+struct AvlTree
+{
+    AvlTree()
+    {
+        header.parent = &header;
+    }
+
+    AvlTree(const AvlTree&) = delete;
+    AvlTree& operator=(const AvlTree&) = delete;
+
+    AvlNode* root() const
+    {
+        return header.left;
+    }
+
+    AvlNode* end_node() const
+    {
+        return const_cast<AvlNode*>(&header);
+    }
+
+    AvlNode* first() const
+    {
+        return root() == nullptr ? end_node() : AvlNode::leftmost(root());
+    }
+
+    AvlNode* last() const
+    {
+        return root() == nullptr ? end_node() : AvlNode::rightmost(root());
+    }
+
+    /// Hangs a fresh node from parent at link, which must be one of
+    /// parent's empty child links (or the header's root link).
+    void link_node(AvlNode* node, AvlNode* parent, AvlNode** link)
+    {
+        node->parent = parent;
+        node->left = nullptr;
+        node->right = nullptr;
+        node->height = 1;
+        *link = node;
+        node_count++;
+        rebalance(parent);
+    }
+
+    /// Takes a node out of the tree and returns its successor. The node
+    /// itself is left for the caller.
+    AvlNode* unlink_node(AvlNode* z)
+    {
+        AvlNode* next = AvlNode::next(z);
+        AvlNode* start;
+
+        if (z->left != nullptr && z->right != nullptr)
+        {
+            // The successor, which has no left child, takes the place of z.
+            // Nodes are relinked rather than their contents moved, so that
+            // iterators to other elements stay valid.
+            AvlNode* y = next;
+            if (y->parent == z)
+            {
+                start = y;
+            }
+            else
+            {
+                start = y->parent;
+                transplant(y, y->right);
+                y->right = z->right;
+                y->right->parent = y;
+            }
+            transplant(z, y);
+            y->left = z->left;
+            y->left->parent = y;
+            y->height = z->height;
+        }
+        else
+        {
+            start = z->parent;
+            transplant(z, z->left != nullptr ? z->left : z->right);
+        }
+
+        node_count--;
+        rebalance(start);
+        z->parent = nullptr;
+        z->left = nullptr;
+        z->right = nullptr;
+        return next;
+    }
+
+    /// Forgets every node without touching them.
+    void reset()
+    {
+        header.left = nullptr;
+        node_count = 0;
+    }
+
+    /// Takes the nodes of other, which is left empty. This tree must be
+    /// empty.
+    void take_root(AvlTree& other)
+    {
+        header.left = other.header.left;
+        node_count = other.node_count;
+        if (header.left != nullptr)
+        {
+            header.left->parent = &header;
+        }
+        other.reset();
+    }
+
+    void swap_root(AvlTree& other)
+    {
+        std::swap(header.left, other.header.left);
+        std::swap(node_count, other.node_count);
+        if (header.left != nullptr)
+        {
+            header.left->parent = &header;
+        }
+        if (other.header.left != nullptr)
+        {
+            other.header.left->parent = &other.header;
+        }
+    }
+
+    /** Balancing. **/
+
+    static int height(const AvlNode* n)
+    {
+        return n == nullptr ? 0 : n->height;
+    }
+
+    static int balance(const AvlNode* n)
+    {
+        return height(n->left) - height(n->right);
+    }
+
+    static void update_height(AvlNode* n)
+    {
+        n->height = 1 + max(height(n->left), height(n->right));
+    }
+
+    // Puts v where u hangs from its parent.
+    static void transplant(AvlNode* u, AvlNode* v)
+    {
+        AvlNode* p = u->parent;
+        if (p->left == u)
+        {
+            p->left = v;
+        }
+        else
+        {
+            p->right = v;
+        }
+        if (v != nullptr)
+        {
+            v->parent = p;
+        }
+    }
+
+    static AvlNode* rotate_left(AvlNode* x)
+    {
+        AvlNode* y = x->right;
+        x->right = y->left;
+        if (y->left != nullptr)
+        {
+            y->left->parent = x;
+        }
+        transplant(x, y);
+        y->left = x;
+        x->parent = y;
+        update_height(x);
+        update_height(y);
+        return y;
+    }
+
+    static AvlNode* rotate_right(AvlNode* x)
+    {
+        AvlNode* y = x->left;
+        x->left = y->right;
+        if (y->right != nullptr)
+        {
+            y->right->parent = x;
+        }
+        transplant(x, y);
+        y->right = x;
+        x->parent = y;
+        update_height(x);
+        update_height(y);
+        return y;
+    }
+
+    // Restores balance from n up to the root. Heights on the path still
+    // describe the tree before the change, so the walk stops at the first
+    // subtree that comes out as tall as it was.
+    void rebalance(AvlNode* n)
+    {
+        while (n != &header)
+        {
+            int old = n->height;
+            AvlNode* parent = n->parent;
+            int b = balance(n);
+            if (b > 1)
+            {
+                // Check for L-R.
+                if (balance(n->left) < 0)
+                {
+                    rotate_left(n->left);
+                }
+                n = rotate_right(n);
+            }
+            else if (b < -1)
+            {
+                // Check for R-L.
+                if (balance(n->right) > 0)
+                {
+                    rotate_right(n->right);
+                }
+                n = rotate_left(n);
+            }
+            else
+            {
+                update_height(n);
+            }
+
+            if (n->height == old)
+            {
+                break;
+            }
+            n = parent;
+        }
+    }
+
+    AvlNode header;
+    size_t node_count = 0;
+};
+
+}
@@ -6,118 +6,654 @@
 
 #pragma once
 
-#include <list>
+#include <algorithm>
+#include <initializer_list>
+#include <iterator>
 #include <memory>
+#include <memory_resource>
+#include <type_traits>
+#include <utility>
+#include <stdint.h>
+#include <string.h>
+
+/// Target size of a deque block in bytes.
+const size_t DEQUE_BLOCK_BYTES = 512;
+
+/// Emptied blocks a deque keeps for reuse before freeing them.
+const size_t DEQUE_SPARE_BLOCKS = 4;
+
+/// Smallest map of block pointers a deque allocates.
+const size_t DEQUE_MIN_MAP = 8;
 
 namespace std
 {
 
-/// Currently just a wrapper around list, so not particularly fast.
+/// Elements per deque block: a power of two filling about
+/// DEQUE_BLOCK_BYTES, and at least 4 for large elements.
+constexpr size_t deque_block_count(size_t size)
+{
+    size_t n = size <= DEQUE_BLOCK_BYTES / 4 ? DEQUE_BLOCK_BYTES / size : 4;
+    size_t p = 1;
+    while (p * 2 <= n)
+    {
+        p *= 2;
+    }
+    return p;
+}
+
+/// Random access iterator over a deque, kept as an index so that it only
+/// needs the deque's O(1) operator[].
+template <class Deque, class T>
+struct DequeIterator
+{
+    using iterator_category = random_access_iterator_tag;
+    using value_type = T;
+    using difference_type = ptrdiff_t;
+    using pointer = T*;
+    using reference = T&;
+
+    DequeIterator() {}
+
+    DequeIterator(Deque* d, size_t i) : owner(d), index(i) {}
+
+    /// Non-const to const conversion.
+    template <class D, class U>
+    DequeIterator(const DequeIterator<D, U>& other)
+        : owner(other.owner), index(other.index) {}
+
+    T& operator*() const
+    {
+        return (*owner)[index];
+    }
+
+    T* operator->() const
+    {
+        return &(*owner)[index];
+    }
+
+    T& operator[](ptrdiff_t n) const
+    {
+        return (*owner)[index + n];
+    }
+
+    DequeIterator& operator++()
+    {
+        ++index;
+        return *this;
+    }
+
+    DequeIterator operator++(int)
+    {
+        DequeIterator ret = *this;
+        ++index;
+        return ret;
+    }
+
+    DequeIterator& operator--()
+    {
+        --index;
+        return *this;
+    }
+
+    DequeIterator operator--(int)
+    {
+        DequeIterator ret = *this;
+        --index;
+        return ret;
+    }
+
+    DequeIterator& operator+=(ptrdiff_t n)
+    {
+        index += n;
+        return *this;
+    }
+
+    DequeIterator& operator-=(ptrdiff_t n)
+    {
+        index -= n;
+        return *this;
+    }
+
+    DequeIterator operator+(ptrdiff_t n) const
+    {
+        return DequeIterator(owner, index + n);
+    }
+
+    DequeIterator operator-(ptrdiff_t n) const
+    {
+        return DequeIterator(owner, index - n);
+    }
+
+    ptrdiff_t operator-(const DequeIterator& other) const
+    {
+        return (ptrdiff_t)index - (ptrdiff_t)other.index;
+    }
+
+    bool operator==(const DequeIterator& other) const
+    {
+        return index == other.index;
+    }
+
+    bool operator!=(const DequeIterator& other) const
+    {
+        return index != other.index;
+    }
+
+    bool operator<(const DequeIterator& other) const
+    {
+        return index < other.index;
+    }
+
+    bool operator>(const DequeIterator& other) const
+    {
+        return index > other.index;
+    }
+
+    bool operator<=(const DequeIterator& other) const
+    {
+        return index <= other.index;
+    }
+
+    bool operator>=(const DequeIterator& other) const
+    {
+        return index >= other.index;
+    }
+
+    Deque* owner = nullptr;
+    size_t index = 0;
+};
+
+/// Double-ended queue kept in fixed-size blocks. A map of block pointers
+/// is indexed by position, so access is O(1), and both ends grow by whole
+/// blocks without moving elements. Blocks that empty are kept for reuse.
 template <class T, class Alloc = allocator<T>>
 class deque
 {
 public:
 
+    using value_type = T;
+    using allocator_type = Alloc;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using iterator = DequeIterator<deque, T>;
+    using const_iterator = DequeIterator<const deque, const T>;
+    using difference_type = ptrdiff_t;
+    using size_type = size_t;
+
+    /// Elements per block.
+    static constexpr size_t block_count = deque_block_count(sizeof(T));
+
     /** Constructors. **/
 
     deque() {}
 
-    explicit deque (const Alloc& alloc) : deque_alloc(alloc), data(deque_alloc) {}
+    explicit deque(const Alloc& alloc) : deque_alloc(alloc) {}
+
+    explicit deque(size_t n, const Alloc& alloc = Alloc())
+        : deque_alloc(alloc)
+    {
+        resize(n);
+    }
+
+    deque(size_t n, const T& t, const Alloc& alloc = Alloc())
+        : deque_alloc(alloc)
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            emplace_back(t);
+        }
+    }
 
-    /** Destructors. **/
+    deque(initializer_list<value_type> il, const Alloc& alloc = Alloc())
+        : deque_alloc(alloc)
+    {
+        for (const auto& t : il)
+        {
+            emplace_back(t);
+        }
+    }
 
-    ~deque() {}
+    deque(const deque& other)
+        : deque_alloc(other.deque_alloc)
+    {
+        copy_from(other);
+    }
+
+    deque(const deque& other, const Alloc& alloc)
+        : deque_alloc(alloc)
+    {
+        copy_from(other);
+    }
+
+    deque(deque&& other)
+        : deque_alloc(other.deque_alloc)
+    {
+        take(other);
+    }
+
+    /** Destructor. **/
+
+    ~deque()
+    {
+        clear();
+        release();
+    }
+
+    /** Assignment operators. **/
+
+    deque& operator=(const deque& other)
+    {
+        if (this != &other)
+        {
+            clear();
+            copy_from(other);
+        }
+        return *this;
+    }
+
+    deque& operator=(deque&& other)
+    {
+        if (this == &other)
+        {
+            return *this;
+        }
+
+        clear();
+        if (deque_alloc == other.deque_alloc)
+        {
+            release();
+            take(other);
+            return *this;
+        }
+
+        // Blocks can't change hands between unequal allocators.
+        for (size_t i = 0; i < other.count; ++i)
+        {
+            emplace_back(std::move(other[i]));
+        }
+        other.clear();
+        return *this;
+    }
 
     /** Status. **/
 
     bool empty() const
     {
-        return data.empty();
+        return count == 0;
     }
 
     size_t size() const
     {
-        return data.size();
+        return count;
     }
 
     size_t max_size() const
     {
-        return SIZE_MAX;
+        return SIZE_MAX / sizeof(T);
     }
 
     /** Accessors. **/
 
+    T& operator[](size_t n)
+    {
+        size_t pos = head + n;
+        return map[pos / block_count][pos % block_count];
+    }
+
+    const T& operator[](size_t n) const
+    {
+        size_t pos = head + n;
+        return map[pos / block_count][pos % block_count];
+    }
+
     T& front()
     {
-        return data.front();
+        return (*this)[0];
     }
-    
+
     const T& front() const
     {
-        return data.front();
+        return (*this)[0];
     }
-    
+
     T& back()
     {
-        return data.back();
+        return (*this)[count - 1];
     }
-    
+
     const T& back() const
     {
-        return data.back();
+        return (*this)[count - 1];
     }
-    
-    deque<T>& operator[](size_t n)
+
+    /** Iterators. **/
+
+    iterator begin()
     {
-        auto it = data.head;
-        for (size_t i = 0; i < n; ++i)
+        return iterator(this, 0);
+    }
+
+    const_iterator begin() const
+    {
+        return const_iterator(this, 0);
+    }
+
+    iterator end()
+    {
+        return iterator(this, count);
+    }
+
+    const_iterator end() const
+    {
+        return const_iterator(this, count);
+    }
+
+    /** Mutators. **/
+
+    template <class... Args>
+    T& emplace_back(Args&&... args)
+    {
+        size_t pos = head + count;
+        if (count == 0 || pos % block_count == 0)
         {
-            it = it->next;
+            if (pos == map_size * block_count)
+            {
+                grow_map(false);
+                pos = head + count;
+            }
+            map[pos / block_count] = get_block();
         }
-        return *it;
+
+        deque_alloc.construct(&map[pos / block_count][pos % block_count], forward<Args>(args)...);
+        ++count;
+        return back();
     }
-    
-    const deque<T>& operator [](size_t n) const
+
+    template <class... Args>
+    T& emplace_front(Args&&... args)
     {
-        auto it = data.head;
-        for (size_t i = 0; i < n; ++i)
+        if (count == 0)
         {
-            it = it->next;
+            return emplace_back(forward<Args>(args)...);
         }
-        return *it;
-    }
 
-    /** Mutators. **/
+        if (head % block_count == 0)
+        {
+            if (head == 0)
+            {
+                grow_map(true);
+            }
+            map[head / block_count - 1] = get_block();
+        }
+
+        size_t pos = head - 1;
+        deque_alloc.construct(&map[pos / block_count][pos % block_count], forward<Args>(args)...);
+        head = pos;
+        ++count;
+        return front();
+    }
 
     void push_back(const T& t)
     {
-        data.push_back(t);
+        emplace_back(t);
+    }
+
+    void push_back(T&& t)
+    {
+        emplace_back(std::move(t));
     }
-    
+
     void push_front(const T& t)
     {
-        data.push_front(t);
+        emplace_front(t);
+    }
+
+    void push_front(T&& t)
+    {
+        emplace_front(std::move(t));
     }
-    
+
     void pop_back()
     {
-        data.pop_back();
+        --count;
+        size_t pos = head + count;
+        deque_alloc.destroy(&map[pos / block_count][pos % block_count]);
+        if (count == 0 || pos % block_count == 0)
+        {
+            put_block(pos / block_count);
+        }
+        if (count == 0)
+        {
+            recentre();
+        }
     }
-    
+
     void pop_front()
     {
-        data.pop_front();
+        size_t pos = head;
+        deque_alloc.destroy(&map[pos / block_count][pos % block_count]);
+        ++head;
+        --count;
+        if (count == 0 || head % block_count == 0)
+        {
+            put_block(pos / block_count);
+        }
+        if (count == 0)
+        {
+            recentre();
+        }
+    }
+
+    /// New elements are value-initialized.
+    void resize(size_t n)
+    {
+        while (count > n)
+        {
+            pop_back();
+        }
+        while (count < n)
+        {
+            emplace_back();
+        }
     }
-    
+
     void clear()
     {
-        data.clear();
+        while (count > 0)
+        {
+            pop_back();
+        }
+    }
+
+    /// Frees the spare blocks, and the map too if the deque is empty.
+    void shrink_to_fit()
+    {
+        free_spares();
+        if (count == 0)
+        {
+            release();
+        }
+    }
+
+    void swap(deque& other)
+    {
+        std::swap(map, other.map);
+        std::swap(map_size, other.map_size);
+        std::swap(head, other.head);
+        std::swap(count, other.count);
+        std::swap(spare, other.spare);
+        std::swap(spare_count, other.spare_count);
+        std::swap(deque_alloc, other.deque_alloc);
+    }
+
+    Alloc get_allocator() const
+    {
+        return deque_alloc;
     }
 
 private:
 
-    std::list<T, Alloc> data;
+    using MapAlloc = typename Alloc::template rebind<T*>::other;
+
+    // A spare block's first bytes link it to the next one.
+    struct Spare
+    {
+        Spare* next;
+    };
+
+    static_assert(sizeof(T) * block_count >= sizeof(Spare), "deque block too small");
+
+    T* get_block()
+    {
+        if (spare != nullptr)
+        {
+            Spare* s = spare;
+            spare = s->next;
+            --spare_count;
+            return (T*)s;
+        }
+        return deque_alloc.allocate(block_count);
+    }
+
+    // Takes the block out of map slot b, which must hold no elements.
+    void put_block(size_t b)
+    {
+        T* block = map[b];
+        map[b] = nullptr;
+        if (spare_count < DEQUE_SPARE_BLOCKS)
+        {
+            Spare* s = (Spare*)(void*)block;
+            s->next = spare;
+            spare = s;
+            ++spare_count;
+        }
+        else
+        {
+            deque_alloc.deallocate(block, block_count);
+        }
+    }
+
+    void free_spares()
+    {
+        while (spare != nullptr)
+        {
+            Spare* s = spare;
+            spare = s->next;
+            deque_alloc.deallocate((T*)(void*)s, block_count);
+        }
+        spare_count = 0;
+    }
+
+    // Starts an empty deque from the middle of the map, so that either end
+    // has room.
+    void recentre()
+    {
+        head = map_size / 2 * block_count;
+    }
+
+    // Makes room for one more block before the first (at_front) or after
+    // the last. The blocks in use are centred in the map, which doubles
+    // if they would fill more than half of it.
+    void grow_map(bool at_front)
+    {
+        size_t first = head / block_count;
+        size_t used = count == 0 ? 0 : (head + count - 1) / block_count - first + 1;
+        size_t size = map_size;
+        if ((used + 1) * 2 > size)
+        {
+            size = max(DEQUE_MIN_MAP, map_size * 2);
+        }
+
+        size_t new_first = (size - used - 1) / 2 + (at_front ? 1 : 0);
+        MapAlloc map_alloc(deque_alloc);
+        if (size == map_size)
+        {
+            memmove(map + new_first, map + first, used * sizeof(T*));
+            if (new_first < first)
+            {
+                memset(map + new_first + used, 0, (first - new_first) * sizeof(T*));
+            }
+            else
+            {
+                memset(map + first, 0, (new_first - first) * sizeof(T*));
+            }
+        }
+        else
+        {
+            T** new_map = map_alloc.allocate(size);
+            memset(new_map, 0, size * sizeof(T*));
+            if (used > 0)
+            {
+                memcpy(new_map + new_first, map + first, used * sizeof(T*));
+            }
+            if (map != nullptr)
+            {
+                map_alloc.deallocate(map, map_size);
+            }
+            map = new_map;
+            map_size = size;
+        }
+
+        head = new_first * block_count + head % block_count;
+    }
+
+    // Frees the spare blocks and the map. The deque must be empty.
+    void release()
+    {
+        free_spares();
+        if (map != nullptr)
+        {
+            MapAlloc map_alloc(deque_alloc);
+            map_alloc.deallocate(map, map_size);
+        }
+        map = nullptr;
+        map_size = 0;
+        head = 0;
+    }
+
+    // Copies the elements of other into an empty deque.
+    void copy_from(const deque& other)
+    {
+        for (size_t i = 0; i < other.count; ++i)
+        {
+            emplace_back(other[i]);
+        }
+    }
+
+    // Takes the map and blocks of other into an empty deque with none.
+    void take(deque& other)
+    {
+        map = other.map;
+        map_size = other.map_size;
+        head = other.head;
+        count = other.count;
+        spare = other.spare;
+        spare_count = other.spare_count;
+        other.map = nullptr;
+        other.map_size = 0;
+        other.head = 0;
+        other.count = 0;
+        other.spare = nullptr;
+        other.spare_count = 0;
+    }
+
+    T** map = nullptr;
+    size_t map_size = 0;
+    size_t head = 0;
+    size_t count = 0;
+    Spare* spare = nullptr;
+    size_t spare_count = 0;
     Alloc deque_alloc;
 };
 
+namespace pmr
+{
+
+template <class T>
+using deque = std::deque<T, polymorphic_allocator<T>>;
+
+} // namespace pmr
+
 }
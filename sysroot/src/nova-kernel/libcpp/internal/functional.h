@@ -8,6 +8,9 @@
 
 #include <globals.h>
 
+#include <hash.h>
+#include <string.h>
+
 namespace std
 {
 
@@ -24,4 +27,102 @@ struct less
     }
 };
 
+template <class T>
+struct equal_to
+{
+    bool operator()(const T& t1, const T& t2) const
+    {
+        return t1 == t2;
+    }
+};
+
+/*
+ * Hashes. Every bit of the value affects every bit of the result, so hash
+ * tables may index with the low bits alone. The primary template covers
+ * enumerations; other types need a specialization.
+ */
+
+template <class T>
+struct hash
+{
+    static_assert(__is_enum(T), "std::hash is not specialized for this type");
+
+    size_t operator()(T val) const
+    {
+        return hash_u64((uint64_t)val);
+    }
+};
+
+template <class T>
+struct hash_by_value
+{
+    size_t operator()(T val) const
+    {
+        return hash_u64((uint64_t)val);
+    }
+};
+
+template <> struct hash<bool> : public hash_by_value<bool> {};
+template <> struct hash<char> : public hash_by_value<char> {};
+template <> struct hash<signed char> : public hash_by_value<signed char> {};
+template <> struct hash<unsigned char> : public hash_by_value<unsigned char> {};
+template <> struct hash<char16_t> : public hash_by_value<char16_t> {};
+template <> struct hash<char32_t> : public hash_by_value<char32_t> {};
+template <> struct hash<wchar_t> : public hash_by_value<wchar_t> {};
+template <> struct hash<short> : public hash_by_value<short> {};
+template <> struct hash<unsigned short> : public hash_by_value<unsigned short> {};
+template <> struct hash<int> : public hash_by_value<int> {};
+template <> struct hash<unsigned int> : public hash_by_value<unsigned int> {};
+template <> struct hash<long> : public hash_by_value<long> {};
+template <> struct hash<unsigned long> : public hash_by_value<unsigned long> {};
+template <> struct hash<long long> : public hash_by_value<long long> {};
+template <> struct hash<unsigned long long> : public hash_by_value<unsigned long long> {};
+
+template <class T>
+struct hash<T*>
+{
+    size_t operator()(T* p) const
+    {
+        return hash_u64((uint64_t)p);
+    }
+};
+
+template <>
+struct hash<nullptr_t>
+{
+    size_t operator()(nullptr_t) const
+    {
+        return hash_u64(0);
+    }
+};
+
+template <>
+struct hash<float>
+{
+    size_t operator()(float val) const
+    {
+        // 0 and -0 compare equal, so must hash alike.
+        uint32_t bits = 0;
+        if (val != 0)
+        {
+            memcpy(&bits, &val, sizeof(bits));
+        }
+        return hash_u64(bits);
+    }
+};
+
+template <>
+struct hash<double>
+{
+    size_t operator()(double val) const
+    {
+        uint64_t bits = 0;
+        if (val != 0)
+        {
+            memcpy(&bits, &val, sizeof(bits));
+        }
+        return hash_u64(bits);
+    }
+};
+
 }
@@ -0,0 +1,809 @@
+/**
+ * @file hash_table.h
+ * @author Seth McBee
+ * @date 2026-10-19
+ * @brief Open-addressing hash table behind unordered_map and unordered_set.
+ *
+ * The table is laid out in the manner of a Swiss table. Elements live in
+ * one flat array of slots, and a parallel array holds a control byte per
+ * slot: empty, deleted, or 7 bits of the element's hash. A lookup loads
+ * 16 control bytes at once and compares them all against the wanted hash
+ * bits with SSE2, so only slots whose bits match are compared by key, and
+ * the probe ends at the first group holding an empty slot.
+ *
+ * The capacity is always one less than a power of two. After the last
+ * control byte come a sentinel, which stops iteration, and copies of the
+ * first 15 bytes, so a group may be loaded from any slot without wrapping.
+ * At most 7/8 of the slots are used. Elements move when the table grows,
+ * so pointers and iterators to them don't survive an insertion.
+ */
+
+#pragma once
+
+#include <globals.h>
+
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <string.h>
+
+namespace std
+{
+
+/// Control bytes. Full slots hold 7 hash bits, from 0 to 127.
+enum : int8_t
+{
+    HASH_CTRL_EMPTY = -128,
+    HASH_CTRL_DELETED = -2,
+    HASH_CTRL_SENTINEL = -1
+};
+
+/// Number of control bytes examined at once.
+const size_t HASH_GROUP_WIDTH = 16;
+
+/// Smallest capacity of a table that holds anything.
+const size_t HASH_MIN_CAPACITY = HASH_GROUP_WIDTH - 1;
+
+/// Control bytes of a table that has never held anything. Any lookup
+/// finds an empty slot, and iteration stops at once.
+alignas(16) inline const int8_t hash_empty_group[HASH_GROUP_WIDTH] =
+{
+    HASH_CTRL_SENTINEL, HASH_CTRL_EMPTY, HASH_CTRL_EMPTY, HASH_CTRL_EMPTY,
+    HASH_CTRL_EMPTY, HASH_CTRL_EMPTY, HASH_CTRL_EMPTY, HASH_CTRL_EMPTY,
+    HASH_CTRL_EMPTY, HASH_CTRL_EMPTY, HASH_CTRL_EMPTY, HASH_CTRL_EMPTY,
+    HASH_CTRL_EMPTY, HASH_CTRL_EMPTY, HASH_CTRL_EMPTY, HASH_CTRL_EMPTY
+};
+
+/// A group of control bytes. Each match returns a mask with bit i set
+/// when byte i matches.
+struct HashGroup
+{
+#ifdef __SSE2__
+    using Vec = signed char __attribute__((vector_size(16)));
+    using Bytes = char __attribute__((vector_size(16)));
+
+    explicit HashGroup(const int8_t* p)
+    {
+        memcpy(&ctrl, p, sizeof(ctrl));
+    }
+
+    uint32_t mask(Vec v) const
+    {
+        return __builtin_ia32_pmovmskb128((Bytes)v);
+    }
+
+    uint32_t match(int8_t h) const
+    {
+        return mask(ctrl == (Vec{} + h));
+    }
+
+    uint32_t match_empty() const
+    {
+        return match(HASH_CTRL_EMPTY);
+    }
+
+    uint32_t match_empty_or_deleted() const
+    {
+        return mask(ctrl < (Vec{} + (int8_t)HASH_CTRL_SENTINEL));
+    }
+
+    Vec ctrl;
+#else
+    explicit HashGroup(const int8_t* p)
+    {
+        memcpy(ctrl, p, sizeof(ctrl));
+    }
+
+    uint32_t match(int8_t h) const
+    {
+        uint32_t m = 0;
+        for (size_t i = 0; i < HASH_GROUP_WIDTH; ++i)
+        {
+            m |= (uint32_t)(ctrl[i] == h) << i;
+        }
+        return m;
+    }
+
+    uint32_t match_empty() const
+    {
+        return match(HASH_CTRL_EMPTY);
+    }
+
+    uint32_t match_empty_or_deleted() const
+    {
+        uint32_t m = 0;
+        for (size_t i = 0; i < HASH_GROUP_WIDTH; ++i)
+        {
+            m |= (uint32_t)(ctrl[i] < HASH_CTRL_SENTINEL) << i;
+        }
+        return m;
+    }
+
+    int8_t ctrl[HASH_GROUP_WIDTH];
+#endif
+};
+
+/// Visits groups in triangular steps, which reach every group of a
+/// power-of-two table.
+struct HashProbe
+{
+    HashProbe(size_t hash, size_t mask) : mask(mask), offset(hash & mask) {}
+
+    void next()
+    {
+        index += HASH_GROUP_WIDTH;
+        offset = (offset + index) & mask;
+    }
+
+    size_t mask;
+    size_t offset;
+    size_t index = 0;
+};
+
+template <class Value>
+struct HashTableIteratorBase
+{
+    using iterator_category = forward_iterator_tag;
+    using value_type = Value;
+    using difference_type = ptrdiff_t;
+    using pointer = Value*;
+    using reference = Value&;
+
+    HashTableIteratorBase(const int8_t* c, Value* s) : ctrl(c), slot(s) {}
+
+    // Moves to the next full slot, or the sentinel.
+    void skip_free()
+    {
+        while (*ctrl < HASH_CTRL_SENTINEL)
+        {
+            uint32_t skip = HashGroup(ctrl).match_empty_or_deleted();
+            size_t shift = __builtin_ctz(~skip);
+            ctrl += shift;
+            slot += shift;
+        }
+    }
+
+    const int8_t* ctrl;
+    Value* slot;
+};
+
+template <class Value>
+struct HashTableIterator : public HashTableIteratorBase<Value>
+{
+    using HashTableIteratorBase<Value>::HashTableIteratorBase;
+
+    bool operator==(const HashTableIterator& other) const
+    {
+        return this->ctrl == other.ctrl;
+    }
+
+    bool operator!=(const HashTableIterator& other) const
+    {
+        return this->ctrl != other.ctrl;
+    }
+
+    Value& operator*() const
+    {
+        return *this->slot;
+    }
+
+    Value* operator->() const
+    {
+        return this->slot;
+    }
+
+    HashTableIterator& operator++()
+    {
+        ++this->ctrl;
+        ++this->slot;
+        this->skip_free();
+        return *this;
+    }
+
+    HashTableIterator operator++(int)
+    {
+        HashTableIterator ret = *this;
+        ++*this;
+        return ret;
+    }
+};
+
+template <class Value>
+struct ConstHashTableIterator : public HashTableIteratorBase<Value>
+{
+    using HashTableIteratorBase<Value>::HashTableIteratorBase;
+
+    ConstHashTableIterator(const HashTableIterator<Value>& other)
+        : HashTableIteratorBase<Value>(other.ctrl, other.slot) {}
+
+    bool operator==(const ConstHashTableIterator& other) const
+    {
+        return this->ctrl == other.ctrl;
+    }
+
+    bool operator!=(const ConstHashTableIterator& other) const
+    {
+        return this->ctrl != other.ctrl;
+    }
+
+    const Value& operator*() const
+    {
+        return *this->slot;
+    }
+
+    const Value* operator->() const
+    {
+        return this->slot;
+    }
+
+    ConstHashTableIterator& operator++()
+    {
+        ++this->ctrl;
+        ++this->slot;
+        this->skip_free();
+        return *this;
+    }
+
+    ConstHashTableIterator operator++(int)
+    {
+        ConstHashTableIterator ret = *this;
+        ++*this;
+        return ret;
+    }
+};
+
+/// Gets the key of a set element, which is the element itself.
+struct HashSetKey
+{
+    template <class Value>
+    const Value& operator()(const Value& v) const
+    {
+        return v;
+    }
+};
+
+/// Gets the key of a map element.
+struct HashMapKey
+{
+    template <class Value>
+    const typename Value::first_type& operator()(const Value& v) const
+    {
+        return v.first;
+    }
+};
+
+template <class Value, class Key, class KeyOf, class Hash, class KeyEqual, class Alloc>
+class HashTable
+{
+public:
+
+    using iterator = HashTableIterator<Value>;
+    using const_iterator = ConstHashTableIterator<Value>;
+
+    /** Constructors. **/
+
+    HashTable() {}
+
+    HashTable(size_t n, const Hash& h, const KeyEqual& eq, const Alloc& a)
+        : hasher(h), equal(eq), slot_alloc(a), ctrl_alloc(a)
+    {
+        reserve(n);
+    }
+
+    HashTable(const HashTable& other)
+        : hasher(other.hasher), equal(other.equal),
+          slot_alloc(other.slot_alloc), ctrl_alloc(other.ctrl_alloc)
+    {
+        copy_from(other);
+    }
+
+    HashTable(const HashTable& other, const Alloc& a)
+        : hasher(other.hasher), equal(other.equal),
+          slot_alloc(a), ctrl_alloc(a)
+    {
+        copy_from(other);
+    }
+
+    HashTable(HashTable&& other)
+        : hasher(std::move(other.hasher)), equal(std::move(other.equal)),
+          slot_alloc(std::move(other.slot_alloc)),
+          ctrl_alloc(std::move(other.ctrl_alloc))
+    {
+        steal(other);
+    }
+
+    ~HashTable()
+    {
+        clear();
+        release();
+    }
+
+    /** Assignment operators. **/
+
+    HashTable& operator=(const HashTable& other)
+    {
+        if (this != &other)
+        {
+            clear();
+            release();
+            hasher = other.hasher;
+            equal = other.equal;
+            copy_from(other);
+        }
+        return *this;
+    }
+
+    HashTable& operator=(HashTable&& other)
+    {
+        if (this == &other)
+        {
+            return *this;
+        }
+
+        clear();
+        release();
+        hasher = std::move(other.hasher);
+        equal = std::move(other.equal);
+        if (slot_alloc == other.slot_alloc)
+        {
+            steal(other);
+            return *this;
+        }
+
+        // Storage can't change hands between unequal allocators.
+        reserve(other.count);
+        for (auto it = other.begin(); it != other.end(); ++it)
+        {
+            size_t i = prepare_insert(hash_of(*it));
+            slot_alloc.construct(slots + i, std::move(*it));
+        }
+        other.clear();
+        return *this;
+    }
+
+    /** Status. **/
+
+    size_t size() const
+    {
+        return count;
+    }
+
+    size_t capacity() const
+    {
+        return cap;
+    }
+
+    /** Iterators. **/
+
+    iterator begin()
+    {
+        iterator it(ctrl, slots);
+        it.skip_free();
+        return it;
+    }
+
+    const_iterator begin() const
+    {
+        const_iterator it(ctrl, slots);
+        it.skip_free();
+        return it;
+    }
+
+    iterator end()
+    {
+        return iterator(ctrl + cap, slots + cap);
+    }
+
+    const_iterator end() const
+    {
+        return const_iterator(ctrl + cap, slots + cap);
+    }
+
+    /** Lookup. **/
+
+    iterator find(const Key& key)
+    {
+        return at_index(find_index(key, hasher(key)));
+    }
+
+    const_iterator find(const Key& key) const
+    {
+        size_t i = find_index(key, hasher(key));
+        return const_iterator(ctrl + i, slots + i);
+    }
+
+    /** Modifiers. **/
+
+    /// Finds key, or makes room for it. A new slot is marked full but
+    /// left unconstructed; the caller must construct the element there.
+    /// When the table is full the new slot is end() instead, and nothing
+    /// moves until construct() has built the element, so key and the
+    /// construct() arguments may refer to elements of this table.
+    pair<iterator, bool> find_or_prepare(const Key& key)
+    {
+        size_t h = hasher(key);
+        size_t i = find_index(key, h);
+        if (i != cap)
+        {
+            return {at_index(i), false};
+        }
+
+        i = find_free(h);
+        if (needs_room(i))
+        {
+            return {end(), true};
+        }
+        claim(i, h);
+        return {at_index(i), true};
+    }
+
+    /// Builds the element in a slot from find_or_prepare(), returning
+    /// where it ended up.
+    template <class... Args>
+    iterator construct(iterator it, Args&&... args)
+    {
+        if (it != end())
+        {
+            slot_alloc.construct(it.slot, forward<Args>(args)...);
+            return it;
+        }
+
+        // The table grows only once the element is built from args.
+        alignas(Value) unsigned char buf[sizeof(Value)];
+        Value* v = (Value*)buf;
+        slot_alloc.construct(v, forward<Args>(args)...);
+        size_t i = prepare_insert(hash_of(*v));
+        slot_alloc.construct(slots + i, std::move(*v));
+        slot_alloc.destroy(v);
+        return at_index(i);
+    }
+
+    /// Inserts an element built from args, unless its key is present.
+    template <class... Args>
+    pair<iterator, bool> emplace(Args&&... args)
+    {
+        // The key is only known once the element exists, so it is built
+        // aside and moved in.
+        alignas(Value) unsigned char buf[sizeof(Value)];
+        Value* v = (Value*)buf;
+        slot_alloc.construct(v, forward<Args>(args)...);
+        auto ret = find_or_prepare(KeyOf()(*v));
+        if (ret.second)
+        {
+            ret.first = construct(ret.first, std::move(*v));
+        }
+        slot_alloc.destroy(v);
+        return ret;
+    }
+
+    /// Erases an element, returning the one after it.
+    iterator erase(iterator it)
+    {
+        iterator next = it;
+        ++next;
+        erase_index(it.slot - slots);
+        return next;
+    }
+
+    size_t erase(const Key& key)
+    {
+        size_t i = find_index(key, hasher(key));
+        if (i == cap)
+        {
+            return 0;
+        }
+        erase_index(i);
+        return 1;
+    }
+
+    /// Destroys every element but keeps the storage.
+    void clear()
+    {
+        if (cap == 0)
+        {
+            return;
+        }
+
+        if (!is_trivially_destructible_v<Value>)
+        {
+            for (auto it = begin(); it != end(); ++it)
+            {
+                slot_alloc.destroy(it.slot);
+            }
+        }
+        reset_ctrl();
+        count = 0;
+        growth_left = capacity_to_growth(cap);
+    }
+
+    /// Makes room for n elements without growing.
+    void reserve(size_t n)
+    {
+        if (n > count + growth_left)
+        {
+            resize(growth_to_capacity(n));
+        }
+    }
+
+    void swap(HashTable& other)
+    {
+        std::swap(ctrl, other.ctrl);
+        std::swap(slots, other.slots);
+        std::swap(cap, other.cap);
+        std::swap(count, other.count);
+        std::swap(growth_left, other.growth_left);
+        std::swap(hasher, other.hasher);
+        std::swap(equal, other.equal);
+    }
+
+    Hash hash_function() const
+    {
+        return hasher;
+    }
+
+    KeyEqual key_eq() const
+    {
+        return equal;
+    }
+
+    Alloc get_allocator() const
+    {
+        return slot_alloc;
+    }
+
+private:
+
+    using CtrlAlloc = typename Alloc::template rebind<int8_t>::other;
+
+    static size_t capacity_to_growth(size_t c)
+    {
+        return c - c / 8;
+    }
+
+    static size_t growth_to_capacity(size_t n)
+    {
+        size_t c = HASH_MIN_CAPACITY;
+        while (capacity_to_growth(c) < n)
+        {
+            c = c * 2 + 1;
+        }
+        return c;
+    }
+
+    size_t hash_of(const Value& v) const
+    {
+        return hasher(KeyOf()(v));
+    }
+
+    iterator at_index(size_t i)
+    {
+        return iterator(ctrl + i, slots + i);
+    }
+
+    // Index of the element with key, or cap if there is none.
+    size_t find_index(const Key& key, size_t h) const
+    {
+        HashProbe probe(h >> 7, cap);
+        while (true)
+        {
+            HashGroup g(ctrl + probe.offset);
+            for (uint32_t m = g.match(h & 0x7f); m != 0; m &= m - 1)
+            {
+                size_t i = (probe.offset + __builtin_ctz(m)) & cap;
+                if (equal(KeyOf()(slots[i]), key))
+                {
+                    return i;
+                }
+            }
+            if (g.match_empty() != 0)
+            {
+                return cap;
+            }
+            probe.next();
+        }
+    }
+
+    // First empty or deleted slot on the probe sequence of h.
+    size_t find_free(size_t h) const
+    {
+        HashProbe probe(h >> 7, cap);
+        while (true)
+        {
+            uint32_t m = HashGroup(ctrl + probe.offset).match_empty_or_deleted();
+            if (m != 0)
+            {
+                return (probe.offset + __builtin_ctz(m)) & cap;
+            }
+            probe.next();
+        }
+    }
+
+    // Claims a slot for a new element with hash h, growing if need be.
+    size_t prepare_insert(size_t h)
+    {
+        size_t i = find_free(h);
+        if (needs_room(i))
+        {
+            // Mostly deleted slots are cleaned out at the same size.
+            if (cap == 0)
+            {
+                resize(HASH_MIN_CAPACITY);
+            }
+            else
+            {
+                resize(count * 32 <= cap * 25 ? cap : cap * 2 + 1);
+            }
+            i = find_free(h);
+        }
+        claim(i, h);
+        return i;
+    }
+
+    // Whether free slot i can't be taken without growing first. Reusing
+    // a deleted slot costs no growth.
+    bool needs_room(size_t i) const
+    {
+        return growth_left == 0 && ctrl[i] != HASH_CTRL_DELETED;
+    }
+
+    // Marks free slot i full for a new element with hash h.
+    void claim(size_t i, size_t h)
+    {
+        if (ctrl[i] == HASH_CTRL_EMPTY)
+        {
+            growth_left--;
+        }
+        set_ctrl(i, h & 0x7f);
+        count++;
+    }
+
+    void erase_index(size_t i)
+    {
+        slot_alloc.destroy(slots + i);
+        count--;
+
+        // If the slot lies in a run of fewer than a group of full or
+        // deleted slots, no probe ever went past it, and it can be empty
+        // again rather than deleted.
+        size_t before = (i - HASH_GROUP_WIDTH) & cap;
+        uint32_t empty_after = HashGroup(ctrl + i).match_empty();
+        uint32_t empty_before = HashGroup(ctrl + before).match_empty();
+        if (empty_after != 0 && empty_before != 0 &&
+            __builtin_ctz(empty_after) + __builtin_clz(empty_before << 16) < (int)HASH_GROUP_WIDTH)
+        {
+            set_ctrl(i, HASH_CTRL_EMPTY);
+            growth_left++;
+        }
+        else
+        {
+            set_ctrl(i, HASH_CTRL_DELETED);
+        }
+    }
+
+    // Sets a control byte and its copy after the sentinel.
+    void set_ctrl(size_t i, int8_t h)
+    {
+        ctrl[i] = h;
+        if (i < HASH_GROUP_WIDTH - 1)
+        {
+            ctrl[cap + 1 + i] = h;
+        }
+    }
+
+    void reset_ctrl()
+    {
+        memset(ctrl, HASH_CTRL_EMPTY, cap + HASH_GROUP_WIDTH);
+        ctrl[cap] = HASH_CTRL_SENTINEL;
+    }
+
+    // Moves every element into fresh storage of capacity c.
+    void resize(size_t c)
+    {
+        int8_t* old_ctrl = ctrl;
+        Value* old_slots = slots;
+        size_t old_cap = cap;
+
+        ctrl = ctrl_alloc.allocate(c + HASH_GROUP_WIDTH);
+        slots = slot_alloc.allocate(c);
+        cap = c;
+        reset_ctrl();
+        growth_left = capacity_to_growth(c) - count;
+
+        for (size_t i = 0; i < old_cap; ++i)
+        {
+            if (old_ctrl[i] >= 0)
+            {
+                size_t h = hash_of(old_slots[i]);
+                size_t j = find_free(h);
+                set_ctrl(j, h & 0x7f);
+                relocate(slots + j, old_slots + i);
+            }
+        }
+
+        if (old_cap != 0)
+        {
+            ctrl_alloc.deallocate(old_ctrl, old_cap + HASH_GROUP_WIDTH);
+            slot_alloc.deallocate(old_slots, old_cap);
+        }
+    }
+
+    void relocate(Value* dst, Value* src)
+    {
+        if (is_trivially_copyable_v<Value>)
+        {
+            memcpy((void*)dst, (const void*)src, sizeof(Value));
+            return;
+        }
+
+        slot_alloc.construct(dst, std::move(*src));
+        slot_alloc.destroy(src);
+    }
+
+    // Frees the storage, which must hold no elements.
+    void release()
+    {
+        if (cap != 0)
+        {
+            ctrl_alloc.deallocate(ctrl, cap + HASH_GROUP_WIDTH);
+            slot_alloc.deallocate(slots, cap);
+        }
+        ctrl = (int8_t*)hash_empty_group;
+        slots = nullptr;
+        cap = 0;
+        growth_left = 0;
+    }
+
+    // Copies other into an empty table. The layout is copied as is, so
+    // nothing is rehashed.
+    void copy_from(const HashTable& other)
+    {
+        if (other.count == 0)
+        {
+            return;
+        }
+
+        cap = other.cap;
+        ctrl = ctrl_alloc.allocate(cap + HASH_GROUP_WIDTH);
+        slots = slot_alloc.allocate(cap);
+        memcpy(ctrl, other.ctrl, cap + HASH_GROUP_WIDTH);
+        for (size_t i = 0; i < cap; ++i)
+        {
+            if (ctrl[i] >= 0)
+            {
+                slot_alloc.construct(slots + i, other.slots[i]);
+            }
+        }
+        count = other.count;
+        growth_left = other.growth_left;
+    }
+
+    void steal(HashTable& other)
+    {
+        ctrl = other.ctrl;
+        slots = other.slots;
+        cap = other.cap;
+        count = other.count;
+        growth_left = other.growth_left;
+        other.ctrl = (int8_t*)hash_empty_group;
+        other.slots = nullptr;
+        other.cap = 0;
+        other.count = 0;
+        other.growth_left = 0;
+    }
+
+    int8_t* ctrl = (int8_t*)hash_empty_group;
+    Value* slots = nullptr;
+    size_t cap = 0;
+    size_t count = 0;
+
+    /// Empty slots that may still be filled before the table grows.
+    size_t growth_left = 0;
+
+    Hash hasher;
+    KeyEqual equal;
+    Alloc slot_alloc;
+    CtrlAlloc ctrl_alloc;
+};
+
+} // namespace std
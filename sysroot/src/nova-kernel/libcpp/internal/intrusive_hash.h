@@ -0,0 +1,380 @@
+/**
+ * @file intrusive_hash.h
+ * @author Seth McBee
+ * @date 2026-10-19
+ * @brief Hash table of buckets threaded through a hook in each element.
+ */
+
+#pragma once
+
+#include <globals.h>
+
+#include <functional>
+#include <iterator>
+#include <utility>
+
+#include <internal/intrusive_list.h>
+
+namespace std
+{
+
+/// Links an object into an intrusive_hash. Copying an object doesn't copy
+/// its links; the copy starts out unlinked.
+struct hash_hook
+{
+    hash_hook() {}
+
+    hash_hook(const hash_hook&) {}
+
+    hash_hook& operator=(const hash_hook&)
+    {
+        return *this;
+    }
+
+    bool is_linked() const
+    {
+        return pprev != nullptr;
+    }
+
+    hash_hook* next = nullptr;
+
+    /// The link that points at this hook, in the bucket or the previous
+    /// element, so that unlinking needs neither.
+    hash_hook** pprev = nullptr;
+};
+
+/// Head of one chain of an intrusive_hash.
+struct hash_bucket
+{
+    hash_hook* first = nullptr;
+};
+
+/// Forward iterator over an intrusive_hash, bucket by bucket. T is the
+/// element type, const for a const_iterator.
+template <class T, class Owner, hash_hook Owner::*Hook>
+struct IntrusiveHashIterator
+{
+    using iterator_category = forward_iterator_tag;
+    using value_type = T;
+    using difference_type = ptrdiff_t;
+    using pointer = T*;
+    using reference = T&;
+
+    IntrusiveHashIterator() {}
+
+    IntrusiveHashIterator(hash_hook* h, hash_bucket* b, hash_bucket* e)
+        : hook(h), bucket(b), buckets_end(e)
+    {
+        skip_empty();
+    }
+
+    /// Non-const to const conversion.
+    IntrusiveHashIterator(const IntrusiveHashIterator<Owner, Owner, Hook>& other)
+        : hook(other.hook), bucket(other.bucket), buckets_end(other.buckets_end) {}
+
+    T& operator*() const
+    {
+        return *hook_owner(hook, Hook);
+    }
+
+    T* operator->() const
+    {
+        return hook_owner(hook, Hook);
+    }
+
+    IntrusiveHashIterator& operator++()
+    {
+        hook = hook->next;
+        skip_empty();
+        return *this;
+    }
+
+    IntrusiveHashIterator operator++(int)
+    {
+        IntrusiveHashIterator ret = *this;
+        ++*this;
+        return ret;
+    }
+
+    bool operator==(const IntrusiveHashIterator& other) const
+    {
+        return hook == other.hook;
+    }
+
+    bool operator!=(const IntrusiveHashIterator& other) const
+    {
+        return hook != other.hook;
+    }
+
+    // Moves on to the next chain when this one is used up.
+    void skip_empty()
+    {
+        while (hook == nullptr && bucket != buckets_end)
+        {
+            ++bucket;
+            if (bucket != buckets_end)
+            {
+                hook = bucket->first;
+            }
+        }
+    }
+
+    hash_hook* hook = nullptr;
+    hash_bucket* bucket = nullptr;
+    hash_bucket* buckets_end = nullptr;
+};
+
+/// Hash table of objects that carry their own links in a hash_hook
+/// member, keyed on the member Key names. Buckets are chains in an array
+/// the caller provides, so the table never allocates:
+///
+///     static hash_bucket pid_buckets[256];
+///     intrusive_hash<Thread, &Thread::pid_hook, &Thread::id> pids(pid_buckets, 256);
+///
+/// Insert and find are O(1) on average and erase is O(1) from the element
+/// itself. The bucket count must be a power of two; rehash() moves the
+/// elements to a larger array when the caller has one. Keys must not
+/// change while linked, and the table doesn't own its elements.
+template <class T, hash_hook T::*Hook, auto Key,
+          class Hash = hash<typename IntrusiveMember<decltype(Key)>::type>,
+          class KeyEqual = equal_to<typename IntrusiveMember<decltype(Key)>::type>>
+class intrusive_hash
+{
+public:
+
+    using key_type = typename IntrusiveMember<decltype(Key)>::type;
+    using value_type = T;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+    using reference = T&;
+    using const_reference = const T&;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using iterator = IntrusiveHashIterator<T, T, Hook>;
+    using const_iterator = IntrusiveHashIterator<const T, T, Hook>;
+    using size_type = size_t;
+
+    /** Constructors. **/
+
+    /// Chains elements in n buckets, a power of two, which must be empty
+    /// and outlive the table.
+    intrusive_hash(hash_bucket* b, size_t n) : buckets(b), bucket_mask(n - 1) {}
+
+    intrusive_hash(const intrusive_hash&) = delete;
+    intrusive_hash& operator=(const intrusive_hash&) = delete;
+
+    /** Destructor. **/
+
+    ~intrusive_hash()
+    {
+        clear();
+    }
+
+    /** Status. **/
+
+    bool empty() const
+    {
+        return count == 0;
+    }
+
+    size_t size() const
+    {
+        return count;
+    }
+
+    size_t bucket_count() const
+    {
+        return bucket_mask + 1;
+    }
+
+    /// Elements per bucket.
+    float load_factor() const
+    {
+        return (float)count / (float)bucket_count();
+    }
+
+    /** Iterators. **/
+
+    iterator begin()
+    {
+        return iterator(buckets[0].first, buckets, buckets + bucket_count());
+    }
+
+    const_iterator begin() const
+    {
+        return const_iterator(buckets[0].first, buckets, buckets + bucket_count());
+    }
+
+    iterator end()
+    {
+        return iterator();
+    }
+
+    const_iterator end() const
+    {
+        return const_iterator();
+    }
+
+    /** Lookup. **/
+
+    /// An element with key, or end().
+    iterator find(const key_type& key)
+    {
+        hash_bucket* b = bucket_of(key);
+        for (hash_hook* h = b->first; h != nullptr; h = h->next)
+        {
+            if (equal_fn(hook_owner(h, Hook)->*Key, key))
+            {
+                return iterator(h, b, buckets + bucket_count());
+            }
+        }
+        return end();
+    }
+
+    const_iterator find(const key_type& key) const
+    {
+        return const_cast<intrusive_hash*>(this)->find(key);
+    }
+
+    bool contains(const key_type& key) const
+    {
+        return find(key) != end();
+    }
+
+    /** Mutators. **/
+
+    /// Links t unless an element with an equal key is present, in which
+    /// case that one is returned.
+    pair<iterator, bool> insert(T& t)
+    {
+        iterator it = find(t.*Key);
+        if (it != end())
+        {
+            return {it, false};
+        }
+
+        hash_bucket* b = bucket_of(t.*Key);
+        hash_hook* h = &(t.*Hook);
+        link(h, b);
+        count++;
+        return {iterator(h, b, buckets + bucket_count()), true};
+    }
+
+    /// Unlinks t, which must be in this table.
+    void erase(T& t)
+    {
+        unlink(&(t.*Hook));
+        count--;
+    }
+
+    /// Unlinks the element at pos and returns the one after it.
+    iterator erase(const_iterator pos)
+    {
+        iterator next(pos.hook->next, pos.bucket, pos.buckets_end);
+        unlink(pos.hook);
+        count--;
+        return next;
+    }
+
+    /// Unlinks the element with key, if any. Returns how many were.
+    size_t erase(const key_type& key)
+    {
+        iterator it = find(key);
+        if (it == end())
+        {
+            return 0;
+        }
+        erase(*it);
+        return 1;
+    }
+
+    /// Unlinks every element.
+    void clear()
+    {
+        for (size_t i = 0; i <= bucket_mask; i++)
+        {
+            hash_hook* h = buckets[i].first;
+            while (h != nullptr)
+            {
+                hash_hook* next = h->next;
+                h->next = nullptr;
+                h->pprev = nullptr;
+                h = next;
+            }
+            buckets[i].first = nullptr;
+        }
+        count = 0;
+    }
+
+    /// Moves every element into n new buckets, a power of two, which must
+    /// be empty and outlive the table. The old array can then be freed.
+    void rehash(hash_bucket* b, size_t n)
+    {
+        hash_bucket* old = buckets;
+        size_t old_count = bucket_count();
+        buckets = b;
+        bucket_mask = n - 1;
+
+        for (size_t i = 0; i < old_count; i++)
+        {
+            hash_hook* h = old[i].first;
+            while (h != nullptr)
+            {
+                hash_hook* next = h->next;
+                link(h, bucket_of(hook_owner(h, Hook)->*Key));
+                h = next;
+            }
+            old[i].first = nullptr;
+        }
+    }
+
+    /** Observers. **/
+
+    hasher hash_function() const
+    {
+        return hash_fn;
+    }
+
+    key_equal key_eq() const
+    {
+        return equal_fn;
+    }
+
+private:
+
+    hash_bucket* bucket_of(const key_type& key) const
+    {
+        return &buckets[hash_fn(key) & bucket_mask];
+    }
+
+    // Pushes h onto the front of bucket b.
+    static void link(hash_hook* h, hash_bucket* b)
+    {
+        h->next = b->first;
+        h->pprev = &b->first;
+        if (b->first != nullptr)
+        {
+            b->first->pprev = &h->next;
+        }
+        b->first = h;
+    }
+
+    static void unlink(hash_hook* h)
+    {
+        *h->pprev = h->next;
+        if (h->next != nullptr)
+        {
+            h->next->pprev = h->pprev;
+        }
+        h->next = nullptr;
+        h->pprev = nullptr;
+    }
+
+    hash_bucket* buckets;
+    size_t bucket_mask;
+    size_t count = 0;
+    Hash hash_fn;
+    KeyEqual equal_fn;
+};
+
+}
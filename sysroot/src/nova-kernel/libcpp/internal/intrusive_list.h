@@ -0,0 +1,365 @@
+/**
+ * @file intrusive_list.h
+ * @author Seth McBee
+ * @date 2026-10-19
+ * @brief Doubly-linked list threaded through a hook in each element.
+ */
+
+#pragma once
+
+#include <globals.h>
+
+#include <iterator>
+#include <utility>
+#include <stdint.h>
+
+namespace std
+{
+
+/// The object holding a hook, found from the hook's address and its
+/// member pointer.
+template <class T, class Hook>
+T* hook_owner(const Hook* h, Hook T::*member)
+{
+    // The offset is measured on a made-up address that is never touched.
+    const uintptr_t probe = alignof(T) > 4096 ? alignof(T) : 4096;
+    uintptr_t offset = (uintptr_t)&(((T*)probe)->*member) - probe;
+    return (T*)((uintptr_t)h - offset);
+}
+
+/// Type of the member a member pointer names.
+template <class M>
+struct IntrusiveMember;
+
+template <class T, class V>
+struct IntrusiveMember<V T::*>
+{
+    using type = V;
+};
+
+/// Links an object into an intrusive_list. An object can be in as many
+/// lists at once as it has hooks. Copying an object doesn't copy its
+/// links; the copy starts out unlinked.
+struct list_hook
+{
+    list_hook() {}
+
+    list_hook(const list_hook&) {}
+
+    list_hook& operator=(const list_hook&)
+    {
+        return *this;
+    }
+
+    bool is_linked() const
+    {
+        return next != nullptr;
+    }
+
+    list_hook* prev = nullptr;
+    list_hook* next = nullptr;
+};
+
+/// Iterator over an intrusive_list. T is the element type, const for a
+/// const_iterator.
+template <class T, class Owner, list_hook Owner::*Hook>
+struct IntrusiveListIterator
+{
+    using iterator_category = bidirectional_iterator_tag;
+    using value_type = T;
+    using difference_type = ptrdiff_t;
+    using pointer = T*;
+    using reference = T&;
+
+    IntrusiveListIterator() {}
+
+    explicit IntrusiveListIterator(list_hook* h) : hook(h) {}
+
+    /// Non-const to const conversion.
+    IntrusiveListIterator(const IntrusiveListIterator<Owner, Owner, Hook>& other)
+        : hook(other.hook) {}
+
+    T& operator*() const
+    {
+        return *hook_owner(hook, Hook);
+    }
+
+    T* operator->() const
+    {
+        return hook_owner(hook, Hook);
+    }
+
+    IntrusiveListIterator& operator++()
+    {
+        hook = hook->next;
+        return *this;
+    }
+
+    IntrusiveListIterator operator++(int)
+    {
+        IntrusiveListIterator ret = *this;
+        hook = hook->next;
+        return ret;
+    }
+
+    IntrusiveListIterator& operator--()
+    {
+        hook = hook->prev;
+        return *this;
+    }
+
+    IntrusiveListIterator operator--(int)
+    {
+        IntrusiveListIterator ret = *this;
+        hook = hook->prev;
+        return ret;
+    }
+
+    bool operator==(const IntrusiveListIterator& other) const
+    {
+        return hook == other.hook;
+    }
+
+    bool operator!=(const IntrusiveListIterator& other) const
+    {
+        return hook != other.hook;
+    }
+
+    list_hook* hook = nullptr;
+};
+
+/// Doubly-linked list of objects that carry their own links in a
+/// list_hook member. Nothing is allocated or copied: linking and
+/// unlinking, from any position, are O(1) pointer updates, so a list can
+/// be used where allocating is not allowed. The list doesn't own its
+/// elements, which must stay put while linked.
+template <class T, list_hook T::*Hook>
+class intrusive_list
+{
+public:
+
+    using value_type = T;
+    using reference = T&;
+    using const_reference = const T&;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using iterator = IntrusiveListIterator<T, T, Hook>;
+    using const_iterator = IntrusiveListIterator<const T, T, Hook>;
+    using size_type = size_t;
+
+    /** Constructors. **/
+
+    intrusive_list()
+    {
+        head.prev = &head;
+        head.next = &head;
+    }
+
+    intrusive_list(const intrusive_list&) = delete;
+
+    intrusive_list(intrusive_list&& other) : intrusive_list()
+    {
+        splice(end(), other);
+    }
+
+    /** Destructor. **/
+
+    ~intrusive_list()
+    {
+        clear();
+    }
+
+    /** Assignment operators. **/
+
+    intrusive_list& operator=(const intrusive_list&) = delete;
+
+    intrusive_list& operator=(intrusive_list&& other)
+    {
+        if (this != &other)
+        {
+            clear();
+            splice(end(), other);
+        }
+        return *this;
+    }
+
+    /** Status. **/
+
+    bool empty() const
+    {
+        return head.next == &head;
+    }
+
+    size_t size() const
+    {
+        return count;
+    }
+
+    /** Accessors. **/
+
+    T& front()
+    {
+        return *begin();
+    }
+
+    const T& front() const
+    {
+        return *begin();
+    }
+
+    T& back()
+    {
+        return *iterator(head.prev);
+    }
+
+    const T& back() const
+    {
+        return *const_iterator(head.prev);
+    }
+
+    /** Iterators. **/
+
+    iterator begin()
+    {
+        return iterator(head.next);
+    }
+
+    const_iterator begin() const
+    {
+        return const_iterator(head.next);
+    }
+
+    iterator end()
+    {
+        return iterator(&head);
+    }
+
+    const_iterator end() const
+    {
+        return const_iterator(const_cast<list_hook*>(&head));
+    }
+
+    /// Iterator to an element in this list.
+    iterator iterator_to(T& t)
+    {
+        return iterator(&(t.*Hook));
+    }
+
+    const_iterator iterator_to(const T& t) const
+    {
+        return const_iterator(const_cast<list_hook*>(&(t.*Hook)));
+    }
+
+    /** Mutators. **/
+
+    /// Links t before pos. t must not be in a list through this hook.
+    iterator insert(const_iterator pos, T& t)
+    {
+        list_hook* h = &(t.*Hook);
+        list_hook* next = pos.hook;
+        h->next = next;
+        h->prev = next->prev;
+        next->prev->next = h;
+        next->prev = h;
+        count++;
+        return iterator(h);
+    }
+
+    void push_front(T& t)
+    {
+        insert(begin(), t);
+    }
+
+    void push_back(T& t)
+    {
+        insert(end(), t);
+    }
+
+    void pop_front()
+    {
+        erase(begin());
+    }
+
+    void pop_back()
+    {
+        erase(iterator(head.prev));
+    }
+
+    /// Unlinks the element at pos and returns the one after it.
+    iterator erase(const_iterator pos)
+    {
+        list_hook* h = pos.hook;
+        list_hook* next = h->next;
+        h->prev->next = next;
+        next->prev = h->prev;
+        h->prev = nullptr;
+        h->next = nullptr;
+        count--;
+        return iterator(next);
+    }
+
+    /// Unlinks t, which must be in this list.
+    void erase(T& t)
+    {
+        erase(iterator_to(t));
+    }
+
+    /// Unlinks every element.
+    void clear()
+    {
+        list_hook* h = head.next;
+        while (h != &head)
+        {
+            list_hook* next = h->next;
+            h->prev = nullptr;
+            h->next = nullptr;
+            h = next;
+        }
+        head.prev = &head;
+        head.next = &head;
+        count = 0;
+    }
+
+    /// Moves every element of other before pos.
+    void splice(const_iterator pos, intrusive_list& other)
+    {
+        if (other.empty() || &other == this)
+        {
+            return;
+        }
+
+        list_hook* first = other.head.next;
+        list_hook* last = other.head.prev;
+        list_hook* next = pos.hook;
+        first->prev = next->prev;
+        last->next = next;
+        next->prev->next = first;
+        next->prev = last;
+        count += other.count;
+
+        other.head.prev = &other.head;
+        other.head.next = &other.head;
+        other.count = 0;
+    }
+
+    /// Moves t, which is in other, before pos.
+    void splice(const_iterator pos, intrusive_list& other, T& t)
+    {
+        other.erase(t);
+        insert(pos, t);
+    }
+
+    void swap(intrusive_list& other)
+    {
+        intrusive_list tmp(std::move(other));
+        other.splice(other.end(), *this);
+        splice(end(), tmp);
+    }
+
+private:
+
+    list_hook head;
+    size_t count = 0;
+};
+
+}
@@ -0,0 +1,421 @@
+/**
+ * @file intrusive_tree.h
+ * @author Seth McBee
+ * @date 2026-10-19
+ * @brief Ordered AVL tree threaded through a hook in each element.
+ */
+
+#pragma once
+
+#include <globals.h>
+
+#include <functional>
+#include <iterator>
+#include <utility>
+
+#include <internal/avl_tree.h>
+#include <internal/intrusive_list.h>
+
+namespace std
+{
+
+/// Links an object into an intrusive_tree. Copying an object doesn't copy
+/// its links; the copy starts out unlinked.
+struct tree_hook : public AvlNode
+{
+    tree_hook() {}
+
+    tree_hook(const tree_hook&) {}
+
+    tree_hook& operator=(const tree_hook&)
+    {
+        return *this;
+    }
+
+    bool is_linked() const
+    {
+        return parent != nullptr;
+    }
+};
+
+/// Iterator over an intrusive_tree. T is the element type, const for a
+/// const_iterator.
+template <class T, class Owner, tree_hook Owner::*Hook>
+struct IntrusiveTreeIterator
+{
+    using iterator_category = bidirectional_iterator_tag;
+    using value_type = T;
+    using difference_type = ptrdiff_t;
+    using pointer = T*;
+    using reference = T&;
+
+    IntrusiveTreeIterator() {}
+
+    explicit IntrusiveTreeIterator(AvlNode* n) : node(n) {}
+
+    /// Non-const to const conversion.
+    IntrusiveTreeIterator(const IntrusiveTreeIterator<Owner, Owner, Hook>& other)
+        : node(other.node) {}
+
+    T& operator*() const
+    {
+        return *hook_owner(static_cast<tree_hook*>(node), Hook);
+    }
+
+    T* operator->() const
+    {
+        return hook_owner(static_cast<tree_hook*>(node), Hook);
+    }
+
+    IntrusiveTreeIterator& operator++()
+    {
+        node = AvlNode::next(node);
+        return *this;
+    }
+
+    IntrusiveTreeIterator operator++(int)
+    {
+        IntrusiveTreeIterator ret = *this;
+        node = AvlNode::next(node);
+        return ret;
+    }
+
+    IntrusiveTreeIterator& operator--()
+    {
+        node = AvlNode::prev(node);
+        return *this;
+    }
+
+    IntrusiveTreeIterator operator--(int)
+    {
+        IntrusiveTreeIterator ret = *this;
+        node = AvlNode::prev(node);
+        return ret;
+    }
+
+    bool operator==(const IntrusiveTreeIterator& other) const
+    {
+        return node == other.node;
+    }
+
+    bool operator!=(const IntrusiveTreeIterator& other) const
+    {
+        return node != other.node;
+    }
+
+    AvlNode* node = nullptr;
+};
+
+/// AVL tree of objects that carry their own links in a tree_hook member,
+/// ordered on the member Key names, e.g.
+///
+///     intrusive_tree<Timer, &Timer::hook, &Timer::deadline> timers;
+///
+/// Nothing is allocated: insert and erase are O(log n) pointer updates,
+/// and an element is reached from itself in O(1) for erase. Equal keys
+/// are allowed and kept in insertion order. Keys must not change while
+/// linked, and the tree doesn't own its elements.
+template <class T, tree_hook T::*Hook, auto Key,
+          class Compare = less<typename IntrusiveMember<decltype(Key)>::type>>
+class intrusive_tree
+{
+public:
+
+    using key_type = typename IntrusiveMember<decltype(Key)>::type;
+    using value_type = T;
+    using key_compare = Compare;
+    using reference = T&;
+    using const_reference = const T&;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using iterator = IntrusiveTreeIterator<T, T, Hook>;
+    using const_iterator = IntrusiveTreeIterator<const T, T, Hook>;
+    using size_type = size_t;
+
+    /** Constructors. **/
+
+    intrusive_tree() {}
+
+    explicit intrusive_tree(const Compare& comp) : compare(comp) {}
+
+    intrusive_tree(const intrusive_tree&) = delete;
+
+    intrusive_tree(intrusive_tree&& other) : compare(other.compare)
+    {
+        tree.take_root(other.tree);
+    }
+
+    /** Destructor. **/
+
+    ~intrusive_tree()
+    {
+        clear();
+    }
+
+    /** Assignment operators. **/
+
+    intrusive_tree& operator=(const intrusive_tree&) = delete;
+
+    intrusive_tree& operator=(intrusive_tree&& other)
+    {
+        if (this != &other)
+        {
+            clear();
+            compare = other.compare;
+            tree.take_root(other.tree);
+        }
+        return *this;
+    }
+
+    /** Status. **/
+
+    bool empty() const
+    {
+        return tree.node_count == 0;
+    }
+
+    size_t size() const
+    {
+        return tree.node_count;
+    }
+
+    /** Iterators. **/
+
+    iterator begin()
+    {
+        return iterator(tree.first());
+    }
+
+    const_iterator begin() const
+    {
+        return const_iterator(tree.first());
+    }
+
+    iterator end()
+    {
+        return iterator(tree.end_node());
+    }
+
+    const_iterator end() const
+    {
+        return const_iterator(tree.end_node());
+    }
+
+    /// Iterator to an element in this tree.
+    iterator iterator_to(T& t)
+    {
+        return iterator(&(t.*Hook));
+    }
+
+    const_iterator iterator_to(const T& t) const
+    {
+        return const_iterator(const_cast<tree_hook*>(&(t.*Hook)));
+    }
+
+    /// Element with the smallest key.
+    T& front()
+    {
+        return *begin();
+    }
+
+    /// Element with the largest key.
+    T& back()
+    {
+        return *iterator(tree.last());
+    }
+
+    /** Lookup. **/
+
+    /// First element whose key is not less than key.
+    iterator lower_bound(const key_type& key)
+    {
+        return iterator(bound(key, false));
+    }
+
+    const_iterator lower_bound(const key_type& key) const
+    {
+        return const_iterator(bound(key, false));
+    }
+
+    /// First element whose key is greater than key.
+    iterator upper_bound(const key_type& key)
+    {
+        return iterator(bound(key, true));
+    }
+
+    const_iterator upper_bound(const key_type& key) const
+    {
+        return const_iterator(bound(key, true));
+    }
+
+    /// First element with key, or end().
+    iterator find(const key_type& key)
+    {
+        return iterator(find_node(key));
+    }
+
+    const_iterator find(const key_type& key) const
+    {
+        return const_iterator(find_node(key));
+    }
+
+    bool contains(const key_type& key) const
+    {
+        return find_node(key) != tree.end_node();
+    }
+
+    /** Mutators. **/
+
+    /// Links t after any elements with an equal key. t must not be in a
+    /// tree through this hook.
+    iterator insert(T& t)
+    {
+        AvlNode* parent = &tree.header;
+        AvlNode** link = &tree.header.left;
+        while (*link != nullptr)
+        {
+            parent = *link;
+            if (compare(t.*Key, key_of(parent)))
+            {
+                link = &parent->left;
+            }
+            else
+            {
+                link = &parent->right;
+            }
+        }
+
+        tree_hook* h = &(t.*Hook);
+        tree.link_node(h, parent, link);
+        return iterator(h);
+    }
+
+    /// Links t unless an element with an equal key is present, in which
+    /// case that one is returned.
+    pair<iterator, bool> insert_unique(T& t)
+    {
+        AvlNode* parent = &tree.header;
+        AvlNode** link = &tree.header.left;
+        while (*link != nullptr)
+        {
+            parent = *link;
+            if (compare(t.*Key, key_of(parent)))
+            {
+                link = &parent->left;
+            }
+            else if (compare(key_of(parent), t.*Key))
+            {
+                link = &parent->right;
+            }
+            else
+            {
+                return {iterator(parent), false};
+            }
+        }
+
+        tree_hook* h = &(t.*Hook);
+        tree.link_node(h, parent, link);
+        return {iterator(h), true};
+    }
+
+    /// Unlinks the element at pos and returns the one after it.
+    iterator erase(const_iterator pos)
+    {
+        return iterator(tree.unlink_node(pos.node));
+    }
+
+    /// Unlinks t, which must be in this tree.
+    void erase(T& t)
+    {
+        tree.unlink_node(&(t.*Hook));
+    }
+
+    /// Unlinks every element.
+    void clear()
+    {
+        // Post-order walk that detaches each leaf as it goes.
+        AvlNode* n = tree.root();
+        while (n != nullptr)
+        {
+            if (n->left != nullptr)
+            {
+                n = n->left;
+            }
+            else if (n->right != nullptr)
+            {
+                n = n->right;
+            }
+            else
+            {
+                AvlNode* p = n->parent;
+                if (p->left == n)
+                {
+                    p->left = nullptr;
+                }
+                else
+                {
+                    p->right = nullptr;
+                }
+                n->parent = nullptr;
+                n = (p == &tree.header) ? nullptr : p;
+            }
+        }
+        tree.reset();
+    }
+
+    void swap(intrusive_tree& other)
+    {
+        tree.swap_root(other.tree);
+        std::swap(compare, other.compare);
+    }
+
+    /** Observers. **/
+
+    key_compare key_comp() const
+    {
+        return compare;
+    }
+
+private:
+
+    static const key_type& key_of(const AvlNode* n)
+    {
+        return hook_owner(static_cast<const tree_hook*>(n), Hook)->*Key;
+    }
+
+    // First node not less than key, or greater than key if upper.
+    AvlNode* bound(const key_type& key, bool upper) const
+    {
+        AvlNode* best = tree.end_node();
+        AvlNode* n = tree.root();
+        while (n != nullptr)
+        {
+            bool go_right = upper ? !compare(key, key_of(n)) : compare(key_of(n), key);
+            if (go_right)
+            {
+                n = n->right;
+            }
+            else
+            {
+                best = n;
+                n = n->left;
+            }
+        }
+        return best;
+    }
+
+    AvlNode* find_node(const key_type& key) const
+    {
+        AvlNode* n = bound(key, false);
+        if (n != tree.end_node() && !compare(key, key_of(n)))
+        {
+            return n;
+        }
+        return tree.end_node();
+    }
+
+    AvlTree tree;
+    Compare compare;
+};
+
+}
@@ -9,6 +9,7 @@
 #include <initializer_list>
 #include <iterator>
 #include <memory>
+#include <memory_resource>
 #include <utility>
 #include <stdint.h>
 
@@ -218,11 +219,11 @@ public:
     using difference_type = ptrdiff_t;
     using size_type = size_t;
 
-    using NodeAlloc = typename Alloc::template rebind<ListNode<T>>::other;
+    using NodeAlloc = typename node_alloc_rebind<Alloc, ListNode<T>>::type;
 
     /** Constructors. **/
 
-    explicit list(const allocator_type& a = allocator_type()) {}
+    explicit list(const allocator_type& a = allocator_type()) : alloc(a) {}
 
     /** Destructor. **/
 
@@ -390,4 +391,12 @@ private:
     NodeAlloc alloc;
 };
 
+namespace pmr
+{
+
+template <class T>
+using list = std::list<T, polymorphic_allocator<T>>;
+
+} // namespace pmr
+
 }
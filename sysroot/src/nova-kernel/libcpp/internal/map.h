@@ -10,241 +10,549 @@
 
 #include <algorithm>
 #include <functional>
+#include <initializer_list>
 #include <iterator>
 #include <memory>
-#include <stack>
+#include <memory_resource>
+#include <type_traits>
 #include <utility>
 #include <stdint.h>
-#include <stdio.h>
+
+#include <internal/avl_tree.h>
 
 namespace std
 {
 
 template <class Data>
-struct MapNode
+struct MapNode : public AvlNode
 {
-    MapNode() {}
-    MapNode(const Data& d) : data(d) {}
+    template <class... Args>
+    MapNode(Args&&... args) : data(forward<Args>(args)...) {}
 
-    size_t height = 1;
     Data data;
-    MapNode<Data>* left;
-    MapNode<Data>* right;
 };
 
-template <class Data, class Compare>
-struct MapTree
+/// Largest number of nodes in one chunk of a MapNodePool.
+const size_t MAP_POOL_CHUNK_MAX = 256;
+
+/// Hands out the nodes of one tree from chunks it owns. Chunks double in
+/// size up to MAP_POOL_CHUNK_MAX nodes, freed nodes are kept for reuse, and
+/// release() gives every chunk back to the allocator at once.
+template <class Node, class Alloc>
+class MapNodePool
 {
-    MapTree() {}
+public:
 
-    ~MapTree()
+    MapNodePool() {}
+
+    explicit MapNodePool(const Alloc& a) : alloc(a) {}
+
+    MapNodePool(MapNodePool&& other) : alloc(other.alloc)
     {
-        if (root == nullptr)
-        {
-            return;
-        }
+        take(other);
+    }
 
-        stack<MapNode<Data>*> stk;
-        stk.push(root);
-        while (!stk.empty())
-        {
-            auto cur = stk.top();
-            stk.pop();
-            if (cur->left != nullptr)
-            {
-                stk.push(cur->left);
-            }
-            if (cur->right != nullptr)
-            {
-                stk.push(cur->right);
-            }
-            delete cur;
-        }
+    MapNodePool(const MapNodePool&) = delete;
+    MapNodePool& operator=(const MapNodePool&) = delete;
+
+    ~MapNodePool()
+    {
+        release();
+    }
+
+    /// Takes over the chunks of other. This pool must hold none.
+    void take(MapNodePool& other)
+    {
+        chunks = other.chunks;
+        free_list = other.free_list;
+        next_count = other.next_count;
+        other.chunks = nullptr;
+        other.free_list = nullptr;
+        other.next_count = 1;
+    }
+
+    void swap(MapNodePool& other)
+    {
+        std::swap(chunks, other.chunks);
+        std::swap(free_list, other.free_list);
+        std::swap(next_count, other.next_count);
     }
 
-    int calc_height(const MapNode<Data>* root)
+    /// Uninitialized storage for one node.
+    Node* allocate()
     {
-        if (root == nullptr)
+        if (free_list == nullptr)
         {
-            return 0;
+            grow();
         }
-        else
+        Slot* s = free_list;
+        free_list = s->next;
+        return (Node*)s->node;
+    }
+
+    void deallocate(Node* n)
+    {
+        Slot* s = (Slot*)n;
+        s->next = free_list;
+        free_list = s;
+    }
+
+    /// Frees every chunk. Nodes still in them must already be destroyed.
+    void release()
+    {
+        while (chunks != nullptr)
         {
-            return root->height;
+            Slot* c = chunks;
+            chunks = c->chunk.next;
+            alloc.deallocate(c, c->chunk.count + 1);
         }
+        free_list = nullptr;
+        next_count = 1;
+    }
+
+    Alloc get_allocator() const
+    {
+        return Alloc(alloc);
     }
 
-    int calc_balance(const MapNode<Data>* root)
+private:
+
+    // The first slot of each chunk holds its link and size in place of a
+    // node.
+    union Slot
     {
-        if (root == nullptr)
+        Slot* next;
+        struct
         {
-            return 0;
-        }
-        else
+            Slot* next;
+            size_t count;
+        } chunk;
+        alignas(Node) unsigned char node[sizeof(Node)];
+    };
+
+    using SlotAlloc = typename Alloc::template rebind<Slot>::other;
+
+    void grow()
+    {
+        size_t count = next_count;
+        next_count = min(count * 2, MAP_POOL_CHUNK_MAX);
+
+        Slot* c = alloc.allocate(count + 1);
+        c->chunk.next = chunks;
+        c->chunk.count = count;
+        chunks = c;
+        for (size_t i = count; i > 0; --i)
         {
-            int l = calc_height(root->left);
-            int r = calc_height(root->right);
-            return l - r;
+            c[i].next = free_list;
+            free_list = &c[i];
         }
     }
 
-    void update_height(MapNode<Data>* root)
+    SlotAlloc alloc;
+    Slot* chunks = nullptr;
+    Slot* free_list = nullptr;
+    size_t next_count = 1;
+};
+
+template <class Data>
+struct MapIteratorBase
+{
+    using iterator_category = bidirectional_iterator_tag;
+    using value_type = Data;
+    using difference_type = ptrdiff_t;
+    using pointer = Data*;
+    using reference = Data&;
+
+    MapIteratorBase() {}
+
+    explicit MapIteratorBase(AvlNode* n) : node(n) {}
+
+    Data& get() const
+    {
+        return static_cast<MapNode<Data>*>(node)->data;
+    }
+
+    AvlNode* node = nullptr;
+};
+
+template <class Data>
+struct MapIterator : public MapIteratorBase<Data>
+{
+    using MapIteratorBase<Data>::MapIteratorBase;
+
+    bool operator==(const MapIterator& other) const
+    {
+        return this->node == other.node;
+    }
+
+    bool operator!=(const MapIterator& other) const
+    {
+        return this->node != other.node;
+    }
+
+    Data& operator*() const
+    {
+        return this->get();
+    }
+
+    Data* operator->() const
+    {
+        return &this->get();
+    }
+
+    MapIterator& operator++()
+    {
+        this->node = AvlNode::next(this->node);
+        return *this;
+    }
+
+    MapIterator operator++(int)
+    {
+        MapIterator ret = *this;
+        ++*this;
+        return ret;
+    }
+
+    MapIterator& operator--()
+    {
+        this->node = AvlNode::prev(this->node);
+        return *this;
+    }
+
+    MapIterator operator--(int)
+    {
+        MapIterator ret = *this;
+        --*this;
+        return ret;
+    }
+};
+
+template <class Data>
+struct ConstMapIterator : public MapIteratorBase<Data>
+{
+    using value_type = const Data;
+    using pointer = const Data*;
+    using reference = const Data&;
+
+    using MapIteratorBase<Data>::MapIteratorBase;
+
+    ConstMapIterator(const MapIterator<Data>& other)
+        : MapIteratorBase<Data>(other.node) {}
+
+    bool operator==(const ConstMapIterator& other) const
+    {
+        return this->node == other.node;
+    }
+
+    bool operator!=(const ConstMapIterator& other) const
     {
-        int l = calc_height(root->left);
-        int r = calc_height(root->right);
-        root->height = 1 + max(l, r);
+        return this->node != other.node;
     }
 
-    void rotate_left(MapNode<Data>*& root)
+    const Data& operator*() const
     {
-        auto new_root = root->right;
-        auto new_right = new_root->left;
+        return this->get();
+    }
+
+    const Data* operator->() const
+    {
+        return &this->get();
+    }
+
+    ConstMapIterator& operator++()
+    {
+        this->node = AvlNode::next(this->node);
+        return *this;
+    }
 
-        // Rotate.
-        new_root->left = root;
-        root->right = new_right;
+    ConstMapIterator operator++(int)
+    {
+        ConstMapIterator ret = *this;
+        ++*this;
+        return ret;
+    }
 
-        // Update heights.
-        update_height(new_root->left->right);
-        update_height(new_root);
+    ConstMapIterator& operator--()
+    {
+        this->node = AvlNode::prev(this->node);
+        return *this;
+    }
 
-        root = new_root;
+    ConstMapIterator operator--(int)
+    {
+        ConstMapIterator ret = *this;
+        --*this;
+        return ret;
     }
+};
+
+/// AVL tree of pairs ordered on their first member, with nodes from a
+/// pool owned by the tree.
+template <class Data, class Compare, class Alloc>
+struct MapTree : public AvlTree
+{
+    using Node = MapNode<Data>;
+    using Key = typename remove_const<typename Data::first_type>::type;
+
+    MapTree() {}
+
+    explicit MapTree(const Alloc& a) : pool(a) {}
 
-    void rotate_right(MapNode<Data>*& root)
+    MapTree(const MapTree& other, const Alloc& a)
+        : compare(other.compare), pool(a)
     {
-        auto new_root = root->left;
-        auto new_left = new_root->left;
+        copy_from(other);
+    }
 
-        // Rotate.
-        new_root->right = root;
-        root->left = new_left;
+    MapTree(MapTree&& other)
+        : compare(other.compare), pool(std::move(other.pool))
+    {
+        take_root(other);
+    }
 
-        update_height(new_root->right->left);
-        update_height(new_root);
+    ~MapTree()
+    {
+        clear();
+    }
 
-        root = new_root;
+    MapTree& operator=(const MapTree& other)
+    {
+        if (this != &other)
+        {
+            clear();
+            compare = other.compare;
+            copy_from(other);
+        }
+        return *this;
     }
 
-    pair<MapNode<Data>*, bool> insert(const Data& d)
+    MapTree& operator=(MapTree&& other)
     {
-        // Check for empty tree.
-        if (root == nullptr)
+        if (this == &other)
         {
-            root = new MapNode<Data>(d);
+            return *this;
         }
-        else
+
+        clear();
+        compare = other.compare;
+        if (pool.get_allocator() == other.pool.get_allocator())
         {
-            MapNode<Data>* cur = root;
-            MapNode<Data>* prev = nullptr;
-            stack<MapNode<Data>*> stk;
+            pool.take(other.pool);
+            take_root(other);
+            return *this;
+        }
 
-            // Build path to new node.
-            while (cur != nullptr)
-            {
-                prev = cur;
+        // Nodes can't change hands between unequal allocators.
+        copy_from(other);
+        other.clear();
+        return *this;
+    }
 
-                if (compare(d.first, cur->data.first))
-                {
-                    cur = cur->left;
-                }
-                else if (compare(cur->data.first, d.first))
-                {
-                    cur = cur->right;
-                }
-                else
-                {
-                    // Can't add duplicate node.
-                    return {nullptr, false};
-                }
+    static const Key& key_of(const AvlNode* n)
+    {
+        return static_cast<const Node*>(n)->data.first;
+    }
 
-                stk.push(prev);
+    /** Lookup. **/
+
+    /// First node not less than key, or the header.
+    AvlNode* lower_bound(const Key& key) const
+    {
+        AvlNode* best = end_node();
+        AvlNode* n = root();
+        while (n != nullptr)
+        {
+            if (compare(key_of(n), key))
+            {
+                n = n->right;
             }
+            else
+            {
+                best = n;
+                n = n->left;
+            }
+        }
+        return best;
+    }
 
-            // Add new node.
-            if (compare(d.first, prev->data.first))
+    /// First node greater than key, or the header.
+    AvlNode* upper_bound(const Key& key) const
+    {
+        AvlNode* best = end_node();
+        AvlNode* n = root();
+        while (n != nullptr)
+        {
+            if (compare(key, key_of(n)))
             {
-                delete prev->left;
-                prev->left = new MapNode<Data>(d);
+                best = n;
+                n = n->left;
             }
             else
             {
-                delete prev->right;
-                prev->right = new MapNode<Data>(d);
+                n = n->right;
             }
+        }
+        return best;
+    }
 
-            // Balance tree
-            while (!stk.empty())
+    AvlNode* find(const Key& key) const
+    {
+        AvlNode* n = lower_bound(key);
+        if (n != end_node() && !compare(key, key_of(n)))
+        {
+            return n;
+        }
+        return end_node();
+    }
+
+    /** Modifiers. **/
+
+    /// Looks for key. If it's missing, parent and link are set to where a
+    /// node for it would hang, and nullptr is returned.
+    AvlNode* find_slot(const Key& key, AvlNode*& parent, AvlNode**& link)
+    {
+        parent = &header;
+        link = &header.left;
+        while (*link != nullptr)
+        {
+            parent = *link;
+            if (compare(key, key_of(parent)))
             {
-                cur = stk.top();
+                link = &parent->left;
+            }
+            else if (compare(key_of(parent), key))
+            {
+                link = &parent->right;
+            }
+            else
+            {
+                return parent;
+            }
+        }
+        return nullptr;
+    }
 
-                if (calc_balance(cur) > 1)
-                {
-                    // Check for L-R.
-                    if (calc_balance(cur->left) < 0)
-                    {
-                        rotate_left(cur->left);
-                    }
+    /// Builds a node from args and hangs it where find_slot() said.
+    template <class... Args>
+    AvlNode* insert_at(AvlNode* parent, AvlNode** link, Args&&... args)
+    {
+        Node* node = create_node(forward<Args>(args)...);
+        link_node(node, parent, link);
+        return node;
+    }
 
-                    rotate_right(cur);
+    /// Inserts Data(args...) unless its key is already present.
+    template <class... Args>
+    pair<AvlNode*, bool> emplace(Args&&... args)
+    {
+        // The key is only known once the element has been built.
+        Node* node = create_node(forward<Args>(args)...);
+        AvlNode* parent;
+        AvlNode** link;
+        AvlNode* found = find_slot(node->data.first, parent, link);
+        if (found != nullptr)
+        {
+            destroy_node(node);
+            return {found, false};
+        }
+        link_node(node, parent, link);
+        return {node, true};
+    }
+
+    /// Unlinks and destroys a node, returning its successor.
+    AvlNode* erase(AvlNode* z)
+    {
+        AvlNode* next = unlink_node(z);
+        destroy_node(static_cast<Node*>(z));
+        return next;
+    }
+
+    /// Destroys every element and frees the pool.
+    void clear()
+    {
+        if (!is_trivially_destructible_v<Data>)
+        {
+            // Post-order walk that detaches each leaf as it goes.
+            AvlNode* n = root();
+            while (n != nullptr)
+            {
+                if (n->left != nullptr)
+                {
+                    n = n->left;
                 }
-                else if (calc_balance(cur) < -1)
+                else if (n->right != nullptr)
+                {
+                    n = n->right;
+                }
+                else
                 {
-                    // Check for R-L.
-                    if (calc_balance(cur->right) > 0)
+                    AvlNode* p = n->parent;
+                    if (p->left == n)
                     {
-                        rotate_right(cur->right);
+                        p->left = nullptr;
                     }
-
-                    rotate_left(cur);
+                    else
+                    {
+                        p->right = nullptr;
+                    }
+                    static_cast<Node*>(n)->~Node();
+                    n = (p == &header) ? nullptr : p;
                 }
-
-                update_height(cur);
-
-                stk.pop();
             }
         }
+
+        reset();
+        pool.release();
     }
 
-    void inorder(const MapNode<Data>* r)
+    void swap(MapTree& other)
     {
-        if (r == nullptr)
-        {
-            return;
-        }
-        else
-        {
-            inorder(r->left);
-            printf("[%d, %s], ", r->data.first, r->data.second);
-            inorder(r->right);
-        }
+        swap_root(other);
+        std::swap(compare, other.compare);
+        pool.swap(other.pool);
     }
 
-    MapNode<Data>* root;
-    Compare compare;
-};
+    /** Nodes. **/
 
-template <class Key, class T, class Compare, class Allocator>
-class map;
+    template <class... Args>
+    Node* create_node(Args&&... args)
+    {
+        Node* node = pool.allocate();
+        new ((void*)node) Node(forward<Args>(args)...);
+        return node;
+    }
 
-template <class Key, class T, class Compare, class Allocator>
-struct MapIteratorBase
-{
-    using iterator_category = bidirectional_iterator_tag;
-    using value_type = pair<Key, T>;
-    using difference_type = ptrdiff_t;
-    using pointer = T*;
-    using reference = T&;
-};
+    void destroy_node(Node* node)
+    {
+        node->~Node();
+        pool.deallocate(node);
+    }
 
-template <class Key, class T, class Compare, class Allocator>
-struct MapIterator : public MapIteratorBase<Key, T, Compare, Allocator>
-{
-};
+    // Copies a subtree node for node, keeping its shape.
+    AvlNode* clone(const AvlNode* src, AvlNode* parent)
+    {
+        if (src == nullptr)
+        {
+            return nullptr;
+        }
 
-template <class Key, class T, class Compare, class Allocator>
-struct ConstMapIterator : public MapIteratorBase<Key, T, Compare, Allocator>
-{
+        Node* node = create_node(static_cast<const Node*>(src)->data);
+        node->parent = parent;
+        node->height = src->height;
+        node->left = clone(src->left, node);
+        node->right = clone(src->right, node);
+        return node;
+    }
+
+    // Copies the elements of other into an empty tree.
+    void copy_from(const MapTree& other)
+    {
+        header.left = clone(other.root(), &header);
+        node_count = other.node_count;
+    }
+
+    Compare compare;
+    MapNodePool<Node, Alloc> pool;
 };
 
 template <class Key, class T, class Compare = less<Key>, class Allocator = allocator<pair<const Key, T>>>
@@ -261,33 +569,295 @@ public:
     using const_reference = const value_type&;
     using pointer = value_type*;
     using const_pointer = const value_type*;
-    using iterator = MapIterator<Key, T, Compare, Allocator>;
-    using const_iterator = ConstMapIterator<Key, T, Compare, Allocator>;
+    using iterator = MapIterator<value_type>;
+    using const_iterator = ConstMapIterator<value_type>;
     using reverse_iterator = typename std::reverse_iterator<iterator>;
     using const_reverse_iterator = typename std::reverse_iterator<const_iterator>;
-    using difference_type = typename iterator_traits<iterator>::difference_type;
+    using difference_type = ptrdiff_t;
     using size_type = size_t;
 
     /** Constructors. **/
 
+    map() {}
+
+    explicit map(const Compare& comp, const Allocator& a = Allocator())
+        : tree(a)
+    {
+        tree.compare = comp;
+    }
+
+    explicit map(const Allocator& a)
+        : tree(a) {}
+
+    map(initializer_list<value_type> il, const Allocator& a = Allocator())
+        : tree(a)
+    {
+        for (const auto& v : il)
+        {
+            insert(v);
+        }
+    }
+
+    map(const map& other)
+        : tree(other.tree, other.get_allocator()) {}
+
+    map(const map& other, const Allocator& a)
+        : tree(other.tree, a) {}
+
+    map(map&& other) = default;
+
+    /** Assignment operators. **/
+
+    map& operator=(const map& other) = default;
+    map& operator=(map&& other) = default;
+
+    /** Status. **/
+
+    bool empty() const
+    {
+        return tree.node_count == 0;
+    }
+
+    size_t size() const
+    {
+        return tree.node_count;
+    }
+
+    size_t max_size() const
+    {
+        return SIZE_MAX / sizeof(MapNode<value_type>);
+    }
+
+    /** Iterators. **/
+
+    iterator begin()
+    {
+        return iterator(tree.first());
+    }
+
+    const_iterator begin() const
+    {
+        return const_iterator(tree.first());
+    }
+
+    iterator end()
+    {
+        return iterator(tree.end_node());
+    }
+
+    const_iterator end() const
+    {
+        return const_iterator(tree.end_node());
+    }
+
+    reverse_iterator rbegin()
+    {
+        return reverse_iterator(iterator(tree.last()));
+    }
+
+    const_reverse_iterator rbegin() const
+    {
+        return const_reverse_iterator(const_iterator(tree.last()));
+    }
+
+    reverse_iterator rend()
+    {
+        return reverse_iterator(end());
+    }
+
+    const_reverse_iterator rend() const
+    {
+        return const_reverse_iterator(end());
+    }
+
+    /** Lookup. **/
+
+    iterator find(const Key& key)
+    {
+        return iterator(tree.find(key));
+    }
+
+    const_iterator find(const Key& key) const
+    {
+        return const_iterator(tree.find(key));
+    }
+
+    size_t count(const Key& key) const
+    {
+        return contains(key) ? 1 : 0;
+    }
+
+    bool contains(const Key& key) const
+    {
+        return tree.find(key) != tree.end_node();
+    }
+
+    /// First element whose key is not less than key.
+    iterator lower_bound(const Key& key)
+    {
+        return iterator(tree.lower_bound(key));
+    }
+
+    const_iterator lower_bound(const Key& key) const
+    {
+        return const_iterator(tree.lower_bound(key));
+    }
+
+    /// First element whose key is greater than key.
+    iterator upper_bound(const Key& key)
+    {
+        return iterator(tree.upper_bound(key));
+    }
+
+    const_iterator upper_bound(const Key& key) const
+    {
+        return const_iterator(tree.upper_bound(key));
+    }
+
+    pair<iterator, iterator> equal_range(const Key& key)
+    {
+        return {lower_bound(key), upper_bound(key)};
+    }
+
+    pair<const_iterator, const_iterator> equal_range(const Key& key) const
+    {
+        return {lower_bound(key), upper_bound(key)};
+    }
+
+    /// The element for key, value-initialized first if it was missing.
+    T& operator[](const Key& key)
+    {
+        return try_emplace(key).first->second;
+    }
+
     /** Modifiers. **/
 
-    void insert(const value_type& v)
+    pair<iterator, bool> insert(const value_type& v)
+    {
+        return insert_unique(v.first, v);
+    }
+
+    pair<iterator, bool> insert(value_type&& v)
+    {
+        return insert_unique(v.first, std::move(v));
+    }
+
+    template <class... Args>
+    pair<iterator, bool> emplace(Args&&... args)
+    {
+        auto ret = tree.emplace(forward<Args>(args)...);
+        return {iterator(ret.first), ret.second};
+    }
+
+    /// Inserts T(args...) under key unless key is present, in which case
+    /// nothing is built.
+    template <class... Args>
+    pair<iterator, bool> try_emplace(const Key& key, Args&&... args)
+    {
+        AvlNode* parent;
+        AvlNode** link;
+        AvlNode* found = tree.find_slot(key, parent, link);
+        if (found != nullptr)
+        {
+            return {iterator(found), false};
+        }
+        return {iterator(tree.insert_at(parent, link, key, T(forward<Args>(args)...))), true};
+    }
+
+    /// Inserts the element for key, or assigns it if key is present.
+    template <class M>
+    pair<iterator, bool> insert_or_assign(const Key& key, M&& m)
+    {
+        AvlNode* parent;
+        AvlNode** link;
+        AvlNode* found = tree.find_slot(key, parent, link);
+        if (found != nullptr)
+        {
+            iterator it(found);
+            it->second = forward<M>(m);
+            return {it, false};
+        }
+        return {iterator(tree.insert_at(parent, link, key, forward<M>(m))), true};
+    }
+
+    /// Returns the element after the one erased.
+    iterator erase(iterator pos)
+    {
+        return iterator(tree.erase(pos.node));
+    }
+
+    iterator erase(const_iterator pos)
+    {
+        return iterator(tree.erase(pos.node));
+    }
+
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        AvlNode* n = first.node;
+        while (n != last.node)
+        {
+            n = tree.erase(n);
+        }
+        return iterator(n);
+    }
+
+    size_t erase(const Key& key)
     {
-        tree.insert(v);
+        AvlNode* n = tree.find(key);
+        if (n == tree.end_node())
+        {
+            return 0;
+        }
+        tree.erase(n);
+        return 1;
+    }
+
+    void clear()
+    {
+        tree.clear();
+    }
+
+    void swap(map& other)
+    {
+        tree.swap(other.tree);
+    }
+
+    /** Observers. **/
+
+    key_compare key_comp() const
+    {
+        return tree.compare;
     }
 
-    // TEST.
-    void inorder()
+    Allocator get_allocator() const
     {
-        tree.inorder(tree.root);
+        return Allocator(tree.pool.get_allocator());
     }
 
 private:
 
-    MapTree<value_type, key_compare> tree;
-    Allocator node_alloc;
-    size_t node_count = 0;
+    template <class V>
+    pair<iterator, bool> insert_unique(const Key& key, V&& v)
+    {
+        AvlNode* parent;
+        AvlNode** link;
+        AvlNode* found = tree.find_slot(key, parent, link);
+        if (found != nullptr)
+        {
+            return {iterator(found), false};
+        }
+        return {iterator(tree.insert_at(parent, link, forward<V>(v))), true};
+    }
+
+    MapTree<value_type, key_compare, Allocator> tree;
 };
 
+namespace pmr
+{
+
+template <class Key, class T, class Compare = less<Key>>
+using map = std::map<Key, T, Compare, polymorphic_allocator<pair<const Key, T>>>;
+
+} // namespace pmr
+
 }
@@ -7,9 +7,14 @@
 #pragma once
 
 #include <stddef.h>
+#include <stdlib.h>
 
+#include <new>
 #include <utility>
 
+#include <mm/heap_prof.h>
+#include <mm/slab.h>
+
 namespace std
 {
 
@@ -32,14 +37,123 @@ public:
         using other = allocator<U>;
     };
 
+    allocator() {}
+
+    template <class U>
+    allocator(const allocator<U>&) {}
+
+    /// Returns uninitialized storage for n objects; containers construct
+    /// them in place as they are needed.
     T* allocate(size_t n)
     {
-        return new T[n];
+        if (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+        {
+            return (T*)::operator new(sizeof(T) * n, align_val_t(alignof(T)));
+        }
+        return (T*)::operator new(sizeof(T) * n);
     }
 
+    /// Frees storage from allocate(). Any objects in it must already be
+    /// destroyed.
     void deallocate(T* t, size_t n)
     {
-        delete[] t;
+        if (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+        {
+            ::operator delete(t, sizeof(T) * n, align_val_t(alignof(T)));
+        }
+        else
+        {
+            ::operator delete(t, sizeof(T) * n);
+        }
+    }
+
+    template <class... Args>
+    void construct(T* t, Args&&... args)
+    {
+        void* p = (void*)t;
+        new (p) T(forward<Args>(args)...);
+    }
+
+    void destroy(T* t)
+    {
+        t->~T();
+    }
+};
+
+template <class T, class U>
+bool operator==(const allocator<T>&, const allocator<U>&)
+{
+    return true;
+}
+
+template <class T, class U>
+bool operator!=(const allocator<T>&, const allocator<U>&)
+{
+    return false;
+}
+
+/// Allocator for container nodes. Single nodes come from the slab size
+/// caches; anything larger falls back to the heap.
+template <class T>
+class node_allocator
+{
+public:
+
+    using value_type = T;
+    using pointer = T*;
+    using reference = T&;
+    using const_pointer = const T*;
+    using const_reference = const T&;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+
+    template <class U>
+    struct rebind
+    {
+        using other = node_allocator<U>;
+    };
+
+    node_allocator() {}
+
+    /// Containers build their node allocator from the one they were given.
+    template <class U>
+    node_allocator(const allocator<U>&) {}
+
+    template <class U>
+    node_allocator(const node_allocator<U>&) {}
+
+    T* allocate(size_t n)
+    {
+        Slab_Cache* cache = slab_size_cache(sizeof(T));
+        if (n == 1 && cache != nullptr)
+        {
+            // Slab blocks skip malloc(), so are charged to the profiler
+            // here.
+            void* p = slab_alloc(cache);
+            if (UNLIKELY(heap_prof_enabled))
+            {
+                heap_prof_alloc(p, sizeof(T), __builtin_return_address(0));
+            }
+            return (T*)p;
+        }
+        return (T*)malloc(sizeof(T) * n);
+    }
+
+    void deallocate(T* t, size_t n)
+    {
+        Slab_Cache* cache = slab_size_cache(sizeof(T));
+        if (n == 1 && cache != nullptr)
+        {
+            if (UNLIKELY(heap_prof_enabled))
+            {
+                heap_prof_free(t);
+            }
+            slab_free(cache, t);
+        }
+        else
+        {
+            free(t);
+        }
     }
 
     template <class... Args>
@@ -55,6 +169,20 @@ public:
     }
 };
 
+/// Picks the allocator a container uses for its nodes. The default
+/// allocator is swapped for node_allocator; others are rebound.
+template <class Alloc, class Node>
+struct node_alloc_rebind
+{
+    using type = typename Alloc::template rebind<Node>::other;
+};
+
+template <class T, class Node>
+struct node_alloc_rebind<allocator<T>, Node>
+{
+    using type = node_allocator<Node>;
+};
+
 template <class T>
 class default_delete
 {
@@ -0,0 +1,102 @@
+/**
+ * @file memory_resource.cc
+ * @author Seth McBee
+ * @date 2026-10-19
+ * @brief Global memory resources.
+ */
+
+#include <stddef.h>
+
+#include <stdlib.h>
+
+#include <internal/memory_resource.h>
+
+namespace std
+{
+
+namespace pmr
+{
+
+namespace
+{
+
+class new_delete_memory_resource : public memory_resource
+{
+public:
+
+    constexpr new_delete_memory_resource() {}
+
+protected:
+
+    void* do_allocate(size_t bytes, size_t align) override
+    {
+        return aligned_alloc(align, bytes);
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t align) override
+    {
+        free_aligned_sized(p, align, bytes);
+    }
+
+    bool do_is_equal(const memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+class null_resource : public memory_resource
+{
+public:
+
+    constexpr null_resource() {}
+
+protected:
+
+    void* do_allocate(size_t, size_t) override
+    {
+        return nullptr;
+    }
+
+    void do_deallocate(void*, size_t, size_t) override
+    {
+    }
+
+    bool do_is_equal(const memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+// Constant-initialized, since global constructors are not run.
+new_delete_memory_resource new_delete_instance;
+null_resource null_instance;
+
+memory_resource* default_resource = &new_delete_instance;
+
+} // namespace
+
+memory_resource* new_delete_resource() noexcept
+{
+    return &new_delete_instance;
+}
+
+memory_resource* null_memory_resource() noexcept
+{
+    return &null_instance;
+}
+
+memory_resource* get_default_resource() noexcept
+{
+    return default_resource;
+}
+
+memory_resource* set_default_resource(memory_resource* r) noexcept
+{
+    memory_resource* old = default_resource;
+    default_resource = (r != nullptr) ? r : &new_delete_instance;
+    return old;
+}
+
+} // namespace pmr
+
+} // namespace std
@@ -0,0 +1,289 @@
+/**
+ * @file memory_resource.h
+ * @author Seth McBee
+ * @date 2026-10-19
+ * @brief Polymorphic memory resources and arena allocation.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <new>
+#include <utility>
+
+namespace std
+{
+
+namespace pmr
+{
+
+/// Interface to a source of memory. Containers reach it through
+/// polymorphic_allocator, so the same container type can draw from the
+/// heap or from an arena.
+class memory_resource
+{
+public:
+
+    constexpr memory_resource() {}
+
+    virtual ~memory_resource() {}
+
+    void* allocate(size_t bytes, size_t align = alignof(max_align_t))
+    {
+        return do_allocate(bytes, align);
+    }
+
+    void deallocate(void* p, size_t bytes, size_t align = alignof(max_align_t))
+    {
+        do_deallocate(p, bytes, align);
+    }
+
+    bool is_equal(const memory_resource& other) const noexcept
+    {
+        return do_is_equal(other);
+    }
+
+protected:
+
+    virtual void* do_allocate(size_t bytes, size_t align) = 0;
+    virtual void do_deallocate(void* p, size_t bytes, size_t align) = 0;
+    virtual bool do_is_equal(const memory_resource& other) const noexcept = 0;
+};
+
+inline bool operator==(const memory_resource& a, const memory_resource& b) noexcept
+{
+    return &a == &b || a.is_equal(b);
+}
+
+inline bool operator!=(const memory_resource& a, const memory_resource& b) noexcept
+{
+    return !(a == b);
+}
+
+/// Resource backed by the kernel heap.
+memory_resource* new_delete_resource() noexcept;
+
+/// Resource that fails every allocation. Useful as the upstream of an
+/// arena that must stay within its buffer.
+memory_resource* null_memory_resource() noexcept;
+
+/// Resource used by default-constructed polymorphic allocators.
+memory_resource* get_default_resource() noexcept;
+memory_resource* set_default_resource(memory_resource* r) noexcept;
+
+/// Arena that hands out memory by bumping a pointer. Deallocation does
+/// nothing; everything is given back at once by release(), which with
+/// a caller-supplied buffer is just a pointer reset. When the buffer
+/// runs out, chunks of growing size are taken from the upstream resource.
+class monotonic_buffer_resource : public memory_resource
+{
+public:
+
+    explicit monotonic_buffer_resource(memory_resource* upstream = get_default_resource())
+        : upstream(upstream) {}
+
+    monotonic_buffer_resource(size_t initial_size,
+                              memory_resource* upstream = get_default_resource())
+        : upstream(upstream),
+          initial_size(initial_size < MIN_CHUNK ? MIN_CHUNK : initial_size),
+          next_size(this->initial_size) {}
+
+    monotonic_buffer_resource(void* buffer, size_t buffer_size,
+                              memory_resource* upstream = get_default_resource())
+        : upstream(upstream), buffer((char*)buffer), buffer_size(buffer_size),
+          cur((char*)buffer), end((char*)buffer + buffer_size) {}
+
+    monotonic_buffer_resource(const monotonic_buffer_resource&) = delete;
+    monotonic_buffer_resource& operator=(const monotonic_buffer_resource&) = delete;
+
+    ~monotonic_buffer_resource()
+    {
+        release();
+    }
+
+    /// Frees every allocation at once, returning upstream chunks and
+    /// rewinding to the start of the initial buffer. Chunks taken after
+    /// this start again from the initial size.
+    void release()
+    {
+        while (chunks != nullptr)
+        {
+            Chunk* prev = chunks->prev;
+            upstream->deallocate(chunks, chunks->size, alignof(Chunk));
+            chunks = prev;
+        }
+
+        cur = buffer;
+        end = buffer + buffer_size;
+        next_size = initial_size;
+    }
+
+    memory_resource* upstream_resource() const
+    {
+        return upstream;
+    }
+
+protected:
+
+    void* do_allocate(size_t bytes, size_t align) override
+    {
+        uintptr_t p = ((uintptr_t)cur + align - 1) & ~(uintptr_t)(align - 1);
+        if (cur == nullptr || p > (uintptr_t)end || bytes > (uintptr_t)end - p)
+        {
+            if (!grow(bytes, align))
+            {
+                return nullptr;
+            }
+            p = ((uintptr_t)cur + align - 1) & ~(uintptr_t)(align - 1);
+        }
+
+        cur = (char*)(p + bytes);
+        return (void*)p;
+    }
+
+    void do_deallocate(void*, size_t, size_t) override
+    {
+        // Memory is only reclaimed by release().
+    }
+
+    bool do_is_equal(const memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+
+private:
+
+    /// Header at the start of every upstream chunk.
+    struct Chunk
+    {
+        Chunk* prev;
+        size_t size;
+    };
+
+    static const size_t MIN_CHUNK = 1024;
+
+    bool grow(size_t bytes, size_t align)
+    {
+        // A request too big to describe can't be met; fail it rather
+        // than wrap the sizes around.
+        size_t need;
+        if (__builtin_add_overflow(bytes, sizeof(Chunk) + align, &need))
+        {
+            return false;
+        }
+        size_t size = next_size;
+        while (size < need)
+        {
+            if (size > SIZE_MAX / 2)
+            {
+                return false;
+            }
+            size *= 2;
+        }
+
+        auto chunk = (Chunk*)upstream->allocate(size, alignof(Chunk));
+        if (chunk == nullptr)
+        {
+            return false;
+        }
+
+        chunk->prev = chunks;
+        chunk->size = size;
+        chunks = chunk;
+        cur = (char*)(chunk + 1);
+        end = (char*)chunk + size;
+        next_size = size > SIZE_MAX / 2 ? size : size * 2;
+
+        return true;
+    }
+
+    memory_resource* upstream;
+    char* buffer = nullptr;
+    size_t buffer_size = 0;
+    char* cur = nullptr;
+    char* end = nullptr;
+    Chunk* chunks = nullptr;
+    size_t initial_size = MIN_CHUNK;
+    size_t next_size = MIN_CHUNK;
+};
+
+/// Allocator that forwards to a memory resource. It is rebound for
+/// container nodes, and the resource travels with it.
+template <class T>
+class polymorphic_allocator
+{
+public:
+
+    using value_type = T;
+    using pointer = T*;
+    using reference = T&;
+    using const_pointer = const T*;
+    using const_reference = const T&;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+
+    template <class U>
+    struct rebind
+    {
+        using other = polymorphic_allocator<U>;
+    };
+
+    polymorphic_allocator() noexcept
+        : res(get_default_resource()) {}
+
+    polymorphic_allocator(memory_resource* r) noexcept
+        : res(r) {}
+
+    template <class U>
+    polymorphic_allocator(const polymorphic_allocator<U>& other) noexcept
+        : res(other.resource()) {}
+
+    T* allocate(size_t n)
+    {
+        return (T*)res->allocate(n * sizeof(T), alignof(T));
+    }
+
+    void deallocate(T* t, size_t n)
+    {
+        res->deallocate(t, n * sizeof(T), alignof(T));
+    }
+
+    template <class U, class... Args>
+    void construct(U* u, Args&&... args)
+    {
+        new ((void*)u) U(forward<Args>(args)...);
+    }
+
+    template <class U>
+    void destroy(U* u)
+    {
+        u->~U();
+    }
+
+    memory_resource* resource() const
+    {
+        return res;
+    }
+
+private:
+
+    memory_resource* res;
+};
+
+template <class T, class U>
+bool operator==(const polymorphic_allocator<T>& a, const polymorphic_allocator<U>& b) noexcept
+{
+    return *a.resource() == *b.resource();
+}
+
+template <class T, class U>
+bool operator!=(const polymorphic_allocator<T>& a, const polymorphic_allocator<U>& b) noexcept
+{
+    return !(a == b);
+}
+
+} // namespace pmr
+
+} // namespace std
@@ -8,14 +8,18 @@
 
 #include <stdlib.h>
 
+#include <internal/new.h>
+#include <mm/heap.h>
+
+// Blocks are charged to the code calling new, not to new itself.
 void* operator new(size_t size)
 {
-    return malloc(size);
+    return heap_alloc(size, __builtin_return_address(0));
 }
 
 void* operator new[](size_t size)
 {
-    return malloc(size);
+    return heap_alloc(size, __builtin_return_address(0));
 }
 
 void operator delete(void* p)
@@ -23,9 +27,10 @@ void operator delete(void* p)
     free(p);
 }
 
+// The size lets small blocks go straight to their size class.
 void operator delete(void* p, size_t size)
 {
-    free(p);
+    free_sized(p, size);
 }
 
 void operator delete[](void* p)
@@ -34,6 +39,36 @@ void operator delete[](void* p)
 }
 
 void operator delete[](void* p, size_t n)
+{
+    free_sized(p, n);
+}
+
+void* operator new(size_t size, std::align_val_t align)
+{
+    return heap_aligned_alloc((size_t)align, size, __builtin_return_address(0));
+}
+
+void* operator new[](size_t size, std::align_val_t align)
+{
+    return heap_aligned_alloc((size_t)align, size, __builtin_return_address(0));
+}
+
+void operator delete(void* p, std::align_val_t align) noexcept
 {
     free(p);
 }
+
+void operator delete(void* p, size_t size, std::align_val_t align) noexcept
+{
+    free_aligned_sized(p, (size_t)align, size);
+}
+
+void operator delete[](void* p, std::align_val_t align) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p, size_t size, std::align_val_t align) noexcept
+{
+    free_aligned_sized(p, (size_t)align, size);
+}
@@ -6,6 +6,24 @@
 
 #pragma once
 
+#include <stddef.h>
+
+namespace std
+{
+
+// Alignment requested from the aligned forms of new and delete.
+enum class align_val_t : size_t {};
+
+} // namespace std
+
+// Aligned new and delete, used for over-aligned types.
+void* operator new(size_t size, std::align_val_t align);
+void* operator new[](size_t size, std::align_val_t align);
+void operator delete(void* p, std::align_val_t align) noexcept;
+void operator delete(void* p, size_t size, std::align_val_t align) noexcept;
+void operator delete[](void* p, std::align_val_t align) noexcept;
+void operator delete[](void* p, size_t size, std::align_val_t align) noexcept;
+
 // Placement new.
 
 inline void* operator new(size_t, void* p) throw()
@@ -0,0 +1,444 @@
+/**
+ * @file small_vector.h
+ * @author Seth McBee
+ * @date 2026-10-19
+ * @brief Vector that keeps its first N elements inline.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <initializer_list>
+#include <memory>
+#include <memory_resource>
+#include <type_traits>
+#include <utility>
+#include <stdint.h>
+#include <string.h>
+
+#include <internal/vector.h>
+
+namespace std
+{
+
+/// Vector whose first N elements live inside the object. Past N it moves
+/// to storage from Alloc and grows like vector; until then it never
+/// allocates.
+template <class T, size_t N, class Alloc = allocator<T>>
+class small_vector
+{
+public:
+
+    using value_type = T;
+    using allocator_type = Alloc;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using iterator = pointer;
+    using const_iterator = const_pointer;
+    using size_type = size_t;
+
+    /** Constructors. **/
+
+    small_vector() {}
+
+    explicit small_vector(const Alloc& alloc)
+        : vector_alloc(alloc) {}
+
+    explicit small_vector(size_t n, const Alloc& alloc = Alloc())
+        : vector_alloc(alloc)
+    {
+        resize(n);
+    }
+
+    small_vector(size_t n, const T& t, const Alloc& alloc = Alloc())
+        : vector_alloc(alloc)
+    {
+        resize(n, t);
+    }
+
+    small_vector(const small_vector& other)
+        : vector_alloc(other.vector_alloc)
+    {
+        copy_from(other);
+    }
+
+    small_vector(small_vector&& other)
+        : vector_alloc(other.vector_alloc)
+    {
+        take(other);
+    }
+
+    small_vector(initializer_list<value_type> il, const Alloc& alloc = Alloc())
+        : vector_alloc(alloc)
+    {
+        reserve(il.size());
+        for (const auto& t : il)
+        {
+            emplace_back(t);
+        }
+    }
+
+    /** Destructor. **/
+
+    ~small_vector()
+    {
+        clear();
+        release();
+    }
+
+    /** Assignment operators. **/
+
+    small_vector& operator=(const small_vector& other)
+    {
+        if (this != &other)
+        {
+            clear();
+            copy_from(other);
+        }
+        return *this;
+    }
+
+    small_vector& operator=(small_vector&& other)
+    {
+        if (this == &other)
+        {
+            return *this;
+        }
+
+        clear();
+        release();
+        take(other);
+        return *this;
+    }
+
+    /** Status. **/
+
+    bool empty() const
+    {
+        return count == 0;
+    }
+
+    size_t size() const
+    {
+        return count;
+    }
+
+    size_t max_size() const
+    {
+        return SIZE_MAX / sizeof(T);
+    }
+
+    size_t capacity() const
+    {
+        return max_count;
+    }
+
+    /// Whether the elements are still in the inline storage.
+    bool is_inline() const
+    {
+        return data_ptr == inline_data();
+    }
+
+    /** Mutators. **/
+
+    /// Shrinking destroys the elements past n and keeps the storage. New
+    /// elements are value-initialized.
+    void resize(size_t n)
+    {
+        if (n <= count)
+        {
+            destroy_from(n);
+            return;
+        }
+
+        grow_to(n);
+        for (; count < n; ++count)
+        {
+            vector_alloc.construct(data_ptr + count);
+        }
+    }
+
+    void resize(size_t n, const T& t)
+    {
+        if (n <= count)
+        {
+            destroy_from(n);
+            return;
+        }
+
+        if (n > max_count)
+        {
+            // t may be one of the elements that are about to move.
+            T copy(t);
+            grow_to(n);
+            fill_to(n, copy);
+        }
+        else
+        {
+            fill_to(n, t);
+        }
+    }
+
+    void reserve(size_t n)
+    {
+        if (n <= max_count)
+        {
+            return;
+        }
+
+        T* new_data = vector_alloc.allocate(n);
+        relocate(new_data, data_ptr, count);
+        release();
+        data_ptr = new_data;
+        max_count = n;
+    }
+
+    /// Moves the elements back inline if they fit, or else to storage of
+    /// exactly their size.
+    void shrink_to_fit()
+    {
+        if (is_inline() || count == max_count)
+        {
+            return;
+        }
+
+        T* new_data = count <= N ? inline_data() : vector_alloc.allocate(count);
+        relocate(new_data, data_ptr, count);
+        release();
+        data_ptr = new_data;
+        max_count = count <= N ? N : count;
+    }
+
+    T& front()
+    {
+        return data_ptr[0];
+    }
+
+    const T& front() const
+    {
+        return data_ptr[0];
+    }
+
+    T& back()
+    {
+        return data_ptr[count - 1];
+    }
+
+    const T& back() const
+    {
+        return data_ptr[count - 1];
+    }
+
+    T& operator[](size_t pos)
+    {
+        return data_ptr[pos];
+    }
+
+    const T& operator[](size_t pos) const
+    {
+        return data_ptr[pos];
+    }
+
+    void clear()
+    {
+        destroy_from(0);
+    }
+
+    /// Constructs an element in place at the end.
+    template <class... Args>
+    T& emplace_back(Args&&... args)
+    {
+        if (count < max_count)
+        {
+            vector_alloc.construct(data_ptr + count, forward<Args>(args)...);
+            ++count;
+            return back();
+        }
+
+        // The new element is built before the old ones move, as args may
+        // refer to one of them.
+        size_t n = next_capacity(count + 1);
+        T* new_data = vector_alloc.allocate(n);
+        vector_alloc.construct(new_data + count, forward<Args>(args)...);
+        relocate(new_data, data_ptr, count);
+        release();
+        data_ptr = new_data;
+        max_count = n;
+        ++count;
+        return back();
+    }
+
+    void push_back(const T& t)
+    {
+        emplace_back(t);
+    }
+
+    void push_back(T&& t)
+    {
+        emplace_back(std::move(t));
+    }
+
+    void pop_back()
+    {
+        --count;
+        vector_alloc.destroy(data_ptr + count);
+    }
+
+    T* data()
+    {
+        return data_ptr;
+    }
+
+    const T* data() const
+    {
+        return data_ptr;
+    }
+
+    iterator begin()
+    {
+        return data_ptr;
+    }
+
+    const_iterator begin() const
+    {
+        return data_ptr;
+    }
+
+    iterator end()
+    {
+        return data_ptr + count;
+    }
+
+    const_iterator end() const
+    {
+        return data_ptr + count;
+    }
+
+private:
+
+    T* inline_data() const
+    {
+        return (T*)storage;
+    }
+
+    // Capacity to grow to when at least n elements must fit.
+    size_t next_capacity(size_t n) const
+    {
+        return max(n, (size_t)(max_count * VECTOR_GROWTH_RATE));
+    }
+
+    void grow_to(size_t n)
+    {
+        if (n > max_count)
+        {
+            reserve(next_capacity(n));
+        }
+    }
+
+    void fill_to(size_t n, const T& t)
+    {
+        for (; count < n; ++count)
+        {
+            vector_alloc.construct(data_ptr + count, t);
+        }
+    }
+
+    // Destroys the elements from index n on.
+    void destroy_from(size_t n)
+    {
+        if (!is_trivially_destructible_v<T>)
+        {
+            for (size_t i = n; i < count; ++i)
+            {
+                vector_alloc.destroy(data_ptr + i);
+            }
+        }
+        count = n;
+    }
+
+    // Frees heap storage, which must hold no elements, and goes back to
+    // the inline storage.
+    void release()
+    {
+        if (!is_inline())
+        {
+            vector_alloc.deallocate(data_ptr, max_count);
+        }
+        data_ptr = inline_data();
+        max_count = N;
+    }
+
+    // Moves n elements into uninitialized storage, leaving src to be
+    // freed. Trivially copyable elements are copied as bytes. The kernel
+    // has no exceptions, so a move can't fail halfway and is used even
+    // when it isn't declared noexcept.
+    void relocate(T* dst, T* src, size_t n)
+    {
+        if (is_trivially_copyable_v<T>)
+        {
+            if (n > 0)
+            {
+                memcpy((void*)dst, (const void*)src, sizeof(T) * n);
+            }
+            return;
+        }
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            vector_alloc.construct(dst + i, std::move(src[i]));
+            vector_alloc.destroy(src + i);
+        }
+    }
+
+    // Copies the elements of other into an empty vector.
+    void copy_from(const small_vector& other)
+    {
+        reserve(other.count);
+        for (size_t i = 0; i < other.count; ++i)
+        {
+            vector_alloc.construct(data_ptr + i, other.data_ptr[i]);
+        }
+        count = other.count;
+    }
+
+    // Takes the contents of another vector into an empty one with inline
+    // storage. Heap storage from an equal allocator is adopted; inline
+    // elements, or anything else, are moved one by one.
+    void take(small_vector& other)
+    {
+        if (!other.is_inline() && vector_alloc == other.vector_alloc)
+        {
+            data_ptr = other.data_ptr;
+            count = other.count;
+            max_count = other.max_count;
+            other.data_ptr = other.inline_data();
+            other.count = 0;
+            other.max_count = N;
+            return;
+        }
+
+        reserve(other.count);
+        relocate(data_ptr, other.data_ptr, other.count);
+        count = other.count;
+        other.count = 0;
+        other.release();
+    }
+
+    T* data_ptr = inline_data();
+    size_t count = 0;
+    size_t max_count = N;
+    Alloc vector_alloc;
+    alignas(T) unsigned char storage[sizeof(T) * N];
+};
+
+namespace pmr
+{
+
+template <class T, size_t N>
+using small_vector = std::small_vector<T, N, polymorphic_allocator<T>>;
+
+} // namespace pmr
+
+}
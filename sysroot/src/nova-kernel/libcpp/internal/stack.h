@@ -9,6 +9,7 @@
 #include <globals.h>
 
 #include <deque>
+#include <utility>
 
 namespace std
 {
@@ -29,7 +30,7 @@ public:
     explicit stack(const container_type& c) : data(c) {}
 
     explicit stack(container_type&& c = container_type())
-        : data(c) {}
+        : data(std::move(c)) {}
 
     /** Member functions. **/
 
@@ -58,6 +59,17 @@ public:
         data.push_back(e);
     }
 
+    void push(value_type&& e)
+    {
+        data.push_back(std::move(e));
+    }
+
+    template <class... Args>
+    reference emplace(Args&&... args)
+    {
+        return data.emplace_back(forward<Args>(args)...);
+    }
+
     void pop()
     {
         data.pop_back();
@@ -0,0 +1,303 @@
+/**
+ * @file static_vector.h
+ * @author Seth McBee
+ * @date 2026-10-19
+ * @brief Vector with a fixed capacity held inline, which never allocates.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <initializer_list>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <stdint.h>
+#include <string.h>
+
+#include <kernel.h>
+
+namespace std
+{
+
+/// Vector of at most N elements, stored inside the object. Nothing is
+/// ever allocated, so it can be used before the heap is up or where
+/// allocating isn't allowed. Going past N panics.
+template <class T, size_t N>
+class static_vector
+{
+public:
+
+    using value_type = T;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using iterator = pointer;
+    using const_iterator = const_pointer;
+    using size_type = size_t;
+
+    /** Constructors. **/
+
+    static_vector() {}
+
+    explicit static_vector(size_t n)
+    {
+        resize(n);
+    }
+
+    static_vector(size_t n, const T& t)
+    {
+        resize(n, t);
+    }
+
+    static_vector(const static_vector& other)
+    {
+        copy_from(other);
+    }
+
+    static_vector(static_vector&& other)
+    {
+        move_from(other);
+    }
+
+    static_vector(initializer_list<value_type> il)
+    {
+        for (const auto& t : il)
+        {
+            emplace_back(t);
+        }
+    }
+
+    /** Destructor. **/
+
+    ~static_vector()
+    {
+        clear();
+    }
+
+    /** Assignment operators. **/
+
+    static_vector& operator=(const static_vector& other)
+    {
+        if (this != &other)
+        {
+            clear();
+            copy_from(other);
+        }
+        return *this;
+    }
+
+    static_vector& operator=(static_vector&& other)
+    {
+        if (this != &other)
+        {
+            clear();
+            move_from(other);
+        }
+        return *this;
+    }
+
+    /** Status. **/
+
+    bool empty() const
+    {
+        return count == 0;
+    }
+
+    bool full() const
+    {
+        return count == N;
+    }
+
+    size_t size() const
+    {
+        return count;
+    }
+
+    size_t max_size() const
+    {
+        return N;
+    }
+
+    size_t capacity() const
+    {
+        return N;
+    }
+
+    /** Mutators. **/
+
+    /// New elements are value-initialized.
+    void resize(size_t n)
+    {
+        check(n);
+        destroy_from(min(n, count));
+        for (; count < n; ++count)
+        {
+            new ((void*)(data() + count)) T();
+        }
+    }
+
+    void resize(size_t n, const T& t)
+    {
+        check(n);
+        destroy_from(min(n, count));
+        for (; count < n; ++count)
+        {
+            new ((void*)(data() + count)) T(t);
+        }
+    }
+
+    /// Only checks that n fits, as the storage is all there already.
+    void reserve(size_t n)
+    {
+        check(n);
+    }
+
+    T& front()
+    {
+        return data()[0];
+    }
+
+    const T& front() const
+    {
+        return data()[0];
+    }
+
+    T& back()
+    {
+        return data()[count - 1];
+    }
+
+    const T& back() const
+    {
+        return data()[count - 1];
+    }
+
+    T& operator[](size_t pos)
+    {
+        return data()[pos];
+    }
+
+    const T& operator[](size_t pos) const
+    {
+        return data()[pos];
+    }
+
+    void clear()
+    {
+        destroy_from(0);
+    }
+
+    /// Constructs an element in place at the end.
+    template <class... Args>
+    T& emplace_back(Args&&... args)
+    {
+        check(count + 1);
+        new ((void*)(data() + count)) T(forward<Args>(args)...);
+        ++count;
+        return back();
+    }
+
+    void push_back(const T& t)
+    {
+        emplace_back(t);
+    }
+
+    void push_back(T&& t)
+    {
+        emplace_back(std::move(t));
+    }
+
+    void pop_back()
+    {
+        --count;
+        data()[count].~T();
+    }
+
+    T* data()
+    {
+        return (T*)storage;
+    }
+
+    const T* data() const
+    {
+        return (const T*)storage;
+    }
+
+    iterator begin()
+    {
+        return data();
+    }
+
+    const_iterator begin() const
+    {
+        return data();
+    }
+
+    iterator end()
+    {
+        return data() + count;
+    }
+
+    const_iterator end() const
+    {
+        return data() + count;
+    }
+
+private:
+
+    static void check(size_t n)
+    {
+        if (n > N)
+        {
+            kernel_panic("static_vector capacity exceeded.");
+        }
+    }
+
+    // Destroys the elements from index n on.
+    void destroy_from(size_t n)
+    {
+        if (!is_trivially_destructible_v<T>)
+        {
+            for (size_t i = n; i < count; ++i)
+            {
+                data()[i].~T();
+            }
+        }
+        count = n;
+    }
+
+    // Copies the elements of other into an empty vector.
+    void copy_from(const static_vector& other)
+    {
+        for (size_t i = 0; i < other.count; ++i)
+        {
+            new ((void*)(data() + i)) T(other.data()[i]);
+        }
+        count = other.count;
+    }
+
+    // Moves the elements of other into an empty vector, leaving it empty.
+    void move_from(static_vector& other)
+    {
+        if (is_trivially_copyable_v<T>)
+        {
+            memcpy((void*)storage, (const void*)other.storage, sizeof(T) * other.count);
+        }
+        else
+        {
+            for (size_t i = 0; i < other.count; ++i)
+            {
+                new ((void*)(data() + i)) T(std::move(other.data()[i]));
+            }
+        }
+        count = other.count;
+        other.clear();
+    }
+
+    alignas(T) unsigned char storage[sizeof(T) * N];
+    size_t count = 0;
+};
+
+}
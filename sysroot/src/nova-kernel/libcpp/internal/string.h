@@ -0,0 +1,688 @@
+/**
+ * @file string.h
+ * @author Seth McBee
+ * @date 2026-10-19
+ * @brief Owned, growable string with short strings held inline.
+ */
+
+#pragma once
+
+#include <globals.h>
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <utility>
+#include <string.h>
+
+#include <internal/string_view.h>
+
+namespace std
+{
+
+/// Longest string kept inside the object rather than allocated.
+const size_t STRING_LOCAL_CAPACITY = 15;
+
+/// Owned char string, always followed by a NUL so c_str() is free.
+/// Strings of up to STRING_LOCAL_CAPACITY characters, which covers most
+/// names and commands, live in the object and never allocate; longer ones
+/// grow in storage from Alloc like vector. Moving a long string takes its
+/// storage. Anything that only reads a string should take a string_view,
+/// which every string converts to.
+template <class Alloc = allocator<char>>
+class basic_string
+{
+public:
+
+    using value_type = char;
+    using allocator_type = Alloc;
+    using reference = char&;
+    using const_reference = const char&;
+    using pointer = char*;
+    using const_pointer = const char*;
+    using iterator = char*;
+    using const_iterator = const char*;
+    using size_type = size_t;
+
+    static constexpr size_t npos = string_view::npos;
+
+    /** Constructors. **/
+
+    basic_string()
+    {
+        local[0] = '\0';
+    }
+
+    explicit basic_string(const Alloc& alloc) : string_alloc(alloc)
+    {
+        local[0] = '\0';
+    }
+
+    basic_string(const char* s, const Alloc& alloc = Alloc())
+        : basic_string(string_view(s), alloc) {}
+
+    basic_string(const char* s, size_t n, const Alloc& alloc = Alloc())
+        : basic_string(string_view(s, n), alloc) {}
+
+    explicit basic_string(string_view sv, const Alloc& alloc = Alloc())
+        : string_alloc(alloc)
+    {
+        local[0] = '\0';
+        append(sv);
+    }
+
+    basic_string(size_t n, char c, const Alloc& alloc = Alloc())
+        : string_alloc(alloc)
+    {
+        local[0] = '\0';
+        append(n, c);
+    }
+
+    basic_string(const basic_string& other)
+        : basic_string(other.view(), other.string_alloc) {}
+
+    basic_string(basic_string&& other) noexcept : string_alloc(other.string_alloc)
+    {
+        take(other);
+    }
+
+    /** Destructor. **/
+
+    ~basic_string()
+    {
+        release();
+    }
+
+    /** Assignment operators. **/
+
+    basic_string& operator=(const basic_string& other)
+    {
+        return assign(other.view());
+    }
+
+    basic_string& operator=(basic_string&& other) noexcept
+    {
+        if (this == &other)
+        {
+            return *this;
+        }
+
+        if (!other.is_local() && string_alloc == other.string_alloc)
+        {
+            release();
+            take(other);
+            return *this;
+        }
+
+        // Storage from another allocator can't be adopted.
+        assign(other.view());
+        other.clear();
+        return *this;
+    }
+
+    basic_string& operator=(string_view sv)
+    {
+        return assign(sv);
+    }
+
+    basic_string& operator=(const char* s)
+    {
+        return assign(string_view(s));
+    }
+
+    basic_string& operator=(char c)
+    {
+        return assign(string_view(&c, 1));
+    }
+
+    /// Replaces the contents with sv, which may be part of this string.
+    basic_string& assign(string_view sv)
+    {
+        if (sv.size() > cap)
+        {
+            // sv can't be part of this string, as it wouldn't fit.
+            clear();
+            append(sv);
+            return *this;
+        }
+
+        memmove(str, sv.data(), sv.size());
+        set_length(sv.size());
+        return *this;
+    }
+
+    /** Status. **/
+
+    bool empty() const
+    {
+        return len == 0;
+    }
+
+    size_t size() const
+    {
+        return len;
+    }
+
+    size_t length() const
+    {
+        return len;
+    }
+
+    size_t max_size() const
+    {
+        return SIZE_MAX - 1;
+    }
+
+    size_t capacity() const
+    {
+        return cap;
+    }
+
+    /** Accessors. **/
+
+    char& operator[](size_t pos)
+    {
+        return str[pos];
+    }
+
+    const char& operator[](size_t pos) const
+    {
+        return str[pos];
+    }
+
+    char& front()
+    {
+        return str[0];
+    }
+
+    const char& front() const
+    {
+        return str[0];
+    }
+
+    char& back()
+    {
+        return str[len - 1];
+    }
+
+    const char& back() const
+    {
+        return str[len - 1];
+    }
+
+    char* data()
+    {
+        return str;
+    }
+
+    const char* data() const
+    {
+        return str;
+    }
+
+    /// The characters followed by a NUL.
+    const char* c_str() const
+    {
+        return str;
+    }
+
+    iterator begin()
+    {
+        return str;
+    }
+
+    const_iterator begin() const
+    {
+        return str;
+    }
+
+    iterator end()
+    {
+        return str + len;
+    }
+
+    const_iterator end() const
+    {
+        return str + len;
+    }
+
+    string_view view() const
+    {
+        return string_view(str, len);
+    }
+
+    operator string_view() const
+    {
+        return view();
+    }
+
+    /** Mutators. **/
+
+    void reserve(size_t n)
+    {
+        if (n > cap)
+        {
+            reallocate(n);
+        }
+    }
+
+    /// Moves the string back inline if it fits, or else to storage of
+    /// exactly its size.
+    void shrink_to_fit()
+    {
+        if (!is_local() && len < cap)
+        {
+            reallocate(len);
+        }
+    }
+
+    /// New characters are NULs.
+    void resize(size_t n)
+    {
+        resize(n, '\0');
+    }
+
+    void resize(size_t n, char c)
+    {
+        if (n <= len)
+        {
+            set_length(n);
+        }
+        else
+        {
+            append(n - len, c);
+        }
+    }
+
+    void clear()
+    {
+        set_length(0);
+    }
+
+    void push_back(char c)
+    {
+        if (len == cap)
+        {
+            grow(len + 1);
+        }
+        str[len] = c;
+        set_length(len + 1);
+    }
+
+    void pop_back()
+    {
+        set_length(len - 1);
+    }
+
+    /// Appends sv, which may be part of this string.
+    basic_string& append(string_view sv)
+    {
+        size_t n = len + sv.size();
+        if (n > cap)
+        {
+            // The old storage is kept until sv has been copied out of it.
+            size_t new_cap = next_capacity(n);
+            char* new_str = allocate(new_cap);
+            memcpy(new_str, str, len);
+            memcpy(new_str + len, sv.data(), sv.size());
+            release();
+            str = new_str;
+            cap = new_cap;
+        }
+        else
+        {
+            memmove(str + len, sv.data(), sv.size());
+        }
+        set_length(n);
+        return *this;
+    }
+
+    basic_string& append(const char* s, size_t n)
+    {
+        return append(string_view(s, n));
+    }
+
+    basic_string& append(size_t n, char c)
+    {
+        reserve_for(len + n);
+        memset(str + len, c, n);
+        set_length(len + n);
+        return *this;
+    }
+
+    basic_string& operator+=(string_view sv)
+    {
+        return append(sv);
+    }
+
+    basic_string& operator+=(const char* s)
+    {
+        return append(string_view(s));
+    }
+
+    basic_string& operator+=(char c)
+    {
+        push_back(c);
+        return *this;
+    }
+
+    /// Inserts sv before pos, which must be at most size(). sv may be
+    /// part of this string.
+    basic_string& insert(size_t pos, string_view sv)
+    {
+        if (sv.data() >= str && sv.data() <= str + len)
+        {
+            basic_string copy(sv, string_alloc);
+            return insert(pos, copy.view());
+        }
+
+        reserve_for(len + sv.size());
+        memmove(str + pos + sv.size(), str + pos, len - pos);
+        memcpy(str + pos, sv.data(), sv.size());
+        set_length(len + sv.size());
+        return *this;
+    }
+
+    basic_string& insert(size_t pos, size_t n, char c)
+    {
+        reserve_for(len + n);
+        memmove(str + pos + n, str + pos, len - pos);
+        memset(str + pos, c, n);
+        set_length(len + n);
+        return *this;
+    }
+
+    /// Removes up to n characters from pos, which must be at most size().
+    basic_string& erase(size_t pos = 0, size_t n = npos)
+    {
+        n = min(n, len - pos);
+        memmove(str + pos, str + pos + n, len - pos - n);
+        set_length(len - n);
+        return *this;
+    }
+
+    /// Removes the character at pos and returns the one after it.
+    iterator erase(const_iterator pos)
+    {
+        size_t i = pos - str;
+        erase(i, 1);
+        return str + i;
+    }
+
+    /// A copy of up to n characters from pos. Slicing a string_view
+    /// instead avoids the copy.
+    basic_string substr(size_t pos = 0, size_t n = npos) const
+    {
+        return basic_string(view().substr(pos, n), string_alloc);
+    }
+
+    void swap(basic_string& other) noexcept
+    {
+        basic_string tmp(std::move(other));
+        other = std::move(*this);
+        *this = std::move(tmp);
+    }
+
+    /** Comparison and searching, as for string_view. **/
+
+    int compare(string_view sv) const
+    {
+        return view().compare(sv);
+    }
+
+    bool starts_with(string_view sv) const
+    {
+        return view().starts_with(sv);
+    }
+
+    bool starts_with(char c) const
+    {
+        return view().starts_with(c);
+    }
+
+    bool ends_with(string_view sv) const
+    {
+        return view().ends_with(sv);
+    }
+
+    bool ends_with(char c) const
+    {
+        return view().ends_with(c);
+    }
+
+    bool contains(string_view sv) const
+    {
+        return view().contains(sv);
+    }
+
+    bool contains(char c) const
+    {
+        return view().contains(c);
+    }
+
+    size_t find(string_view sv, size_t pos = 0) const
+    {
+        return view().find(sv, pos);
+    }
+
+    size_t find(char c, size_t pos = 0) const
+    {
+        return view().find(c, pos);
+    }
+
+    size_t rfind(string_view sv, size_t pos = npos) const
+    {
+        return view().rfind(sv, pos);
+    }
+
+    size_t rfind(char c, size_t pos = npos) const
+    {
+        return view().rfind(c, pos);
+    }
+
+    size_t find_first_of(string_view chars, size_t pos = 0) const
+    {
+        return view().find_first_of(chars, pos);
+    }
+
+    size_t find_first_not_of(string_view chars, size_t pos = 0) const
+    {
+        return view().find_first_not_of(chars, pos);
+    }
+
+    size_t find_last_of(string_view chars, size_t pos = npos) const
+    {
+        return view().find_last_of(chars, pos);
+    }
+
+    size_t find_last_not_of(string_view chars, size_t pos = npos) const
+    {
+        return view().find_last_not_of(chars, pos);
+    }
+
+    /** Observers. **/
+
+    allocator_type get_allocator() const
+    {
+        return string_alloc;
+    }
+
+    /// Whether the characters are held in the object itself.
+    bool is_local() const
+    {
+        return str == local;
+    }
+
+private:
+
+    char* allocate(size_t n)
+    {
+        return string_alloc.allocate(n + 1);
+    }
+
+    // Capacity to grow to when at least n characters must fit.
+    size_t next_capacity(size_t n) const
+    {
+        return max(n, 2 * cap);
+    }
+
+    void grow(size_t n)
+    {
+        reallocate(next_capacity(n));
+    }
+
+    void reserve_for(size_t n)
+    {
+        if (n > cap)
+        {
+            grow(n);
+        }
+    }
+
+    // Moves the characters to storage for n, inline if they fit.
+    void reallocate(size_t n)
+    {
+        if (n <= STRING_LOCAL_CAPACITY)
+        {
+            if (!is_local())
+            {
+                char* old = str;
+                size_t old_cap = cap;
+                memcpy(local, old, len + 1);
+                str = local;
+                cap = STRING_LOCAL_CAPACITY;
+                string_alloc.deallocate(old, old_cap + 1);
+            }
+            return;
+        }
+
+        char* new_str = allocate(n);
+        memcpy(new_str, str, len + 1);
+        release();
+        str = new_str;
+        cap = n;
+    }
+
+    void set_length(size_t n)
+    {
+        len = n;
+        str[n] = '\0';
+    }
+
+    // Frees allocated storage and goes back to the inline buffer, whose
+    // contents are left as they are.
+    void release()
+    {
+        if (!is_local())
+        {
+            string_alloc.deallocate(str, cap + 1);
+        }
+        str = local;
+        cap = STRING_LOCAL_CAPACITY;
+    }
+
+    // Takes the contents of other into a string holding nothing
+    // allocated, leaving other empty.
+    void take(basic_string& other)
+    {
+        if (other.is_local())
+        {
+            memcpy(local, other.local, other.len + 1);
+            str = local;
+            cap = STRING_LOCAL_CAPACITY;
+            len = other.len;
+        }
+        else
+        {
+            str = other.str;
+            cap = other.cap;
+            len = other.len;
+            other.str = other.local;
+            other.cap = STRING_LOCAL_CAPACITY;
+        }
+        other.set_length(0);
+    }
+
+    char* str = local;
+    size_t len = 0;
+    size_t cap = STRING_LOCAL_CAPACITY;
+    char local[STRING_LOCAL_CAPACITY + 1];
+    Alloc string_alloc;
+};
+
+using string = basic_string<>;
+
+// Two strings would otherwise convert either side to string_view and be
+// ambiguous.
+template <class Alloc>
+basic_string<Alloc> operator+(const basic_string<Alloc>& a, const basic_string<Alloc>& b)
+{
+    return a + b.view();
+}
+
+template <class Alloc>
+basic_string<Alloc> operator+(basic_string<Alloc>&& a, const basic_string<Alloc>& b)
+{
+    return std::move(a) + b.view();
+}
+
+template <class Alloc>
+basic_string<Alloc> operator+(const basic_string<Alloc>& a, string_view b)
+{
+    basic_string<Alloc> ret(a.get_allocator());
+    ret.reserve(a.size() + b.size());
+    ret.append(a);
+    ret.append(b);
+    return ret;
+}
+
+template <class Alloc>
+basic_string<Alloc> operator+(basic_string<Alloc>&& a, string_view b)
+{
+    a.append(b);
+    return std::move(a);
+}
+
+template <class Alloc>
+basic_string<Alloc> operator+(string_view a, const basic_string<Alloc>& b)
+{
+    basic_string<Alloc> ret(b.get_allocator());
+    ret.reserve(a.size() + b.size());
+    ret.append(a);
+    ret.append(b);
+    return ret;
+}
+
+template <class Alloc>
+basic_string<Alloc> operator+(const basic_string<Alloc>& a, char c)
+{
+    basic_string<Alloc> ret(a);
+    ret.push_back(c);
+    return ret;
+}
+
+template <class Alloc>
+basic_string<Alloc> operator+(basic_string<Alloc>&& a, char c)
+{
+    a.push_back(c);
+    return std::move(a);
+}
+
+template <class Alloc>
+struct hash<basic_string<Alloc>>
+{
+    size_t operator()(const basic_string<Alloc>& s) const
+    {
+        return hash<string_view>()(s.view());
+    }
+};
+
+namespace pmr
+{
+
+using string = std::basic_string<polymorphic_allocator<char>>;
+
+} // namespace pmr
+
+}
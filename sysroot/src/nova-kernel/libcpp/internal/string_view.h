@@ -0,0 +1,340 @@
+/**
+ * @file string_view.h
+ * @author Seth McBee
+ * @date 2026-10-19
+ * @brief Non-owning view of a run of characters.
+ */
+
+#pragma once
+
+#include <globals.h>
+
+#include <hash.h>
+#include <string.h>
+
+#include <internal/functional.h>
+
+namespace std
+{
+
+/// A pointer and a length into characters owned by someone else. Views
+/// are cheap to copy and to slice, and needn't end in a NUL, so they're
+/// passed by value wherever a function only reads a string. Only char
+/// strings are supported.
+class string_view
+{
+public:
+
+    using value_type = char;
+    using pointer = char*;
+    using const_pointer = const char*;
+    using reference = char&;
+    using const_reference = const char&;
+    using iterator = const char*;
+    using const_iterator = const char*;
+    using size_type = size_t;
+
+    /// Returned by the searches when nothing is found, and taken by
+    /// substr() and friends to mean "to the end".
+    static constexpr size_t npos = (size_t)-1;
+
+    /** Constructors. **/
+
+    constexpr string_view() {}
+
+    constexpr string_view(const char* s, size_t n) : str(s), len(n) {}
+
+    /// View of a NUL-terminated string, without the NUL.
+    string_view(const char* s) : str(s), len(strlen(s)) {}
+
+    /** Status. **/
+
+    constexpr bool empty() const
+    {
+        return len == 0;
+    }
+
+    constexpr size_t size() const
+    {
+        return len;
+    }
+
+    constexpr size_t length() const
+    {
+        return len;
+    }
+
+    /** Accessors. **/
+
+    constexpr const char& operator[](size_t pos) const
+    {
+        return str[pos];
+    }
+
+    constexpr const char& front() const
+    {
+        return str[0];
+    }
+
+    constexpr const char& back() const
+    {
+        return str[len - 1];
+    }
+
+    /// The characters, which aren't necessarily followed by a NUL.
+    constexpr const char* data() const
+    {
+        return str;
+    }
+
+    constexpr const_iterator begin() const
+    {
+        return str;
+    }
+
+    constexpr const_iterator end() const
+    {
+        return str + len;
+    }
+
+    /** Slicing. **/
+
+    constexpr void remove_prefix(size_t n)
+    {
+        str += n;
+        len -= n;
+    }
+
+    constexpr void remove_suffix(size_t n)
+    {
+        len -= n;
+    }
+
+    /// Up to n characters from pos. A pos past the end gives an empty
+    /// view rather than an error.
+    constexpr string_view substr(size_t pos, size_t n = npos) const
+    {
+        if (pos > len)
+        {
+            pos = len;
+        }
+        if (n > len - pos)
+        {
+            n = len - pos;
+        }
+        return string_view(str + pos, n);
+    }
+
+    /** Comparison. **/
+
+    /// Negative, zero or positive as this sorts before, with or after sv.
+    int compare(string_view sv) const
+    {
+        size_t n = len < sv.len ? len : sv.len;
+        int ret = n > 0 ? memcmp(str, sv.str, n) : 0;
+        if (ret != 0)
+        {
+            return ret;
+        }
+        return len < sv.len ? -1 : (len > sv.len ? 1 : 0);
+    }
+
+    bool starts_with(string_view sv) const
+    {
+        return len >= sv.len && (sv.len == 0 || memcmp(str, sv.str, sv.len) == 0);
+    }
+
+    bool starts_with(char c) const
+    {
+        return len > 0 && str[0] == c;
+    }
+
+    bool ends_with(string_view sv) const
+    {
+        return len >= sv.len &&
+               (sv.len == 0 || memcmp(str + len - sv.len, sv.str, sv.len) == 0);
+    }
+
+    bool ends_with(char c) const
+    {
+        return len > 0 && str[len - 1] == c;
+    }
+
+    /** Searching. All return an index, or npos. **/
+
+    size_t find(char c, size_t pos = 0) const
+    {
+        if (pos >= len)
+        {
+            return npos;
+        }
+        const char* p = (const char*)memchr(str + pos, c, len - pos);
+        return p != nullptr ? (size_t)(p - str) : npos;
+    }
+
+    size_t find(string_view sv, size_t pos = 0) const
+    {
+        if (sv.len == 0)
+        {
+            return pos <= len ? pos : npos;
+        }
+
+        // Look for the first character, then check the rest there.
+        while (sv.len <= len && pos <= len - sv.len)
+        {
+            pos = find(sv.str[0], pos);
+            if (pos == npos || pos > len - sv.len)
+            {
+                return npos;
+            }
+            if (memcmp(str + pos, sv.str, sv.len) == 0)
+            {
+                return pos;
+            }
+            pos++;
+        }
+        return npos;
+    }
+
+    size_t rfind(char c, size_t pos = npos) const
+    {
+        if (len == 0)
+        {
+            return npos;
+        }
+        for (size_t i = (pos < len - 1 ? pos : len - 1) + 1; i > 0; i--)
+        {
+            if (str[i - 1] == c)
+            {
+                return i - 1;
+            }
+        }
+        return npos;
+    }
+
+    size_t rfind(string_view sv, size_t pos = npos) const
+    {
+        if (sv.len > len)
+        {
+            return npos;
+        }
+        for (size_t i = (pos < len - sv.len ? pos : len - sv.len) + 1; i > 0; i--)
+        {
+            if (sv.len == 0 || memcmp(str + i - 1, sv.str, sv.len) == 0)
+            {
+                return i - 1;
+            }
+        }
+        return npos;
+    }
+
+    /// First character from pos that is one of chars.
+    size_t find_first_of(string_view chars, size_t pos = 0) const
+    {
+        for (; pos < len; pos++)
+        {
+            if (chars.find(str[pos]) != npos)
+            {
+                return pos;
+            }
+        }
+        return npos;
+    }
+
+    /// First character from pos that is none of chars.
+    size_t find_first_not_of(string_view chars, size_t pos = 0) const
+    {
+        for (; pos < len; pos++)
+        {
+            if (chars.find(str[pos]) == npos)
+            {
+                return pos;
+            }
+        }
+        return npos;
+    }
+
+    /// Last character up to pos that is one of chars.
+    size_t find_last_of(string_view chars, size_t pos = npos) const
+    {
+        for (size_t i = (pos < len ? pos + 1 : len); i > 0; i--)
+        {
+            if (chars.find(str[i - 1]) != npos)
+            {
+                return i - 1;
+            }
+        }
+        return npos;
+    }
+
+    /// Last character up to pos that is none of chars.
+    size_t find_last_not_of(string_view chars, size_t pos = npos) const
+    {
+        for (size_t i = (pos < len ? pos + 1 : len); i > 0; i--)
+        {
+            if (chars.find(str[i - 1]) == npos)
+            {
+                return i - 1;
+            }
+        }
+        return npos;
+    }
+
+    bool contains(char c) const
+    {
+        return find(c) != npos;
+    }
+
+    bool contains(string_view sv) const
+    {
+        return find(sv) != npos;
+    }
+
+private:
+
+    const char* str = nullptr;
+    size_t len = 0;
+};
+
+// Free functions, so that strings and C strings on either side convert.
+
+inline bool operator==(string_view a, string_view b)
+{
+    return a.size() == b.size() && (a.empty() || memcmp(a.data(), b.data(), a.size()) == 0);
+}
+
+inline bool operator!=(string_view a, string_view b)
+{
+    return !(a == b);
+}
+
+inline bool operator<(string_view a, string_view b)
+{
+    return a.compare(b) < 0;
+}
+
+inline bool operator<=(string_view a, string_view b)
+{
+    return a.compare(b) <= 0;
+}
+
+inline bool operator>(string_view a, string_view b)
+{
+    return a.compare(b) > 0;
+}
+
+inline bool operator>=(string_view a, string_view b)
+{
+    return a.compare(b) >= 0;
+}
+
+template <>
+struct hash<string_view>
+{
+    size_t operator()(string_view sv) const
+    {
+        return hash_bytes(sv.data(), sv.size(), 0);
+    }
+};
+
+}
@@ -325,4 +325,35 @@ struct decay
 template <class T>
 using decay_t = typename decay<T>::type;
 
+template <class T>
+struct is_trivially_copyable
+    : public integral_constant<bool, __is_trivially_copyable(T)> {};
+
+template <class T>
+constexpr auto is_trivially_copyable_v = is_trivially_copyable<T>::value;
+
+
+template <class T>
+struct is_trivially_destructible
+    : public integral_constant<bool, __has_trivial_destructor(T)> {};
+
+template <class T>
+constexpr auto is_trivially_destructible_v = is_trivially_destructible<T>::value;
+
+
+template <class T>
+struct is_copy_constructible
+    : public integral_constant<bool, __is_constructible(T, const T&)> {};
+
+template <class T>
+constexpr auto is_copy_constructible_v = is_copy_constructible<T>::value;
+
+
+template <class T>
+struct is_nothrow_move_constructible
+    : public integral_constant<bool, __is_nothrow_constructible(T, T&&)> {};
+
+template <class T>
+constexpr auto is_nothrow_move_constructible_v = is_nothrow_move_constructible<T>::value;
+
 } // namespace std
@@ -0,0 +1,275 @@
+/**
+ * @file unordered_map.h
+ * @author Seth McBee
+ * @date 2026-10-19
+ */
+
+#pragma once
+
+#include <globals.h>
+
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <memory_resource>
+#include <utility>
+
+#include <internal/hash_table.h>
+
+namespace std
+{
+
+/// Hash map on an open-addressing table. See hash_table.h for the layout;
+/// unlike the standard container, elements move when the table grows.
+template <class Key, class T, class Hash = hash<Key>, class KeyEqual = equal_to<Key>,
+          class Allocator = allocator<pair<const Key, T>>>
+class unordered_map
+{
+public:
+
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = pair<const Key, T>;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+    using allocator_type = Allocator;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = value_type*;
+    using const_pointer = const value_type*;
+
+private:
+
+    using Table = HashTable<value_type, Key, HashMapKey, Hash, KeyEqual, Allocator>;
+
+public:
+
+    using iterator = typename Table::iterator;
+    using const_iterator = typename Table::const_iterator;
+
+    /** Constructors. **/
+
+    unordered_map() {}
+
+    explicit unordered_map(size_t n, const Hash& h = Hash(),
+                           const KeyEqual& eq = KeyEqual(),
+                           const Allocator& a = Allocator())
+        : table(n, h, eq, a) {}
+
+    explicit unordered_map(const Allocator& a)
+        : table(0, Hash(), KeyEqual(), a) {}
+
+    unordered_map(initializer_list<value_type> il, const Allocator& a = Allocator())
+        : table(il.size(), Hash(), KeyEqual(), a)
+    {
+        for (const auto& v : il)
+        {
+            insert(v);
+        }
+    }
+
+    unordered_map(const unordered_map& other) = default;
+
+    unordered_map(const unordered_map& other, const Allocator& a)
+        : table(other.table, a) {}
+
+    unordered_map(unordered_map&& other) = default;
+
+    /** Assignment operators. **/
+
+    unordered_map& operator=(const unordered_map& other) = default;
+    unordered_map& operator=(unordered_map&& other) = default;
+
+    /** Status. **/
+
+    bool empty() const
+    {
+        return table.size() == 0;
+    }
+
+    size_t size() const
+    {
+        return table.size();
+    }
+
+    size_t max_size() const
+    {
+        return SIZE_MAX / sizeof(value_type);
+    }
+
+    size_t bucket_count() const
+    {
+        return table.capacity();
+    }
+
+    float load_factor() const
+    {
+        return bucket_count() == 0 ? 0.0f : (float)size() / bucket_count();
+    }
+
+    /** Iterators. **/
+
+    iterator begin()
+    {
+        return table.begin();
+    }
+
+    const_iterator begin() const
+    {
+        return table.begin();
+    }
+
+    iterator end()
+    {
+        return table.end();
+    }
+
+    const_iterator end() const
+    {
+        return table.end();
+    }
+
+    /** Lookup. **/
+
+    iterator find(const Key& key)
+    {
+        return table.find(key);
+    }
+
+    const_iterator find(const Key& key) const
+    {
+        return table.find(key);
+    }
+
+    size_t count(const Key& key) const
+    {
+        return find(key) != end();
+    }
+
+    bool contains(const Key& key) const
+    {
+        return find(key) != end();
+    }
+
+    /// The element for key, default-constructed if it wasn't there.
+    T& operator[](const Key& key)
+    {
+        return try_emplace(key).first->second;
+    }
+
+    /** Modifiers. **/
+
+    pair<iterator, bool> insert(const value_type& v)
+    {
+        auto ret = table.find_or_prepare(v.first);
+        if (ret.second)
+        {
+            ret.first = table.construct(ret.first, v);
+        }
+        return ret;
+    }
+
+    pair<iterator, bool> insert(value_type&& v)
+    {
+        auto ret = table.find_or_prepare(v.first);
+        if (ret.second)
+        {
+            ret.first = table.construct(ret.first, std::move(v));
+        }
+        return ret;
+    }
+
+    template <class... Args>
+    pair<iterator, bool> emplace(Args&&... args)
+    {
+        return table.emplace(forward<Args>(args)...);
+    }
+
+    /// Inserts T(args...) under key if key isn't there. Nothing is built
+    /// when it is.
+    template <class... Args>
+    pair<iterator, bool> try_emplace(const Key& key, Args&&... args)
+    {
+        auto ret = table.find_or_prepare(key);
+        if (ret.second)
+        {
+            ret.first = table.construct(ret.first, key, T(forward<Args>(args)...));
+        }
+        return ret;
+    }
+
+    /// Inserts or replaces the element for key.
+    template <class M>
+    pair<iterator, bool> insert_or_assign(const Key& key, M&& m)
+    {
+        auto ret = table.find_or_prepare(key);
+        if (ret.second)
+        {
+            ret.first = table.construct(ret.first, key, forward<M>(m));
+        }
+        else
+        {
+            ret.first->second = forward<M>(m);
+        }
+        return ret;
+    }
+
+    iterator erase(iterator pos)
+    {
+        return table.erase(pos);
+    }
+
+    size_t erase(const Key& key)
+    {
+        return table.erase(key);
+    }
+
+    void clear()
+    {
+        table.clear();
+    }
+
+    void reserve(size_t n)
+    {
+        table.reserve(n);
+    }
+
+    void swap(unordered_map& other)
+    {
+        table.swap(other.table);
+    }
+
+    /** Observers. **/
+
+    Hash hash_function() const
+    {
+        return table.hash_function();
+    }
+
+    KeyEqual key_eq() const
+    {
+        return table.key_eq();
+    }
+
+    Allocator get_allocator() const
+    {
+        return table.get_allocator();
+    }
+
+private:
+
+    Table table;
+};
+
+namespace pmr
+{
+
+template <class Key, class T, class Hash = hash<Key>, class KeyEqual = equal_to<Key>>
+using unordered_map = std::unordered_map<Key, T, Hash, KeyEqual,
+                                         polymorphic_allocator<pair<const Key, T>>>;
+
+} // namespace pmr
+
+}
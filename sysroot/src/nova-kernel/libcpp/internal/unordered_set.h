@@ -0,0 +1,225 @@
+/**
+ * @file unordered_set.h
+ * @author Seth McBee
+ * @date 2026-10-19
+ */
+
+#pragma once
+
+#include <globals.h>
+
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <memory_resource>
+#include <utility>
+
+#include <internal/hash_table.h>
+
+namespace std
+{
+
+/// Hash set on an open-addressing table. See hash_table.h for the layout;
+/// unlike the standard container, elements move when the table grows.
+template <class Key, class Hash = hash<Key>, class KeyEqual = equal_to<Key>,
+          class Allocator = allocator<Key>>
+class unordered_set
+{
+public:
+
+    using key_type = Key;
+    using value_type = Key;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+    using allocator_type = Allocator;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = value_type*;
+    using const_pointer = const value_type*;
+
+private:
+
+    using Table = HashTable<Key, Key, HashSetKey, Hash, KeyEqual, Allocator>;
+
+public:
+
+    // Elements are keys, so they can't be changed in place.
+    using iterator = typename Table::const_iterator;
+    using const_iterator = typename Table::const_iterator;
+
+    /** Constructors. **/
+
+    unordered_set() {}
+
+    explicit unordered_set(size_t n, const Hash& h = Hash(),
+                           const KeyEqual& eq = KeyEqual(),
+                           const Allocator& a = Allocator())
+        : table(n, h, eq, a) {}
+
+    explicit unordered_set(const Allocator& a)
+        : table(0, Hash(), KeyEqual(), a) {}
+
+    unordered_set(initializer_list<value_type> il, const Allocator& a = Allocator())
+        : table(il.size(), Hash(), KeyEqual(), a)
+    {
+        for (const auto& v : il)
+        {
+            insert(v);
+        }
+    }
+
+    unordered_set(const unordered_set& other) = default;
+
+    unordered_set(const unordered_set& other, const Allocator& a)
+        : table(other.table, a) {}
+
+    unordered_set(unordered_set&& other) = default;
+
+    /** Assignment operators. **/
+
+    unordered_set& operator=(const unordered_set& other) = default;
+    unordered_set& operator=(unordered_set&& other) = default;
+
+    /** Status. **/
+
+    bool empty() const
+    {
+        return table.size() == 0;
+    }
+
+    size_t size() const
+    {
+        return table.size();
+    }
+
+    size_t max_size() const
+    {
+        return SIZE_MAX / sizeof(value_type);
+    }
+
+    size_t bucket_count() const
+    {
+        return table.capacity();
+    }
+
+    float load_factor() const
+    {
+        return bucket_count() == 0 ? 0.0f : (float)size() / bucket_count();
+    }
+
+    /** Iterators. **/
+
+    iterator begin() const
+    {
+        return table.begin();
+    }
+
+    iterator end() const
+    {
+        return table.end();
+    }
+
+    /** Lookup. **/
+
+    iterator find(const Key& key) const
+    {
+        return table.find(key);
+    }
+
+    size_t count(const Key& key) const
+    {
+        return find(key) != end();
+    }
+
+    bool contains(const Key& key) const
+    {
+        return find(key) != end();
+    }
+
+    /** Modifiers. **/
+
+    pair<iterator, bool> insert(const value_type& v)
+    {
+        auto ret = table.find_or_prepare(v);
+        if (ret.second)
+        {
+            ret.first = table.construct(ret.first, v);
+        }
+        return {ret.first, ret.second};
+    }
+
+    pair<iterator, bool> insert(value_type&& v)
+    {
+        auto ret = table.find_or_prepare(v);
+        if (ret.second)
+        {
+            ret.first = table.construct(ret.first, std::move(v));
+        }
+        return {ret.first, ret.second};
+    }
+
+    template <class... Args>
+    pair<iterator, bool> emplace(Args&&... args)
+    {
+        auto ret = table.emplace(forward<Args>(args)...);
+        return {ret.first, ret.second};
+    }
+
+    iterator erase(iterator pos)
+    {
+        return table.erase(typename Table::iterator(pos.ctrl, pos.slot));
+    }
+
+    size_t erase(const Key& key)
+    {
+        return table.erase(key);
+    }
+
+    void clear()
+    {
+        table.clear();
+    }
+
+    void reserve(size_t n)
+    {
+        table.reserve(n);
+    }
+
+    void swap(unordered_set& other)
+    {
+        table.swap(other.table);
+    }
+
+    /** Observers. **/
+
+    Hash hash_function() const
+    {
+        return table.hash_function();
+    }
+
+    KeyEqual key_eq() const
+    {
+        return table.key_eq();
+    }
+
+    Allocator get_allocator() const
+    {
+        return table.get_allocator();
+    }
+
+private:
+
+    Table table;
+};
+
+namespace pmr
+{
+
+template <class Key, class Hash = hash<Key>, class KeyEqual = equal_to<Key>>
+using unordered_set = std::unordered_set<Key, Hash, KeyEqual, polymorphic_allocator<Key>>;
+
+} // namespace pmr
+
+}
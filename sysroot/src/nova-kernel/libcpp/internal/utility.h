@@ -29,6 +29,20 @@ remove_reference_t<T>&& move(T&& t) noexcept
 }
 
 
+// Moves unless the move could throw and a copy is possible, so that a
+// failed relocation leaves the source intact.
+template <class T>
+conditional_t
+<
+    !is_nothrow_move_constructible_v<T> && is_copy_constructible_v<T>,
+    const T&,
+    T&&
+> move_if_noexcept(T& t) noexcept
+{
+    return move(t);
+}
+
+
 template <class T>
 constexpr T&& forward(remove_reference_t<T>& t) noexcept
 {
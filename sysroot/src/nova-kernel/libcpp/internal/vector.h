@@ -9,8 +9,11 @@
 #include <algorithm>
 #include <initializer_list>
 #include <memory>
+#include <memory_resource>
+#include <type_traits>
 #include <utility>
 #include <stdint.h>
+#include <string.h>
 
 #include <kernel.h>
 
@@ -41,44 +44,27 @@ public:
         : vector_alloc(alloc) {}
         
     explicit vector(size_t n, const Alloc& alloc = Alloc())
-        : vector_alloc(alloc), count(n), max_count(n)
+        : vector_alloc(alloc)
     {
-        data = vector_alloc.allocate(n);
+        resize(n);
     }
     
     vector(size_t n, const T& t, const Alloc& alloc = Alloc())
-        : vector_alloc(alloc), count(n), max_count(n)
+        : vector_alloc(alloc)
     {
-        data = vector_alloc.allocate(n);
-        for (size_t i = 0; i < n; ++i)
-        {
-            data[i] = t;
-        }
+        resize(n, t);
     }
     
     vector(const vector& other)
+        : vector_alloc(other.vector_alloc)
     {
-        count = other.count;
-        max_count = other.max_count;
-        vector_alloc = other.vector_alloc;
-        data = vector_alloc.allocate(max_count);
-        for (size_t i = 0; i < count; ++i)
-        {
-            data[i] = other.data[i];
-        }
+        copy_from(other);
     }
     
     vector(const vector& other, const Alloc& alloc)
         : vector_alloc(alloc)
     {
-        count = other.count;
-        max_count = other.max_count;
-        vector_alloc = alloc;
-        data = vector_alloc.allocate(max_count);
-        for (size_t i = 0; i < count; ++i)
-        {
-            data[i] = other.data[i];
-        }
+        copy_from(other);
     }
     
     vector(vector&& other)
@@ -95,20 +81,16 @@ public:
     vector(vector&& other, const Alloc& alloc)
         : vector_alloc(alloc)
     {
-        count = other.count;
-        max_count = other.max_count;
-        other.count = 0;
-        other.max_count = 0;
-        data = other.data;
-        other.data = nullptr;
+        take(other);
     }
     
     vector(initializer_list<value_type> il, const Alloc& alloc = Alloc())
         : vector_alloc(alloc)
     {
+        reserve(il.size());
         for (const auto& n : il)
         {
-            push_back(n);
+            emplace_back(n);
         }
     }
     
@@ -116,39 +98,40 @@ public:
     
     ~vector()
     {
-        vector_alloc.deallocate(data, max_count);
+        clear();
+        release();
     }
     
     /** Assignment operators. **/
     
     vector& operator=(const vector& other)
     {
-        vector_alloc.deallocate(data, max_count);
-        count = other.count;
-        max_count = other.max_count;
-        vector_alloc = other.vector_alloc;
-        data = vector_alloc.allocate(max_count);
-        for (size_t i = 0; i < count; ++i)
+        if (this == &other)
         {
-            data[i] = other.data[i];
+            return *this;
         }
+
+        // The allocator stays with the container, so that a vector built
+        // on an arena keeps drawing from it. Enough storage is reused.
+        clear();
+        if (other.count > max_count)
+        {
+            release();
+        }
+        copy_from(other);
         return *this;
     }
     
     vector& operator=(vector&& other)
     {
-        vector_alloc.deallocate(data, max_count);
-        count = other.count;
-        max_count = other.max_count;
-        other.count = 0;
-        other.max_count = 0;
-        vector_alloc = std::move(other.vector_alloc);
-        data = vector_alloc.allocate(count);
-        for (size_t i = 0; i < count; ++i)
+        if (this == &other)
         {
-            data[i] = std::move(other.data[i]);
+            return *this;
         }
-        other.data = 0;
+
+        clear();
+        release();
+        take(other);
         return *this;
     }
     
@@ -176,38 +159,42 @@ public:
     
     /** Mutators. **/
     
+    /// Shrinking destroys the elements past n and keeps the storage. New
+    /// elements are value-initialized.
     void resize(size_t n)
     {
-        // This could be optimized to only reallocate if the size
-        // is greater than the current capacity.
-        T* new_data = vector_alloc.allocate(n);
-        size_t upper = min(n, max_count);
-        for (size_t i = 0; i < upper; ++i)
+        if (n <= count)
         {
-            new_data[i] = data[i];
+            destroy_from(n);
+            return;
+        }
+
+        grow_to(n);
+        for (; count < n; ++count)
+        {
+            vector_alloc.construct(data + count);
         }
-        vector_alloc.deallocate(data, max_count);
-        data = new_data;
-        count = n;
-        max_count = n;
     }
     
     void resize(size_t n, const T& t)
     {
-        T* new_data = vector_alloc.allocate(n);
-        size_t upper = min(n, max_count);
-        for (size_t i = 0; i < n; ++i)
+        if (n <= count)
         {
-            new_data[i] = data[i];
+            destroy_from(n);
+            return;
         }
-        for (size_t i = upper; i < n; ++i)
+
+        if (n > max_count)
         {
-            new_data[i] = t;
+            // t may be one of the elements that are about to move.
+            T copy(t);
+            grow_to(n);
+            fill_to(n, copy);
+        }
+        else
+        {
+            fill_to(n, t);
         }
-        vector_alloc.deallocate(data, max_count);
-        data = new_data;
-        count = n;
-        max_count = n;
     }
     
     void reserve(size_t n)
@@ -218,11 +205,8 @@ public:
         }
         
         T* new_data = vector_alloc.allocate(n);
-        for (size_t i = 0; i < count; ++i)
-        {
-            new_data[i] = data[i];
-        }
-        vector_alloc.deallocate(data, max_count);
+        relocate(new_data, data, count);
+        release();
         data = new_data;
         max_count = n;
     }
@@ -259,27 +243,47 @@ public:
     
     void clear() noexcept
     {
-        for (size_t i = 0; i < count; ++i)
-        {
-            data[i].~T();
-        }
-        count = 0;
+        destroy_from(0);
     }
     
-    void push_back(const T& t)
+    /// Constructs an element in place at the end.
+    template <class... Args>
+    T& emplace_back(Args&&... args)
     {
-        if (count == 0 || count == (max_count - 1))
+        if (count < max_count)
         {
-            reserve(max(2.0f, max_count * VECTOR_GROWTH_RATE));
+            vector_alloc.construct(data + count, forward<Args>(args)...);
+            ++count;
+            return back();
         }
-        
-        data[count] = t;
+
+        // The new element is built before the old ones move, as args may
+        // refer to one of them.
+        size_t n = next_capacity(count + 1);
+        T* new_data = vector_alloc.allocate(n);
+        vector_alloc.construct(new_data + count, forward<Args>(args)...);
+        relocate(new_data, data, count);
+        release();
+        data = new_data;
+        max_count = n;
         ++count;
+        return back();
+    }
+    
+    void push_back(const T& t)
+    {
+        emplace_back(t);
+    }
+    
+    void push_back(T&& t)
+    {
+        emplace_back(std::move(t));
     }
     
     void pop_back()
     {
         --count;
+        vector_alloc.destroy(data + count);
     }
     
     iterator begin() noexcept
@@ -304,11 +308,121 @@ public:
     
 private:
 
+    // Capacity to grow to when at least n elements must fit.
+    size_t next_capacity(size_t n) const
+    {
+        return max(n, max((size_t)2, (size_t)(max_count * VECTOR_GROWTH_RATE)));
+    }
+
+    void grow_to(size_t n)
+    {
+        if (n > max_count)
+        {
+            reserve(next_capacity(n));
+        }
+    }
+
+    void fill_to(size_t n, const T& t)
+    {
+        for (; count < n; ++count)
+        {
+            vector_alloc.construct(data + count, t);
+        }
+    }
+
+    // Destroys the elements from index n on.
+    void destroy_from(size_t n)
+    {
+        if (!is_trivially_destructible_v<T>)
+        {
+            for (size_t i = n; i < count; ++i)
+            {
+                vector_alloc.destroy(data + i);
+            }
+        }
+        count = n;
+    }
+
+    // Frees the storage, which must hold no elements.
+    void release()
+    {
+        if (data != nullptr)
+        {
+            vector_alloc.deallocate(data, max_count);
+        }
+        data = nullptr;
+        max_count = 0;
+    }
+
+    // Moves n elements into uninitialized storage, leaving src to be
+    // freed. Trivially copyable elements are copied as bytes. The kernel
+    // has no exceptions, so a move can't fail halfway and is used even
+    // when it isn't declared noexcept.
+    void relocate(T* dst, T* src, size_t n)
+    {
+        if (is_trivially_copyable_v<T>)
+        {
+            if (n > 0)
+            {
+                memcpy((void*)dst, (const void*)src, sizeof(T) * n);
+            }
+            return;
+        }
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            vector_alloc.construct(dst + i, std::move(src[i]));
+            vector_alloc.destroy(src + i);
+        }
+    }
+
+    // Copies the elements of other into an empty vector.
+    void copy_from(const vector& other)
+    {
+        reserve(other.count);
+        for (size_t i = 0; i < other.count; ++i)
+        {
+            vector_alloc.construct(data + i, other.data[i]);
+        }
+        count = other.count;
+    }
+
+    // Takes the contents of another vector. Storage from an equal
+    // allocator is adopted; anything else is moved element by element.
+    void take(vector& other)
+    {
+        if (vector_alloc == other.vector_alloc)
+        {
+            count = other.count;
+            max_count = other.max_count;
+            data = other.data;
+            other.data = nullptr;
+            other.count = 0;
+            other.max_count = 0;
+            return;
+        }
+
+        reserve(other.count);
+        for (size_t i = 0; i < other.count; ++i)
+        {
+            vector_alloc.construct(data + i, std::move(other.data[i]));
+        }
+        count = other.count;
+        other.clear();
+    }
+
     T* data = nullptr;
     size_t count = 0;
     size_t max_count = 0;
     Alloc vector_alloc;
 };
 
-}
+namespace pmr
+{
 
+template <class T>
+using vector = std::vector<T, polymorphic_allocator<T>>;
+
+} // namespace pmr
+
+}
@@ -0,0 +1,283 @@
+/**
+ * @file heap.cc
+ * @author Seth McBee
+ * @date 2026-10-19
+ * @brief Kernel heap front-end.
+ *
+ * Blocks of up to SLAB_SIZE_MAX bytes are served by the generic slab
+ * caches, whose fast paths are per-CPU and lock-free. Only larger blocks
+ * go through liballoc and its global lock. A block's origin is known
+ * from its address alone, since all slab memory lies in one window.
+ *
+ * The public entry points charge each block to their caller when the
+ * heap profiler is on; internally the heap uses the untraced versions.
+ */
+
+#include <globals.h>
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <liballoc/liballoc.h>
+#include <mm/heap.h>
+#include <mm/heap_prof.h>
+#include <mm/slab.h>
+
+#ifdef ARCH_X86_64
+#include <arch/x86_64/memory/paging.h>
+#endif // ARCH_X86_64
+
+#ifdef ARCH_X86
+#include <arch/x86/memory/paging.h>
+#endif // ARCH_X86
+
+static inline void* heap_malloc(size_t size)
+{
+    if (LIKELY(size <= SLAB_SIZE_MAX))
+    {
+        void* p = slab_alloc(slab_size_cache(size));
+        if (LIKELY(p != NULL))
+        {
+            return (p);
+        }
+    }
+
+    return (l_malloc(size));
+}
+
+static inline void heap_free(void* p)
+{
+    if (p == NULL)
+    {
+        return;
+    }
+
+    if (LIKELY(slab_owns(p)))
+    {
+        slab_free(slab_cache_of(p), p);
+        return;
+    }
+
+    l_free(p);
+}
+
+extern "C" void* heap_alloc(size_t size, const void* caller)
+{
+    void* p = heap_malloc(size);
+    if (UNLIKELY(heap_prof_enabled))
+    {
+        heap_prof_alloc(p, size, caller);
+    }
+    return (p);
+}
+
+extern "C" void* malloc(size_t size)
+{
+    return (heap_alloc(size, __builtin_return_address(0)));
+}
+
+extern "C" void free(void* p)
+{
+    if (UNLIKELY(heap_prof_enabled))
+    {
+        heap_prof_free(p);
+    }
+    heap_free(p);
+}
+
+// Size class that serves an aligned request, or 0 if the slabs can't.
+static inline size_t heap_aligned_size(size_t align, size_t size)
+{
+    if (align > SLAB_NATURAL_ALIGN)
+    {
+        return (0);
+    }
+
+    // A size that is a multiple of the alignment lands in a class that is
+    // too, and such classes are naturally aligned.
+    size = (size + align - 1) & ~(align - 1);
+    if (size == 0 || size > SLAB_SIZE_MAX)
+    {
+        return (0);
+    }
+
+    return (size);
+}
+
+static inline void* heap_memalign(size_t align, size_t size)
+{
+    if (align == 0 || (align & (align - 1)) != 0)
+    {
+        return (NULL);
+    }
+
+    size_t slab_size = heap_aligned_size(align, size);
+    if (LIKELY(slab_size != 0))
+    {
+        void* p = slab_alloc(slab_size_cache(slab_size));
+        if (LIKELY(p != NULL))
+        {
+            return (p);
+        }
+    }
+
+    return (l_memalign(align, size));
+}
+
+extern "C" void* heap_aligned_alloc(size_t align, size_t size, const void* caller)
+{
+    void* p = heap_memalign(align, size);
+    if (UNLIKELY(heap_prof_enabled))
+    {
+        heap_prof_alloc(p, size, caller);
+    }
+    return (p);
+}
+
+extern "C" void* aligned_alloc(size_t align, size_t size)
+{
+    return (heap_aligned_alloc(align, size, __builtin_return_address(0)));
+}
+
+extern "C" int posix_memalign(void** p, size_t align, size_t size)
+{
+    if (align < sizeof(void*) || (align & (align - 1)) != 0)
+    {
+        return (EINVAL);
+    }
+
+    void* q = heap_aligned_alloc(align, size, __builtin_return_address(0));
+    if (q == NULL)
+    {
+        return (ENOMEM);
+    }
+
+    *p = q;
+    return (0);
+}
+
+extern "C" void free_sized(void* p, size_t size)
+{
+    if (UNLIKELY(heap_prof_enabled))
+    {
+        heap_prof_free(p);
+    }
+
+    if (LIKELY(size <= SLAB_SIZE_MAX && slab_owns(p)))
+    {
+        slab_free(slab_size_cache(size), p);
+        return;
+    }
+
+    heap_free(p);
+}
+
+extern "C" void free_aligned_sized(void* p, size_t align, size_t size)
+{
+    if (UNLIKELY(heap_prof_enabled))
+    {
+        heap_prof_free(p);
+    }
+
+    size_t slab_size = heap_aligned_size(align, size);
+    if (LIKELY(slab_size != 0 && slab_owns(p)))
+    {
+        slab_free(slab_size_cache(slab_size), p);
+        return;
+    }
+
+    heap_free(p);
+}
+
+extern "C" void* calloc(size_t nobj, size_t size)
+{
+    size_t total;
+    if (__builtin_mul_overflow(nobj, size, &total))
+    {
+        return (NULL);
+    }
+
+    void* p = heap_alloc(total, __builtin_return_address(0));
+    if (p != NULL)
+    {
+        memset(p, 0, total);
+    }
+
+    return (p);
+}
+
+static void* heap_realloc(void* p, size_t size)
+{
+    if (p == NULL)
+    {
+        return (heap_malloc(size));
+    }
+
+    if (size == 0)
+    {
+        heap_free(p);
+        return (NULL);
+    }
+
+    if (!slab_owns(p))
+    {
+        return (l_realloc(p, size));
+    }
+
+    // Slab blocks stay put while the new size fits their size class.
+    size_t old_size = slab_cache_of(p)->size;
+    if (size <= old_size)
+    {
+        return (p);
+    }
+
+    void* q = heap_malloc(size);
+    if (q != NULL)
+    {
+        memcpy(q, p, old_size);
+        heap_free(p);
+    }
+
+    return (q);
+}
+
+extern "C" void* realloc(void* p, size_t size)
+{
+    if (LIKELY(!heap_prof_enabled))
+    {
+        return (heap_realloc(p, size));
+    }
+
+    // The block is charged to this caller again under its new size.
+    void* q = heap_realloc(p, size);
+    if (q != NULL || size == 0)
+    {
+        heap_prof_free(p);
+    }
+    heap_prof_alloc(q, size, __builtin_return_address(0));
+
+    return (q);
+}
+
+extern "C" void heap_info(void)
+{
+    Slab_Page_Stats slab;
+    slab_page_stats(&slab);
+
+    liballoc_stats large;
+    l_stats(&large);
+
+    printf("slab: %ld KiB held, %ld KiB cached empty, %ld KiB returned\n",
+           slab.pages * PAGE_SIZE / 1024,
+           slab.empty * PAGE_SIZE / 1024,
+           slab.returned * PAGE_SIZE / 1024);
+    printf("large: %ld KiB held, %ld KiB cached free, %ld KiB returned\n",
+           large.allocated / 1024,
+           large.cached / 1024,
+           large.returned / 1024);
+    printf("large cache watermarks: %ld KiB high, %ld KiB low\n",
+           large.high / 1024,
+           large.low / 1024);
+}
@@ -0,0 +1,43 @@
+/**
+ * @file heap.h
+ * @author Seth McBee
+ * @date 2026-10-19
+ * @brief Kernel heap front-end. The allocation functions themselves are
+ * declared in stdlib.h.
+ */
+
+#pragma once
+
+#include <globals.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Prints how much memory the heap holds, how much of it is cached
+ * free for reuse, and how much has been returned to the VMM.
+ */
+void heap_info(void);
+
+/**
+ * @brief malloc() that charges the block to a given caller in the heap
+ * profiler. Used by wrappers such as operator new.
+ *
+ * @param size Size of the block.
+ * @param caller Return address to charge the block to.
+ */
+void* heap_alloc(size_t size, const void* caller);
+
+/**
+ * @brief aligned_alloc() that charges the block to a given caller.
+ *
+ * @param align Alignment, a power of two.
+ * @param size Size of the block.
+ * @param caller Return address to charge the block to.
+ */
+void* heap_aligned_alloc(size_t align, size_t size, const void* caller);
+
+#ifdef __cplusplus
+}
+#endif
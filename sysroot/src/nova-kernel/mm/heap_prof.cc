@@ -0,0 +1,432 @@
+/**
+ * @file heap_prof.cc
+ * @author Seth McBee
+ * @date 2026-10-19
+ * @brief Heap profiler.
+ *
+ * Live blocks are kept in an open-addressed table keyed by address, with
+ * linear probing and backward-shift deletion so that no tombstones build
+ * up. Each entry packs the block's address and call-site index into one
+ * word, next to the size and the tick it was allocated on. Call sites
+ * are interned in a second table and never removed while profiling.
+ * Both tables live in pages taken straight from the VMM, so recording
+ * never re-enters the heap.
+ */
+
+#include <globals.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <mm/heap_prof.h>
+
+#ifdef ARCH_X86_64
+#include <arch/x86_64/cpu.h>
+#include <arch/x86_64/devices/pit.h>
+#include <arch/x86_64/memory/paging.h>
+#include <arch/x86_64/memory/vmm.h>
+#endif // ARCH_X86_64
+
+#ifdef ARCH_X86
+#include <arch/x86/cpu.h>
+#include <arch/x86/memory/paging.h>
+#include <arch/x86/memory/vmm.h>
+#endif // ARCH_X86
+
+// A live block. The address takes the low 48 bits of the key and the
+// call-site index the top 16; a zero key marks an empty slot.
+struct Heap_Prof_Block
+{
+    uint64_t key;
+    uint32_t size;
+    uint32_t tick;
+};
+
+struct Heap_Prof_Site
+{
+    const void* caller;
+    uint64_t live_bytes;
+    uint64_t live_blocks;
+    uint64_t allocs;
+    uint64_t bytes;
+};
+
+static_assert(sizeof(Heap_Prof_Block) == 16, "Heap_Prof_Block should pack into 16 bytes.");
+static_assert((HEAP_PROF_BLOCKS & (HEAP_PROF_BLOCKS - 1)) == 0, "HEAP_PROF_BLOCKS must be a power of two.");
+static_assert((HEAP_PROF_SITES & (HEAP_PROF_SITES - 1)) == 0, "HEAP_PROF_SITES must be a power of two.");
+static_assert(HEAP_PROF_SITES <= 65536, "Site indices must fit in 16 bits.");
+
+static const uint64_t HEAP_PROF_ADDR_MASK = (1UL << 48) - 1;
+
+// Site that absorbs call sites once the site table is full.
+static const size_t HEAP_PROF_OVERFLOW = 0;
+
+bool heap_prof_enabled;
+
+static Heap_Prof_Block* heap_prof_blocks;
+static Heap_Prof_Site* heap_prof_sites;
+static size_t heap_prof_pages;
+static size_t heap_prof_live;
+static size_t heap_prof_site_count;
+static uint64_t heap_prof_dropped;
+static uint64_t heap_prof_start_tick;
+static volatile uint32_t heap_prof_lock;
+
+static uint64_t heap_prof_irq_lock(void)
+{
+    uint64_t flags = cpu_irq_save();
+    while (__sync_lock_test_and_set(&heap_prof_lock, 1))
+    {
+        while (heap_prof_lock)
+        {
+            cpu_relax();
+        }
+    }
+    return (flags);
+}
+
+static void heap_prof_irq_unlock(uint64_t flags)
+{
+    __sync_lock_release(&heap_prof_lock);
+    cpu_irq_restore(flags);
+}
+
+static inline size_t heap_prof_hash(uint64_t x)
+{
+    // Fibonacci hashing; block addresses are at least 8-byte aligned.
+    return ((size_t)((x >> 3) * 0x9E3779B97F4A7C15UL >> 32));
+}
+
+static inline uint64_t heap_prof_addr(const void* p)
+{
+    return ((uint64_t)(uintptr_t)p & HEAP_PROF_ADDR_MASK);
+}
+
+// Index of a call site, interning it if it is new. Must hold the lock.
+static size_t heap_prof_site(const void* caller)
+{
+    size_t mask = HEAP_PROF_SITES - 1;
+    size_t i = heap_prof_hash((uint64_t)(uintptr_t)caller) & mask;
+
+    while (true)
+    {
+        // Slot 0 is the overflow site, so probing skips it.
+        if (i == HEAP_PROF_OVERFLOW)
+        {
+            i = 1;
+        }
+
+        Heap_Prof_Site* site = &heap_prof_sites[i];
+        if (site->caller == caller)
+        {
+            return (i);
+        }
+
+        if (site->caller == NULL)
+        {
+            // Leave a quarter of the table free to keep probes short.
+            if (heap_prof_site_count >= HEAP_PROF_SITES / 4 * 3)
+            {
+                return (HEAP_PROF_OVERFLOW);
+            }
+
+            site->caller = caller;
+            heap_prof_site_count++;
+            return (i);
+        }
+
+        i = (i + 1) & mask;
+    }
+}
+
+// Slot holding a block, or of the empty slot ending its probe sequence.
+// Must hold the lock.
+static size_t heap_prof_slot(uint64_t addr)
+{
+    size_t mask = HEAP_PROF_BLOCKS - 1;
+    size_t i = heap_prof_hash(addr) & mask;
+
+    while (heap_prof_blocks[i].key != 0 &&
+           (heap_prof_blocks[i].key & HEAP_PROF_ADDR_MASK) != addr)
+    {
+        i = (i + 1) & mask;
+    }
+
+    return (i);
+}
+
+bool heap_prof_start(void)
+{
+    if (heap_prof_enabled)
+    {
+        return (true);
+    }
+
+    size_t bytes = sizeof(Heap_Prof_Block) * HEAP_PROF_BLOCKS +
+                   sizeof(Heap_Prof_Site) * HEAP_PROF_SITES;
+    size_t pages = (bytes + PAGE_SIZE - 1) / PAGE_SIZE;
+
+    auto mem = (uint8_t*)vmm_pages_alloc_kernel(pages);
+    if (mem == NULL)
+    {
+        return (false);
+    }
+    memset(mem, 0, pages * PAGE_SIZE);
+
+    uint64_t flags = heap_prof_irq_lock();
+    heap_prof_blocks = (Heap_Prof_Block*)mem;
+    heap_prof_sites = (Heap_Prof_Site*)(mem + sizeof(Heap_Prof_Block) * HEAP_PROF_BLOCKS);
+    heap_prof_pages = pages;
+    heap_prof_live = 0;
+    heap_prof_site_count = 0;
+    heap_prof_dropped = 0;
+    heap_prof_start_tick = irq_pit_count;
+    heap_prof_enabled = true;
+    heap_prof_irq_unlock(flags);
+
+    return (true);
+}
+
+void heap_prof_stop(void)
+{
+    uint64_t flags = heap_prof_irq_lock();
+    if (!heap_prof_enabled)
+    {
+        heap_prof_irq_unlock(flags);
+        return;
+    }
+
+    heap_prof_enabled = false;
+    void* mem = heap_prof_blocks;
+    size_t pages = heap_prof_pages;
+    heap_prof_blocks = NULL;
+    heap_prof_sites = NULL;
+    heap_prof_irq_unlock(flags);
+
+    vmm_pages_free_kernel(mem, pages);
+}
+
+void heap_prof_alloc(const void* p, size_t size, const void* caller)
+{
+    if (p == NULL)
+    {
+        return;
+    }
+
+    uint64_t flags = heap_prof_irq_lock();
+
+    // Recheck now that the tables can't go away.
+    if (!heap_prof_enabled)
+    {
+        heap_prof_irq_unlock(flags);
+        return;
+    }
+
+    size_t s = heap_prof_site(caller);
+    Heap_Prof_Site* site = &heap_prof_sites[s];
+    site->allocs++;
+    site->bytes += size;
+
+    // Past three quarters full, new blocks are only counted.
+    uint64_t addr = heap_prof_addr(p);
+    size_t i = heap_prof_slot(addr);
+    if (heap_prof_blocks[i].key == 0 && heap_prof_live >= HEAP_PROF_BLOCKS / 4 * 3)
+    {
+        heap_prof_dropped++;
+        heap_prof_irq_unlock(flags);
+        return;
+    }
+
+    if (heap_prof_blocks[i].key == 0)
+    {
+        heap_prof_live++;
+    }
+    else
+    {
+        // A block we missed the free of; take it off its old site.
+        Heap_Prof_Site* old = &heap_prof_sites[heap_prof_blocks[i].key >> 48];
+        old->live_bytes -= heap_prof_blocks[i].size;
+        old->live_blocks--;
+    }
+
+    size = (size > UINT32_MAX) ? UINT32_MAX : size;
+    heap_prof_blocks[i].key = addr | ((uint64_t)s << 48);
+    heap_prof_blocks[i].size = (uint32_t)size;
+    heap_prof_blocks[i].tick = (uint32_t)irq_pit_count;
+    site->live_bytes += size;
+    site->live_blocks++;
+
+    heap_prof_irq_unlock(flags);
+}
+
+void heap_prof_free(const void* p)
+{
+    if (p == NULL)
+    {
+        return;
+    }
+
+    uint64_t flags = heap_prof_irq_lock();
+
+    if (!heap_prof_enabled)
+    {
+        heap_prof_irq_unlock(flags);
+        return;
+    }
+
+    size_t mask = HEAP_PROF_BLOCKS - 1;
+    size_t i = heap_prof_slot(heap_prof_addr(p));
+    if (heap_prof_blocks[i].key == 0)
+    {
+        heap_prof_irq_unlock(flags);
+        return;
+    }
+
+    Heap_Prof_Site* site = &heap_prof_sites[heap_prof_blocks[i].key >> 48];
+    site->live_bytes -= heap_prof_blocks[i].size;
+    site->live_blocks--;
+    heap_prof_live--;
+
+    // Shift later entries of the probe sequence back into the hole, so
+    // lookups never need to skip deleted slots.
+    size_t hole = i;
+    size_t j = i;
+    while (true)
+    {
+        j = (j + 1) & mask;
+        if (heap_prof_blocks[j].key == 0)
+        {
+            break;
+        }
+
+        size_t home = heap_prof_hash(heap_prof_blocks[j].key & HEAP_PROF_ADDR_MASK) & mask;
+        if (((j - home) & mask) >= ((j - hole) & mask))
+        {
+            heap_prof_blocks[hole] = heap_prof_blocks[j];
+            hole = j;
+        }
+    }
+    heap_prof_blocks[hole].key = 0;
+
+    heap_prof_irq_unlock(flags);
+}
+
+void heap_prof_report(size_t top)
+{
+    static const size_t REPORT_MAX = 32;
+
+    struct Row
+    {
+        Heap_Prof_Site site;
+        uint64_t age_ticks;
+    };
+    Row rows[REPORT_MAX];
+    size_t count = 0;
+
+    if (top > REPORT_MAX)
+    {
+        top = REPORT_MAX;
+    }
+
+    uint64_t flags = heap_prof_irq_lock();
+    if (!heap_prof_enabled)
+    {
+        heap_prof_irq_unlock(flags);
+        printf("heap profiler is off\n");
+        return;
+    }
+
+    // Keep the top sites by live bytes, in order.
+    size_t indices[REPORT_MAX];
+    for (size_t s = 0; s < HEAP_PROF_SITES; s++)
+    {
+        const Heap_Prof_Site* site = &heap_prof_sites[s];
+        if (site->allocs == 0)
+        {
+            continue;
+        }
+
+        size_t pos = count;
+        while (pos > 0 && rows[pos - 1].site.live_bytes < site->live_bytes)
+        {
+            pos--;
+        }
+        if (pos >= top)
+        {
+            continue;
+        }
+
+        size_t last = (count < top) ? count : top - 1;
+        for (size_t k = last; k > pos; k--)
+        {
+            rows[k] = rows[k - 1];
+            indices[k] = indices[k - 1];
+        }
+        rows[pos].site = *site;
+        rows[pos].age_ticks = 0;
+        indices[pos] = s;
+        if (count < top)
+        {
+            count++;
+        }
+    }
+
+    // Average age of each reported site's live blocks.
+    uint32_t now = (uint32_t)irq_pit_count;
+    for (size_t i = 0; i < HEAP_PROF_BLOCKS; i++)
+    {
+        uint64_t key = heap_prof_blocks[i].key;
+        if (key == 0)
+        {
+            continue;
+        }
+
+        for (size_t k = 0; k < count; k++)
+        {
+            if (indices[k] == (key >> 48))
+            {
+                rows[k].age_ticks += (uint32_t)(now - heap_prof_blocks[i].tick);
+                break;
+            }
+        }
+    }
+
+    uint64_t elapsed_ms = (irq_pit_count - heap_prof_start_tick) * 1000 / PIT_REAL_FREQ;
+    size_t live = heap_prof_live;
+    size_t sites = heap_prof_site_count;
+    uint64_t dropped = heap_prof_dropped;
+    heap_prof_irq_unlock(flags);
+
+    if (elapsed_ms == 0)
+    {
+        elapsed_ms = 1;
+    }
+
+    printf("%ld live blocks tracked, %ld call sites, %ld blocks untracked, %ld ms\n",
+           live, sites, dropped, elapsed_ms);
+
+    for (size_t k = 0; k < count; k++)
+    {
+        const Heap_Prof_Site* site = &rows[k].site;
+        uint64_t age_ms = 0;
+        if (site->live_blocks > 0)
+        {
+            age_ms = rows[k].age_ticks * 1000 / PIT_REAL_FREQ / site->live_blocks;
+        }
+
+        // The label is formatted first so the row is a single printf.
+        char label[24] = "(other sites)";
+        if (indices[k] != HEAP_PROF_OVERFLOW)
+        {
+            snprintf(label, sizeof(label), "%p", site->caller);
+        }
+        printf("%s: %ld B live in %ld blocks (avg age %ld ms), %ld allocs/s, %ld allocs, %ld B total\n",
+               label,
+               site->live_bytes,
+               site->live_blocks,
+               age_ms,
+               site->allocs * 1000 / elapsed_ms,
+               site->allocs,
+               site->bytes);
+    }
+}
@@ -0,0 +1,67 @@
+/**
+ * @file heap_prof.h
+ * @author Seth McBee
+ * @date 2026-10-19
+ * @brief Heap profiler. While on, every heap block is charged to the
+ * code that allocated it, so live memory can be broken down by call site.
+ */
+
+#pragma once
+
+#include <globals.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Live blocks the profiler can track at once (16 bytes each).
+#define HEAP_PROF_BLOCKS 65536
+
+/// Distinct call sites the profiler can tell apart. Further sites are
+/// charged to a shared overflow entry.
+#define HEAP_PROF_SITES 1024
+
+/// Whether allocations are being recorded. Only read by the heap on its
+/// fast paths; use heap_prof_start() and heap_prof_stop() to change it.
+extern bool heap_prof_enabled;
+
+/**
+ * @brief Starts recording allocations. Blocks allocated earlier are not
+ * known to the profiler.
+ *
+ * @return Whether the tables could be allocated.
+ */
+bool heap_prof_start(void);
+
+/**
+ * @brief Stops recording and discards everything recorded.
+ */
+void heap_prof_stop(void);
+
+/**
+ * @brief Records a new block.
+ *
+ * @param p Block, or NULL if the allocation failed.
+ * @param size Requested size.
+ * @param caller Return address of the allocating call.
+ */
+void heap_prof_alloc(const void* p, size_t size, const void* caller);
+
+/**
+ * @brief Forgets a block that is about to be freed.
+ *
+ * @param p Block. Blocks the profiler doesn't know are ignored.
+ */
+void heap_prof_free(const void* p);
+
+/**
+ * @brief Prints the call sites holding the most live memory, with their
+ * allocation rate and the average age of their live blocks.
+ *
+ * @param top Number of call sites to print.
+ */
+void heap_prof_report(size_t top);
+
+#ifdef __cplusplus
+}
+#endif
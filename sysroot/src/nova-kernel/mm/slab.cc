@@ -0,0 +1,643 @@
+/**
+ * @file slab.cc
+ * @author Seth McBee
+ * @date 2026-10-19
+ * @brief Slab object-cache allocator.
+ *
+ * Every slab is a single page with a Slab header at its start, so the
+ * slab owning an object is found by rounding the object's address down.
+ * Slabs are owned by a CPU, which allocates and frees from them with
+ * interrupts disabled but no lock. Objects freed on another CPU are
+ * pushed onto the slab's remote list with a compare-and-swap, and the
+ * owner takes the whole list back the next time it allocates. The
+ * cache lock is only taken to move whole slabs in and out of the cache.
+ *
+ * Slab pages are carved from a virtual window reserved on first use,
+ * which makes slab_owns() a range check.
+ */
+
+#include <globals.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <kernel.h>
+#include <mm/slab.h>
+
+#ifdef ARCH_X86_64
+#include <arch/x86_64/memory/paging.h>
+#include <arch/x86_64/memory/pmm.h>
+#include <arch/x86_64/memory/vmm.h>
+#endif // ARCH_X86_64
+
+#ifdef ARCH_X86
+#include <arch/x86/memory/paging.h>
+#include <arch/x86/memory/pmm.h>
+#include <arch/x86/memory/vmm.h>
+#endif // ARCH_X86
+
+// All caches that have been set up, for slab_info().
+static Slab_Cache* slab_caches;
+static volatile uint32_t slab_caches_lock;
+
+// Generic caches for container nodes and other small objects: 8 bytes,
+// then every multiple of 16 up to SLAB_SIZE_MAX.
+static Slab_Cache slab_size_caches[] =
+{
+    { "size-8", 8, 8, NULL },
+    { "size-16", 16, 16, NULL },
+    { "size-32", 32, 16, NULL },
+    { "size-48", 48, 16, NULL },
+    { "size-64", 64, 16, NULL },
+    { "size-80", 80, 16, NULL },
+    { "size-96", 96, 16, NULL },
+    { "size-112", 112, 16, NULL },
+    { "size-128", 128, 16, NULL },
+    { "size-144", 144, 16, NULL },
+    { "size-160", 160, 16, NULL },
+    { "size-176", 176, 16, NULL },
+    { "size-192", 192, 16, NULL },
+    { "size-208", 208, 16, NULL },
+    { "size-224", 224, 16, NULL },
+    { "size-240", 240, 16, NULL },
+    { "size-256", 256, 16, NULL },
+};
+
+// The first object of a 16-byte aligned cache sits after the header
+// rounded up to 16 bytes, which must keep the natural alignment promised
+// in slab.h.
+static_assert(((sizeof(Slab) + 15) & ~15) % SLAB_NATURAL_ALIGN == 0,
+              "Slab header breaks natural alignment of the size caches.");
+
+// Virtual window holding every slab page, and which of its pages are in
+// use.
+static uint8_t* slab_window;
+static uint64_t slab_window_map[SLAB_WINDOW_PAGES / 64];
+static size_t slab_window_hint;
+static volatile uint32_t slab_window_lock;
+static size_t slab_window_returned;
+
+static void slab_spin_lock(volatile uint32_t* lock)
+{
+    while (__sync_lock_test_and_set(lock, 1))
+    {
+        while (*lock)
+        {
+            cpu_relax();
+        }
+    }
+}
+
+static void slab_spin_unlock(volatile uint32_t* lock)
+{
+    __sync_lock_release(lock);
+}
+
+// Location of the free-list link of an object.
+static inline void** slab_link(Slab_Cache* cache, void* obj)
+{
+    return ((void**)((uint8_t*)obj + cache->link));
+}
+
+static inline Slab* slab_of(const void* obj)
+{
+    return ((Slab*)((uintptr_t)obj & ~(uintptr_t)(PAGE_SIZE - 1)));
+}
+
+static void slab_list_push(Slab** list, Slab* slab)
+{
+    slab->prev = NULL;
+    slab->next = *list;
+    if (*list != NULL)
+    {
+        (*list)->prev = slab;
+    }
+    *list = slab;
+}
+
+static void slab_list_remove(Slab** list, Slab* slab)
+{
+    if (slab->prev != NULL)
+    {
+        slab->prev->next = slab->next;
+    }
+    else
+    {
+        *list = slab->next;
+    }
+
+    if (slab->next != NULL)
+    {
+        slab->next->prev = slab->prev;
+    }
+
+    slab->prev = NULL;
+    slab->next = NULL;
+}
+
+// Takes a page from the slab window and backs it with a frame.
+static void* slab_page_alloc(void)
+{
+    const size_t words = SLAB_WINDOW_PAGES / 64;
+    size_t page = SLAB_WINDOW_PAGES;
+
+    slab_spin_lock(&slab_window_lock);
+
+    if (UNLIKELY(slab_window == NULL))
+    {
+        slab_window = (uint8_t*)vmm_pages_reserve_kernel(SLAB_WINDOW_PAGES);
+    }
+
+    if (slab_window != NULL)
+    {
+        for (size_t n = 0; n < words; n++)
+        {
+            size_t i = (slab_window_hint + n) % words;
+            if (slab_window_map[i] != ~(uint64_t)0)
+            {
+                size_t bit = __builtin_ctzll(~slab_window_map[i]);
+                slab_window_map[i] |= (uint64_t)1 << bit;
+                slab_window_hint = i;
+                page = i * 64 + bit;
+                break;
+            }
+        }
+    }
+
+    slab_spin_unlock(&slab_window_lock);
+
+    if (page == SLAB_WINDOW_PAGES)
+    {
+        return (NULL);
+    }
+
+    void* virt = slab_window + page * PAGE_SIZE;
+    void* phys = pmm_frame_alloc();
+    if (phys == NULL)
+    {
+        slab_spin_lock(&slab_window_lock);
+        slab_window_map[page / 64] &= ~((uint64_t)1 << (page % 64));
+        slab_spin_unlock(&slab_window_lock);
+        return (NULL);
+    }
+
+    vmm_page_map(phys, virt, PG_PR | PG_RW);
+
+    return (virt);
+}
+
+// Unmaps a slab page and returns it to the window.
+static void slab_page_free(void* virt)
+{
+    size_t page = ((uint8_t*)virt - slab_window) / PAGE_SIZE;
+    void* phys = vmm_phys_addr(virt);
+
+    vmm_page_unmap(virt);
+    pmm_frame_free(phys);
+
+    slab_spin_lock(&slab_window_lock);
+    slab_window_map[page / 64] &= ~((uint64_t)1 << (page % 64));
+    if (page / 64 < slab_window_hint)
+    {
+        slab_window_hint = page / 64;
+    }
+    slab_window_returned++;
+    slab_spin_unlock(&slab_window_lock);
+}
+
+// Computes the object layout of a cache. Must hold the cache lock.
+static void slab_cache_setup(Slab_Cache* cache)
+{
+    size_t align = cache->align;
+    if (align < sizeof(void*))
+    {
+        align = sizeof(void*);
+    }
+
+    // Objects with a constructor must keep their contents while free, so
+    // their free-list link goes after the object instead of inside it.
+    size_t stride = cache->size;
+    if (cache->ctor != NULL || stride < sizeof(void*))
+    {
+        cache->link = (stride + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+        stride = cache->link + sizeof(void*);
+    }
+    else
+    {
+        cache->link = 0;
+    }
+    stride = (stride + align - 1) & ~(align - 1);
+
+    cache->stride = stride;
+    cache->offset = (sizeof(Slab) + align - 1) & ~(align - 1);
+    cache->per_slab = (PAGE_SIZE - cache->offset) / stride;
+
+    if (cache->per_slab == 0)
+    {
+        kernel_panic("Slab cache object does not fit in a page.");
+    }
+
+    slab_spin_lock(&slab_caches_lock);
+    cache->next = slab_caches;
+    slab_caches = cache;
+    slab_spin_unlock(&slab_caches_lock);
+}
+
+// Turns a fresh page into a slab full of free objects.
+static Slab* slab_create(Slab_Cache* cache, void* page)
+{
+    Slab* slab = (Slab*)page;
+    uint8_t* obj = (uint8_t*)page + cache->offset;
+
+    slab->cache = cache;
+    slab->prev = NULL;
+    slab->next = NULL;
+    slab->free = NULL;
+    slab->remote = NULL;
+    slab->remote_next = NULL;
+    slab->inuse = 0;
+    slab->cpu = 0;
+
+    // Build the free list back to front so objects go out in address
+    // order.
+    for (size_t i = cache->per_slab; i > 0; i--)
+    {
+        void* cur = obj + (i - 1) * cache->stride;
+        if (cache->ctor != NULL)
+        {
+            cache->ctor(cur);
+        }
+        *slab_link(cache, cur) = slab->free;
+        slab->free = cur;
+    }
+
+    return (slab);
+}
+
+// Gives an empty slab back to the cache, releasing its page if the cache
+// already holds enough empty slabs.
+static void slab_release(Slab_Cache* cache, Slab* slab)
+{
+    bool keep;
+
+    slab_spin_lock(&cache->lock);
+    keep = cache->empty_count < SLAB_EMPTY_MAX;
+    if (keep)
+    {
+        slab_list_push(&cache->empty, slab);
+        cache->empty_count++;
+    }
+    else
+    {
+        cache->slabs--;
+    }
+    slab_spin_unlock(&cache->lock);
+
+    if (!keep)
+    {
+        slab_page_free(slab);
+    }
+}
+
+// Moves the remote frees of a slab onto its local free list. Must run on
+// the owning CPU with interrupts disabled.
+static void slab_collect(Slab_Cache* cache, Slab_Cpu* cpu, Slab* slab)
+{
+    void* list = __atomic_exchange_n(&slab->remote, NULL, __ATOMIC_ACQUIRE);
+    if (list == NULL)
+    {
+        return;
+    }
+
+    // Find the tail and splice the list in front of the local one.
+    uint32_t count = 1;
+    void* tail = list;
+    while (*slab_link(cache, tail) != NULL)
+    {
+        tail = *slab_link(cache, tail);
+        count++;
+    }
+
+    if (slab->free == NULL)
+    {
+        slab_list_remove(&cpu->full, slab);
+        slab_list_push(&cpu->partial, slab);
+    }
+
+    *slab_link(cache, tail) = slab->free;
+    slab->free = list;
+    slab->inuse -= count;
+}
+
+// Collects every slab that received remote frees since the last call.
+static void slab_collect_remote(Slab_Cache* cache, Slab_Cpu* cpu)
+{
+    Slab* slab = __atomic_exchange_n(&cpu->remote, NULL, __ATOMIC_ACQUIRE);
+
+    while (slab != NULL)
+    {
+        // The slab may be pushed again as soon as its remote list is
+        // taken, so read the link first.
+        Slab* next = slab->remote_next;
+        slab_collect(cache, cpu, slab);
+
+        if (slab->inuse == 0 && (slab != cpu->partial || slab->next != NULL))
+        {
+            slab_list_remove(&cpu->partial, slab);
+            slab_release(cache, slab);
+        }
+
+        slab = next;
+    }
+}
+
+// Gives a CPU whose partial list is empty a slab with free objects.
+// Interrupts must be disabled.
+static Slab* slab_refill(Slab_Cache* cache, Slab_Cpu* cpu, uint32_t id)
+{
+    slab_spin_lock(&cache->lock);
+
+    if (UNLIKELY(cache->per_slab == 0))
+    {
+        slab_cache_setup(cache);
+    }
+
+    Slab* slab = cache->empty;
+    if (slab != NULL)
+    {
+        slab_list_remove(&cache->empty, slab);
+        cache->empty_count--;
+    }
+
+    slab_spin_unlock(&cache->lock);
+
+    if (slab == NULL)
+    {
+        void* page = slab_page_alloc();
+        if (page == NULL)
+        {
+            return (NULL);
+        }
+
+        slab = slab_create(cache, page);
+
+        slab_spin_lock(&cache->lock);
+        cache->slabs++;
+        slab_spin_unlock(&cache->lock);
+    }
+
+    slab->cpu = id;
+    slab_list_push(&cpu->partial, slab);
+
+    return (slab);
+}
+
+void slab_cache_init(Slab_Cache* cache, const char* name, size_t size,
+                     size_t align, void (*ctor)(void*))
+{
+    memset(cache, 0, sizeof(*cache));
+    cache->name = name;
+    cache->size = size;
+    cache->align = align;
+    cache->ctor = ctor;
+}
+
+void slab_cache_destroy(Slab_Cache* cache)
+{
+    uint64_t flags = cpu_irq_save();
+
+    for (size_t i = 0; i < CPU_MAX; i++)
+    {
+        Slab_Cpu* cpu = &cache->cpu[i];
+
+        slab_collect_remote(cache, cpu);
+        if (cpu->full != NULL)
+        {
+            kernel_panic("Slab cache destroyed with objects in use.");
+        }
+
+        while (cpu->partial != NULL)
+        {
+            Slab* slab = cpu->partial;
+            if (slab->inuse != 0)
+            {
+                kernel_panic("Slab cache destroyed with objects in use.");
+            }
+            slab_list_remove(&cpu->partial, slab);
+            slab_list_push(&cache->empty, slab);
+        }
+    }
+
+    slab_spin_lock(&cache->lock);
+
+    Slab* release = cache->empty;
+    cache->empty = NULL;
+    cache->empty_count = 0;
+
+    if (cache->per_slab != 0)
+    {
+        slab_spin_lock(&slab_caches_lock);
+        Slab_Cache** it = &slab_caches;
+        while (*it != NULL && *it != cache)
+        {
+            it = &(*it)->next;
+        }
+        if (*it != NULL)
+        {
+            *it = cache->next;
+        }
+        slab_spin_unlock(&slab_caches_lock);
+        cache->per_slab = 0;
+    }
+
+    slab_spin_unlock(&cache->lock);
+
+    while (release != NULL)
+    {
+        Slab* next = release->next;
+        slab_page_free(release);
+        cache->slabs--;
+        release = next;
+    }
+
+    cpu_irq_restore(flags);
+}
+
+void* slab_alloc(Slab_Cache* cache)
+{
+    uint64_t flags = cpu_irq_save();
+    uint32_t id = cpu_id();
+    Slab_Cpu* cpu = &cache->cpu[id];
+
+    // Take back remote frees early so emptied slabs are released.
+    if (UNLIKELY(cpu->remote != NULL))
+    {
+        slab_collect_remote(cache, cpu);
+    }
+
+    Slab* slab = cpu->partial;
+    if (UNLIKELY(slab == NULL))
+    {
+        slab = slab_refill(cache, cpu, id);
+
+        if (slab == NULL)
+        {
+            cpu_irq_restore(flags);
+            return (NULL);
+        }
+    }
+
+    void* obj = slab->free;
+    slab->free = *slab_link(cache, obj);
+    slab->inuse++;
+    cpu->allocs++;
+
+    if (slab->free == NULL)
+    {
+        slab_list_remove(&cpu->partial, slab);
+        slab_list_push(&cpu->full, slab);
+    }
+
+    cpu_irq_restore(flags);
+
+    return (obj);
+}
+
+void slab_free(Slab_Cache* cache, void* obj)
+{
+    if (obj == NULL)
+    {
+        return;
+    }
+
+    uint64_t flags = cpu_irq_save();
+    uint32_t id = cpu_id();
+    Slab_Cpu* cpu = &cache->cpu[id];
+    Slab* slab = slab_of(obj);
+
+    cpu->frees++;
+
+    if (LIKELY(slab->cpu == id))
+    {
+        if (slab->free == NULL)
+        {
+            slab_list_remove(&cpu->full, slab);
+            slab_list_push(&cpu->partial, slab);
+        }
+
+        *slab_link(cache, obj) = slab->free;
+        slab->free = obj;
+        slab->inuse--;
+
+        // Keep the last slab around so a CPU freeing and allocating one
+        // object doesn't bounce pages through the cache.
+        if (slab->inuse == 0 && (slab != cpu->partial || slab->next != NULL))
+        {
+            slab_list_remove(&cpu->partial, slab);
+            slab_release(cache, slab);
+        }
+    }
+    else
+    {
+        // Hand the object back to the owning CPU.
+        cpu->remote_frees++;
+
+        void* head = slab->remote;
+        do
+        {
+            *slab_link(cache, obj) = head;
+        } while (!__atomic_compare_exchange_n(&slab->remote, &head, obj, true,
+                                              __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+        // The first remote free also queues the slab for collection.
+        if (head == NULL)
+        {
+            Slab_Cpu* owner = &cache->cpu[slab->cpu];
+            Slab* next = owner->remote;
+            do
+            {
+                slab->remote_next = next;
+            } while (!__atomic_compare_exchange_n(&owner->remote, &next, slab, true,
+                                                  __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+        }
+    }
+
+    cpu_irq_restore(flags);
+}
+
+bool slab_owns(const void* ptr)
+{
+    return ((uintptr_t)ptr - (uintptr_t)slab_window
+            < (uintptr_t)SLAB_WINDOW_PAGES * PAGE_SIZE
+            && slab_window != NULL);
+}
+
+Slab_Cache* slab_cache_of(const void* obj)
+{
+    return (slab_of(obj)->cache);
+}
+
+Slab_Cache* slab_size_cache(size_t size)
+{
+    if (UNLIKELY(size > SLAB_SIZE_MAX))
+    {
+        return (NULL);
+    }
+
+    // Class n > 0 holds objects of up to 16 * n bytes.
+    size_t index = size <= 8 ? 0 : (size + 15) >> 4;
+
+    return (&slab_size_caches[index]);
+}
+
+void slab_cache_stats(Slab_Cache* cache, Slab_Stats* stats)
+{
+    stats->allocs = 0;
+    stats->frees = 0;
+    stats->remote_frees = 0;
+    for (size_t i = 0; i < CPU_MAX; i++)
+    {
+        const Slab_Cpu* cpu = &cache->cpu[i];
+        stats->allocs += cpu->allocs;
+        stats->frees += cpu->frees;
+        stats->remote_frees += cpu->remote_frees;
+    }
+
+    stats->size = cache->size;
+    stats->slabs = cache->slabs;
+    stats->objects = cache->slabs * cache->per_slab;
+    stats->inuse = stats->allocs - stats->frees;
+}
+
+void slab_page_stats(Slab_Page_Stats* stats)
+{
+    stats->pages = 0;
+    stats->empty = 0;
+    stats->returned = slab_window_returned;
+
+    slab_spin_lock(&slab_caches_lock);
+    for (Slab_Cache* cache = slab_caches; cache != NULL; cache = cache->next)
+    {
+        stats->pages += cache->slabs;
+        stats->empty += cache->empty_count;
+    }
+    slab_spin_unlock(&slab_caches_lock);
+}
+
+void slab_info(void)
+{
+    for (Slab_Cache* cache = slab_caches; cache != NULL; cache = cache->next)
+    {
+        Slab_Stats stats;
+        slab_cache_stats(cache, &stats);
+        printf("%s: size %ld, slabs %ld, inuse %ld/%ld, allocs %ld, frees %ld (%ld remote)\n",
+               cache->name,
+               stats.size,
+               stats.slabs,
+               stats.inuse,
+               stats.objects,
+               stats.allocs,
+               stats.frees,
+               stats.remote_frees);
+    }
+}
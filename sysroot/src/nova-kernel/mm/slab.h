@@ -0,0 +1,247 @@
+/**
+ * @file slab.h
+ * @author Seth McBee
+ * @date 2026-10-19
+ * @brief Slab object-cache allocator for hot fixed-size kernel objects.
+ */
+
+#pragma once
+
+#include <globals.h>
+
+#ifdef ARCH_X86_64
+#include <arch/x86_64/cpu.h>
+#endif // ARCH_X86_64
+
+#ifdef ARCH_X86
+#include <arch/x86/cpu.h>
+#endif // ARCH_X86
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Number of completely free slabs a cache keeps before releasing pages.
+#define SLAB_EMPTY_MAX 2
+
+/// Largest object served by the generic size caches.
+#define SLAB_SIZE_MAX 256
+
+/// Objects of a generic size cache are aligned to the largest power of two
+/// up to this that divides the cache's size.
+#define SLAB_NATURAL_ALIGN 64
+
+/// Pages of the virtual window all slabs are carved from (64 MiB).
+#define SLAB_WINDOW_PAGES 16384
+
+typedef struct Slab_Cache Slab_Cache;
+
+/// Header stored at the start of every slab page. A slab belongs to the
+/// CPU that took it; only that CPU touches its free list, and any other
+/// CPU hands objects back through the lock-free remote list.
+typedef struct Slab Slab;
+struct Slab
+{
+    /// Cache that owns this slab.
+    Slab_Cache* cache;
+
+    /// Linkage in the owning CPU's partial or full list, or in the
+    /// cache's empty list.
+    Slab* prev;
+    Slab* next;
+
+    /// Free objects, only touched by the owning CPU.
+    void* free;
+
+    /// Objects freed by other CPUs, waiting to be collected.
+    void* volatile remote;
+
+    /// Linkage in the owning CPU's list of slabs with remote frees.
+    Slab* remote_next;
+
+    /// Number of objects not on the local free list.
+    uint32_t inuse;
+
+    /// Owning CPU.
+    uint32_t cpu;
+};
+
+/// Per-CPU state of a cache. Only touched by its own CPU with interrupts
+/// disabled, except for the remote list, which other CPUs push onto.
+typedef struct Slab_Cpu Slab_Cpu;
+struct Slab_Cpu
+{
+    /// Slabs with free objects; allocations come from the first one.
+    Slab* partial;
+
+    /// Slabs with no local free objects.
+    Slab* full;
+
+    /// Slabs that received remote frees since they were last collected.
+    Slab* volatile remote;
+
+    /// Statistics.
+    uint64_t allocs;
+    uint64_t frees;
+    uint64_t remote_frees;
+} __attribute__((aligned(64)));
+
+/// An object cache. Caches are usually defined statically with
+/// SLAB_CACHE() and finish setting themselves up on first use.
+struct Slab_Cache
+{
+    /// Name reported by slab_info().
+    const char* name;
+
+    /// Object size and alignment.
+    size_t size;
+    size_t align;
+
+    /// Called once on every object when a new slab is populated. Objects
+    /// must be returned to the cache in their constructed state.
+    void (*ctor)(void* obj);
+
+    /// Layout, computed on first use.
+    size_t stride;
+    size_t link;
+    size_t offset;
+    uint32_t per_slab;
+
+    /// Protects the empty list and the counters below. Only taken when a
+    /// CPU runs out of slabs or gives one back.
+    volatile uint32_t lock;
+
+    Slab* empty;
+
+    /// Pages owned by this cache, and how many of them are empty.
+    size_t slabs;
+    size_t empty_count;
+
+    /// Linkage in the list of all caches.
+    Slab_Cache* next;
+
+    Slab_Cpu cpu[CPU_MAX];
+};
+
+/// Snapshot of cache statistics.
+typedef struct Slab_Stats Slab_Stats;
+struct Slab_Stats
+{
+    size_t size;
+    size_t slabs;
+    size_t objects;
+    size_t inuse;
+    uint64_t allocs;
+    uint64_t frees;
+    uint64_t remote_frees;
+};
+
+/// Page accounting over every cache.
+typedef struct Slab_Page_Stats Slab_Page_Stats;
+struct Slab_Page_Stats
+{
+    /// Pages held by caches, and how many of them are empty.
+    size_t pages;
+    size_t empty;
+
+    /// Pages given back to the VMM so far.
+    size_t returned;
+};
+
+/**
+ * @brief Static initializer for a cache of objects of the given type.
+ *
+ * @param name Name of the cache.
+ * @param type Type of object stored in the cache.
+ * @param ctor Object constructor, or NULL.
+ */
+#define SLAB_CACHE(name, type, ctor) \
+    { (name), sizeof(type), __alignof__(type), (ctor) }
+
+/**
+ * @brief Initializes a cache at run-time.
+ *
+ * @param cache Cache to initialize.
+ * @param name Name of the cache.
+ * @param size Size of each object.
+ * @param align Required alignment of each object.
+ * @param ctor Object constructor, or NULL.
+ */
+void slab_cache_init(Slab_Cache* cache, const char* name, size_t size,
+                     size_t align, void (*ctor)(void*));
+
+/**
+ * @brief Releases every page held by a cache. All objects must have
+ * been freed.
+ *
+ * @param cache Cache to destroy.
+ */
+void slab_cache_destroy(Slab_Cache* cache);
+
+/**
+ * @brief Allocates an object from a cache.
+ *
+ * @param cache Cache to allocate from.
+ *
+ * @return Pointer to the object, or NULL if out of memory.
+ */
+void* slab_alloc(Slab_Cache* cache);
+
+/**
+ * @brief Returns an object to its cache.
+ *
+ * @param cache Cache the object was allocated from.
+ * @param obj Object to free. May be NULL.
+ */
+void slab_free(Slab_Cache* cache, void* obj);
+
+/**
+ * @brief Checks whether a pointer lies in slab memory.
+ *
+ * @param ptr Pointer to check.
+ *
+ * @return Whether ptr points into a slab.
+ */
+bool slab_owns(const void* ptr);
+
+/**
+ * @brief Returns the cache an object was allocated from.
+ *
+ * @param obj Object in slab memory.
+ *
+ * @return Cache owning the object.
+ */
+Slab_Cache* slab_cache_of(const void* obj);
+
+/**
+ * @brief Returns the generic cache that serves objects of a given size.
+ *
+ * @param size Object size.
+ *
+ * @return Cache for the size, or NULL if size exceeds SLAB_SIZE_MAX.
+ */
+Slab_Cache* slab_size_cache(size_t size);
+
+/**
+ * @brief Collects statistics for a cache.
+ *
+ * @param cache Cache to inspect.
+ * @param stats Destination of the statistics.
+ */
+void slab_cache_stats(Slab_Cache* cache, Slab_Stats* stats);
+
+/**
+ * @brief Collects page accounting over every cache.
+ *
+ * @param stats Destination of the statistics.
+ */
+void slab_page_stats(Slab_Page_Stats* stats);
+
+/**
+ * @brief Prints statistics for every cache in use.
+ */
+void slab_info(void);
+
+#ifdef __cplusplus
+}
+#endif
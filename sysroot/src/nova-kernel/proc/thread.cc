@@ -0,0 +1,35 @@
+/**
+ * @file thread.cc
+ * @author Seth McBee
+ * @date 2026-10-19
+ * @brief Kernel and userspace threads.
+ */
+
+#include <globals.h>
+
+#include <mm/slab.h>
+#include <proc/thread.h>
+
+static void thread_ctor(void* obj)
+{
+    new (obj) Thread();
+}
+
+static Slab_Cache thread_cache = SLAB_CACHE("thread", Thread, thread_ctor);
+
+Thread* thread_alloc()
+{
+    return (Thread*)slab_alloc(&thread_cache);
+}
+
+void thread_free(Thread* thread)
+{
+    if (thread == nullptr)
+    {
+        return;
+    }
+
+    // Cached threads are kept in their constructed state.
+    *thread = Thread();
+    slab_free(&thread_cache, thread);
+}
@@ -33,6 +33,12 @@ extern Thread* volatile current_thread;
 extern Thread* null_thread;
 extern Thread* kernel_thread;
 
+// Allocates a zeroed thread from the thread cache.
+Thread* thread_alloc();
+
+// Returns a thread to the thread cache.
+void thread_free(Thread* thread);
+
 // Architecture-specific.
 extern "C" void thread_switch(Thread* target);
 Thread* thread_spawn(void* entry);